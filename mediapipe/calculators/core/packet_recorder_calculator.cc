@@ -0,0 +1,88 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/tool/packet_recording.h"
+
+namespace mediapipe {
+
+// Records the packets of its input streams to a packet recording file, which
+// can be replayed into a graph with ReplayRecording().  Each packet is
+// recorded under the name of its input stream, so packets recorded from the
+// graph input streams can be replayed into the same graph.  The inputs may
+// be specified by tag or index, and may have any type with serialization
+// functions registered, see mediapipe/framework/tool/packet_codec.h.
+//
+// Example config:
+//
+// node {
+//   calculator: "PacketRecorderCalculator"
+//   input_stream: "input_video"
+//   input_stream: "detections"
+//   input_side_packet: "OUTPUT_FILE_PATH:recording_path"
+//   input_stream_handler {
+//     input_stream_handler: "ImmediateInputStreamHandler"
+//   }
+// }
+class PacketRecorderCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    for (CollectionItemId id = cc->Inputs().BeginId();
+         id < cc->Inputs().EndId(); ++id) {
+      cc->Inputs().Get(id).SetAny();
+    }
+    RET_CHECK(cc->InputSidePackets().HasTag("OUTPUT_FILE_PATH"));
+    cc->InputSidePackets().Tag("OUTPUT_FILE_PATH").Set<std::string>();
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    ASSIGN_OR_RETURN(
+        writer_,
+        PacketRecordingWriter::Create(
+            cc->InputSidePackets().Tag("OUTPUT_FILE_PATH").Get<std::string>()));
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    for (CollectionItemId id = cc->Inputs().BeginId();
+         id < cc->Inputs().EndId(); ++id) {
+      const InputStreamShard& input = cc->Inputs().Get(id);
+      if (!input.IsEmpty()) {
+        RETURN_IF_ERROR(writer_->WritePacket(input.Name(), input.Value()));
+      }
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Close(CalculatorContext* cc) override {
+    if (writer_) {
+      RETURN_IF_ERROR(writer_->Close());
+      writer_.reset();
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+ private:
+  std::unique_ptr<PacketRecordingWriter> writer_;
+};
+REGISTER_CALCULATOR(PacketRecorderCalculator);
+
+}  // namespace mediapipe
@@ -16,6 +16,7 @@
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/formats/image_frame_pool.h"
 #include "mediapipe/framework/port/opencv_core_inc.h"
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/ret_check.h"
@@ -189,6 +190,7 @@ REGISTER_CALCULATOR(ImageTransformationCalculator);
     RET_CHECK(cc->Outputs().HasTag("IMAGE"));
     cc->Inputs().Tag("IMAGE").Set<ImageFrame>();
     cc->Outputs().Tag("IMAGE").Set<ImageFrame>();
+    cc->UseService(kImageFramePoolService);
   }
 #if defined(__ANDROID__) || defined(__APPLE__) && !TARGET_OS_OSX
   if (cc->Inputs().HasTag("IMAGE_GPU")) {
@@ -360,8 +362,10 @@ REGISTER_CALCULATOR(ImageTransformationCalculator);
   cv::Mat rotation_mat = cv::getRotationMatrix2D(src_center, angle, 1.0);
   cv::warpAffine(scaled_mat, rotated_mat, rotation_mat, scaled_mat.size());
 
-  std::unique_ptr<ImageFrame> output_frame(
-      new ImageFrame(input_img.Format(), output_width, output_height));
+  std::unique_ptr<ImageFrame> output_frame =
+      cc->Service(kImageFramePoolService)
+          .GetObject()
+          .GetFrame(input_img.Format(), output_width, output_height);
   cv::Mat output_mat = formats::MatView(output_frame.get());
   rotated_mat.copyTo(output_mat);
   cc->Outputs().Tag("IMAGE").Add(output_frame.release(), cc->InputTimestamp());
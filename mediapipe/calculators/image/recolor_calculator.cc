@@ -12,13 +12,21 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <memory>
 #include <vector>
 
+#include "absl/memory/memory.h"
+#include "absl/synchronization/blocking_counter.h"
 #include "mediapipe/calculators/image/recolor_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
 #include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_pool.h"
+#include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/threadpool.h"
 #include "mediapipe/util/color.pb.h"
 
 #if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
@@ -30,6 +38,40 @@
 
 namespace {
 enum { ATTRIB_VERTEX, ATTRIB_TEXTURE_POSITION, NUM_ATTRIBUTES };
+
+// Luminance weights of the GPU shader, divided by 255 * 255 so that the
+// product of an 8-bit mask value and the luminance of 8-bit pixel values is
+// in [0, 1].
+constexpr float kRedWeight = 0.299f / (255.f * 255.f);
+constexpr float kGreenWeight = 0.587f / (255.f * 255.f);
+constexpr float kBlueWeight = 0.114f / (255.f * 255.f);
+
+// Blends color_row into a row of width pixels, weighted by the mask value at
+// mask_row[mask_columns[x]] times the luminance of pixel x, as the GPU
+// shader.  color_row holds the color of each value of the row, and weights
+// holds as many values of scratch space.  The blend runs over contiguous
+// values rather than pixels, so that the compiler vectorizes it.
+template <int kNumChannels>
+void RecolorRow(const uint8* __restrict src, const uint8* __restrict mask_row,
+                const int* __restrict mask_columns,
+                const float* __restrict color_row, int width,
+                float* __restrict weights, uint8* __restrict dst) {
+  for (int x = 0; x < width; ++x) {
+    const uint8* pixel = src + x * kNumChannels;
+    const float weight = mask_row[mask_columns[x]] *
+                         (kRedWeight * pixel[0] + kGreenWeight * pixel[1] +
+                          kBlueWeight * pixel[2]);
+    for (int c = 0; c < kNumChannels; ++c) {
+      weights[x * kNumChannels + c] = weight;
+    }
+  }
+  const int row_size = width * kNumChannels;
+  for (int i = 0; i < row_size; ++i) {
+    const float value = src[i];
+    dst[i] = static_cast<int>(value + (color_row[i] - value) * weights[i] +
+                              0.5f);
+  }
+}
 }  // namespace
 
 namespace mediapipe {
@@ -40,7 +82,9 @@ namespace mediapipe {
 // The luminance of the input image is used to adjust the blending weight,
 // to help preserve image textures.
 //
-// TODO implement cpu support.
+// On CPU, a mask of a different size than the image is sampled at the
+// nearest pixel, and the rows of the image can be blended in parallel bands
+// by setting num_threads.
 //
 // Inputs:
 //   One of the following IMAGE tags:
@@ -57,6 +101,7 @@ namespace mediapipe {
 // Options:
 //   color_rgb (required): A map of RGB values [0-255].
 //   mask_channel (optional): Which channel of mask image is used [RED or ALPHA]
+//   num_threads (optional): Number of threads blending on CPU [default 1]
 //
 // Usage example:
 //  node {
@@ -93,6 +138,9 @@ class RecolorCalculator : public CalculatorBase {
   bool initialized_ = false;
   std::vector<float> color_;
   mediapipe::RecolorCalculatorOptions::MaskChannel mask_channel_;
+  int num_threads_ = 1;
+  // Blends bands of rows on CPU if num_threads_ > 1.
+  std::unique_ptr<ThreadPool> thread_pool_;
 
   bool use_gpu_ = false;
 #if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
@@ -132,6 +180,7 @@ REGISTER_CALCULATOR(RecolorCalculator);
 #endif  // __ANDROID__ or iOS
   if (cc->Outputs().HasTag("IMAGE")) {
     cc->Outputs().Tag("IMAGE").Set<ImageFrame>();
+    cc->UseService(kImageFramePoolService);
   }
 
 #if defined(__ANDROID__) || (defined(__APPLE__) && !TARGET_OS_OSX)
@@ -153,6 +202,11 @@ REGISTER_CALCULATOR(RecolorCalculator);
 
   RETURN_IF_ERROR(LoadOptions(cc));
 
+  if (!use_gpu_ && num_threads_ > 1) {
+    thread_pool_ = absl::make_unique<ThreadPool>("recolor", num_threads_ - 1);
+    thread_pool_->StartWorkers();
+  }
+
   return ::mediapipe::OkStatus();
 }
 
@@ -187,7 +241,90 @@ REGISTER_CALCULATOR(RecolorCalculator);
 }
 
 ::mediapipe::Status RecolorCalculator::RenderCpu(CalculatorContext* cc) {
-  return ::mediapipe::UnimplementedError("CPU support is not implemented yet.");
+  if (cc->Inputs().Tag("MASK").IsEmpty()) {
+    return ::mediapipe::OkStatus();
+  }
+  // Get inputs and setup output.
+  const auto& input_img = cc->Inputs().Tag("IMAGE").Get<ImageFrame>();
+  const auto& mask_img = cc->Inputs().Tag("MASK").Get<ImageFrame>();
+  RET_CHECK(input_img.Format() == ImageFormat::SRGB ||
+            input_img.Format() == ImageFormat::SRGBA)
+      << "Unsupported image format: " << input_img.Format();
+  RET_CHECK(mask_img.Format() == ImageFormat::GRAY8 ||
+            mask_img.Format() == ImageFormat::SRGB ||
+            mask_img.Format() == ImageFormat::SRGBA)
+      << "Unsupported mask format: " << mask_img.Format();
+  int mask_channel = 0;
+  if (mask_channel_ == mediapipe::RecolorCalculatorOptions_MaskChannel_ALPHA) {
+    RET_CHECK_EQ(mask_img.Format(), ImageFormat::SRGBA)
+        << "The mask has no alpha channel.";
+    mask_channel = 3;
+  }
+
+  const int width = input_img.Width();
+  const int height = input_img.Height();
+  const int num_channels = input_img.NumberOfChannels();
+  const int mask_width = mask_img.Width();
+  const int mask_height = mask_img.Height();
+  // The offset of the mask value of each image column in a mask row.
+  std::vector<int> mask_columns(width);
+  for (int x = 0; x < width; ++x) {
+    mask_columns[x] = (2 * x + 1) * mask_width / (2 * width) *
+                          mask_img.NumberOfChannels() +
+                      mask_channel;
+  }
+  // The color blended into each value of a row.  The color is opaque.
+  const float color[4] = {color_[0] * 255.f, color_[1] * 255.f,
+                          color_[2] * 255.f, 255.f};
+  std::vector<float> color_row(width * num_channels);
+  for (int i = 0; i < color_row.size(); ++i) {
+    color_row[i] = color[i % num_channels];
+  }
+
+  std::unique_ptr<ImageFrame> output_img =
+      cc->Service(kImageFramePoolService)
+          .GetObject()
+          .GetFrame(input_img.Format(), width, height);
+
+  auto recolor_rows = [&](int begin, int end) {
+    std::vector<float> weights(width * num_channels);
+    for (int y = begin; y < end; ++y) {
+      const uint8* src = input_img.PixelData() + y * input_img.WidthStep();
+      const uint8* mask_row =
+          mask_img.PixelData() +
+          (2 * y + 1) * mask_height / (2 * height) * mask_img.WidthStep();
+      uint8* dst = output_img->MutablePixelData() + y * output_img->WidthStep();
+      if (num_channels == 4) {
+        RecolorRow<4>(src, mask_row, mask_columns.data(), color_row.data(),
+                      width, weights.data(), dst);
+      } else {
+        RecolorRow<3>(src, mask_row, mask_columns.data(), color_row.data(),
+                      width, weights.data(), dst);
+      }
+    }
+  };
+
+  if (thread_pool_) {
+    // Blend the first band on this thread and the others in the pool.
+    const int band_height = (height + num_threads_ - 1) / num_threads_;
+    absl::BlockingCounter bands_done(num_threads_ - 1);
+    for (int band = 1; band < num_threads_; ++band) {
+      const int begin = std::min(band * band_height, height);
+      const int end = std::min(begin + band_height, height);
+      thread_pool_->Schedule([&recolor_rows, &bands_done, begin, end] {
+        recolor_rows(begin, end);
+        bands_done.DecrementCount();
+      });
+    }
+    recolor_rows(0, std::min(band_height, height));
+    bands_done.Wait();
+  } else {
+    recolor_rows(0, height);
+  }
+
+  cc->Outputs().Tag("IMAGE").Add(output_img.release(), cc->InputTimestamp());
+
+  return ::mediapipe::OkStatus();
 }
 
 ::mediapipe::Status RecolorCalculator::RenderGpu(CalculatorContext* cc) {
@@ -294,6 +431,8 @@ void RecolorCalculator::GlRender() {
   const auto& options = cc->Options<mediapipe::RecolorCalculatorOptions>();
 
   mask_channel_ = options.mask_channel();
+  num_threads_ = options.num_threads();
+  RET_CHECK_GE(num_threads_, 1);
 
   if (!options.has_color()) RET_CHECK_FAIL() << "Missing color option.";
 
@@ -0,0 +1,219 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/substitute.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/tool/sink.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Returns a node blending the color (r, g, b) with the given options.
+CalculatorGraphConfig::Node MakeNode(int r, int g, int b,
+                                     const std::string& mask_channel,
+                                     int num_threads) {
+  return ParseTextProtoOrDie<CalculatorGraphConfig::Node>(absl::Substitute(
+      R"(
+        calculator: "RecolorCalculator"
+        input_stream: "IMAGE:image"
+        input_stream: "MASK:mask"
+        output_stream: "IMAGE:output_image"
+        options {
+          [mediapipe.RecolorCalculatorOptions.ext] {
+            color { r: $0 g: $1 b: $2 }
+            mask_channel: $3
+            num_threads: $4
+          }
+        }
+      )",
+      r, g, b, mask_channel, num_threads));
+}
+
+// Returns an image whose pixel values are a function of their position.
+std::unique_ptr<ImageFrame> MakeImage(ImageFormat::Format format, int width,
+                                      int height, int seed) {
+  auto image = absl::make_unique<ImageFrame>(format, width, height);
+  for (int y = 0; y < height; ++y) {
+    uint8* row = image->MutablePixelData() + y * image->WidthStep();
+    for (int i = 0; i < width * image->NumberOfChannels(); ++i) {
+      row[i] = (seed + y * 37 + i * 11) % 256;
+    }
+  }
+  return image;
+}
+
+// Runs node on one image and mask, and returns the output image.
+ImageFrame RunRecolor(const CalculatorGraphConfig::Node& node,
+                      std::unique_ptr<ImageFrame> image,
+                      std::unique_ptr<ImageFrame> mask) {
+  CalculatorRunner runner(node);
+  runner.MutableInputs()->Tag("IMAGE").packets.push_back(
+      Adopt(image.release()).At(Timestamp(0)));
+  runner.MutableInputs()->Tag("MASK").packets.push_back(
+      Adopt(mask.release()).At(Timestamp(0)));
+  MEDIAPIPE_CHECK_OK(runner.Run());
+  const std::vector<Packet>& packets = runner.Outputs().Tag("IMAGE").packets;
+  CHECK_EQ(1, packets.size());
+  ImageFrame output;
+  output.CopyFrom(packets[0].Get<ImageFrame>(), 1);
+  return output;
+}
+
+// Blends color into pixel as the GPU shader does.
+uint8 ExpectedValue(const uint8* pixel, int channel, uint8 mask_value,
+                    float color) {
+  const double luminance =
+      (0.299 * pixel[0] + 0.587 * pixel[1] + 0.114 * pixel[2]) / 255.0;
+  const double weight = mask_value / 255.0 * luminance;
+  return static_cast<uint8>(
+      std::round(pixel[channel] + (color - pixel[channel]) * weight));
+}
+
+TEST(RecolorCalculatorTest, BlendsColorByMaskAndLuminance) {
+  auto image = absl::make_unique<ImageFrame>(ImageFormat::SRGB, 3, 1);
+  const uint8 pixels[] = {200, 100, 50, 255, 255, 255, 200, 100, 50};
+  std::copy(pixels, pixels + 9, image->MutablePixelData());
+  auto mask = absl::make_unique<ImageFrame>(ImageFormat::GRAY8, 3, 1);
+  const uint8 mask_values[] = {255, 255, 0};
+  std::copy(mask_values, mask_values + 3, mask->MutablePixelData());
+
+  const ImageFrame output = RunRecolor(MakeNode(0, 0, 255, "RED", 1),
+                                       std::move(image), std::move(mask));
+  ASSERT_EQ(ImageFormat::SRGB, output.Format());
+  const uint8* result = output.PixelData();
+  const float color[] = {0, 0, 255};
+  for (int c = 0; c < 3; ++c) {
+    EXPECT_EQ(ExpectedValue(pixels, c, 255, color[c]), result[c]) << c;
+  }
+  // A white pixel under the mask is replaced by the color.
+  EXPECT_EQ(0, result[3]);
+  EXPECT_EQ(0, result[4]);
+  EXPECT_EQ(255, result[5]);
+  // Pixels outside the mask are kept.
+  EXPECT_EQ(200, result[6]);
+  EXPECT_EQ(100, result[7]);
+  EXPECT_EQ(50, result[8]);
+}
+
+TEST(RecolorCalculatorTest, UsesMaskAlphaAndBlendsImageAlpha) {
+  auto image = absl::make_unique<ImageFrame>(ImageFormat::SRGBA, 1, 1);
+  const uint8 pixel[] = {120, 60, 240, 0};
+  std::copy(pixel, pixel + 4, image->MutablePixelData());
+  auto mask = absl::make_unique<ImageFrame>(ImageFormat::SRGBA, 1, 1);
+  const uint8 mask_value[] = {0, 0, 0, 128};
+  std::copy(mask_value, mask_value + 4, mask->MutablePixelData());
+
+  const ImageFrame output = RunRecolor(MakeNode(255, 0, 0, "ALPHA", 1),
+                                       std::move(image), std::move(mask));
+  const float color[] = {255, 0, 0, 255};
+  for (int c = 0; c < 4; ++c) {
+    EXPECT_NEAR(ExpectedValue(pixel, c, 128, color[c]), output.PixelData()[c],
+                1)
+        << c;
+  }
+}
+
+TEST(RecolorCalculatorTest, RejectsMaskWithoutAlpha) {
+  CalculatorRunner runner(MakeNode(255, 0, 0, "ALPHA", 1));
+  runner.MutableInputs()->Tag("IMAGE").packets.push_back(
+      Adopt(MakeImage(ImageFormat::SRGB, 2, 2, 0).release()).At(Timestamp(0)));
+  runner.MutableInputs()->Tag("MASK").packets.push_back(
+      Adopt(MakeImage(ImageFormat::GRAY8, 2, 2, 0).release())
+          .At(Timestamp(0)));
+  EXPECT_FALSE(runner.Run().ok());
+}
+
+TEST(RecolorCalculatorTest, SamplesSmallerMaskAndMatchesInParallel) {
+  const int width = 67;
+  const int height = 41;
+  const ImageFrame serial = RunRecolor(
+      MakeNode(10, 200, 30, "RED", 1), MakeImage(ImageFormat::SRGB, width,
+                                                 height, 1),
+      MakeImage(ImageFormat::SRGB, 32, 20, 2));
+  const ImageFrame parallel = RunRecolor(
+      MakeNode(10, 200, 30, "RED", 3), MakeImage(ImageFormat::SRGB, width,
+                                                 height, 1),
+      MakeImage(ImageFormat::SRGB, 32, 20, 2));
+
+  const auto image = MakeImage(ImageFormat::SRGB, width, height, 1);
+  const auto mask = MakeImage(ImageFormat::SRGB, 32, 20, 2);
+  const float color[] = {10, 200, 30};
+  for (int y = 0; y < height; ++y) {
+    // The mask pixel nearest to the center of each image pixel.
+    const uint8* mask_row =
+        mask->PixelData() + (y * 20 + 10) / height * mask->WidthStep();
+    for (int x = 0; x < width; ++x) {
+      const uint8 mask_value = mask_row[(x * 32 + 16) / width * 3];
+      const uint8* pixel = image->PixelData() + y * image->WidthStep() + x * 3;
+      for (int c = 0; c < 3; ++c) {
+        const int offset = y * serial.WidthStep() + x * 3 + c;
+        ASSERT_NEAR(ExpectedValue(pixel, c, mask_value, color[c]),
+                    serial.PixelData()[offset], 1)
+            << x << ", " << y << ", " << c;
+        ASSERT_EQ(serial.PixelData()[offset], parallel.PixelData()[offset]);
+      }
+    }
+  }
+}
+
+// Recolors 1080p SRGB frames with a 512x512 mask on range(0) threads.
+void BM_RecolorCpu(benchmark::State& state) {
+  CalculatorGraphConfig config;
+  *config.add_node() = MakeNode(0, 0, 255, "RED", state.range(0));
+  config.add_input_stream("image");
+  config.add_input_stream("mask");
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("output_image", &config, &output_packets);
+  CalculatorGraph graph(config);
+  MEDIAPIPE_CHECK_OK(graph.StartRun({}));
+
+  const Packet image =
+      Adopt(MakeImage(ImageFormat::SRGB, 1920, 1080, 0).release());
+  const Packet mask =
+      Adopt(MakeImage(ImageFormat::GRAY8, 512, 512, 0).release());
+  int64 timestamp = 0;
+  for (auto _ : state) {
+    MEDIAPIPE_CHECK_OK(
+        graph.AddPacketToInputStream("image", image.At(Timestamp(timestamp))));
+    MEDIAPIPE_CHECK_OK(
+        graph.AddPacketToInputStream("mask", mask.At(Timestamp(timestamp))));
+    ++timestamp;
+    MEDIAPIPE_CHECK_OK(graph.WaitUntilIdle());
+    output_packets.clear();
+  }
+  MEDIAPIPE_CHECK_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_CHECK_OK(graph.WaitUntilDone());
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_RecolorCpu)->Arg(1)->Arg(4);
+
+}  // namespace
+
+}  // namespace mediapipe
@@ -17,7 +17,9 @@
 #include <algorithm>
 #include <memory>
 #include <string>
+#include <utility>
 
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/substitute.h"
 #include "libyuv/scale.h"
@@ -27,6 +29,7 @@
 #include "mediapipe/framework/formats/image_format.pb.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/formats/image_frame_pool.h"
 #include "mediapipe/framework/formats/video_stream_header.h"
 #include "mediapipe/framework/formats/yuv_image.h"
 #include "mediapipe/framework/port/image_resizer.h"
@@ -92,13 +95,35 @@ void CropImageFrame(const ImageFrame& original, int col_start, int row_start,
   }
 }
 
+// Sets cropped to a view of the crop_width x crop_height region of the planes
+// of an I420 original, without copying.  col_start and row_start must be
+// even.  original must outlive cropped.
+void CropYUVImage(const YUVImage& original, int col_start, int row_start,
+                  int crop_width, int crop_height, YUVImage* cropped) {
+  uint8* y = const_cast<uint8*>(original.data(0)) +
+             row_start * original.stride(0) + col_start;
+  uint8* u = const_cast<uint8*>(original.data(1)) +
+             row_start / 2 * original.stride(1) + col_start / 2;
+  uint8* v = const_cast<uint8*>(original.data(2)) +
+             row_start / 2 * original.stride(2) + col_start / 2;
+  cropped->Initialize(original.fourcc(), /*deallocation_function=*/nullptr,
+                      y, original.stride(0), u, original.stride(1), v,
+                      original.stride(2), crop_width, crop_height,
+                      original.bit_depth());
+  cropped->set_matrix_coefficients(original.matrix_coefficients());
+  cropped->set_full_range(original.full_range());
+}
+
 }  // namespace
 
 // Crops and scales an ImageFrame or YUVImage according to the options;
 // The output can be cropped and scaled ImageFrame with the SRGB format. If the
-// input is a YUVImage, the output can be a scaled YUVImage (the scaling is done
-// using libyuv). Cropping is not yet supported for a YUVImage to a scaled
-// YUVImage conversion.
+// input is a YUVImage, the output can be a cropped and scaled YUVImage (the
+// scaling is done using libyuv). A YUVImage is cropped at an even row and
+// column, so that its chroma planes stay aligned with its luma plane; if
+// needed, the crop is moved up and left by one pixel.  When converting a
+// YUVImage to SRGB, only the cropped region is converted if the crop starts at
+// an even row and column.
 //
 // Example config:
 // node {
@@ -179,6 +204,7 @@ class ScaleImageCalculator : public CalculatorBase {
       cc->Outputs().Get(output_data_id).Set<YUVImage>();
     } else {
       cc->Outputs().Get(output_data_id).Set<ImageFrame>();
+      cc->UseService(kImageFramePoolService);
     }
 
     if (cc->Inputs().HasTag("OVERRIDE_OPTIONS")) {
@@ -550,21 +576,35 @@ ScaleImageCalculator::~ScaleImageCalculator() {}
         &cc->Inputs().Get(input_data_id_).Get<YUVImage>();
     RETURN_IF_ERROR(ValidateYUVImage(cc, *yuv_image));
 
+    const bool crop =
+        crop_width_ < input_width_ || crop_height_ < input_height_;
     if (output_format_ == ImageFormat::SRGB) {
-      // TODO: For ease of implementation, YUVImage is converted to
-      // ImageFrame immediately, before cropping and scaling. Investigate how to
-      // make color space conversion more efficient when cropping or scaling is
-      // also needed.
-      image_frame_util::YUVImageToImageFrame(*yuv_image, &converted_image_frame,
-                                             options_.use_bt709());
+      // Convert only the cropped region if it is aligned with the chroma
+      // planes.  Otherwise, the YUVImage is converted to ImageFrame
+      // immediately, and cropped below.
+      if (crop && row_start_ % 2 == 0 && col_start_ % 2 == 0) {
+        cc->GetCounter("Crops")->Increment();
+        YUVImage cropped_yuv_image;
+        CropYUVImage(*yuv_image, col_start_, row_start_, crop_width_,
+                     crop_height_, &cropped_yuv_image);
+        image_frame_util::YUVImageToImageFrame(
+            cropped_yuv_image, &converted_image_frame, options_.use_bt709());
+      } else {
+        image_frame_util::YUVImageToImageFrame(
+            *yuv_image, &converted_image_frame, options_.use_bt709());
+      }
       image_frame = &converted_image_frame;
     } else if (output_format_ == ImageFormat::YCBCR420P) {
-      RET_CHECK(row_start_ == 0 && col_start_ == 0 &&
-                crop_width_ == input_width_ && crop_height_ == input_height_)
-          << "ScaleImageCalculator only supports scaling on YUVImages. To crop "
-             "images, the output format must be SRGB.";
-
-      // Scale the YUVImage and output without converting the color space.
+      // Crop and scale the YUVImage and output without converting the color
+      // space.
+      YUVImage cropped_yuv_image;
+      if (crop) {
+        cc->GetCounter("Crops")->Increment();
+        CropYUVImage(*yuv_image, col_start_ - col_start_ % 2,
+                     row_start_ - row_start_ % 2, crop_width_, crop_height_,
+                     &cropped_yuv_image);
+        yuv_image = &cropped_yuv_image;
+      }
       const int y_size = output_width_ * output_height_;
       const int uv_size = output_width_ * output_height_ / 4;
       std::unique_ptr<uint8_t[]> yuv_data(new uint8_t[y_size + uv_size * 2]);
@@ -600,11 +640,15 @@ ScaleImageCalculator::~ScaleImageCalculator() {}
   }
 
   std::unique_ptr<ImageFrame> cropped_image;
-  if (crop_width_ < input_width_ || crop_height_ < input_height_) {
+  // A YUVImage may have been cropped before its conversion.
+  if (crop_width_ < image_frame->Width() ||
+      crop_height_ < image_frame->Height()) {
     cc->GetCounter("Crops")->Increment();
     // TODO Do the crop as a range restrict inside OpenCV code below.
-    cropped_image.reset(new ImageFrame(image_frame->Format(), crop_width_,
-                                       crop_height_, alignment_boundary_));
+    cropped_image = cc->Service(kImageFramePoolService)
+                        .GetObject()
+                        .GetFrame(image_frame->Format(), crop_width_,
+                                  crop_height_, alignment_boundary_);
     if (image_frame->ByteDepth() == 1 || image_frame->ByteDepth() == 2) {
       CropImageFrame(*image_frame, col_start_, row_start_, crop_width_,
                      crop_height_, cropped_image.get());
@@ -621,6 +665,14 @@ ScaleImageCalculator::~ScaleImageCalculator() {}
 
   // Skip later operations if no scaling is necessary.
   if (crop_width_ == output_width_ && crop_height_ == output_height_) {
+    // A YUVImage converted to the output size is output without a copy if it
+    // is aligned.  The input packet holds the YUVImage, not this frame.
+    if (image_frame == &converted_image_frame &&
+        converted_image_frame.IsAligned(alignment_boundary_)) {
+      cropped_image =
+          absl::make_unique<ImageFrame>(std::move(converted_image_frame));
+      image_frame = cropped_image.get();
+    }
     // Efficiently use either the cropped image or the original image.
     if (image_frame == cropped_image.get()) {
       if (options_.set_alignment_padding()) {
@@ -631,7 +683,8 @@ ScaleImageCalculator::~ScaleImageCalculator() {}
           .Get(output_data_id_)
           .Add(cropped_image.release(), cc->InputTimestamp());
     } else {
-      if (options_.alignment_boundary() <= 0 &&
+      if (image_frame != &converted_image_frame &&
+          options_.alignment_boundary() <= 0 &&
           (!options_.set_alignment_padding() || image_frame->IsContiguous())) {
         // Any alignment is acceptable and we don't need to clear the
         // alignment padding (either because the user didn't request it
@@ -657,19 +710,22 @@ ScaleImageCalculator::~ScaleImageCalculator() {}
   }
 
   // Rescale the image frame.
-  std::unique_ptr<ImageFrame> output_frame(new ImageFrame());
+  std::unique_ptr<ImageFrame> output_frame;
   if (image_frame->Width() >= output_width_ &&
       image_frame->Height() >= output_height_) {
     // Downscale.
     cc->GetCounter("Downscales")->Increment();
     cv::Mat input_mat = ::mediapipe::formats::MatView(image_frame);
-    output_frame->Reset(image_frame->Format(), output_width_, output_height_,
-                        alignment_boundary_);
+    output_frame = cc->Service(kImageFramePoolService)
+                       .GetObject()
+                       .GetFrame(image_frame->Format(), output_width_,
+                                 output_height_, alignment_boundary_);
     cv::Mat output_mat = ::mediapipe::formats::MatView(output_frame.get());
     downscaler_->Resize(input_mat, &output_mat);
   } else {
     // Upscale. If upscaling is disallowed, output_width_ and output_height_ are
     // the same as the input/crop width and height.
+    output_frame = absl::make_unique<ImageFrame>();
     image_frame_util::RescaleImageFrame(
         *image_frame, output_width_, output_height_, alignment_boundary_,
         interpolation_algorithm_, output_frame.get());
@@ -0,0 +1,100 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "libyuv/video_common.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/yuv_image.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/util/image_frame_util.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Returns an I420 image whose luma increases along each row, with neutral
+// chroma.
+std::unique_ptr<YUVImage> MakeYuvImage(int width, int height) {
+  const int y_size = width * height;
+  const int uv_size = y_size / 4;
+  std::unique_ptr<uint8_t[]> yuv_data(new uint8_t[y_size + uv_size * 2]);
+  uint8* y = yuv_data.get();
+  uint8* u = y + y_size;
+  uint8* v = u + uv_size;
+  for (int row = 0; row < height; ++row) {
+    for (int col = 0; col < width; ++col) {
+      y[row * width + col] = 16 + col * 3;
+    }
+  }
+  std::fill(u, u + uv_size * 2, 128);
+  return absl::make_unique<YUVImage>(libyuv::FOURCC_I420, std::move(yuv_data),
+                                     y, width, u, width / 2, v, width / 2,
+                                     width, height);
+}
+
+// A YUVImage that is cropped but not scaled is output as an SRGB ImageFrame
+// holding the cropped region, rather than as the input packet.
+TEST(ScaleImageCalculatorTest, CropsYuvImageWithoutScaling) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+    calculator: "ScaleImageCalculator"
+    input_stream: "FRAMES:input"
+    output_stream: "FRAMES:output"
+    options {
+      [mediapipe.ScaleImageCalculatorOptions.ext] {
+        input_format: YCBCR420P
+        output_format: SRGB
+        max_aspect_ratio: "2/1"
+        alignment_boundary: 0
+        set_alignment_padding: false
+      }
+    }
+  )"));
+  // The 64x16 input is cropped to the central 32x16 region.
+  std::unique_ptr<YUVImage> yuv_image = MakeYuvImage(64, 16);
+  ImageFrame expected;
+  image_frame_util::YUVImageToImageFrame(*yuv_image, &expected,
+                                         /*use_bt709=*/false);
+  runner.MutableInputs()->Tag("FRAMES").packets.push_back(
+      Adopt(yuv_image.release()).At(Timestamp(0)));
+  MEDIAPIPE_ASSERT_OK(runner.Run());
+
+  const auto& outputs = runner.Outputs().Tag("FRAMES").packets;
+  ASSERT_EQ(1, outputs.size());
+  ASSERT_TRUE(outputs[0].ValidateAsType<ImageFrame>().ok());
+  const ImageFrame& output = outputs[0].Get<ImageFrame>();
+  EXPECT_EQ(ImageFormat::SRGB, output.Format());
+  ASSERT_EQ(32, output.Width());
+  ASSERT_EQ(16, output.Height());
+  for (int row = 0; row < 16; ++row) {
+    const uint8* output_row = output.PixelData() + row * output.WidthStep();
+    const uint8* expected_row =
+        expected.PixelData() + row * expected.WidthStep() + 16 * 3;
+    for (int i = 0; i < 32 * 3; ++i) {
+      ASSERT_EQ(expected_row[i], output_row[i]) << "row " << row << " at " << i;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,944 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tflite/image_to_tensor_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "mediapipe/framework/port/canonical_errors.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/ret_check.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define IMAGE_TO_TENSOR_USE_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define IMAGE_TO_TENSOR_USE_NEON 1
+#endif
+
+namespace mediapipe {
+namespace image_to_tensor {
+
+namespace {
+
+// A vector of four floats, with the few operations that the kernels below
+// need.  The instruction set is selected at compile time, as in mathutil.h;
+// the scalar version is left to the compiler to vectorize.
+#if defined(IMAGE_TO_TENSOR_USE_SSE2)
+
+typedef __m128 Float4;
+
+inline Float4 Set4(float a, float b, float c, float d) {
+  return _mm_setr_ps(a, b, c, d);
+}
+inline Float4 Load4(const float* src) { return _mm_loadu_ps(src); }
+inline void Store4(float* dst, Float4 v) { _mm_storeu_ps(dst, v); }
+inline Float4 MulAdd4(Float4 v, Float4 scale, Float4 offset) {
+  return _mm_add_ps(_mm_mul_ps(v, scale), offset);
+}
+
+// Converts four bytes to floats.
+inline Float4 Load4(const uint8* src) {
+  int32 bytes;
+  std::memcpy(&bytes, src, sizeof(bytes));
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i v = _mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero);
+  return _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero));
+}
+
+// Converts sixteen bytes to floats.
+inline void Load16(const uint8* src, Float4 out[4]) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+  const __m128i low = _mm_unpacklo_epi8(v, zero);
+  const __m128i high = _mm_unpackhi_epi8(v, zero);
+  out[0] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero));
+  out[1] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero));
+  out[2] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero));
+  out[3] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero));
+}
+
+inline void Transpose4(Float4& row0, Float4& row1, Float4& row2,
+                       Float4& row3) {
+  _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+}
+
+#elif defined(IMAGE_TO_TENSOR_USE_NEON)
+
+typedef float32x4_t Float4;
+
+inline Float4 Set4(float a, float b, float c, float d) {
+  const float values[4] = {a, b, c, d};
+  return vld1q_f32(values);
+}
+inline Float4 Load4(const float* src) { return vld1q_f32(src); }
+inline void Store4(float* dst, Float4 v) { vst1q_f32(dst, v); }
+inline Float4 MulAdd4(Float4 v, Float4 scale, Float4 offset) {
+  return vmlaq_f32(offset, v, scale);
+}
+
+// Converts four bytes to floats.
+inline Float4 Load4(const uint8* src) {
+  uint32 bytes;
+  std::memcpy(&bytes, src, sizeof(bytes));
+  const uint16x8_t v = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(bytes)));
+  return vcvtq_f32_u32(vmovl_u16(vget_low_u16(v)));
+}
+
+// Converts sixteen bytes to floats.
+inline void Load16(const uint8* src, Float4 out[4]) {
+  const uint8x16_t v = vld1q_u8(src);
+  const uint16x8_t low = vmovl_u8(vget_low_u8(v));
+  const uint16x8_t high = vmovl_u8(vget_high_u8(v));
+  out[0] = vcvtq_f32_u32(vmovl_u16(vget_low_u16(low)));
+  out[1] = vcvtq_f32_u32(vmovl_u16(vget_high_u16(low)));
+  out[2] = vcvtq_f32_u32(vmovl_u16(vget_low_u16(high)));
+  out[3] = vcvtq_f32_u32(vmovl_u16(vget_high_u16(high)));
+}
+
+inline void Transpose4(Float4& row0, Float4& row1, Float4& row2,
+                       Float4& row3) {
+  const float32x4x2_t rows01 = vtrnq_f32(row0, row1);
+  const float32x4x2_t rows23 = vtrnq_f32(row2, row3);
+  row0 = vcombine_f32(vget_low_f32(rows01.val[0]),
+                      vget_low_f32(rows23.val[0]));
+  row1 = vcombine_f32(vget_low_f32(rows01.val[1]),
+                      vget_low_f32(rows23.val[1]));
+  row2 = vcombine_f32(vget_high_f32(rows01.val[0]),
+                      vget_high_f32(rows23.val[0]));
+  row3 = vcombine_f32(vget_high_f32(rows01.val[1]),
+                      vget_high_f32(rows23.val[1]));
+}
+
+#else  // Scalar.
+
+struct Float4 {
+  float v[4];
+};
+
+inline Float4 Set4(float a, float b, float c, float d) {
+  return {{a, b, c, d}};
+}
+template <typename T>
+inline Float4 Load4(const T* src) {
+  return {{static_cast<float>(src[0]), static_cast<float>(src[1]),
+           static_cast<float>(src[2]), static_cast<float>(src[3])}};
+}
+inline void Store4(float* dst, Float4 v) {
+  std::memcpy(dst, v.v, sizeof(v.v));
+}
+inline Float4 MulAdd4(Float4 v, Float4 scale, Float4 offset) {
+  for (int i = 0; i < 4; ++i) v.v[i] = v.v[i] * scale.v[i] + offset.v[i];
+  return v;
+}
+
+inline void Load16(const uint8* src, Float4 out[4]) {
+  for (int i = 0; i < 4; ++i) out[i] = Load4(src + 4 * i);
+}
+
+inline void Transpose4(Float4& row0, Float4& row1, Float4& row2,
+                       Float4& row3) {
+  Float4* rows[4] = {&row0, &row1, &row2, &row3};
+  for (int i = 0; i < 4; ++i) {
+    for (int j = i + 1; j < 4; ++j) {
+      std::swap(rows[i]->v[j], rows[j]->v[i]);
+    }
+  }
+}
+
+#endif
+
+// The source samples of one output coordinate along one axis: the two
+// neighboring source indices and the weight of the second one.
+struct Sample {
+  int index0;
+  int index1;
+  float weight;
+};
+
+// Computes the source samples for output coordinates [0, size) that cover
+// [start, start + length) of a source axis of source_size pixels.  Source
+// indices are clamped to the image, which repeats its edge pixels.
+std::vector<Sample> ComputeSamples(float start, float length, int size,
+                                   int source_size) {
+  std::vector<Sample> samples(size);
+  const float scale = length / size;
+  for (int i = 0; i < size; ++i) {
+    const float source = start + (i + 0.5f) * scale - 0.5f;
+    const float source_floor = std::floor(source);
+    Sample& sample = samples[i];
+    if (source_floor < 0) {
+      sample.index0 = 0;
+      sample.weight = 0.f;
+    } else if (source_floor >= source_size - 1) {
+      sample.index0 = source_size - 1;
+      sample.weight = 0.f;
+    } else {
+      sample.index0 = static_cast<int>(source_floor);
+      sample.weight = source - source_floor;
+    }
+    sample.index1 = std::min(sample.index0 + 1, source_size - 1);
+  }
+  return samples;
+}
+
+// Resamples one image row horizontally and normalizes it into dst, which
+// holds columns.size() * num_channels values.  Normalizing before the
+// vertical pass is exact since the bilinear weights sum to one.
+// The number of channels is a template argument so that the channel loop is
+// unrolled.
+template <typename T, int kNumChannels>
+void ResampleRow(const T* src, const std::vector<Sample>& columns,
+                 int image_channels, const Normalization& normalization,
+                 float* dst) {
+  float scale[kNumChannels];
+  float offset[kNumChannels];
+  for (int c = 0; c < kNumChannels; ++c) {
+    scale[c] = normalization.scale[c];
+    offset[c] = normalization.offset[c];
+  }
+  for (const Sample& column : columns) {
+    const T* pixel0 = src + column.index0 * image_channels;
+    const T* pixel1 = src + column.index1 * image_channels;
+    for (int c = 0; c < kNumChannels; ++c) {
+      const float value0 = pixel0[c];
+      const float value1 = pixel1[c];
+      dst[c] = (value0 + column.weight * (value1 - value0)) * scale[c] +
+               offset[c];
+    }
+    dst += kNumChannels;
+  }
+}
+
+template <typename T>
+void ResampleRow(const T* src, const std::vector<Sample>& columns,
+                 int image_channels, int num_channels,
+                 const Normalization& normalization, float* dst) {
+  switch (num_channels) {
+    case 1:
+      ResampleRow<T, 1>(src, columns, image_channels, normalization, dst);
+      break;
+    case 2:
+      ResampleRow<T, 2>(src, columns, image_channels, normalization, dst);
+      break;
+    case 3:
+      ResampleRow<T, 3>(src, columns, image_channels, normalization, dst);
+      break;
+    default:
+      ResampleRow<T, 4>(src, columns, image_channels, normalization, dst);
+      break;
+  }
+}
+
+// Blends size contiguous values of two rows into dst.  The compiler
+// vectorizes this loop.
+template <typename T>
+void BlendRows(const T* __restrict row0, const T* __restrict row1,
+               float weight, int size, float* __restrict dst) {
+  for (int i = 0; i < size; ++i) {
+    const float value0 = row0[i];
+    dst[i] = value0 + weight * (row1[i] - value0);
+  }
+}
+
+// Fills the left and right letterbox padding of an output row, with
+// padding_value if constant_padding is true, otherwise with the edge pixels of
+// the row.
+void PadRow(const LetterboxRegion& letterbox, int output_width,
+            int num_channels, const float* padding_value,
+            bool constant_padding, float* dst) {
+  const int right = letterbox.left + letterbox.width;
+  const float* left_value =
+      constant_padding ? padding_value : dst + letterbox.left * num_channels;
+  const float* right_value =
+      constant_padding ? padding_value : dst + (right - 1) * num_channels;
+  for (int x = 0; x < letterbox.left; ++x) {
+    std::memcpy(dst + x * num_channels, left_value,
+                num_channels * sizeof(float));
+  }
+  for (int x = right; x < output_width; ++x) {
+    std::memcpy(dst + x * num_channels, right_value,
+                num_channels * sizeof(float));
+  }
+}
+
+// Fills the top and bottom letterbox padding of the output, with
+// padding_value if constant_padding is true, otherwise with the edge rows of
+// the letterbox region, which must have been written.
+void PadRows(const LetterboxRegion& letterbox, int output_width,
+             int output_height, int num_channels, const float* padding_value,
+             bool constant_padding, bool flip_vertically,
+             float* tensor_buffer) {
+  const int output_row_size = output_width * num_channels;
+  auto output_row = [&](int y) {
+    return tensor_buffer +
+           (flip_vertically ? output_height - 1 - y : y) * output_row_size;
+  };
+  const int bottom = letterbox.top + letterbox.height;
+  for (int y = 0; y < output_height; ++y) {
+    if (y >= letterbox.top && y < bottom) continue;
+    float* dst = output_row(y);
+    if (constant_padding) {
+      for (int x = 0; x < output_width; ++x) {
+        std::memcpy(dst + x * num_channels, padding_value,
+                    num_channels * sizeof(float));
+      }
+    } else {
+      const int edge = y < letterbox.top ? letterbox.top : bottom - 1;
+      std::memcpy(dst, output_row(edge), output_row_size * sizeof(float));
+    }
+  }
+}
+
+template <typename T>
+void ResizeAndNormalizeImpl(const ImageFrame& image, const CropRegion& crop,
+                            const LetterboxRegion& letterbox, int output_width,
+                            int output_height, int num_channels,
+                            const Normalization& normalization,
+                            bool constant_padding, bool flip_vertically,
+                            float* tensor_buffer) {
+  const int image_channels = image.NumberOfChannels();
+  const int row_size = letterbox.width * num_channels;
+  const int output_row_size = output_width * num_channels;
+  const std::vector<Sample> columns =
+      ComputeSamples(crop.x_min, crop.width, letterbox.width, image.Width());
+  const std::vector<Sample> rows =
+      ComputeSamples(crop.y_min, crop.height, letterbox.height, image.Height());
+
+  auto output_row = [&](int y) {
+    return tensor_buffer +
+           (flip_vertically ? output_height - 1 - y : y) * output_row_size;
+  };
+  auto image_row = [&](int y) {
+    return reinterpret_cast<const T*>(image.PixelData() +
+                                      y * image.WidthStep());
+  };
+
+  // When the rows are upscaled, consecutive output rows mostly share their
+  // source rows, so each source row is resampled horizontally once and the
+  // two most recent ones are kept.  When the rows are downscaled, the two
+  // source rows are blended first over the columns that are read, so that
+  // each output row is resampled horizontally once.
+  const bool blend_rows_first = letterbox.height < crop.height;
+  const int column_begin = columns.front().index0;
+  const int blended_size =
+      (columns.back().index1 + 1 - column_begin) * image_channels;
+  std::vector<Sample> blended_columns;
+  std::vector<float> buffer0;
+  std::vector<float> buffer1;
+  if (blend_rows_first) {
+    blended_columns = columns;
+    for (Sample& column : blended_columns) {
+      column.index0 -= column_begin;
+      column.index1 -= column_begin;
+    }
+    buffer0.resize(blended_size);
+  } else {
+    buffer0.resize(row_size);
+    buffer1.resize(row_size);
+  }
+  float* resampled[2] = {buffer0.data(), buffer1.data()};
+  int resampled_index[2] = {-1, -1};
+
+  std::array<float, 4> padding_value;
+  for (int c = 0; c < num_channels; ++c) {
+    padding_value[c] = normalization.offset[c];
+  }
+
+  for (int y = 0; y < letterbox.height; ++y) {
+    const Sample& row = rows[y];
+    float* dst = output_row(letterbox.top + y);
+    if (blend_rows_first) {
+      const int offset = column_begin * image_channels;
+      BlendRows(image_row(row.index0) + offset, image_row(row.index1) + offset,
+                row.weight, blended_size, resampled[0]);
+      ResampleRow(resampled[0], blended_columns, image_channels, num_channels,
+                  normalization, dst + letterbox.left * num_channels);
+    } else {
+      if (resampled_index[1] == row.index0) {
+        std::swap(resampled[0], resampled[1]);
+        std::swap(resampled_index[0], resampled_index[1]);
+      }
+      if (resampled_index[0] != row.index0) {
+        ResampleRow(image_row(row.index0), columns, image_channels,
+                    num_channels, normalization, resampled[0]);
+        resampled_index[0] = row.index0;
+      }
+      if (row.weight != 0.f && resampled_index[1] != row.index1) {
+        ResampleRow(image_row(row.index1), columns, image_channels,
+                    num_channels, normalization, resampled[1]);
+        resampled_index[1] = row.index1;
+      }
+      BlendRows(resampled[0], row.weight != 0.f ? resampled[1] : resampled[0],
+                row.weight, row_size, dst + letterbox.left * num_channels);
+    }
+
+    PadRow(letterbox, output_width, num_channels, padding_value.data(),
+           constant_padding, dst);
+  }
+  PadRows(letterbox, output_width, output_height, num_channels,
+          padding_value.data(), constant_padding, flip_vertically,
+          tensor_buffer);
+}
+
+// The samples of one plane of a YUVImage, of num_channels interleaved 8-bit
+// channels, for the output rows and columns of a letterbox region.  Each
+// output row is resampled from two blended source rows, or, if the crop
+// region is rotated by 90 or 270 degrees, from two source columns.
+struct PlaneSampling {
+  const uint8* data;
+  int stride;
+  int num_channels;
+  // If true, rows sample the columns of the plane and columns sample its
+  // rows.
+  bool transposed;
+  std::vector<Sample> rows;
+  // Relative to column_begin, the first column that is read, unless
+  // transposed.
+  std::vector<Sample> columns;
+  int column_begin;
+  std::vector<float> blended;
+};
+
+// Returns the samples of a width x height plane whose pixels cover `scale`
+// pixels of the image on each axis.
+PlaneSampling MakePlaneSampling(const uint8* data, int stride, int width,
+                                int height, int num_channels, float scale,
+                                const CropRegion& crop,
+                                const LetterboxRegion& letterbox) {
+  PlaneSampling plane;
+  plane.data = data;
+  plane.stride = stride;
+  plane.num_channels = num_channels;
+  plane.transposed = crop.rotation == 90 || crop.rotation == 270;
+  // The crop region on the axes of the plane.  A quarter turn swaps its
+  // width and height.
+  const float x_center = (crop.x_min + crop.width / 2) / scale;
+  const float y_center = (crop.y_min + crop.height / 2) / scale;
+  const float x_extent = (plane.transposed ? crop.height : crop.width) / scale;
+  const float y_extent = (plane.transposed ? crop.width : crop.height) / scale;
+  std::vector<Sample> x_samples =
+      ComputeSamples(x_center - x_extent / 2, x_extent,
+                     plane.transposed ? letterbox.height : letterbox.width,
+                     width);
+  std::vector<Sample> y_samples =
+      ComputeSamples(y_center - y_extent / 2, y_extent,
+                     plane.transposed ? letterbox.width : letterbox.height,
+                     height);
+  // Turning the region clockwise makes the output run against the plane
+  // axes: 90 degrees reverses x, 180 degrees both axes, 270 degrees y.
+  if (crop.rotation == 90 || crop.rotation == 180) {
+    std::reverse(x_samples.begin(), x_samples.end());
+  }
+  if (crop.rotation == 180 || crop.rotation == 270) {
+    std::reverse(y_samples.begin(), y_samples.end());
+  }
+  if (plane.transposed) {
+    plane.rows = std::move(x_samples);
+    plane.columns = std::move(y_samples);
+    plane.column_begin = 0;
+    return plane;
+  }
+  plane.rows = std::move(y_samples);
+  plane.columns = std::move(x_samples);
+  plane.column_begin = std::min(plane.columns.front().index0,
+                                plane.columns.back().index0);
+  int column_end = 0;
+  for (Sample& column : plane.columns) {
+    column.index0 -= plane.column_begin;
+    column.index1 -= plane.column_begin;
+    column_end = std::max(column_end, column.index1 + 1);
+  }
+  plane.blended.resize(column_end * num_channels);
+  return plane;
+}
+
+// Resamples output row y of plane into dst, which holds
+// plane->columns.size() * plane->num_channels values.
+void ResamplePlaneRow(int y, PlaneSampling* plane, float* dst) {
+  static const Normalization kIdentity = {{{1.f, 1.f, 1.f, 1.f}},
+                                          {{0.f, 0.f, 0.f, 0.f}}};
+  const Sample& row = plane->rows[y];
+  const int num_channels = plane->num_channels;
+  if (plane->transposed) {
+    // Each output pixel blends two pixels of two source rows.  This reads
+    // the plane with a stride, but only once per output pixel.
+    const uint8* column0 = plane->data + row.index0 * num_channels;
+    const uint8* column1 = plane->data + row.index1 * num_channels;
+    for (const Sample& column : plane->columns) {
+      const int offset0 = column.index0 * plane->stride;
+      const int offset1 = column.index1 * plane->stride;
+      for (int c = 0; c < num_channels; ++c) {
+        const float value00 = column0[offset0 + c];
+        const float value01 = column1[offset0 + c];
+        const float value10 = column0[offset1 + c];
+        const float value11 = column1[offset1 + c];
+        const float value0 = value00 + row.weight * (value01 - value00);
+        const float value1 = value10 + row.weight * (value11 - value10);
+        *dst++ = value0 + column.weight * (value1 - value0);
+      }
+    }
+    return;
+  }
+  const int offset = plane->column_begin * num_channels;
+  BlendRows(plane->data + row.index0 * plane->stride + offset,
+            plane->data + row.index1 * plane->stride + offset, row.weight,
+            plane->blended.size(), plane->blended.data());
+  ResampleRow(plane->blended.data(), plane->columns, num_channels,
+              num_channels, kIdentity, dst);
+}
+
+// Coefficients of the conversion from 8-bit YCbCr to RGB:
+//   r = y_scale * (Y - y_offset) + r_cr * (Cr - 128)
+//   g = y_scale * (Y - y_offset) + g_cb * (Cb - 128) + g_cr * (Cr - 128)
+//   b = y_scale * (Y - y_offset) + b_cb * (Cb - 128)
+struct YuvToRgb {
+  float y_scale;
+  float y_offset;
+  float r_cr;
+  float g_cb;
+  float g_cr;
+  float b_cb;
+};
+
+// Returns the BT.709 conversion if bt709 is true, otherwise the BT.601 one.
+// Limited range values span [16, 235] for Y and [16, 240] for Cb and Cr.
+YuvToRgb MakeYuvToRgb(bool bt709, bool full_range) {
+  const float kr = bt709 ? 0.2126f : 0.299f;
+  const float kb = bt709 ? 0.0722f : 0.114f;
+  const float kg = 1.f - kr - kb;
+  const float y_scale = full_range ? 1.f : 255.f / 219.f;
+  const float c_scale = full_range ? 1.f : 255.f / 224.f;
+  YuvToRgb conversion;
+  conversion.y_scale = y_scale;
+  conversion.y_offset = full_range ? 0.f : 16.f;
+  conversion.r_cr = c_scale * 2.f * (1.f - kr);
+  conversion.g_cb = -c_scale * 2.f * (1.f - kb) * kb / kg;
+  conversion.g_cr = -c_scale * 2.f * (1.f - kr) * kr / kg;
+  conversion.b_cb = c_scale * 2.f * (1.f - kb);
+  return conversion;
+}
+
+// Converts width resampled YCbCr pixels to normalized RGB in dst.  cb and cr
+// point to the chroma values of the first pixel, which are chroma_step
+// values apart.
+void ConvertYuvRow(const float* y, const float* cb, const float* cr,
+                   int chroma_step, int width, const YuvToRgb& conversion,
+                   const Normalization& normalization, float* dst) {
+  for (int x = 0; x < width; ++x) {
+    const float luma = conversion.y_scale * (y[x] - conversion.y_offset);
+    const float u = cb[x * chroma_step] - 128.f;
+    const float v = cr[x * chroma_step] - 128.f;
+    const float rgb[3] = {
+        luma + conversion.r_cr * v,
+        luma + conversion.g_cb * u + conversion.g_cr * v,
+        luma + conversion.b_cb * u,
+    };
+    for (int c = 0; c < 3; ++c) {
+      const float value = std::min(std::max(rgb[c], 0.f), 255.f);
+      dst[x * 3 + c] = value * normalization.scale[c] + normalization.offset[c];
+    }
+  }
+}
+
+// Normalizes size contiguous values, where value i is normalized with
+// scale[i % 4] and offset[i % 4].
+template <typename T>
+void NormalizeValues(const T* src, int size, const float* scale,
+                     const float* offset, float* dst) {
+  const Float4 scale4 = Set4(scale[0], scale[1], scale[2], scale[3]);
+  const Float4 offset4 = Set4(offset[0], offset[1], offset[2], offset[3]);
+  int i = 0;
+  for (; i + 4 <= size; i += 4) {
+    Store4(dst + i, MulAdd4(Load4(src + i), scale4, offset4));
+  }
+  for (; i < size; ++i) {
+    dst[i] = src[i] * scale[i % 4] + offset[i % 4];
+  }
+}
+
+template <>
+void NormalizeValues<uint8>(const uint8* src, int size, const float* scale,
+                            const float* offset, float* dst) {
+  const Float4 scale4 = Set4(scale[0], scale[1], scale[2], scale[3]);
+  const Float4 offset4 = Set4(offset[0], offset[1], offset[2], offset[3]);
+  int i = 0;
+  for (; i + 16 <= size; i += 16) {
+    Float4 values[4];
+    Load16(src + i, values);
+    for (int j = 0; j < 4; ++j) {
+      Store4(dst + i + 4 * j, MulAdd4(values[j], scale4, offset4));
+    }
+  }
+  for (; i + 4 <= size; i += 4) {
+    Store4(dst + i, MulAdd4(Load4(src + i), scale4, offset4));
+  }
+  for (; i < size; ++i) {
+    dst[i] = src[i] * scale[i % 4] + offset[i % 4];
+  }
+}
+
+// Normalizes the first three channels of width four-channel pixels.  Each
+// pixel is stored as four values, the last of which is overwritten by the
+// next pixel, so the last pixel is normalized separately.
+template <typename T>
+void NormalizeDroppingAlpha(const T* src, int width,
+                            const Normalization& normalization, float* dst) {
+  const Float4 scale4 = Set4(normalization.scale[0], normalization.scale[1],
+                             normalization.scale[2], normalization.scale[3]);
+  const Float4 offset4 =
+      Set4(normalization.offset[0], normalization.offset[1],
+           normalization.offset[2], normalization.offset[3]);
+  int x = 0;
+  for (; x + 1 < width; ++x) {
+    Store4(dst + 3 * x, MulAdd4(Load4(src + 4 * x), scale4, offset4));
+  }
+  for (int c = 0; c < 3; ++c) {
+    dst[3 * x + c] =
+        src[4 * x + c] * normalization.scale[c] + normalization.offset[c];
+  }
+}
+
+template <>
+void NormalizeDroppingAlpha<uint8>(const uint8* src, int width,
+                                   const Normalization& normalization,
+                                   float* dst) {
+  const Float4 scale4 = Set4(normalization.scale[0], normalization.scale[1],
+                             normalization.scale[2], normalization.scale[3]);
+  const Float4 offset4 =
+      Set4(normalization.offset[0], normalization.offset[1],
+           normalization.offset[2], normalization.offset[3]);
+  int x = 0;
+  for (; x + 4 < width; x += 4) {
+    Float4 pixels[4];
+    Load16(src + 4 * x, pixels);
+    for (int j = 0; j < 4; ++j) {
+      Store4(dst + 3 * (x + j), MulAdd4(pixels[j], scale4, offset4));
+    }
+  }
+  for (; x + 1 < width; ++x) {
+    Store4(dst + 3 * x, MulAdd4(Load4(src + 4 * x), scale4, offset4));
+  }
+  for (int c = 0; c < 3; ++c) {
+    dst[3 * x + c] =
+        src[4 * x + c] * normalization.scale[c] + normalization.offset[c];
+  }
+}
+
+template <typename T>
+void NormalizeImageImpl(const ImageFrame& image, int num_channels,
+                        const Normalization& normalization,
+                        bool flip_vertically, float* tensor_buffer) {
+  const int width = image.Width();
+  const int height = image.Height();
+  const int image_channels = image.NumberOfChannels();
+  const int row_size = width * num_channels;
+
+  // Contiguous values can be normalized regardless of pixel boundaries if
+  // the normalization repeats every four values.
+  bool uniform = true;
+  for (int c = 1; c < num_channels; ++c) {
+    uniform = uniform && normalization.scale[c] == normalization.scale[0] &&
+              normalization.offset[c] == normalization.offset[0];
+  }
+  float scale[4];
+  float offset[4];
+  for (int i = 0; i < 4; ++i) {
+    scale[i] = normalization.scale[i % num_channels];
+    offset[i] = normalization.offset[i % num_channels];
+  }
+
+  for (int y = 0; y < height; ++y) {
+    const T* src = reinterpret_cast<const T*>(
+        image.PixelData() +
+        (flip_vertically ? height - 1 - y : y) * image.WidthStep());
+    float* dst = tensor_buffer + y * row_size;
+    if (image_channels == num_channels &&
+        (uniform || 4 % num_channels == 0)) {
+      NormalizeValues(src, row_size, scale, offset, dst);
+    } else if (image_channels == 4 && num_channels == 3) {
+      NormalizeDroppingAlpha(src, width, normalization, dst);
+    } else {
+      for (int x = 0; x < width; ++x) {
+        for (int c = 0; c < num_channels; ++c) {
+          *dst++ = src[c] * normalization.scale[c] + normalization.offset[c];
+        }
+        src += image_channels;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+Normalization RangeNormalization(bool zero_center) {
+  Normalization normalization;
+  if (zero_center) {
+    // [-1,1]
+    normalization.scale.fill(1.0f / 127.5f);
+    normalization.offset.fill(-1.0f);
+  } else {
+    // [0,1]
+    normalization.scale.fill(1.0f / 255.0f);
+    normalization.offset.fill(0.0f);
+  }
+  return normalization;
+}
+
+LetterboxRegion ComputeLetterboxRegion(float crop_width, float crop_height,
+                                       int output_width, int output_height,
+                                       bool keep_aspect_ratio) {
+  if (!keep_aspect_ratio) {
+    return {0, 0, output_width, output_height};
+  }
+  const float scale = std::min(output_width / crop_width,
+                               output_height / crop_height);
+  const int width = std::max(
+      1, std::min<int>(std::round(crop_width * scale), output_width));
+  const int height = std::max(
+      1, std::min<int>(std::round(crop_height * scale), output_height));
+  return {(output_width - width) / 2, (output_height - height) / 2, width,
+          height};
+}
+
+::mediapipe::Status ResizeAndNormalize(const ImageFrame& image,
+                                       const CropRegion& crop,
+                                       const LetterboxRegion& letterbox,
+                                       int output_width, int output_height,
+                                       int num_channels,
+                                       const Normalization& normalization,
+                                       bool constant_padding,
+                                       bool flip_vertically,
+                                       float* tensor_buffer) {
+  RET_CHECK(tensor_buffer);
+  RET_CHECK(!image.IsEmpty());
+  RET_CHECK_GT(crop.width, 0.f);
+  RET_CHECK_GT(crop.height, 0.f);
+  RET_CHECK_EQ(crop.rotation, 0)
+      << "Rotated crop regions are only supported for YUVImages.";
+  RET_CHECK(num_channels >= 1 && num_channels <= 4 &&
+            num_channels <= image.NumberOfChannels())
+      << "Cannot output " << num_channels << " channels from an image with "
+      << image.NumberOfChannels() << " channels.";
+  RET_CHECK(letterbox.width > 0 && letterbox.height > 0 &&
+            letterbox.left >= 0 && letterbox.top >= 0 &&
+            letterbox.left + letterbox.width <= output_width &&
+            letterbox.top + letterbox.height <= output_height)
+      << "The letterbox region must lie within the output.";
+
+  if (image.ByteDepth() == 1) {
+    ResizeAndNormalizeImpl<uint8>(image, crop, letterbox, output_width,
+                                  output_height, num_channels, normalization,
+                                  constant_padding, flip_vertically,
+                                  tensor_buffer);
+  } else if (image.ByteDepth() == 4) {
+    ResizeAndNormalizeImpl<float>(image, crop, letterbox, output_width,
+                                  output_height, num_channels, normalization,
+                                  constant_padding, flip_vertically,
+                                  tensor_buffer);
+  } else {
+    return ::mediapipe::InvalidArgumentError(
+        "Only byte-based (8 bit) and float (32 bit) images supported.");
+  }
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status ResizeAndNormalizeYuv(const YUVImage& image,
+                                          const CropRegion& crop,
+                                          const LetterboxRegion& letterbox,
+                                          int output_width, int output_height,
+                                          const Normalization& normalization,
+                                          bool constant_padding,
+                                          bool flip_vertically,
+                                          float* tensor_buffer) {
+  RET_CHECK(tensor_buffer);
+  RET_CHECK(image.width() > 0 && image.height() > 0);
+  RET_CHECK_EQ(image.bit_depth(), 8) << "Only 8-bit YUVImages are supported.";
+  RET_CHECK_GT(crop.width, 0.f);
+  RET_CHECK_GT(crop.height, 0.f);
+  RET_CHECK(crop.rotation == 0 || crop.rotation == 90 ||
+            crop.rotation == 180 || crop.rotation == 270)
+      << "Crop regions can only be rotated by multiples of 90 degrees.";
+  RET_CHECK(letterbox.width > 0 && letterbox.height > 0 &&
+            letterbox.left >= 0 && letterbox.top >= 0 &&
+            letterbox.left + letterbox.width <= output_width &&
+            letterbox.top + letterbox.height <= output_height)
+      << "The letterbox region must lie within the output.";
+
+  // The chroma planes are subsampled by two on both axes.  Semi-planar
+  // formats interleave Cb and Cr in the second plane.
+  const int chroma_width = (image.width() + 1) / 2;
+  const int chroma_height = (image.height() + 1) / 2;
+  bool interleaved;
+  int cb_index;
+  switch (image.fourcc()) {
+    case libyuv::FOURCC_I420:
+      interleaved = false;
+      cb_index = 1;
+      break;
+    case libyuv::FOURCC_YV12:
+      interleaved = false;
+      cb_index = 2;
+      break;
+    case libyuv::FOURCC_NV12:
+      interleaved = true;
+      cb_index = 0;
+      break;
+    case libyuv::FOURCC_NV21:
+      interleaved = true;
+      cb_index = 1;
+      break;
+    default:
+      return ::mediapipe::InvalidArgumentError(
+          "Only I420, YV12, NV12 and NV21 YUVImages are supported.");
+  }
+
+  PlaneSampling luma =
+      MakePlaneSampling(image.data(0), image.stride(0), image.width(),
+                        image.height(), 1, 1.f, crop, letterbox);
+  std::vector<PlaneSampling> chroma;
+  if (interleaved) {
+    chroma.push_back(MakePlaneSampling(image.data(1), image.stride(1),
+                                       chroma_width, chroma_height, 2, 2.f,
+                                       crop, letterbox));
+  } else {
+    for (int plane = 1; plane <= 2; ++plane) {
+      chroma.push_back(MakePlaneSampling(image.data(plane),
+                                         image.stride(plane), chroma_width,
+                                         chroma_height, 1, 2.f, crop,
+                                         letterbox));
+    }
+  }
+  std::vector<float> luma_row(letterbox.width);
+  std::vector<float> chroma_row(letterbox.width * 2);
+  // Where the Cb and Cr values of the first pixel are in chroma_row, and how
+  // far apart the values of consecutive pixels are.
+  const float* cb = chroma_row.data() + (interleaved ? cb_index : 0);
+  const float* cr = chroma_row.data() + (interleaved ? 1 - cb_index : 0);
+  int chroma_step = 2;
+  if (!interleaved) {
+    chroma_step = 1;
+    const int cr_index = cb_index == 1 ? 2 : 1;
+    cb = chroma_row.data() + (cb_index - 1) * letterbox.width;
+    cr = chroma_row.data() + (cr_index - 1) * letterbox.width;
+  }
+
+  const YuvToRgb conversion = MakeYuvToRgb(
+      image.matrix_coefficients() ==
+          YUVImage::COLOR_MATRIX_COEFFICIENTS_BT709,
+      image.full_range());
+  const int output_row_size = output_width * 3;
+  for (int y = 0; y < letterbox.height; ++y) {
+    ResamplePlaneRow(y, &luma, luma_row.data());
+    for (int plane = 0; plane < chroma.size(); ++plane) {
+      ResamplePlaneRow(y, &chroma[plane],
+                       chroma_row.data() + plane * letterbox.width);
+    }
+    const int output_y = letterbox.top + y;
+    float* dst =
+        tensor_buffer +
+        (flip_vertically ? output_height - 1 - output_y : output_y) *
+            output_row_size;
+    ConvertYuvRow(luma_row.data(), cb, cr, chroma_step, letterbox.width,
+                  conversion, normalization, dst + letterbox.left * 3);
+    PadRow(letterbox, output_width, 3, normalization.offset.data(),
+           constant_padding, dst);
+  }
+  PadRows(letterbox, output_width, output_height, 3,
+          normalization.offset.data(), constant_padding, flip_vertically,
+          tensor_buffer);
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status NormalizeImage(const ImageFrame& image, int num_channels,
+                                   const Normalization& normalization,
+                                   bool flip_vertically,
+                                   float* tensor_buffer) {
+  RET_CHECK(tensor_buffer);
+  RET_CHECK(num_channels >= 1 && num_channels <= 4 &&
+            num_channels <= image.NumberOfChannels())
+      << "Cannot output " << num_channels << " channels from an image with "
+      << image.NumberOfChannels() << " channels.";
+
+  if (image.ByteDepth() == 1) {
+    NormalizeImageImpl<uint8>(image, num_channels, normalization,
+                              flip_vertically, tensor_buffer);
+  } else if (image.ByteDepth() == 4) {
+    NormalizeImageImpl<float>(image, num_channels, normalization,
+                              flip_vertically, tensor_buffer);
+  } else {
+    return ::mediapipe::InvalidArgumentError(
+        "Only byte-based (8 bit) and float (32 bit) images supported.");
+  }
+  return ::mediapipe::OkStatus();
+}
+
+void CopyMatrixToTensor(const Matrix& matrix, bool row_major,
+                        float* tensor_buffer) {
+  const int rows = matrix.rows();
+  const int cols = matrix.cols();
+  const float* src = matrix.data();
+  if (!row_major) {
+    // Matrix is column-major already.
+    std::memcpy(tensor_buffer, src, rows * cols * sizeof(float));
+    return;
+  }
+
+  // Transposes 4x4 blocks in registers, a kBlockSize square at a time so
+  // that the columns being read stay in cache.
+  constexpr int kBlockSize = 32;
+  const int vector_rows = rows - rows % 4;
+  const int vector_cols = cols - cols % 4;
+  for (int row_block = 0; row_block < vector_rows; row_block += kBlockSize) {
+    const int row_end = std::min(row_block + kBlockSize, vector_rows);
+    for (int col_block = 0; col_block < vector_cols;
+         col_block += kBlockSize) {
+      const int col_end = std::min(col_block + kBlockSize, vector_cols);
+      for (int r = row_block; r < row_end; r += 4) {
+        for (int c = col_block; c < col_end; c += 4) {
+          const float* block = src + c * rows + r;
+          Float4 row0 = Load4(block);
+          Float4 row1 = Load4(block + rows);
+          Float4 row2 = Load4(block + 2 * rows);
+          Float4 row3 = Load4(block + 3 * rows);
+          Transpose4(row0, row1, row2, row3);
+          float* dst = tensor_buffer + r * cols + c;
+          Store4(dst, row0);
+          Store4(dst + cols, row1);
+          Store4(dst + 2 * cols, row2);
+          Store4(dst + 3 * cols, row3);
+        }
+      }
+    }
+  }
+  // The remaining columns and rows.
+  for (int r = 0; r < vector_rows; ++r) {
+    for (int c = vector_cols; c < cols; ++c) {
+      tensor_buffer[r * cols + c] = src[c * rows + r];
+    }
+  }
+  for (int r = vector_rows; r < rows; ++r) {
+    for (int c = 0; c < cols; ++c) {
+      tensor_buffer[r * cols + c] = src[c * rows + r];
+    }
+  }
+}
+
+}  // namespace image_to_tensor
+}  // namespace mediapipe
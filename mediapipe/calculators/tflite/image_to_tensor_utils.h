@@ -0,0 +1,130 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Utilities for converting ImageFrames and Matrices into float tensors, as
+// done by TfLiteImageToTensorCalculator and TfLiteConverterCalculator.
+#ifndef MEDIAPIPE_CALCULATORS_TFLITE_IMAGE_TO_TENSOR_UTILS_H_
+#define MEDIAPIPE_CALCULATORS_TFLITE_IMAGE_TO_TENSOR_UTILS_H_
+
+#include <array>
+
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/formats/yuv_image.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe {
+namespace image_to_tensor {
+
+// The per-channel affine map from pixel values to tensor values:
+//   value = pixel * scale[c] + offset[c]
+struct Normalization {
+  std::array<float, 4> scale;
+  std::array<float, 4> offset;
+};
+
+// Maps 8-bit pixel values to [-1,1] if zero_center is true, or to [0,1]
+// otherwise, as TfLiteConverterCalculator does.
+Normalization RangeNormalization(bool zero_center);
+
+// A region of an image, in pixels.  It may extend past the image, in which
+// case the edge pixels of the image are repeated.  The region is rotated
+// clockwise around its center by rotation degrees, a multiple of 90 that is
+// zero if left out of the initializer.  width and height are measured along
+// the rotated axes, as for a rotated NormalizedRect.
+struct CropRegion {
+  float x_min;
+  float y_min;
+  float width;
+  float height;
+  int rotation;
+};
+
+// The placement of the resized crop region within the output, in pixels.
+// The rest of the output is letterbox padding.
+struct LetterboxRegion {
+  int left;
+  int top;
+  int width;
+  int height;
+};
+
+// Returns the region that a crop of crop_width x crop_height is resized to
+// within an output of output_width x output_height.  If keep_aspect_ratio is
+// true, the crop is scaled uniformly and centered as in the FIT scale mode of
+// ImageTransformationCalculator, otherwise it is stretched over the output.
+LetterboxRegion ComputeLetterboxRegion(float crop_width, float crop_height,
+                                       int output_width, int output_height,
+                                       bool keep_aspect_ratio);
+
+// Resizes the crop region of image into the letterbox region of an
+// output_width x output_height x num_channels float tensor, normalizes it,
+// and fills the letterbox padding.  The padding is the normalized value of a
+// zero pixel if constant_padding is true, otherwise the edge pixels of the
+// resized crop are repeated.  Rows are written bottom-up if flip_vertically
+// is true.
+//
+// Resampling is bilinear with pixel centers at half-integer coordinates, as
+// cv::resize with INTER_LINEAR.  The image is read a row at a time and each
+// output row is written once, so no intermediate image is allocated.  The
+// image must have 8-bit or 32-bit float channels, and at least num_channels
+// of them.  The crop region must not be rotated.
+::mediapipe::Status ResizeAndNormalize(const ImageFrame& image,
+                                       const CropRegion& crop,
+                                       const LetterboxRegion& letterbox,
+                                       int output_width, int output_height,
+                                       int num_channels,
+                                       const Normalization& normalization,
+                                       bool constant_padding,
+                                       bool flip_vertically,
+                                       float* tensor_buffer);
+
+// Like ResizeAndNormalize, for an 8-bit YUVImage in the I420, YV12, NV12 or
+// NV21 format, which is converted to RGB as it is resized, so that no RGB
+// image is allocated.  The output has three channels.  The chroma planes are
+// resampled at their own resolution, with their samples centered on 2x2
+// blocks of luma samples.  The conversion uses the BT.709 matrix if the image
+// has those matrix coefficients, and the BT.601 matrix otherwise, and follows
+// the range of the image.  The crop region may be rotated, which is applied
+// while resampling the planes.
+::mediapipe::Status ResizeAndNormalizeYuv(const YUVImage& image,
+                                          const CropRegion& crop,
+                                          const LetterboxRegion& letterbox,
+                                          int output_width, int output_height,
+                                          const Normalization& normalization,
+                                          bool constant_padding,
+                                          bool flip_vertically,
+                                          float* tensor_buffer);
+
+// Normalizes image into a Height() x Width() x num_channels float tensor.
+// Channels past num_channels, such as alpha, are dropped.  Rows are written
+// bottom-up if flip_vertically is true.  The image must have 8-bit or 32-bit
+// float channels, and at least num_channels of them.
+//
+// The rows are converted with SSE2 on x86 and NEON on ARM, and with scalar
+// code elsewhere.
+::mediapipe::Status NormalizeImage(const ImageFrame& image, int num_channels,
+                                   const Normalization& normalization,
+                                   bool flip_vertically,
+                                   float* tensor_buffer);
+
+// Copies matrix into tensor_buffer in row-major order if row_major is true,
+// otherwise in column-major order.
+void CopyMatrixToTensor(const Matrix& matrix, bool row_major,
+                        float* tensor_buffer);
+
+}  // namespace image_to_tensor
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_CALCULATORS_TFLITE_IMAGE_TO_TENSOR_UTILS_H_
@@ -0,0 +1,548 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tflite/image_to_tensor_utils.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/formats/yuv_image.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace image_to_tensor {
+namespace {
+
+// Returns a width x height image whose pixel values are given row by row.
+ImageFrame MakeImage(ImageFormat::Format format, int width, int height,
+                     const std::vector<uint8>& values) {
+  ImageFrame image(format, width, height);
+  const int row_size = width * image.NumberOfChannels();
+  CHECK_EQ(row_size * height, values.size());
+  for (int y = 0; y < height; ++y) {
+    std::copy(values.begin() + y * row_size,
+              values.begin() + (y + 1) * row_size,
+              image.MutablePixelData() + y * image.WidthStep());
+  }
+  return image;
+}
+
+// Normalization that keeps the pixel values, for readable expectations.
+Normalization Identity() {
+  Normalization normalization;
+  normalization.scale.fill(1.f);
+  normalization.offset.fill(0.f);
+  return normalization;
+}
+
+TEST(ImageToTensorUtilsTest, CopiesAndNormalizesSameSize) {
+  ImageFrame image =
+      MakeImage(ImageFormat::SRGB, 2, 2, {0, 255, 51, 102, 0, 255,  //
+                                          255, 0, 0, 0, 0, 0});
+  std::vector<float> tensor(2 * 2 * 3);
+  MEDIAPIPE_ASSERT_OK(ResizeAndNormalize(
+      image, {0, 0, 2, 2}, ComputeLetterboxRegion(2, 2, 2, 2, true), 2, 2, 3,
+      RangeNormalization(/*zero_center=*/false), /*constant_padding=*/true,
+      /*flip_vertically=*/false, tensor.data()));
+  const std::vector<float> expected = {0.f, 1.f, 0.2f, 0.4f, 0.f, 1.f,
+                                       1.f, 0.f, 0.f,  0.f,  0.f, 0.f};
+  for (int i = 0; i < expected.size(); ++i) {
+    EXPECT_NEAR(expected[i], tensor[i], 1e-6) << i;
+  }
+}
+
+TEST(ImageToTensorUtilsTest, DropsAlphaAndFlips) {
+  ImageFrame image = MakeImage(ImageFormat::SRGBA, 1, 2,
+                               {10, 20, 30, 40,  //
+                                50, 60, 70, 80});
+  std::vector<float> tensor(1 * 2 * 3);
+  MEDIAPIPE_ASSERT_OK(ResizeAndNormalize(
+      image, {0, 0, 1, 2}, {0, 0, 1, 2}, 1, 2, 3, Identity(),
+      /*constant_padding=*/true, /*flip_vertically=*/true, tensor.data()));
+  EXPECT_EQ((std::vector<float>{50, 60, 70, 10, 20, 30}), tensor);
+}
+
+TEST(ImageToTensorUtilsTest, DownscalesByAveraging) {
+  // Halving an image samples the centers of 2x2 blocks.
+  ImageFrame image = MakeImage(ImageFormat::GRAY8, 4, 2,
+                               {0, 4, 8, 16,  //
+                                2, 6, 32, 64});
+  std::vector<float> tensor(2);
+  MEDIAPIPE_ASSERT_OK(ResizeAndNormalize(
+      image, {0, 0, 4, 2}, {0, 0, 2, 1}, 2, 1, 1, Identity(),
+      /*constant_padding=*/true, /*flip_vertically=*/false, tensor.data()));
+  EXPECT_EQ((std::vector<float>{3, 30}), tensor);
+}
+
+TEST(ImageToTensorUtilsTest, UpscalesWithClampedEdges) {
+  ImageFrame image = MakeImage(ImageFormat::GRAY8, 2, 1, {0, 100});
+  std::vector<float> tensor(4);
+  MEDIAPIPE_ASSERT_OK(ResizeAndNormalize(
+      image, {0, 0, 2, 1}, {0, 0, 4, 1}, 4, 1, 1, Identity(),
+      /*constant_padding=*/true, /*flip_vertically=*/false, tensor.data()));
+  EXPECT_EQ((std::vector<float>{0, 25, 75, 100}), tensor);
+}
+
+TEST(ImageToTensorUtilsTest, Crops) {
+  ImageFrame image = MakeImage(ImageFormat::GRAY8, 4, 2,
+                               {1, 2, 3, 4,  //
+                                5, 6, 7, 8});
+  std::vector<float> tensor(2 * 2);
+  MEDIAPIPE_ASSERT_OK(ResizeAndNormalize(
+      image, {2, 0, 2, 2}, {0, 0, 2, 2}, 2, 2, 1, Identity(),
+      /*constant_padding=*/true, /*flip_vertically=*/false, tensor.data()));
+  EXPECT_EQ((std::vector<float>{3, 4, 7, 8}), tensor);
+}
+
+TEST(ImageToTensorUtilsTest, CropsAndDownscales) {
+  ImageFrame image = MakeImage(ImageFormat::GRAY8, 4, 4,
+                               {0, 1, 2, 3,    //
+                                4, 5, 6, 7,    //
+                                8, 9, 10, 11,  //
+                                12, 13, 14, 15});
+  std::vector<float> tensor(2);
+  MEDIAPIPE_ASSERT_OK(ResizeAndNormalize(
+      image, {2, 0, 2, 4}, {0, 0, 1, 2}, 1, 2, 1, Identity(),
+      /*constant_padding=*/true, /*flip_vertically=*/false, tensor.data()));
+  EXPECT_EQ((std::vector<float>{4.5, 12.5}), tensor);
+}
+
+TEST(ImageToTensorUtilsTest, ComputesLetterboxRegion) {
+  const LetterboxRegion stretch = ComputeLetterboxRegion(640, 480, 256, 256,
+                                                         false);
+  EXPECT_EQ(0, stretch.left);
+  EXPECT_EQ(0, stretch.top);
+  EXPECT_EQ(256, stretch.width);
+  EXPECT_EQ(256, stretch.height);
+  const LetterboxRegion fit = ComputeLetterboxRegion(640, 480, 256, 256, true);
+  EXPECT_EQ(0, fit.left);
+  EXPECT_EQ(32, fit.top);
+  EXPECT_EQ(256, fit.width);
+  EXPECT_EQ(192, fit.height);
+}
+
+TEST(ImageToTensorUtilsTest, PadsLetterbox) {
+  ImageFrame image = MakeImage(ImageFormat::GRAY8, 2, 1, {10, 20});
+  const LetterboxRegion letterbox = ComputeLetterboxRegion(2, 1, 4, 4, true);
+  ASSERT_EQ(1, letterbox.top);
+  ASSERT_EQ(2, letterbox.height);
+  std::vector<float> tensor(4 * 4);
+
+  Normalization normalization = Identity();
+  normalization.offset.fill(-1.f);
+  MEDIAPIPE_ASSERT_OK(ResizeAndNormalize(
+      image, {0, 0, 2, 1}, letterbox, 4, 4, 1, normalization,
+      /*constant_padding=*/true, /*flip_vertically=*/false, tensor.data()));
+  EXPECT_EQ((std::vector<float>{-1, -1, -1, -1,  //
+                                9, 11.5, 16.5, 19,  //
+                                9, 11.5, 16.5, 19,  //
+                                -1, -1, -1, -1}),
+            tensor);
+
+  MEDIAPIPE_ASSERT_OK(ResizeAndNormalize(
+      image, {0, 0, 2, 1}, {1, 1, 2, 2}, 4, 4, 1, Identity(),
+      /*constant_padding=*/false, /*flip_vertically=*/false, tensor.data()));
+  EXPECT_EQ((std::vector<float>{10, 10, 20, 20,  //
+                                10, 10, 20, 20,  //
+                                10, 10, 20, 20,  //
+                                10, 10, 20, 20}),
+            tensor);
+}
+
+TEST(ImageToTensorUtilsTest, RejectsTooManyChannels) {
+  ImageFrame image = MakeImage(ImageFormat::GRAY8, 1, 1, {0});
+  std::vector<float> tensor(3);
+  EXPECT_FALSE(ResizeAndNormalize(image, {0, 0, 1, 1}, {0, 0, 1, 1}, 1, 1, 3,
+                                  Identity(), /*constant_padding=*/true,
+                                  /*flip_vertically=*/false, tensor.data())
+                   .ok());
+}
+
+// Returns a width x height YUVImage with luma values y(col, row) and
+// constant chroma values cb and cr, in the given format.
+template <typename LumaFunction>
+std::unique_ptr<YUVImage> MakeYuvImage(libyuv::FourCC fourcc, int width,
+                                       int height, LumaFunction y, uint8 cb,
+                                       uint8 cr) {
+  const int chroma_width = (width + 1) / 2;
+  const int chroma_height = (height + 1) / 2;
+  const int chroma_size = chroma_width * chroma_height;
+  auto data = absl::make_unique<uint8[]>(width * height + 2 * chroma_size);
+  uint8* luma = data.get();
+  uint8* chroma = luma + width * height;
+  for (int row = 0; row < height; ++row) {
+    for (int col = 0; col < width; ++col) {
+      luma[row * width + col] = y(col, row);
+    }
+  }
+  uint8* planes[2] = {chroma, chroma + chroma_size};
+  int chroma_stride = chroma_width;
+  if (fourcc == libyuv::FOURCC_NV12 || fourcc == libyuv::FOURCC_NV21) {
+    const bool cb_first = fourcc == libyuv::FOURCC_NV12;
+    for (int i = 0; i < chroma_size; ++i) {
+      chroma[2 * i] = cb_first ? cb : cr;
+      chroma[2 * i + 1] = cb_first ? cr : cb;
+    }
+    chroma_stride = 2 * chroma_width;
+    planes[1] = nullptr;
+  } else {
+    const bool cb_first = fourcc == libyuv::FOURCC_I420;
+    std::fill(planes[0], planes[0] + chroma_size, cb_first ? cb : cr);
+    std::fill(planes[1], planes[1] + chroma_size, cb_first ? cr : cb);
+  }
+  uint8* buffer = data.release();
+  auto image = absl::make_unique<YUVImage>();
+  image->Initialize(fourcc, [buffer]() { delete[] buffer; }, luma, width,
+                    planes[0], chroma_stride, planes[1],
+                    planes[1] ? chroma_width : 0, width, height);
+  return image;
+}
+
+TEST(ImageToTensorUtilsTest, ConvertsYuvFormatsToRgb) {
+  // Limited range BT.601, whose coefficients are commonly rounded to three
+  // decimals.
+  const float y = 100, cb = 90, cr = 170;
+  const float expected[3] = {
+      1.164f * (y - 16) + 1.596f * (cr - 128),
+      1.164f * (y - 16) - 0.392f * (cb - 128) - 0.813f * (cr - 128),
+      1.164f * (y - 16) + 2.017f * (cb - 128)};
+  for (libyuv::FourCC fourcc : {libyuv::FOURCC_I420, libyuv::FOURCC_YV12,
+                                libyuv::FOURCC_NV12, libyuv::FOURCC_NV21}) {
+    auto image = MakeYuvImage(
+        fourcc, 7, 5, [](int, int) { return 100; }, 90, 170);
+    const LetterboxRegion letterbox = ComputeLetterboxRegion(7, 5, 4, 4, true);
+    std::vector<float> tensor(4 * 4 * 3);
+    MEDIAPIPE_ASSERT_OK(ResizeAndNormalizeYuv(
+        *image, {0, 0, 7, 5}, letterbox, 4, 4, Identity(),
+        /*constant_padding=*/false, /*flip_vertically=*/false, tensor.data()));
+    for (int i = 0; i < tensor.size(); ++i) {
+      EXPECT_NEAR(expected[i % 3], tensor[i], 0.5) << fourcc << " at " << i;
+    }
+  }
+}
+
+TEST(ImageToTensorUtilsTest, ConvertsBt709FullRangeYuv) {
+  auto image = MakeYuvImage(
+      libyuv::FOURCC_I420, 2, 2, [](int, int) { return 120; }, 150, 100);
+  image->set_matrix_coefficients(YUVImage::COLOR_MATRIX_COEFFICIENTS_BT709);
+  image->set_full_range(true);
+  std::vector<float> tensor(3);
+  MEDIAPIPE_ASSERT_OK(ResizeAndNormalizeYuv(
+      *image, {0, 0, 2, 2}, {0, 0, 1, 1}, 1, 1, Identity(),
+      /*constant_padding=*/true, /*flip_vertically=*/false, tensor.data()));
+  EXPECT_NEAR(120 + 1.5748f * -28, tensor[0], 0.01);
+  EXPECT_NEAR(120 - 0.1873f * 22 - 0.4681f * -28, tensor[1], 0.01);
+  EXPECT_NEAR(120 + 1.8556f * 22, tensor[2], 0.01);
+}
+
+TEST(ImageToTensorUtilsTest, ResizesYuvAsRgb) {
+  // With neutral chroma and full range, RGB equals luma, so the result must
+  // match resizing the equivalent gray SRGB image.
+  auto luma = [](int col, int row) { return (col * 29 + row * 53) % 256; };
+  const int width = 37;
+  const int height = 23;
+  auto image =
+      MakeYuvImage(libyuv::FOURCC_NV21, width, height, luma, 128, 128);
+  image->set_full_range(true);
+  ImageFrame rgb_image(ImageFormat::SRGB, width, height);
+  for (int row = 0; row < height; ++row) {
+    uint8* pixel = rgb_image.MutablePixelData() + row * rgb_image.WidthStep();
+    for (int col = 0; col < width; ++col) {
+      std::fill(pixel + 3 * col, pixel + 3 * col + 3, luma(col, row));
+    }
+  }
+
+  const CropRegion crop = {3.5f, -2.f, 30.f, 20.f};
+  for (int size : {8, 64}) {
+    const LetterboxRegion letterbox =
+        ComputeLetterboxRegion(crop.width, crop.height, size, size, true);
+    const Normalization normalization = RangeNormalization(true);
+    std::vector<float> tensor(size * size * 3);
+    std::vector<float> expected(size * size * 3);
+    MEDIAPIPE_ASSERT_OK(ResizeAndNormalizeYuv(
+        *image, crop, letterbox, size, size, normalization,
+        /*constant_padding=*/false, /*flip_vertically=*/true, tensor.data()));
+    MEDIAPIPE_ASSERT_OK(ResizeAndNormalize(
+        rgb_image, crop, letterbox, size, size, 3, normalization,
+        /*constant_padding=*/false, /*flip_vertically=*/true,
+        expected.data()));
+    for (int i = 0; i < expected.size(); ++i) {
+      ASSERT_NEAR(expected[i], tensor[i], 1e-4) << size << " at " << i;
+    }
+  }
+}
+
+TEST(ImageToTensorUtilsTest, RotatesYuv) {
+  // At the size of the rotated crop region, every output pixel is a pixel of
+  // the image.
+  auto luma = [](int col, int row) { return col * 10 + row; };
+  const int width = 6;
+  const int height = 4;
+  for (libyuv::FourCC fourcc : {libyuv::FOURCC_I420, libyuv::FOURCC_NV12}) {
+    auto image = MakeYuvImage(fourcc, width, height, luma, 128, 128);
+    image->set_full_range(true);
+    for (int rotation : {90, 180, 270}) {
+      const bool transposed = rotation != 180;
+      const int output_width = transposed ? height : width;
+      const int output_height = transposed ? width : height;
+      CropRegion crop = {(width - output_width) / 2.f,
+                         (height - output_height) / 2.f,
+                         static_cast<float>(output_width),
+                         static_cast<float>(output_height)};
+      crop.rotation = rotation;
+      std::vector<float> tensor(output_width * output_height * 3);
+      MEDIAPIPE_ASSERT_OK(ResizeAndNormalizeYuv(
+          *image, crop, {0, 0, output_width, output_height}, output_width,
+          output_height, Identity(), /*constant_padding=*/true,
+          /*flip_vertically=*/false, tensor.data()));
+      for (int y = 0; y < output_height; ++y) {
+        for (int x = 0; x < output_width; ++x) {
+          // The image pixel that a clockwise turn of the region moves to x,y.
+          int col = x;
+          int row = y;
+          if (rotation == 90) {
+            col = width - 1 - y;
+            row = x;
+          } else if (rotation == 180) {
+            col = width - 1 - x;
+            row = height - 1 - y;
+          } else if (rotation == 270) {
+            col = y;
+            row = height - 1 - x;
+          }
+          const int i = (y * output_width + x) * 3;
+          EXPECT_NEAR(luma(col, row), tensor[i], 1e-4)
+              << fourcc << " rotated by " << rotation << " at " << x << ","
+              << y;
+        }
+      }
+    }
+  }
+}
+
+TEST(ImageToTensorUtilsTest, RejectsUnsupportedYuvFormats) {
+  auto image = MakeYuvImage(
+      libyuv::FOURCC_ANY, 2, 2, [](int, int) { return 0; }, 128, 128);
+  std::vector<float> tensor(3);
+  EXPECT_FALSE(ResizeAndNormalizeYuv(*image, {0, 0, 2, 2}, {0, 0, 1, 1}, 1, 1,
+                                     Identity(), /*constant_padding=*/true,
+                                     /*flip_vertically=*/false, tensor.data())
+                   .ok());
+}
+
+// Normalizes image one value at a time, as TfLiteConverterCalculator did.
+template <typename T>
+std::vector<float> NormalizeImageReference(const ImageFrame& image,
+                                           int num_channels,
+                                           const Normalization& normalization,
+                                           bool flip_vertically) {
+  std::vector<float> tensor;
+  for (int y = 0; y < image.Height(); ++y) {
+    const int row = flip_vertically ? image.Height() - 1 - y : y;
+    const T* src =
+        reinterpret_cast<const T*>(image.PixelData() + row * image.WidthStep());
+    for (int x = 0; x < image.Width(); ++x) {
+      for (int c = 0; c < num_channels; ++c) {
+        tensor.push_back(src[x * image.NumberOfChannels() + c] *
+                             normalization.scale[c] +
+                         normalization.offset[c]);
+      }
+    }
+  }
+  return tensor;
+}
+
+// Fills image with pseudo-random values in [0, 255].
+void FillImage(ImageFrame* image) {
+  for (int y = 0; y < image->Height(); ++y) {
+    uint8* row = image->MutablePixelData() + y * image->WidthStep();
+    const int row_size = image->Width() * image->NumberOfChannels();
+    for (int i = 0; i < row_size; ++i) {
+      const int value = (y * 131 + i * 71) % 256;
+      if (image->ByteDepth() == 1) {
+        row[i] = value;
+      } else {
+        reinterpret_cast<float*>(row)[i] = value;
+      }
+    }
+  }
+}
+
+// Checks NormalizeImage against the reference for odd widths, which leave
+// remainders after the vector loops, and for both row orders.
+void ExpectNormalizeImageMatchesReference(ImageFormat::Format format,
+                                          int num_channels,
+                                          const Normalization& normalization) {
+  for (int width : {1, 2, 5, 17, 35}) {
+    for (bool flip_vertically : {false, true}) {
+      ImageFrame image(format, width, 3);
+      FillImage(&image);
+      std::vector<float> tensor(width * 3 * num_channels);
+      MEDIAPIPE_ASSERT_OK(NormalizeImage(image, num_channels, normalization,
+                                         flip_vertically, tensor.data()));
+      const std::vector<float> expected =
+          image.ByteDepth() == 1
+              ? NormalizeImageReference<uint8>(image, num_channels,
+                                               normalization, flip_vertically)
+              : NormalizeImageReference<float>(image, num_channels,
+                                               normalization, flip_vertically);
+      ASSERT_EQ(expected.size(), tensor.size());
+      for (int i = 0; i < expected.size(); ++i) {
+        ASSERT_FLOAT_EQ(expected[i], tensor[i])
+            << "width " << width << " flip " << flip_vertically << " at " << i;
+      }
+    }
+  }
+}
+
+// Normalization with a different scale and offset per channel.
+Normalization PerChannel() {
+  Normalization normalization;
+  normalization.scale = {{1.f / 10, 1.f / 20, 1.f / 30, 1.f / 40}};
+  normalization.offset = {{-1.f, -2.f, -3.f, -4.f}};
+  return normalization;
+}
+
+TEST(ImageToTensorUtilsTest, NormalizesImage) {
+  for (bool zero_center : {false, true}) {
+    const Normalization normalization = RangeNormalization(zero_center);
+    ExpectNormalizeImageMatchesReference(ImageFormat::GRAY8, 1, normalization);
+    ExpectNormalizeImageMatchesReference(ImageFormat::SRGB, 3, normalization);
+    ExpectNormalizeImageMatchesReference(ImageFormat::SRGBA, 4, normalization);
+    ExpectNormalizeImageMatchesReference(ImageFormat::VEC32F1, 1,
+                                         normalization);
+  }
+  ExpectNormalizeImageMatchesReference(ImageFormat::SRGB, 3, PerChannel());
+  ExpectNormalizeImageMatchesReference(ImageFormat::SRGBA, 4, PerChannel());
+  ExpectNormalizeImageMatchesReference(ImageFormat::VEC32F1, 1, PerChannel());
+}
+
+TEST(ImageToTensorUtilsTest, NormalizesImageDroppingChannels) {
+  ExpectNormalizeImageMatchesReference(ImageFormat::SRGBA, 3,
+                                       RangeNormalization(true));
+  ExpectNormalizeImageMatchesReference(ImageFormat::SRGBA, 3, PerChannel());
+  ExpectNormalizeImageMatchesReference(ImageFormat::SRGB, 1, PerChannel());
+}
+
+TEST(ImageToTensorUtilsTest, CopiesMatrixToTensor) {
+  for (int rows : {1, 3, 4, 37}) {
+    for (int cols : {1, 4, 6, 40}) {
+      Matrix matrix(rows, cols);
+      for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+          matrix(r, c) = r * 1000 + c;
+        }
+      }
+      std::vector<float> tensor(rows * cols);
+      CopyMatrixToTensor(matrix, /*row_major=*/true, tensor.data());
+      for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+          ASSERT_EQ(matrix(r, c), tensor[r * cols + c]) << r << ", " << c;
+        }
+      }
+      CopyMatrixToTensor(matrix, /*row_major=*/false, tensor.data());
+      for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+          ASSERT_EQ(matrix(r, c), tensor[c * rows + r]) << r << ", " << c;
+        }
+      }
+    }
+  }
+}
+
+// Converts a 640x480 SRGB frame into a 256x256x3 letterboxed tensor.
+void BM_ResizeAndNormalize(benchmark::State& state) {
+  ImageFrame image(ImageFormat::SRGB, 640, 480);
+  for (int i = 0; i < image.PixelDataSize(); ++i) {
+    image.MutablePixelData()[i] = i % 251;
+  }
+  const int size = 256;
+  std::vector<float> tensor(size * size * 3);
+  const LetterboxRegion letterbox =
+      ComputeLetterboxRegion(640, 480, size, size, true);
+  const Normalization normalization = RangeNormalization(true);
+  for (auto _ : state) {
+    MEDIAPIPE_CHECK_OK(ResizeAndNormalize(
+        image, {0, 0, 640, 480}, letterbox, size, size, 3, normalization,
+        /*constant_padding=*/true, /*flip_vertically=*/false, tensor.data()));
+    benchmark::DoNotOptimize(tensor.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_ResizeAndNormalize);
+
+// Converts a 1920x1080 I420 frame into a 256x256x3 letterboxed tensor.
+void BM_ResizeAndNormalizeYuv(benchmark::State& state) {
+  auto image = MakeYuvImage(
+      libyuv::FOURCC_I420, 1920, 1080,
+      [](int col, int row) { return (col + row) % 251; }, 100, 150);
+  const int size = 256;
+  std::vector<float> tensor(size * size * 3);
+  const LetterboxRegion letterbox =
+      ComputeLetterboxRegion(1920, 1080, size, size, true);
+  const Normalization normalization = RangeNormalization(true);
+  for (auto _ : state) {
+    MEDIAPIPE_CHECK_OK(ResizeAndNormalizeYuv(
+        *image, {0, 0, 1920, 1080}, letterbox, size, size, normalization,
+        /*constant_padding=*/true, /*flip_vertically=*/false, tensor.data()));
+    benchmark::DoNotOptimize(tensor.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_ResizeAndNormalizeYuv);
+
+// Normalizes a size x size SRGB frame into [-1,1].
+void BM_NormalizeImage(benchmark::State& state) {
+  const int size = state.range(0);
+  ImageFrame image(ImageFormat::SRGB, size, size);
+  FillImage(&image);
+  std::vector<float> tensor(size * size * 3);
+  const Normalization normalization = RangeNormalization(true);
+  for (auto _ : state) {
+    MEDIAPIPE_CHECK_OK(NormalizeImage(image, 3, normalization,
+                                      /*flip_vertically=*/false,
+                                      tensor.data()));
+    benchmark::DoNotOptimize(tensor.data());
+  }
+  state.SetItemsProcessed(state.iterations() * size * size);
+}
+
+BENCHMARK(BM_NormalizeImage)->Arg(128)->Arg(256)->Arg(512);
+
+// Copies a size x size matrix into a row-major tensor.
+void BM_CopyMatrixToTensor(benchmark::State& state) {
+  const int size = state.range(0);
+  const Matrix matrix = Matrix::Random(size, size);
+  std::vector<float> tensor(size * size);
+  for (auto _ : state) {
+    CopyMatrixToTensor(matrix, /*row_major=*/true, tensor.data());
+    benchmark::DoNotOptimize(tensor.data());
+  }
+  state.SetItemsProcessed(state.iterations() * size * size);
+}
+
+BENCHMARK(BM_CopyMatrixToTensor)->Arg(128)->Arg(256)->Arg(512);
+
+}  // namespace
+}  // namespace image_to_tensor
+}  // namespace mediapipe
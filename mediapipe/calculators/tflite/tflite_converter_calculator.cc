@@ -15,6 +15,7 @@
 #include <string>
 #include <vector>
 
+#include "mediapipe/calculators/tflite/image_to_tensor_utils.h"
 #include "mediapipe/calculators/tflite/tflite_converter_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image_frame.h"
@@ -57,11 +58,6 @@ int NumGroups(const int size, const int group_size) {  // NOLINT
   return (size + group_size - 1) / group_size;
 }
 
-typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
-    RowMajorMatrixXf;
-typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor>
-    ColMajorMatrixXf;
-
 }  // namespace
 
 namespace mediapipe {
@@ -133,12 +129,6 @@ class TfLiteConverterCalculator : public CalculatorBase {
  private:
   ::mediapipe::Status InitGpu(CalculatorContext* cc);
   ::mediapipe::Status LoadOptions(CalculatorContext* cc);
-  template <class T>
-  ::mediapipe::Status NormalizeImage(const ImageFrame& image_frame,
-                                     bool zero_center, bool flip_vertically,
-                                     float* tensor_buffer);
-  ::mediapipe::Status CopyMatrixToTensor(const Matrix& matrix,
-                                         float* tensor_buffer);
   ::mediapipe::Status ProcessCPU(CalculatorContext* cc);
   ::mediapipe::Status ProcessGPU(CalculatorContext* cc);
 
@@ -320,16 +310,10 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
     } else {
       float* tensor_buffer = tensor->data.f;
       RET_CHECK(tensor_buffer);
-      if (image_frame.ByteDepth() == 1) {
-        RETURN_IF_ERROR(NormalizeImage<uint8>(image_frame, zero_center_,
-                                              flip_vertically_, tensor_buffer));
-      } else if (image_frame.ByteDepth() == 4) {
-        RETURN_IF_ERROR(NormalizeImage<float>(image_frame, zero_center_,
-                                              flip_vertically_, tensor_buffer));
-      } else {
-        return ::mediapipe::InternalError(
-            "Only byte-based (8 bit) and float (32 bit) images supported.");
-      }
+      RETURN_IF_ERROR(image_to_tensor::NormalizeImage(
+          image_frame, channels_preserved,
+          image_to_tensor::RangeNormalization(zero_center_), flip_vertically_,
+          tensor_buffer));
     }
 
     auto output_tensors = absl::make_unique<std::vector<TfLiteTensor>>();
@@ -359,7 +343,8 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
     float* tensor_buffer = tensor->data.f;
     RET_CHECK(tensor_buffer);
 
-    RETURN_IF_ERROR(CopyMatrixToTensor(matrix, tensor_buffer));
+    image_to_tensor::CopyMatrixToTensor(matrix, row_major_matrix_,
+                                        tensor_buffer);
 
     auto output_tensors = absl::make_unique<std::vector<TfLiteTensor>>();
     output_tensors->emplace_back(*tensor);
@@ -628,55 +613,4 @@ REGISTER_CALCULATOR(TfLiteConverterCalculator);
   return ::mediapipe::OkStatus();
 }
 
-template <class T>
-::mediapipe::Status TfLiteConverterCalculator::NormalizeImage(
-    const ImageFrame& image_frame, bool zero_center, bool flip_vertically,
-    float* tensor_buffer) {
-  const int height = image_frame.Height();
-  const int width = image_frame.Width();
-  const int channels = image_frame.NumberOfChannels();
-  const int channels_preserved = std::min(channels, max_num_channels_);
-  const int channels_ignored = channels - channels_preserved;
-
-  float div, sub;
-  if (zero_center) {
-    // [-1,1]
-    div = 127.5f;
-    sub = 1.0f;
-  } else {
-    // [0,1]
-    div = 255.0f;
-    sub = 0.0f;
-  }
-
-  for (int i = 0; i < height; ++i) {
-    const T* image_ptr = reinterpret_cast<const T*>(
-        image_frame.PixelData() +
-        (flip_vertically ? height - 1 - i : i) * image_frame.WidthStep());
-    for (int j = 0; j < width; ++j) {
-      for (int c = 0; c < channels_preserved; ++c) {
-        *tensor_buffer++ = *image_ptr++ / div - sub;
-      }
-      image_ptr += channels_ignored;
-    }
-  }
-
-  return ::mediapipe::OkStatus();
-}
-
-::mediapipe::Status TfLiteConverterCalculator::CopyMatrixToTensor(
-    const Matrix& matrix, float* tensor_buffer) {
-  if (row_major_matrix_) {
-    auto matrix_map = Eigen::Map<RowMajorMatrixXf>(tensor_buffer, matrix.rows(),
-                                                   matrix.cols());
-    matrix_map = matrix;
-  } else {
-    auto matrix_map = Eigen::Map<ColMajorMatrixXf>(tensor_buffer, matrix.rows(),
-                                                   matrix.cols());
-    matrix_map = matrix;
-  }
-
-  return ::mediapipe::OkStatus();
-}
-
 }  // namespace mediapipe
@@ -0,0 +1,301 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/calculators/tflite/image_to_tensor_utils.h"
+#include "mediapipe/calculators/tflite/tflite_image_to_tensor_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/rect.pb.h"
+#include "mediapipe/framework/formats/yuv_image.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "tensorflow/lite/interpreter.h"
+
+namespace mediapipe {
+
+// Crops, resizes, letterboxes and normalizes an ImageFrame into a
+// TfLiteTensor (float 32) in a single pass.
+//
+// This calculator replaces the CPU pair of ImageTransformationCalculator
+// (with scale_mode STRETCH or FIT) followed by TfLiteConverterCalculator,
+// without allocating the intermediate ImageFrame or reading the image twice.
+// Its output matches that pair up to the rounding of the resized pixels.
+//
+// A decoded YUVImage can be input instead, and is converted to RGB as it is
+// resized, so that the full-resolution RGB frame is never allocated.
+//
+// Inputs:
+//  One of the following:
+//  IMAGE - ImageFrame (SRGB, SRGBA, GRAY8 or VEC32F1).
+//  YUV_IMAGE - 8-bit YUVImage (I420, YV12, NV12 or NV21), output as RGB.
+//  NORM_RECT (optional) - NormalizedRect, the region of the image to convert.
+//    It may extend past the image, in which case the edge pixels are
+//    repeated.  With YUV_IMAGE, the rect may be rotated by a multiple of 90
+//    degrees.  Other rotated rects are not supported; use
+//    ImageCroppingCalculator for those.
+//
+// Outputs:
+//  TENSORS - Vector of one TfLiteTensor of type kTfLiteFloat32, of shape
+//    output_height x output_width x channels.
+//  LETTERBOX_PADDING (optional) - An std::array<float, 4> with the left, top,
+//    right and bottom padding as fractions of the output size, as
+//    ImageTransformationCalculator.
+//
+// Example use:
+// node {
+//   calculator: "TfLiteImageToTensorCalculator"
+//   input_stream: "IMAGE:input_image"
+//   output_stream: "TENSORS:image_tensor"
+//   output_stream: "LETTERBOX_PADDING:letterbox_padding"
+//   options: {
+//     [mediapipe.TfLiteImageToTensorCalculatorOptions.ext] {
+//       output_width: 128
+//       output_height: 128
+//       keep_aspect_ratio: true
+//       zero_center: true
+//     }
+//   }
+// }
+//
+// IMPORTANT Notes:
+//  The output tensor shares its buffer with the next output, as
+//  TfLiteConverterCalculator.  This calculator uses
+//  FixedSizeInputStreamHandler by default.
+//
+class TfLiteImageToTensorCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc);
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override;
+  ::mediapipe::Status Process(CalculatorContext* cc) override;
+
+ private:
+  ::mediapipe::Status LoadOptions(CalculatorContext* cc);
+  ::mediapipe::Status InitTensor(int num_channels);
+
+  std::unique_ptr<tflite::Interpreter> interpreter_ = nullptr;
+
+  bool initialized_ = false;
+  int output_width_ = 0;
+  int output_height_ = 0;
+  bool keep_aspect_ratio_ = false;
+  bool constant_padding_ = true;
+  bool flip_vertically_ = false;
+  int max_num_channels_ = 3;
+  int num_channels_ = 0;
+  // The number of channels that normalization_ is set for.
+  int num_normalized_channels_ = 4;
+  image_to_tensor::Normalization normalization_;
+};
+REGISTER_CALCULATOR(TfLiteImageToTensorCalculator);
+
+::mediapipe::Status TfLiteImageToTensorCalculator::GetContract(
+    CalculatorContract* cc) {
+  RET_CHECK(cc->Inputs().HasTag("IMAGE") ^ cc->Inputs().HasTag("YUV_IMAGE"));
+  RET_CHECK(cc->Outputs().HasTag("TENSORS"));
+
+  if (cc->Inputs().HasTag("IMAGE")) {
+    cc->Inputs().Tag("IMAGE").Set<ImageFrame>();
+  }
+  if (cc->Inputs().HasTag("YUV_IMAGE")) {
+    cc->Inputs().Tag("YUV_IMAGE").Set<YUVImage>();
+  }
+  if (cc->Inputs().HasTag("NORM_RECT")) {
+    cc->Inputs().Tag("NORM_RECT").Set<NormalizedRect>();
+  }
+  cc->Outputs().Tag("TENSORS").Set<std::vector<TfLiteTensor>>();
+  if (cc->Outputs().HasTag("LETTERBOX_PADDING")) {
+    cc->Outputs().Tag("LETTERBOX_PADDING").Set<std::array<float, 4>>();
+  }
+
+  // Assign this calculator's default InputStreamHandler.
+  cc->SetInputStreamHandler("FixedSizeInputStreamHandler");
+
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status TfLiteImageToTensorCalculator::Open(CalculatorContext* cc) {
+  cc->SetOffset(TimestampDiff(0));
+
+  RETURN_IF_ERROR(LoadOptions(cc));
+
+  interpreter_ = absl::make_unique<tflite::Interpreter>();
+  interpreter_->AddTensors(1);
+  interpreter_->SetInputs({0});
+
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status TfLiteImageToTensorCalculator::Process(
+    CalculatorContext* cc) {
+  const ImageFrame* image_frame = nullptr;
+  const YUVImage* yuv_image = nullptr;
+  int image_width;
+  int image_height;
+  if (cc->Inputs().HasTag("YUV_IMAGE")) {
+    if (cc->Inputs().Tag("YUV_IMAGE").IsEmpty()) {
+      return ::mediapipe::OkStatus();
+    }
+    yuv_image = &cc->Inputs().Tag("YUV_IMAGE").Get<YUVImage>();
+    image_width = yuv_image->width();
+    image_height = yuv_image->height();
+  } else {
+    if (cc->Inputs().Tag("IMAGE").IsEmpty()) {
+      return ::mediapipe::OkStatus();
+    }
+    image_frame = &cc->Inputs().Tag("IMAGE").Get<ImageFrame>();
+    image_width = image_frame->Width();
+    image_height = image_frame->Height();
+  }
+  if (!initialized_) {
+    // YUVImages are converted to RGB.
+    int num_channels = 3;
+    if (image_frame) {
+      if (!(image_frame->Format() == mediapipe::ImageFormat::SRGBA ||
+            image_frame->Format() == mediapipe::ImageFormat::SRGB ||
+            image_frame->Format() == mediapipe::ImageFormat::GRAY8 ||
+            image_frame->Format() == mediapipe::ImageFormat::VEC32F1))
+        RET_CHECK_FAIL() << "Unsupported CPU input format.";
+      num_channels =
+          std::min(image_frame->NumberOfChannels(), max_num_channels_);
+    }
+    RETURN_IF_ERROR(InitTensor(num_channels));
+    initialized_ = true;
+  }
+
+  image_to_tensor::CropRegion crop = {0.f, 0.f, static_cast<float>(image_width),
+                                      static_cast<float>(image_height)};
+  if (cc->Inputs().HasTag("NORM_RECT") &&
+      !cc->Inputs().Tag("NORM_RECT").IsEmpty()) {
+    const auto& rect = cc->Inputs().Tag("NORM_RECT").Get<NormalizedRect>();
+    const float quarter_turns = std::round(rect.rotation() / M_PI_2);
+    RET_CHECK_LT(std::abs(rect.rotation() - quarter_turns * M_PI_2), 1e-3)
+        << "Only rects rotated by a multiple of 90 degrees are supported.";
+    RET_CHECK(yuv_image || quarter_turns == 0.f)
+        << "Rotated rects are only supported with YUV_IMAGE.";
+    if (rect.width() <= 0.f || rect.height() <= 0.f) {
+      return ::mediapipe::OkStatus();
+    }
+    crop.width = rect.width() * image_width;
+    crop.height = rect.height() * image_height;
+    crop.x_min = rect.x_center() * image_width - crop.width / 2;
+    crop.y_min = rect.y_center() * image_height - crop.height / 2;
+    crop.rotation = (static_cast<int>(quarter_turns) % 4 + 4) % 4 * 90;
+  }
+
+  const image_to_tensor::LetterboxRegion letterbox =
+      image_to_tensor::ComputeLetterboxRegion(crop.width, crop.height,
+                                              output_width_, output_height_,
+                                              keep_aspect_ratio_);
+
+  const int tensor_idx = interpreter_->inputs()[0];
+  TfLiteTensor* tensor = interpreter_->tensor(tensor_idx);
+  if (yuv_image) {
+    RETURN_IF_ERROR(image_to_tensor::ResizeAndNormalizeYuv(
+        *yuv_image, crop, letterbox, output_width_, output_height_,
+        normalization_, constant_padding_, flip_vertically_, tensor->data.f));
+  } else {
+    RETURN_IF_ERROR(image_to_tensor::ResizeAndNormalize(
+        *image_frame, crop, letterbox, output_width_, output_height_,
+        num_channels_, normalization_, constant_padding_, flip_vertically_,
+        tensor->data.f));
+  }
+
+  if (cc->Outputs().HasTag("LETTERBOX_PADDING")) {
+    auto padding = absl::make_unique<std::array<float, 4>>();
+    (*padding)[0] = static_cast<float>(letterbox.left) / output_width_;
+    (*padding)[1] = static_cast<float>(letterbox.top) / output_height_;
+    (*padding)[2] =
+        static_cast<float>(output_width_ - letterbox.left - letterbox.width) /
+        output_width_;
+    (*padding)[3] =
+        static_cast<float>(output_height_ - letterbox.top - letterbox.height) /
+        output_height_;
+    cc->Outputs()
+        .Tag("LETTERBOX_PADDING")
+        .Add(padding.release(), cc->InputTimestamp());
+  }
+
+  auto output_tensors = absl::make_unique<std::vector<TfLiteTensor>>();
+  output_tensors->emplace_back(*tensor);
+  cc->Outputs().Tag("TENSORS").Add(output_tensors.release(),
+                                   cc->InputTimestamp());
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status TfLiteImageToTensorCalculator::InitTensor(
+    int num_channels) {
+  num_channels_ = num_channels;
+  RET_CHECK_LE(num_channels_, num_normalized_channels_)
+      << "mean and stddev must have a value per output channel.";
+
+  // Default TfLiteQuantization used for no quantization.
+  const int tensor_idx = interpreter_->inputs()[0];
+  interpreter_->SetTensorParametersReadWrite(tensor_idx, kTfLiteFloat32, "",
+                                             {num_channels_},
+                                             TfLiteQuantization());
+  interpreter_->ResizeInputTensor(tensor_idx,
+                                  {output_height_, output_width_,
+                                   num_channels_});
+  RET_CHECK_EQ(interpreter_->AllocateTensors(), kTfLiteOk);
+  RET_CHECK(interpreter_->tensor(tensor_idx)->data.f);
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status TfLiteImageToTensorCalculator::LoadOptions(
+    CalculatorContext* cc) {
+  // Get calculator options specified in the graph.
+  const auto& options =
+      cc->Options<::mediapipe::TfLiteImageToTensorCalculatorOptions>();
+
+  output_width_ = options.output_width();
+  output_height_ = options.output_height();
+  RET_CHECK(output_width_ > 0 && output_height_ > 0)
+      << "output_width and output_height must be set.";
+  keep_aspect_ratio_ = options.keep_aspect_ratio();
+  constant_padding_ = options.constant_padding();
+  flip_vertically_ = options.flip_vertically();
+
+  // Get desired way to handle input channels.
+  max_num_channels_ = options.max_num_channels();
+  // Currently only alpha channel toggling is suppored.
+  RET_CHECK_GE(max_num_channels_, 3);
+  RET_CHECK_LE(max_num_channels_, 4);
+
+  // Get data normalization mode.
+  if (options.mean_size() > 0 || options.stddev_size() > 0) {
+    RET_CHECK_EQ(options.mean_size(), options.stddev_size());
+    RET_CHECK_LE(options.mean_size(), 4);
+    for (int c = 0; c < options.mean_size(); ++c) {
+      RET_CHECK_NE(options.stddev(c), 0.f);
+      normalization_.scale[c] = 1.f / options.stddev(c);
+      normalization_.offset[c] = -options.mean(c) / options.stddev(c);
+    }
+    num_normalized_channels_ = options.mean_size();
+  } else {
+    normalization_ =
+        image_to_tensor::RangeNormalization(options.zero_center());
+  }
+
+  return ::mediapipe::OkStatus();
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,298 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/substitute.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/yuv_image.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"  // NOLINT
+#include "mediapipe/framework/tool/sink.h"
+#include "tensorflow/lite/interpreter.h"
+
+namespace mediapipe {
+namespace {
+
+using RandomEngine = std::mt19937_64;
+const uint32 kSeed = 1234;
+
+// Runs TfLiteImageToTensorCalculator next to ImageTransformationCalculator
+// followed by TfLiteConverterCalculator on a random image, and checks that
+// their outputs match.
+class TfLiteImageToTensorCalculatorTest : public ::testing::Test {
+ protected:
+  void RunAndCompare(ImageFormat::Format format, int input_width,
+                     int input_height, int output_width, int output_height,
+                     bool keep_aspect_ratio, bool zero_center) {
+    CalculatorGraphConfig graph_config =
+        ParseTextProtoOrDie<CalculatorGraphConfig>(absl::Substitute(
+            R"(
+          input_stream: "image"
+          node {
+            calculator: "TfLiteImageToTensorCalculator"
+            input_stream: "IMAGE:image"
+            output_stream: "TENSORS:fused_tensors"
+            output_stream: "LETTERBOX_PADDING:fused_padding"
+            options {
+              [mediapipe.TfLiteImageToTensorCalculatorOptions.ext] {
+                output_width: $0
+                output_height: $1
+                keep_aspect_ratio: $2
+                zero_center: $3
+              }
+            }
+          }
+          node {
+            calculator: "ImageTransformationCalculator"
+            input_stream: "IMAGE:image"
+            output_stream: "IMAGE:transformed_image"
+            output_stream: "LETTERBOX_PADDING:padding"
+            options {
+              [mediapipe.ImageTransformationCalculatorOptions.ext] {
+                output_width: $0
+                output_height: $1
+                scale_mode: $4
+              }
+            }
+          }
+          node {
+            calculator: "TfLiteConverterCalculator"
+            input_stream: "IMAGE:transformed_image"
+            output_stream: "TENSORS:tensors"
+            options {
+              [mediapipe.TfLiteConverterCalculatorOptions.ext] {
+                zero_center: $3
+              }
+            }
+          }
+        )",
+            output_width, output_height, keep_aspect_ratio, zero_center,
+            keep_aspect_ratio ? "FIT" : "STRETCH"));
+
+    std::vector<Packet> fused_tensors;
+    std::vector<Packet> tensors;
+    std::vector<Packet> fused_padding;
+    std::vector<Packet> padding;
+    tool::AddVectorSink("fused_tensors", &graph_config, &fused_tensors);
+    tool::AddVectorSink("tensors", &graph_config, &tensors);
+    tool::AddVectorSink("fused_padding", &graph_config, &fused_padding);
+    tool::AddVectorSink("padding", &graph_config, &padding);
+
+    auto image = absl::make_unique<ImageFrame>(format, input_width,
+                                               input_height);
+    RandomEngine random(kSeed);
+    std::uniform_int_distribution<> uniform_dist(0, 255);
+    for (int y = 0; y < input_height; ++y) {
+      uint8* row = image->MutablePixelData() + y * image->WidthStep();
+      for (int x = 0; x < input_width * image->NumberOfChannels(); ++x) {
+        row[x] = uniform_dist(random);
+      }
+    }
+
+    CalculatorGraph graph(graph_config);
+    MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+    MEDIAPIPE_ASSERT_OK(graph.AddPacketToInputStream(
+        "image", Adopt(image.release()).At(Timestamp(0))));
+    MEDIAPIPE_ASSERT_OK(graph.WaitUntilIdle());
+
+    ASSERT_EQ(1, fused_tensors.size());
+    ASSERT_EQ(1, tensors.size());
+    const TfLiteTensor& fused =
+        fused_tensors[0].Get<std::vector<TfLiteTensor>>()[0];
+    const TfLiteTensor& expected =
+        tensors[0].Get<std::vector<TfLiteTensor>>()[0];
+    ASSERT_EQ(kTfLiteFloat32, fused.type);
+    ASSERT_EQ(expected.dims->size, fused.dims->size);
+    for (int i = 0; i < expected.dims->size; ++i) {
+      ASSERT_EQ(expected.dims->data[i], fused.dims->data[i]);
+    }
+    const int num_values = output_width * output_height * fused.dims->data[2];
+    // Resized 8-bit pixels are rounded by cv::resize, and its fixed-point
+    // weights add up to another level.
+    const float tolerance = (zero_center ? 2.f / 127.5f : 2.f / 255.f) + 1e-5f;
+    float max_difference = 0.f;
+    for (int i = 0; i < num_values; ++i) {
+      max_difference = std::max(
+          max_difference, std::abs(fused.data.f[i] - expected.data.f[i]));
+    }
+    EXPECT_LE(max_difference, tolerance);
+
+    ASSERT_EQ(1, fused_padding.size());
+    ASSERT_EQ(1, padding.size());
+    const auto& fused_values = fused_padding[0].Get<std::array<float, 4>>();
+    const auto& expected_values = padding[0].Get<std::array<float, 4>>();
+    for (int i = 0; i < 4; ++i) {
+      // The fused padding is exact in pixels, the other one in aspect ratio.
+      EXPECT_NEAR(expected_values[i], fused_values[i], 1.f / output_width);
+    }
+
+    MEDIAPIPE_ASSERT_OK(graph.CloseAllInputStreams());
+    MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+  }
+};
+
+TEST_F(TfLiteImageToTensorCalculatorTest, MatchesTransformAndConvertStretch) {
+  RunAndCompare(ImageFormat::SRGB, 640, 480, 128, 128,
+                /*keep_aspect_ratio=*/false, /*zero_center=*/true);
+}
+
+TEST_F(TfLiteImageToTensorCalculatorTest, MatchesTransformAndConvertFit) {
+  RunAndCompare(ImageFormat::SRGB, 640, 480, 256, 256,
+                /*keep_aspect_ratio=*/true, /*zero_center=*/true);
+}
+
+TEST_F(TfLiteImageToTensorCalculatorTest, MatchesTransformAndConvertUpscale) {
+  RunAndCompare(ImageFormat::SRGBA, 100, 60, 192, 192,
+                /*keep_aspect_ratio=*/true, /*zero_center=*/false);
+}
+
+TEST_F(TfLiteImageToTensorCalculatorTest, NormalizesWithMeanAndStddev) {
+  CalculatorGraphConfig graph_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "image"
+        node {
+          calculator: "TfLiteImageToTensorCalculator"
+          input_stream: "IMAGE:image"
+          output_stream: "TENSORS:tensors"
+          options {
+            [mediapipe.TfLiteImageToTensorCalculatorOptions.ext] {
+              output_width: 2
+              output_height: 1
+              mean: [ 0, 100, 200 ]
+              stddev: [ 1, 10, 100 ]
+            }
+          }
+        }
+      )");
+  std::vector<Packet> tensors;
+  tool::AddVectorSink("tensors", &graph_config, &tensors);
+
+  auto image = absl::make_unique<ImageFrame>(ImageFormat::SRGB, 2, 1);
+  const uint8 pixels[] = {10, 110, 0, 20, 90, 255};
+  std::copy(pixels, pixels + 6, image->MutablePixelData());
+
+  CalculatorGraph graph(graph_config);
+  MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+  MEDIAPIPE_ASSERT_OK(graph.AddPacketToInputStream(
+      "image", Adopt(image.release()).At(Timestamp(0))));
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilIdle());
+
+  ASSERT_EQ(1, tensors.size());
+  const TfLiteTensor& tensor = tensors[0].Get<std::vector<TfLiteTensor>>()[0];
+  const std::vector<float> expected = {10.f, 1.f, -2.f, 20.f, -1.f, 0.55f};
+  for (int i = 0; i < expected.size(); ++i) {
+    EXPECT_NEAR(expected[i], tensor.data.f[i], 1e-5) << i;
+  }
+
+  MEDIAPIPE_ASSERT_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+}
+
+TEST_F(TfLiteImageToTensorCalculatorTest, ConvertsYuvImageLikeRgbImage) {
+  CalculatorGraphConfig graph_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "image"
+        input_stream: "yuv_image"
+        node {
+          calculator: "TfLiteImageToTensorCalculator"
+          input_stream: "IMAGE:image"
+          output_stream: "TENSORS:tensors"
+          options {
+            [mediapipe.TfLiteImageToTensorCalculatorOptions.ext] {
+              output_width: 32
+              output_height: 32
+              keep_aspect_ratio: true
+            }
+          }
+        }
+        node {
+          calculator: "TfLiteImageToTensorCalculator"
+          input_stream: "YUV_IMAGE:yuv_image"
+          output_stream: "TENSORS:yuv_tensors"
+          options {
+            [mediapipe.TfLiteImageToTensorCalculatorOptions.ext] {
+              output_width: 32
+              output_height: 32
+              keep_aspect_ratio: true
+            }
+          }
+        }
+      )");
+  std::vector<Packet> tensors;
+  std::vector<Packet> yuv_tensors;
+  tool::AddVectorSink("tensors", &graph_config, &tensors);
+  tool::AddVectorSink("yuv_tensors", &graph_config, &yuv_tensors);
+
+  // A full-range gray NV12 image, and the SRGB image it converts to.
+  const int width = 48;
+  const int height = 36;
+  const int chroma_size = width * height / 2;
+  uint8* yuv_data = new uint8[width * height + chroma_size];
+  auto image = absl::make_unique<ImageFrame>(ImageFormat::SRGB, width, height);
+  RandomEngine random(kSeed);
+  std::uniform_int_distribution<> uniform_dist(0, 255);
+  for (int y = 0; y < height; ++y) {
+    uint8* row = image->MutablePixelData() + y * image->WidthStep();
+    for (int x = 0; x < width; ++x) {
+      const uint8 value = uniform_dist(random);
+      yuv_data[y * width + x] = value;
+      std::fill(row + 3 * x, row + 3 * x + 3, value);
+    }
+  }
+  std::fill(yuv_data + width * height, yuv_data + width * height + chroma_size,
+            128);
+  auto yuv_image = absl::make_unique<YUVImage>();
+  yuv_image->Initialize(libyuv::FOURCC_NV12,
+                        [yuv_data] { delete[] yuv_data; },  //
+                        yuv_data, width,                    //
+                        yuv_data + width * height, width,   //
+                        nullptr, 0, width, height);
+  yuv_image->set_full_range(true);
+
+  CalculatorGraph graph(graph_config);
+  MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+  MEDIAPIPE_ASSERT_OK(graph.AddPacketToInputStream(
+      "image", Adopt(image.release()).At(Timestamp(0))));
+  MEDIAPIPE_ASSERT_OK(graph.AddPacketToInputStream(
+      "yuv_image", Adopt(yuv_image.release()).At(Timestamp(0))));
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilIdle());
+
+  ASSERT_EQ(1, tensors.size());
+  ASSERT_EQ(1, yuv_tensors.size());
+  const TfLiteTensor& expected =
+      tensors[0].Get<std::vector<TfLiteTensor>>()[0];
+  const TfLiteTensor& tensor =
+      yuv_tensors[0].Get<std::vector<TfLiteTensor>>()[0];
+  ASSERT_EQ(3, tensor.dims->data[2]);
+  for (int i = 0; i < 32 * 32 * 3; ++i) {
+    ASSERT_NEAR(expected.data.f[i], tensor.data.f[i], 1e-4) << i;
+  }
+
+  MEDIAPIPE_ASSERT_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -114,6 +114,7 @@ struct GPUData {
 //  Input tensors are assumed to be of the correct size and already normalized.
 //  All output TfLiteTensors will be destroyed when the graph closes,
 //  (i.e. after calling graph.WaitUntilDone()).
+//  On CPU, the model is kept across runs of the same graph (see Reset()).
 //  GPU tensors are currently only supported on Android and iOS.
 //  This calculator uses FixedSizeInputStreamHandler by default.
 //
@@ -124,6 +125,7 @@ class TfLiteInferenceCalculator : public CalculatorBase {
   ::mediapipe::Status Open(CalculatorContext* cc) override;
   ::mediapipe::Status Process(CalculatorContext* cc) override;
   ::mediapipe::Status Close(CalculatorContext* cc) override;
+  ::mediapipe::Status Reset() override;
 
  private:
   ::mediapipe::Status LoadOptions(CalculatorContext* cc);
@@ -196,6 +198,7 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
 ::mediapipe::Status TfLiteInferenceCalculator::Open(CalculatorContext* cc) {
   cc->SetOffset(TimestampDiff(0));
 
+  const std::string previous_model_path = model_path_;
   RETURN_IF_ERROR(LoadOptions(cc));
 
   if (cc->Inputs().HasTag("TENSORS_GPU")) {
@@ -217,7 +220,14 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
 #endif
   }
 
-  RETURN_IF_ERROR(LoadModel(cc));
+  // After Reset(), the interpreter of the previous run is reused unless the
+  // model or the op resolver may have changed.
+  if (!interpreter_ || model_path_ != previous_model_path ||
+      cc->InputSidePackets().HasTag("CUSTOM_OP_RESOLVER")) {
+    RETURN_IF_ERROR(LoadModel(cc));
+  } else if (use_quantized_tensors_) {
+    gpu_inference_ = false;
+  }
 
   if (gpu_inference_) {
 #if defined(__ANDROID__)
@@ -387,6 +397,16 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
   return ::mediapipe::OkStatus();
 }
 
+::mediapipe::Status TfLiteInferenceCalculator::Reset() {
+  // The GPU delegate and buffers are released in Close().
+  if (gpu_inference_ || gpu_input_ || gpu_output_) {
+    return ::mediapipe::UnimplementedError(
+        "Reset() is only supported for CPU inference.");
+  }
+  RET_CHECK_EQ(interpreter_->ResetVariableTensors(), kTfLiteOk);
+  return ::mediapipe::OkStatus();
+}
+
 // Calculator Auxiliary Section
 
 ::mediapipe::Status TfLiteInferenceCalculator::LoadOptions(
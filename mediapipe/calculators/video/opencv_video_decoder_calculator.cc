@@ -16,6 +16,7 @@
 #include "mediapipe/framework/formats/image_format.pb.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/formats/image_frame_pool.h"
 #include "mediapipe/framework/formats/video_stream_header.h"
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/opencv_video_inc.h"
@@ -71,6 +72,7 @@ class OpenCvVideoDecoderCalculator : public CalculatorBase {
   static ::mediapipe::Status GetContract(CalculatorContract* cc) {
     cc->InputSidePackets().Tag("INPUT_FILE_PATH").Set<std::string>();
     cc->Outputs().Tag("VIDEO").Set<ImageFrame>();
+    cc->UseService(kImageFramePoolService);
     if (cc->Outputs().HasTag("VIDEO_PRESTREAM")) {
       cc->Outputs().Tag("VIDEO_PRESTREAM").Set<VideoHeader>();
     }
@@ -130,8 +132,10 @@ class OpenCvVideoDecoderCalculator : public CalculatorBase {
   }
 
   ::mediapipe::Status Process(CalculatorContext* cc) override {
-    auto image_frame = absl::make_unique<ImageFrame>(format_, width_, height_,
-                                                     /*alignment_boundary=*/1);
+    std::unique_ptr<ImageFrame> image_frame =
+        cc->Service(kImageFramePoolService)
+            .GetObject()
+            .GetFrame(format_, width_, height_, /*alignment_boundary=*/1);
     // Use microsecond as the unit of time.
     Timestamp timestamp(cap_->get(cv::CAP_PROP_POS_MSEC) * 1000);
     if (format_ == ImageFormat::GRAY8) {
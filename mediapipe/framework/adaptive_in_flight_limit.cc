@@ -0,0 +1,90 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/adaptive_in_flight_limit.h"
+
+#include <algorithm>
+
+#include "mediapipe/framework/port/logging.h"
+
+namespace mediapipe {
+
+constexpr int AdaptiveInFlightLimit::kWindowSize;
+constexpr int AdaptiveInFlightLimit::kHoldWindows;
+constexpr double AdaptiveInFlightLimit::kMinThroughputGain;
+
+AdaptiveInFlightLimit::AdaptiveInFlightLimit(int max_limit)
+    : max_limit_(max_limit) {
+  CHECK_GE(max_limit_, 1);
+}
+
+bool AdaptiveInFlightLimit::RecordInvocation(int64 process_time_ns,
+                                             int queue_size) {
+  if (num_invocations_ == 0) {
+    min_queue_size_ = queue_size;
+    max_queue_size_ = queue_size;
+  } else {
+    min_queue_size_ = std::min(min_queue_size_, queue_size);
+    max_queue_size_ = std::max(max_queue_size_, queue_size);
+  }
+  total_process_time_ns_ += std::max<int64>(process_time_ns, 0);
+  if (++num_invocations_ < kWindowSize) {
+    return false;
+  }
+  const int old_limit = limit_;
+  Adapt();
+  num_invocations_ = 0;
+  total_process_time_ns_ = 0;
+  return limit_ != old_limit;
+}
+
+void AdaptiveInFlightLimit::Adapt() {
+  const double mean_process_time_ns =
+      std::max(1.0, static_cast<double>(total_process_time_ns_) /
+                        static_cast<double>(num_invocations_));
+  const double throughput = limit_ / mean_process_time_ns;
+  if (hold_windows_ > 0) {
+    --hold_windows_;
+  }
+  int change = 0;
+  if (last_change_ > 0 &&
+      throughput < last_throughput_ * (1.0 + kMinThroughputGain)) {
+    // The last increase did not pay off, e.g. because the invocations
+    // contend for a lock or for the CPU.
+    change = -1;
+    hold_windows_ = kHoldWindows;
+  } else if (max_queue_size_ == 0) {
+    // The node keeps up with its inputs, so fewer invocations will do.
+    change = limit_ > 1 ? -1 : 0;
+  } else if (min_queue_size_ > 0 && hold_windows_ == 0 &&
+             limit_ < max_limit_) {
+    change = 1;
+  }
+  limit_ += change;
+  last_change_ = change;
+  last_throughput_ = throughput;
+}
+
+void AdaptiveInFlightLimit::Reset() {
+  limit_ = 1;
+  num_invocations_ = 0;
+  total_process_time_ns_ = 0;
+  min_queue_size_ = 0;
+  max_queue_size_ = 0;
+  last_change_ = 0;
+  last_throughput_ = 0;
+  hold_windows_ = 0;
+}
+
+}  // namespace mediapipe
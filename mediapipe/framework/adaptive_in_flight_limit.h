@@ -0,0 +1,77 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_ADAPTIVE_IN_FLIGHT_LIMIT_H_
+#define MEDIAPIPE_FRAMEWORK_ADAPTIVE_IN_FLIGHT_LIMIT_H_
+
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+
+// Chooses how many invocations of a node may run in parallel, between 1 and
+// the node's max_in_flight, for nodes with adaptive_max_in_flight set.
+//
+// The limit is revisited once every kWindowSize invocations. It grows by one
+// if input packets were waiting after every invocation of the window, which
+// means the node cannot keep up at the current limit. An increase is kept
+// only if it raised the estimated throughput, the limit divided by the mean
+// Process() time, by at least kMinThroughputGain; otherwise it is reverted
+// and no increase is tried for kHoldWindows windows. The limit shrinks by one
+// if no input packets were waiting after any invocation of the window.
+//
+// This class is not thread-safe.
+class AdaptiveInFlightLimit {
+ public:
+  static constexpr int kWindowSize = 16;
+  static constexpr int kHoldWindows = 8;
+  static constexpr double kMinThroughputGain = 0.1;
+
+  explicit AdaptiveInFlightLimit(int max_limit);
+
+  // The current limit, between 1 and max_limit().
+  int limit() const { return limit_; }
+  int max_limit() const { return max_limit_; }
+
+  // Records a finished invocation whose Process() call took
+  // "process_time_ns", after which "queue_size" input packets were waiting.
+  // Returns true if the limit changed.
+  bool RecordInvocation(int64 process_time_ns, int queue_size);
+
+  // Restores the limit to 1 and forgets all measurements.
+  void Reset();
+
+ private:
+  // Updates limit_ at the end of a window.
+  void Adapt();
+
+  const int max_limit_;
+  int limit_ = 1;
+
+  // Measurements of the current window.
+  int num_invocations_ = 0;
+  int64 total_process_time_ns_ = 0;
+  int min_queue_size_ = 0;
+  int max_queue_size_ = 0;
+
+  // The change made to limit_ at the end of the previous window.
+  int last_change_ = 0;
+  // The estimated throughput of the previous window, in invocations per ns.
+  double last_throughput_ = 0;
+  // The number of windows left before the limit may grow again.
+  int hold_windows_ = 0;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_ADAPTIVE_IN_FLIGHT_LIMIT_H_
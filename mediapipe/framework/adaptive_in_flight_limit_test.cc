@@ -0,0 +1,105 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/adaptive_in_flight_limit.h"
+
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kWindowSize = AdaptiveInFlightLimit::kWindowSize;
+
+// Records one window of invocations that each took "process_time_ns" and
+// left "queue_size" packets waiting.
+void RecordWindow(AdaptiveInFlightLimit* limit, int64 process_time_ns,
+                  int queue_size) {
+  for (int i = 0; i < kWindowSize; ++i) {
+    limit->RecordInvocation(process_time_ns, queue_size);
+  }
+}
+
+TEST(AdaptiveInFlightLimitTest, StartsAtOne) {
+  AdaptiveInFlightLimit limit(4);
+  EXPECT_EQ(1, limit.limit());
+  EXPECT_EQ(4, limit.max_limit());
+}
+
+TEST(AdaptiveInFlightLimitTest, ChangesOnlyAtTheEndOfAWindow) {
+  AdaptiveInFlightLimit limit(4);
+  for (int i = 0; i < kWindowSize - 1; ++i) {
+    EXPECT_FALSE(limit.RecordInvocation(1000, 10));
+  }
+  EXPECT_TRUE(limit.RecordInvocation(1000, 10));
+  EXPECT_EQ(2, limit.limit());
+}
+
+// Invocations that run in parallel without slowing each other down raise
+// the limit up to the maximum while there is a backlog.
+TEST(AdaptiveInFlightLimitTest, GrowsWithBacklogUpToMax) {
+  AdaptiveInFlightLimit limit(4);
+  for (int window = 0; window < 10; ++window) {
+    RecordWindow(&limit, 1000, 10);
+  }
+  EXPECT_EQ(4, limit.limit());
+}
+
+// Invocations whose Process() time grows with the limit, e.g. because they
+// contend for a single core, do not keep a higher limit.
+TEST(AdaptiveInFlightLimitTest, RevertsIncreaseWithoutThroughputGain) {
+  AdaptiveInFlightLimit limit(4);
+  RecordWindow(&limit, 1000, 10);
+  ASSERT_EQ(2, limit.limit());
+  RecordWindow(&limit, 2000, 10);
+  EXPECT_EQ(1, limit.limit());
+  // The limit is held at 1 for a while despite the backlog.
+  for (int window = 0; window < AdaptiveInFlightLimit::kHoldWindows - 1;
+       ++window) {
+    RecordWindow(&limit, 1000, 10);
+    EXPECT_EQ(1, limit.limit());
+  }
+  RecordWindow(&limit, 1000, 10);
+  EXPECT_EQ(2, limit.limit());
+}
+
+TEST(AdaptiveInFlightLimitTest, ShrinksWithoutBacklog) {
+  AdaptiveInFlightLimit limit(4);
+  for (int window = 0; window < 3; ++window) {
+    RecordWindow(&limit, 1000, 10);
+  }
+  ASSERT_EQ(4, limit.limit());
+  // A window with only an occasional backlog leaves the limit alone.
+  for (int i = 0; i < kWindowSize; ++i) {
+    limit.RecordInvocation(1000, i % 2);
+  }
+  EXPECT_EQ(4, limit.limit());
+  for (int window = 0; window < 10; ++window) {
+    RecordWindow(&limit, 1000, 0);
+  }
+  EXPECT_EQ(1, limit.limit());
+}
+
+TEST(AdaptiveInFlightLimitTest, Reset) {
+  AdaptiveInFlightLimit limit(4);
+  RecordWindow(&limit, 1000, 10);
+  ASSERT_EQ(2, limit.limit());
+  limit.Reset();
+  EXPECT_EQ(1, limit.limit());
+  RecordWindow(&limit, 1000, 10);
+  EXPECT_EQ(2, limit.limit());
+}
+
+}  // namespace
+}  // namespace mediapipe
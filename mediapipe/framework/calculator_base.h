@@ -47,7 +47,8 @@ namespace mediapipe {
 // The entire calculator is constructed and destroyed for each graph run
 // (set of input side packets, which could mean once per video, or once
 // per image).  Any expensive operations and large objects should be
-// input side packets.
+// input side packets.  Alternatively, a calculator can implement Reset() to
+// be kept for the next run of the same CalculatorGraph.
 //
 // The framework calls Open() to initialize the calculator.
 // If appropriate, Open() should call cc->SetOffset() or
@@ -113,8 +114,10 @@ class CalculatorBase {
   //   }
 
   // Open is called before any Process() calls, on a freshly constructed
-  // calculator.  Subclasses may override this method to perform necessary
-  // setup, and possibly output Packets and/or set output streams' headers.
+  // calculator or on a calculator kept from the previous graph run after a
+  // successful Reset().  Subclasses may override this method to perform
+  // necessary setup, and possibly output Packets and/or set output streams'
+  // headers.
   // Must return ::mediapipe::OkStatus() to indicate success. On failure any
   // other status code can be returned. If failure is returned then the
   // framework will call neither Process() nor Close() on the calculator (so any
@@ -157,6 +160,18 @@ class CalculatorBase {
     return ::mediapipe::OkStatus();
   }
 
+  // Is called after Close() when a graph run has ended successfully.
+  // Subclasses may override this method to discard the state of the finished
+  // run and return ::mediapipe::OkStatus().  The framework then keeps the
+  // calculator for the next run of the graph and calls Open() on it again,
+  // instead of constructing a new calculator.  This allows expensive
+  // resources, such as a loaded model, to be kept across graph runs.  If any
+  // other status is returned, the calculator is destroyed.  The default
+  // implementation returns an UnimplementedError.
+  virtual ::mediapipe::Status Reset() {
+    return ::mediapipe::UnimplementedError("Reset() is not implemented.");
+  }
+
   // Returns a value according to which the framework selects
   // the next source calculator to Process(); smaller value means
   // Process() first. The default implementation returns the smallest
@@ -100,6 +100,15 @@ class EndCalculator : public CalculatorBase {
 };
 REGISTER_CALCULATOR(::mediapipe::EndCalculator);
 
+// A calculator registered as part of a statically linked set.
+class StaticallyRegisteredCalculator : public EndCalculator {};
+
+constexpr internal::CalculatorRegistration kStaticCalculators[] = {
+    MEDIAPIPE_CALCULATOR_REGISTRATION(
+        ::mediapipe::StaticallyRegisteredCalculator),
+};
+REGISTER_CALCULATORS(static_calculators, kStaticCalculators);
+
 namespace {
 
 TEST(CalculatorTest, SourceProcessOrder) {
@@ -189,6 +198,14 @@ TEST(CalculatorTest, CreateByName) {
             ::mediapipe::StatusCode::kNotFound);
 }
 
+TEST(CalculatorTest, CreateStaticallyRegistered) {
+  MEDIAPIPE_EXPECT_OK(CalculatorBaseRegistry::CreateByName(  //
+      "StaticallyRegisteredCalculator"));
+  MEDIAPIPE_EXPECT_OK(
+      internal::StaticAccessToCalculatorBaseRegistry::CreateByNameInNamespace(
+          "mediapipe", "StaticallyRegisteredCalculator"));
+}
+
 // Tests registration of a calculator within a whitelisted namespace.
 TEST(CalculatorTest, CreateByNameWhitelisted) {
   // Reset the registration namespace whitelist.
@@ -29,6 +29,7 @@
 #include "mediapipe/framework/port.h"
 #include "mediapipe/framework/port/any_proto.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/ring_buffer.h"
 #include "mediapipe/framework/timestamp.h"
 
 namespace mediapipe {
@@ -164,7 +165,7 @@ class CalculatorContext {
   InputStreamShardSet inputs_;
   OutputStreamShardSet outputs_;
   // The queue of timestamp values to Process() in this calculator context.
-  std::queue<Timestamp> input_timestamps_;
+  std::queue<Timestamp, RingBuffer<Timestamp>> input_timestamps_;
 
   // The status of the graph run. Only used when Close() is called.
   ::mediapipe::Status graph_status_;
@@ -113,14 +113,16 @@ class CalculatorContract {
     }
 
     // Internal use.
-    GraphServiceRequest(const GraphServiceBase& service) : service_(service) {}
+    GraphServiceRequest(const GraphServiceBase& service) : service_(&service) {}
 
-    const GraphServiceBase& Service() const { return service_; }
+    const GraphServiceBase& Service() const { return *service_; }
 
     bool IsOptional() const { return optional_; }
 
    private:
-    GraphServiceBase service_;
+    // Services are global constants.  Keeping a pointer instead of a copy
+    // lets GraphService<T>::create_default_packet see the typed service.
+    const GraphServiceBase* service_;
     bool optional_ = false;
   };
 
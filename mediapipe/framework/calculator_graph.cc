@@ -20,6 +20,7 @@
 #include <map>
 #include <memory>
 #include <queue>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -74,6 +75,21 @@ namespace {
 constexpr int kMaxNumAccumulatedErrors = 1000;
 constexpr char kApplicationThreadExecutorType[] = "ApplicationThreadExecutor";
 
+// Returns true if the graph input stream of any node in "node_ids" is
+// throttled, i.e. feeds a full input stream.
+template <typename NodeIds>
+bool AnyInputStreamThrottled(
+    const std::vector<std::unordered_set<InputStreamManager*>>&
+        full_input_streams,
+    const NodeIds& node_ids) {
+  for (int node_id : node_ids) {
+    if (!full_input_streams[node_id].empty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
 }  // namespace
 
 void CalculatorGraph::ScheduleAllOpenableNodes() {
@@ -168,7 +184,19 @@ CalculatorGraph::~CalculatorGraph() {}
     const EdgeInfo& edge_info = validated_graph_->InputStreamInfos()[index];
     RETURN_IF_ERROR(input_stream_managers_[index].Initialize(
         edge_info.name, edge_info.packet_type, edge_info.back_edge));
+#ifdef NDEBUG
+    // Every packet was validated against the upstream type when it was added
+    // to the output stream.
+    if (validated_graph_->Config().skip_implied_packet_type_checks() &&
+        edge_info.implied_by_upstream_type) {
+      input_stream_managers_[index].DisablePacketTypeValidation();
+      ++num_unchecked_input_streams_;
+    }
+#endif  // NDEBUG
   }
+  VLOG(1) << "Skipping packet type checks on " << num_unchecked_input_streams_
+          << " of " << validated_graph_->InputStreamInfos().size()
+          << " input streams.";
 
   // Create and initialize the output streams.
   output_stream_managers_ = absl::make_unique<OutputStreamManager[]>(
@@ -257,6 +285,7 @@ CalculatorGraph::~CalculatorGraph() {}
 
 ::mediapipe::Status CalculatorGraph::InitializeProfiler() {
   profiler_->Initialize(*validated_graph_);
+  profiler_->SetInputStreamManagers(input_stream_managers_.get());
   return ::mediapipe::OkStatus();
 }
 
@@ -351,11 +380,12 @@ CalculatorGraph::~CalculatorGraph() {}
 }
 
 ::mediapipe::Status CalculatorGraph::Initialize(
-    std::unique_ptr<ValidatedGraphConfig> validated_graph,
+    std::shared_ptr<const ValidatedGraphConfig> validated_graph,
     const std::map<std::string, Packet>& side_packets) {
   RET_CHECK(!initialized_).SetNoLogging()
       << "CalculatorGraph can be initialized only once.";
-  RET_CHECK(validated_graph->Initialized()).SetNoLogging()
+  RET_CHECK(validated_graph != nullptr && validated_graph->Initialized())
+      .SetNoLogging()
       << "validated_graph is not initialized.";
   validated_graph_ = std::move(validated_graph);
 
@@ -578,6 +608,89 @@ CalculatorGraph::PrepareGpu(const std::map<std::string, Packet>& side_packets) {
 }
 #endif  // !defined(MEDIAPIPE_DISABLE_GPU)
 
+::mediapipe::Status CalculatorGraph::PrepareDefaultServices() {
+  for (const auto& node_type_info : validated_graph_->CalculatorInfos()) {
+    for (const auto& service_request :
+         node_type_info.Contract().ServiceRequests()) {
+      const GraphServiceBase& service = service_request.second.Service();
+      if (service_request.second.IsOptional() ||
+          service.create_default_packet == nullptr ||
+          ContainsKey(service_packets_, service.key)) {
+        continue;
+      }
+      RETURN_IF_ERROR(
+          SetServicePacket(service, service.create_default_packet(service)));
+    }
+  }
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status CalculatorGraph::SetCriticalPathPriorities() {
+  const int num_nodes = validated_graph_->CalculatorInfos().size();
+  std::map<std::string, double> mean_runtimes;
+  std::vector<CalculatorProfile> profiles;
+  RETURN_IF_ERROR(profiler_->GetCalculatorProfiles(&profiles));
+  for (const CalculatorProfile& profile : profiles) {
+    int64 count = 0;
+    for (int64 interval_count : profile.process_runtime().count()) {
+      count += interval_count;
+    }
+    if (count > 0) {
+      mean_runtimes[profile.name()] =
+          static_cast<double>(profile.process_runtime().total()) / count;
+    }
+  }
+
+  // The nodes are sorted topologically, so the consumers of a node come
+  // after it, except along back edges, which are ignored.
+  std::vector<double> path_lengths(num_nodes, 0.0);
+  std::vector<double> downstream_lengths(num_nodes, 0.0);
+  for (int node_id = num_nodes - 1; node_id >= 0; --node_id) {
+    auto iter = mean_runtimes.find(
+        CanonicalNodeName(validated_graph_->Config(), node_id));
+    // Nodes that have not been profiled count as one microsecond.
+    const double runtime =
+        iter == mean_runtimes.end() ? 1.0 : std::max(iter->second, 1.0);
+    path_lengths[node_id] = runtime + downstream_lengths[node_id];
+
+    const NodeTypeInfo& node_type_info =
+        validated_graph_->CalculatorInfos()[node_id];
+    const int base_index = node_type_info.InputStreamBaseIndex();
+    for (int i = 0; i < node_type_info.InputStreamTypes().NumEntries(); ++i) {
+      const EdgeInfo& edge_info =
+          validated_graph_->InputStreamInfos()[base_index + i];
+      if (edge_info.back_edge) {
+        continue;
+      }
+      const NodeTypeInfo::NodeRef& producer =
+          validated_graph_->OutputStreamInfos()[edge_info.upstream].parent_node;
+      if (producer.type != NodeTypeInfo::NodeType::CALCULATOR) {
+        continue;
+      }
+      downstream_lengths[producer.index] = std::max(
+          downstream_lengths[producer.index], path_lengths[node_id]);
+    }
+  }
+
+  // Longer paths get lower ranks. Ties keep the default order, in which
+  // larger ids get lower ranks.
+  std::vector<int> node_ids(num_nodes);
+  for (int node_id = 0; node_id < num_nodes; ++node_id) {
+    node_ids[node_id] = node_id;
+  }
+  std::sort(node_ids.begin(), node_ids.end(),
+            [&path_lengths](int a, int b) {
+              if (path_lengths[a] != path_lengths[b]) {
+                return path_lengths[a] > path_lengths[b];
+              }
+              return a > b;
+            });
+  for (int rank = 0; rank < num_nodes; ++rank) {
+    (*nodes_)[node_ids[rank]].SetPriorityRank(rank);
+  }
+  return ::mediapipe::OkStatus();
+}
+
 ::mediapipe::Status CalculatorGraph::PrepareForRun(
     const std::map<std::string, Packet>& extra_side_packets,
     const std::map<std::string, Packet>& stream_headers) {
@@ -598,6 +711,7 @@ CalculatorGraph::PrepareGpu(const std::map<std::string, Packet>& side_packets) {
 #ifndef MEDIAPIPE_DISABLE_GPU
   ASSIGN_OR_RETURN(additional_side_packets, PrepareGpu(extra_side_packets));
 #endif  // !defined(MEDIAPIPE_DISABLE_GPU)
+  RETURN_IF_ERROR(PrepareDefaultServices());
 
   const std::map<std::string, Packet>* input_side_packets;
   if (!additional_side_packets.empty()) {
@@ -642,6 +756,20 @@ CalculatorGraph::PrepareGpu(const std::map<std::string, Packet>& side_packets) {
     RET_CHECK(default_executor);
   }
   scheduler_.Reset();
+  const bool use_lock_free_queues =
+      validated_graph_->Config().scheduler_queue_type() ==
+      CalculatorGraphConfig::LOCK_FREE_BUCKETS;
+  if (use_lock_free_queues) {
+    scheduler_.UseLockFreeQueues(validated_graph_->CalculatorInfos().size());
+  }
+  // Timing the scheduler queues slows down every queue operation.
+  scheduler_.SetQueueTimingEnabled(
+      use_lock_free_queues ||
+      validated_graph_->Config().profiler_config().enable_profiler());
+  if (validated_graph_->Config().node_priority() ==
+      CalculatorGraphConfig::CRITICAL_PATH) {
+    RETURN_IF_ERROR(SetCriticalPathPriorities());
+  }
 
   {
     absl::MutexLock lock(&full_input_streams_mutex_);
@@ -720,6 +848,19 @@ CalculatorGraph::PrepareGpu(const std::map<std::string, Packet>& side_packets) {
     (*stream)->SetMaxQueueSize(name_max.second);
   }
 
+  queue_size_budget_ = max_queue_size_ == -1
+                           ? 0
+                           : validated_graph_->Config().queue_size_budget();
+  {
+    absl::MutexLock lock(&queue_size_budget_mutex_);
+    total_max_queue_size_ = 0;
+    for (int index = 0; index < validated_graph_->InputStreamInfos().size();
+         ++index) {
+      total_max_queue_size_ +=
+          std::max(input_stream_managers_[index].MaxQueueSize(), 0);
+    }
+  }
+
   for (CalculatorNode& node : *nodes_) {
     if (node.IsSource()) {
       scheduler_.AddUnopenedSourceNode(&node);
@@ -776,6 +917,55 @@ CalculatorGraph::PrepareGpu(const std::map<std::string, Packet>& side_packets) {
   return scheduler_.WaitForObservedOutput();
 }
 
+template <typename NodeIds>
+::mediapipe::Status CalculatorGraph::WaitUntilGraphInputStreamsUnthrottled(
+    const NodeIds& node_ids) {
+  absl::MutexLock lock(&full_input_streams_mutex_);
+  if (graph_input_stream_add_mode_ ==
+      GraphInputStreamAddMode::ADD_IF_NOT_FULL) {
+    if (has_error_) {
+      ::mediapipe::Status error_status;
+      GetCombinedErrors("Graph has errors: ", &error_status);
+      return error_status;
+    }
+    // Return with StatusUnavailable if any of the streams is being throttled.
+    if (AnyInputStreamThrottled(full_input_streams_, node_ids)) {
+      return ::mediapipe::UnavailableErrorBuilder(MEDIAPIPE_LOC)
+             << "Graph is throttled.";
+    }
+  } else if (graph_input_stream_add_mode_ ==
+             GraphInputStreamAddMode::WAIT_TILL_NOT_FULL) {
+    // Wait until none of the streams is being throttled.
+    // TODO: instead of checking has_error_, we could just check
+    // if the graph is done. That could also be indicated by returning an
+    // error from WaitUntilGraphInputStreamUnthrottled.
+    while (!has_error_ &&
+           AnyInputStreamThrottled(full_input_streams_, node_ids)) {
+      // TODO: allow waiting for a specific stream?
+      scheduler_.WaitUntilGraphInputStreamUnthrottled(
+          &full_input_streams_mutex_);
+    }
+    if (has_error_) {
+      ::mediapipe::Status error_status;
+      GetCombinedErrors("Graph has errors: ", &error_status);
+      return error_status;
+    }
+  }
+  return ::mediapipe::OkStatus();
+}
+
+void CalculatorGraph::LogGraphInputPacket(GraphInputStream* stream,
+                                          const Packet& packet) {
+  // Adding profiling info for a new packet entering the graph.
+  const std::string* stream_id = &stream->GetManager()->Name();
+  profiler_->LogEvent(TraceEvent(TraceEvent::PROCESS)
+                          .set_is_finish(true)
+                          .set_input_ts(packet.Timestamp())
+                          .set_stream_id(stream_id)
+                          .set_packet_ts(packet.Timestamp())
+                          .set_packet_data_id(&packet));
+}
+
 ::mediapipe::Status CalculatorGraph::AddPacketToInputStream(
     const std::string& stream_name, const Packet& packet) {
   return AddPacketToInputStreamInternal(stream_name, packet);
@@ -802,47 +992,10 @@ template <typename T>
   int node_id =
       ::mediapipe::FindOrDie(graph_input_stream_node_ids_, stream_name);
   CHECK_GE(node_id, validated_graph_->CalculatorInfos().size());
-  {
-    absl::MutexLock lock(&full_input_streams_mutex_);
-    if (graph_input_stream_add_mode_ ==
-        GraphInputStreamAddMode::ADD_IF_NOT_FULL) {
-      if (has_error_) {
-        ::mediapipe::Status error_status;
-        GetCombinedErrors("Graph has errors: ", &error_status);
-        return error_status;
-      }
-      // Return with StatusUnavailable if this stream is being throttled.
-      if (!full_input_streams_[node_id].empty()) {
-        return ::mediapipe::UnavailableErrorBuilder(MEDIAPIPE_LOC)
-               << "Graph is throttled.";
-      }
-    } else if (graph_input_stream_add_mode_ ==
-               GraphInputStreamAddMode::WAIT_TILL_NOT_FULL) {
-      // Wait until this stream is not being throttled.
-      // TODO: instead of checking has_error_, we could just check
-      // if the graph is done. That could also be indicated by returning an
-      // error from WaitUntilGraphInputStreamUnthrottled.
-      while (!has_error_ && !full_input_streams_[node_id].empty()) {
-        // TODO: allow waiting for a specific stream?
-        scheduler_.WaitUntilGraphInputStreamUnthrottled(
-            &full_input_streams_mutex_);
-      }
-      if (has_error_) {
-        ::mediapipe::Status error_status;
-        GetCombinedErrors("Graph has errors: ", &error_status);
-        return error_status;
-      }
-    }
-  }
+  const int node_ids[] = {node_id};
+  RETURN_IF_ERROR(WaitUntilGraphInputStreamsUnthrottled(node_ids));
 
-  // Adding profiling info for a new packet entering the graph.
-  const std::string* stream_id = &(*stream)->GetManager()->Name();
-  profiler_->LogEvent(TraceEvent(TraceEvent::PROCESS)
-                          .set_is_finish(true)
-                          .set_input_ts(packet.Timestamp())
-                          .set_stream_id(stream_id)
-                          .set_packet_ts(packet.Timestamp())
-                          .set_packet_data_id(&packet));
+  LogGraphInputPacket(stream->get(), packet);
 
   // InputStreamManager is thread safe. GraphInputStream is not, so this method
   // should not be called by multiple threads concurrently. Note that this could
@@ -865,6 +1018,61 @@ template <typename T>
   return ::mediapipe::OkStatus();
 }
 
+::mediapipe::Status CalculatorGraph::AddPacketsToInputStreams(
+    std::map<std::string, std::vector<Packet>> packets) {
+  // Looks up all the streams first, so that nothing is added on error.
+  std::vector<GraphInputStream*> streams;
+  std::vector<int> node_ids;
+  streams.reserve(packets.size());
+  node_ids.reserve(packets.size());
+  for (const auto& stream_packets : packets) {
+    const std::string& stream_name = stream_packets.first;
+    std::unique_ptr<GraphInputStream>* stream =
+        ::mediapipe::FindOrNull(graph_input_streams_, stream_name);
+    RET_CHECK(stream).SetNoLogging() << absl::Substitute(
+        "AddPacketsToInputStreams called on input stream \"$0\" which is "
+        "not a graph input stream.",
+        stream_name);
+    int node_id =
+        ::mediapipe::FindOrDie(graph_input_stream_node_ids_, stream_name);
+    CHECK_GE(node_id, validated_graph_->CalculatorInfos().size());
+    streams.push_back(stream->get());
+    node_ids.push_back(node_id);
+  }
+  RETURN_IF_ERROR(WaitUntilGraphInputStreamsUnthrottled(node_ids));
+
+  int index = 0;
+  for (auto& stream_packets : packets) {
+    GraphInputStream* stream = streams[index++];
+    if (stream_packets.second.empty()) {
+      continue;
+    }
+    for (Packet& packet : stream_packets.second) {
+      LogGraphInputPacket(stream, packet);
+      stream->AddPacket(std::move(packet));
+    }
+    if (has_error_) {
+      ::mediapipe::Status error_status;
+      GetCombinedErrors("Graph has errors: ", &error_status);
+      return error_status;
+    }
+    // Delivers all the packets of this stream to its mirrors at once.
+    stream->PropagateUpdatesToMirrors();
+  }
+
+  VLOG(2) << "Packets added directly to " << packets.size()
+          << " graph input streams.";
+  scheduler_.AddedPacketToGraphInputStream();
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status CalculatorGraph::AddPacketsToInputStream(
+    const std::string& stream_name, std::vector<Packet> packets) {
+  std::map<std::string, std::vector<Packet>> batch;
+  batch.emplace(stream_name, std::move(packets));
+  return AddPacketsToInputStreams(std::move(batch));
+}
+
 ::mediapipe::Status CalculatorGraph::SetInputStreamMaxQueueSize(
     const std::string& stream_name, int max_queue_size) {
   // graph_input_streams_ has not been filled in yet, so we'll check this when
@@ -1014,6 +1222,10 @@ int CalculatorGraph::GetMaxInputStreamQueueSize() { return max_queue_size_; }
 
 void CalculatorGraph::UpdateThrottledNodes(InputStreamManager* stream,
                                            bool* stream_was_full) {
+  if (queue_size_budget_ > 0 && stream->IsFull() &&
+      GrowQueueWithinBudget(stream)) {
+    return;
+  }
   // TODO Change the throttling code to use the index directly
   // rather than looking up a stream name.
   int node_index = validated_graph_->OutputStreamToNode(stream->Name());
@@ -1039,6 +1251,9 @@ void CalculatorGraph::UpdateThrottledNodes(InputStreamManager* stream,
     // in this function and is guarded by full_input_streams_mutex_.
     bool stream_is_full = stream->IsFull();
     if (*stream_was_full != stream_is_full) {
+      if (!upstream_nodes->empty()) {
+        stream->SetThrottling(stream_is_full);
+      }
       for (int node_id : *upstream_nodes) {
         VLOG(2) << "Stream \"" << stream->Name() << "\" is "
                 << (stream_is_full ? "throttling" : "no longer throttling")
@@ -1088,6 +1303,33 @@ void CalculatorGraph::UpdateThrottledNodes(InputStreamManager* stream,
   }
 }
 
+bool CalculatorGraph::GrowQueueWithinBudget(InputStreamManager* stream) {
+  // Only calculator input streams are tuned. The queue size of a graph output
+  // stream is left to the caller of the graph.
+  const int num_input_streams = validated_graph_->InputStreamInfos().size();
+  if (stream < &input_stream_managers_[0] ||
+      stream >= &input_stream_managers_[0] + num_input_streams) {
+    return false;
+  }
+  absl::MutexLock lock(&queue_size_budget_mutex_);
+  const int max_queue_size = stream->MaxQueueSize();
+  if (max_queue_size <= 0) {
+    return false;
+  }
+  const int64 growth = std::min<int64>(
+      max_queue_size, queue_size_budget_ - total_max_queue_size_);
+  if (growth <= 0) {
+    return false;
+  }
+  total_max_queue_size_ += growth;
+  // Calls UpdateThrottledNodes() if the stream becomes non-full, which finds
+  // the stream non-full and therefore never throttled.
+  stream->SetMaxQueueSize(max_queue_size + growth);
+  VLOG(2) << "Increased max_queue_size of input stream \"" << stream->Name()
+          << "\" to " << max_queue_size + growth;
+  return !stream->IsFull();
+}
+
 bool CalculatorGraph::IsNodeThrottled(int node_id) {
   absl::MutexLock lock(&full_input_streams_mutex_);
   return max_queue_size_ != -1 && !full_input_streams_[node_id].empty();
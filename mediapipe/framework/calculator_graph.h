@@ -130,6 +130,13 @@ class CalculatorGraph {
   // Convenience version which does not take side packets.
   ::mediapipe::Status Initialize(const CalculatorGraphConfig& config);
 
+  // Initializes the graph from a ValidatedGraphConfig object, which can be
+  // shared by many graphs.  ValidatedGraphConfigCache provides shared
+  // ValidatedGraphConfigs for repeatedly used configs.
+  ::mediapipe::Status Initialize(
+      std::shared_ptr<const ValidatedGraphConfig> validated_graph,
+      const std::map<std::string, Packet>& side_packets);
+
   // Initializes the CalculatorGraph from the specified graph and subgraph
   // configs.  Template graph and subgraph configs can be specified through
   // |input_templates|.  Every subgraph must have its graph type specified in
@@ -252,6 +259,23 @@ class CalculatorGraph {
   ::mediapipe::Status AddPacketToInputStream(const std::string& stream_name,
                                              Packet&& packet);
 
+  // Adds a batch of packets to graph input streams. "packets" maps the name of
+  // each graph input stream to its packets, in increasing timestamp order.
+  // The result is the same as calling AddPacketToInputStream() for every
+  // packet, except that the graph input stream add mode is applied once to
+  // the whole batch: with ADD_IF_NOT_FULL nothing is added if any of the
+  // streams is throttled, and with WAIT_TILL_NOT_FULL the call blocks until
+  // none of them is. The packets of each stream are then delivered together,
+  // and the scheduler is notified once. A batch can therefore exceed
+  // max_queue_size by up to its own size. Like AddPacketToInputStream(), this
+  // should not be called by multiple threads concurrently.
+  ::mediapipe::Status AddPacketsToInputStreams(
+      std::map<std::string, std::vector<Packet>> packets);
+
+  // Same as AddPacketsToInputStreams() for a single graph input stream.
+  ::mediapipe::Status AddPacketsToInputStream(const std::string& stream_name,
+                                              std::vector<Packet> packets);
+
   // Sets the queue size of a graph input stream, overriding the graph default.
   ::mediapipe::Status SetInputStreamMaxQueueSize(const std::string& stream_name,
                                                  int max_queue_size);
@@ -303,6 +327,12 @@ class CalculatorGraph {
   // Returns the maximum input stream queue size.
   int GetMaxInputStreamQueueSize();
 
+  // Returns the number of input streams that do not validate the types of
+  // arriving packets, because skip_implied_packet_type_checks is set in the
+  // graph config.  This counts streams, not individual packet checks.  Always
+  // 0 in debug builds.
+  int NumUncheckedInputStreams() const { return num_unchecked_input_streams_; }
+
   // Get the mode for adding packets to an input stream.
   GraphInputStreamAddMode GetGraphInputStreamAddMode() const;
 
@@ -367,6 +397,12 @@ class CalculatorGraph {
   ::mediapipe::StatusOr<std::map<std::string, Packet>> PrepareGpu(
       const std::map<std::string, Packet>& side_packets);
 #endif  // !defined(MEDIAPIPE_DISABLE_GPU)
+
+  // Helper for PrepareForRun.  Creates the default object of each service
+  // that a calculator requires, if the service has a default and its object
+  // has not been set.
+  ::mediapipe::Status PrepareDefaultServices();
+
   template <typename T>
   ::mediapipe::Status SetServiceObject(const GraphService<T>& service,
                                        std::shared_ptr<T> object) {
@@ -435,11 +471,6 @@ class CalculatorGraph {
     OutputStreamShard shard_;
   };
 
-  // Initializes the graph from a ValidatedGraphConfig object.
-  ::mediapipe::Status Initialize(
-      std::unique_ptr<ValidatedGraphConfig> validated_graph,
-      const std::map<std::string, Packet>& side_packets);
-
   // AddPacketToInputStreamInternal template is called by either
   // AddPacketToInputStream(Packet&& packet) or
   // AddPacketToInputStream(const Packet& packet).
@@ -447,6 +478,16 @@ class CalculatorGraph {
   ::mediapipe::Status AddPacketToInputStreamInternal(
       const std::string& stream_name, T&& packet);
 
+  // Applies graph_input_stream_add_mode_ before packets are added to the
+  // graph input streams of the nodes in "node_ids": returns an error or
+  // blocks while any of those streams is throttled.
+  template <typename NodeIds>
+  ::mediapipe::Status WaitUntilGraphInputStreamsUnthrottled(
+      const NodeIds& node_ids) LOCKS_EXCLUDED(full_input_streams_mutex_);
+
+  // Logs the profiler event for a packet entering the graph through "stream".
+  void LogGraphInputPacket(GraphInputStream* stream, const Packet& packet);
+
   // Sets the executor that will run the nodes assigned to the executor
   // named |name|.  If |name| is empty, this sets the default executor.
   // Does not check that the graph is uninitialized and |name| is not a
@@ -488,6 +529,11 @@ class CalculatorGraph {
       const std::map<std::string, Packet>& extra_side_packets,
       const std::map<std::string, Packet>& stream_headers);
 
+  // Helper for PrepareForRun. Sets the priority ranks of the calculator nodes
+  // so that the nodes with the longest remaining path to the graph outputs
+  // run first. See CalculatorGraphConfig::CRITICAL_PATH.
+  ::mediapipe::Status SetCriticalPathPriorities();
+
   // Cleans up any remaining state after the run and returns any errors that may
   // have occurred during the run. Called after the scheduler has terminated.
   ::mediapipe::Status FinishRun();
@@ -527,6 +573,12 @@ class CalculatorGraph {
   // status before taking any action.
   void UpdateThrottledNodes(InputStreamManager* stream, bool* stream_was_full);
 
+  // Grows the max queue size of a full calculator input stream within the
+  // queue_size_budget of the graph config. Returns true if the stream is no
+  // longer full.
+  bool GrowQueueWithinBudget(InputStreamManager* stream)
+      LOCKS_EXCLUDED(queue_size_budget_mutex_);
+
   Packet GetServicePacket(const GraphServiceBase& service);
 #ifndef MEDIAPIPE_DISABLE_GPU
   // Owns the legacy GpuSharedData if we need to create one for backwards
@@ -541,7 +593,7 @@ class CalculatorGraph {
   PacketType any_packet_type_;
 
   // The ValidatedGraphConfig object defining this CalculatorGraph.
-  std::unique_ptr<ValidatedGraphConfig> validated_graph_;
+  std::shared_ptr<const ValidatedGraphConfig> validated_graph_;
 
   // The PacketGeneratorGraph to use to generate all the input side packets.
   PacketGeneratorGraph packet_generator_graph_;
@@ -568,6 +620,16 @@ class CalculatorGraph {
   // restrict memory usage.
   int max_queue_size_ = -1;
 
+  // See NumUncheckedInputStreams().
+  int num_unchecked_input_streams_ = 0;
+
+  // The queue_size_budget of the graph config, or 0 if the max queue sizes
+  // are not tuned in the current run.
+  int queue_size_budget_ = 0;
+  // The sum of the max queue sizes of the calculator input streams.
+  int64 total_max_queue_size_ GUARDED_BY(queue_size_budget_mutex_) = 0;
+  absl::Mutex queue_size_budget_mutex_;
+
   // Mode for adding packets to a graph input stream. Set to block until all
   // affected input streams are not full by default.
   GraphInputStreamAddMode graph_input_stream_add_mode_
@@ -15,12 +15,14 @@
 #include "mediapipe/framework/calculator_graph.h"
 
 #include <pthread.h>
+#include <sched.h>
 
 #include <atomic>
 #include <ctime>
 #include <deque>
 #include <map>
 #include <memory>
+#include <set>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -42,6 +44,7 @@
 #include "mediapipe/framework/output_stream_poller.h"
 #include "mediapipe/framework/packet_set.h"
 #include "mediapipe/framework/packet_type.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
@@ -1791,6 +1794,168 @@ TEST(CalculatorGraph, RunsCorrectlyWithExternalExecutor) {
   RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
 }
 
+TEST(CalculatorGraph, RunsCorrectlyWithWorkStealingExecutor) {
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.SetExecutor(
+      "", std::make_shared<ThreadPoolExecutor>(4, /*work_stealing=*/true)));
+  CalculatorGraphConfig proto = GetConfig();
+  RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
+}
+
+TEST(CalculatorGraph, RunsCorrectlyWithWorkStealingDefaultExecutor) {
+  CalculatorGraph graph;
+  CalculatorGraphConfig proto = GetConfig();
+  ExecutorConfig* executor = proto.add_executor();
+  ThreadPoolExecutorOptions* extension =
+      executor->mutable_options()->MutableExtension(
+          ThreadPoolExecutorOptions::ext);
+  extension->set_num_threads(4);
+  extension->set_queueing_policy(ThreadPoolExecutorOptions::WORK_STEALING);
+  RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
+}
+
+TEST(CalculatorGraph, RunsCorrectlyWithLockFreeSchedulerQueue) {
+  CalculatorGraph graph;
+  CalculatorGraphConfig proto = GetConfig();
+  proto.set_num_threads(4);
+  proto.set_scheduler_queue_type(CalculatorGraphConfig::LOCK_FREE_BUCKETS);
+  RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
+  internal::SchedulerTimes times = graph.GetSchedulerTimes();
+  EXPECT_GT(times.num_queue_operations, 0);
+  EXPECT_GE(times.queue_time, 0);
+}
+
+// The scheduler queue operations are not timed by default.
+TEST(CalculatorGraph, SchedulerQueueNotTimedByDefault) {
+  CalculatorGraph graph;
+  CalculatorGraphConfig proto = GetConfig();
+  proto.set_num_threads(4);
+  RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
+  internal::SchedulerTimes times = graph.GetSchedulerTimes();
+  EXPECT_EQ(0, times.num_queue_operations);
+  EXPECT_EQ(0, times.queue_time);
+}
+
+// A pass-through calculator that appends its node name to the vector in the
+// "ORDER" input side packet each time Process() is called. If the "SLEEP"
+// input side packet is specified, Process() first sleeps for that duration.
+class RecordProcessOrderCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).SetSameAs(&cc->Inputs().Index(0));
+    cc->InputSidePackets().Tag("ORDER").Set<std::vector<std::string>*>();
+    if (cc->InputSidePackets().HasTag("SLEEP")) {
+      cc->InputSidePackets().Tag("SLEEP").Set<absl::Duration>();
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) final {
+    if (cc->InputSidePackets().HasTag("SLEEP")) {
+      absl::SleepFor(cc->InputSidePackets().Tag("SLEEP").Get<absl::Duration>());
+    }
+    cc->InputSidePackets()
+        .Tag("ORDER")
+        .Get<std::vector<std::string>*>()
+        ->push_back(cc->NodeName());
+    cc->Outputs().Index(0).AddPacket(cc->Inputs().Index(0).Value());
+    return ::mediapipe::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(RecordProcessOrderCalculator);
+
+// Returns a graph with two branches that become runnable at the same time: a
+// chain of three nodes "x", "y", "z", and a single node "a", which sleeps for
+// the duration in the "a_sleep" side packet. The graph runs on the
+// application thread, so that the nodes run one at a time.
+CalculatorGraphConfig GetTwoBranchConfig(
+    CalculatorGraphConfig::NodePriority node_priority) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: 'in'
+        executor { type: 'ApplicationThreadExecutor' }
+        node {
+          name: 'x'
+          calculator: 'RecordProcessOrderCalculator'
+          input_stream: 'in'
+          output_stream: 'x_out'
+          input_side_packet: 'ORDER:order'
+        }
+        node {
+          name: 'y'
+          calculator: 'RecordProcessOrderCalculator'
+          input_stream: 'x_out'
+          output_stream: 'y_out'
+          input_side_packet: 'ORDER:order'
+        }
+        node {
+          name: 'z'
+          calculator: 'RecordProcessOrderCalculator'
+          input_stream: 'y_out'
+          output_stream: 'z_out'
+          input_side_packet: 'ORDER:order'
+        }
+        node {
+          name: 'a'
+          calculator: 'RecordProcessOrderCalculator'
+          input_stream: 'in'
+          output_stream: 'a_out'
+          input_side_packet: 'ORDER:order'
+          input_side_packet: 'SLEEP:a_sleep'
+        }
+      )");
+  config.set_node_priority(node_priority);
+  return config;
+}
+
+// Runs the graph on a single packet and returns the order in which the nodes
+// processed it.
+std::vector<std::string> RunTwoBranchGraph(CalculatorGraph* graph) {
+  std::vector<std::string> order;
+  MEDIAPIPE_EXPECT_OK(
+      graph->StartRun({{"order", MakePacket<std::vector<std::string>*>(&order)},
+                       {"a_sleep", MakePacket<absl::Duration>(
+                                       absl::Milliseconds(20))}}));
+  MEDIAPIPE_EXPECT_OK(
+      graph->AddPacketToInputStream("in", MakePacket<int>(1).At(Timestamp(0))));
+  MEDIAPIPE_EXPECT_OK(graph->CloseAllInputStreams());
+  MEDIAPIPE_EXPECT_OK(graph->WaitUntilDone());
+  return order;
+}
+
+TEST(CalculatorGraph, NodeOrderPriorityRunsLaterNodesFirst) {
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(
+      graph.Initialize(GetTwoBranchConfig(CalculatorGraphConfig::NODE_ORDER)));
+  EXPECT_THAT(RunTwoBranchGraph(&graph),
+              testing::ElementsAre("a", "x", "y", "z"));
+}
+
+TEST(CalculatorGraph, CriticalPathPriorityRunsLongestPathFirst) {
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(
+      GetTwoBranchConfig(CalculatorGraphConfig::CRITICAL_PATH)));
+  // Once "y" has run, "z" and "a" both have one node left on their path, so
+  // they run in the default order.
+  EXPECT_THAT(RunTwoBranchGraph(&graph),
+              testing::ElementsAre("x", "y", "a", "z"));
+}
+
+// Once the profiler has recorded that "a" takes much longer than the whole
+// chain, "a" is on the critical path and runs first.
+TEST(CalculatorGraph, CriticalPathPriorityUsesProfiledRuntimes) {
+  CalculatorGraphConfig config =
+      GetTwoBranchConfig(CalculatorGraphConfig::CRITICAL_PATH);
+  config.mutable_profiler_config()->set_enable_profiler(true);
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  EXPECT_THAT(RunTwoBranchGraph(&graph),
+              testing::ElementsAre("x", "y", "a", "z"));
+  EXPECT_THAT(RunTwoBranchGraph(&graph),
+              testing::ElementsAre("a", "x", "y", "z"));
+}
+
 // This test verifies that the MediaPipe framework calls Executor::AddTask()
 // without holding any mutex, because CurrentThreadExecutor::AddTask() may
 // result in a recursive call to itself.
@@ -1863,6 +2028,182 @@ TEST(CalculatorGraph, RunsCorrectlyWithMultipleExecutors) {
   RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
 }
 
+#if defined(__linux__)
+// Returns the processors that the calling thread may run on.
+std::set<int> GetCurrentThreadCpus() {
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CHECK_EQ(0, sched_getaffinity(0, sizeof(cpu_set), &cpu_set));
+  std::set<int> cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &cpu_set)) {
+      cpus.insert(cpu);
+    }
+  }
+  return cpus;
+}
+
+// Outputs the processors that the thread running Process() may run on.
+class CpuAffinityCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).Set<std::set<int>>();
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) final {
+    cc->Outputs().Index(0).Add(new std::set<int>(GetCurrentThreadCpus()),
+                               cc->InputTimestamp());
+    return ::mediapipe::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(CpuAffinityCalculator);
+
+TEST(CalculatorGraph, ExecutorPinnedToCpu) {
+  const int cpu = *GetCurrentThreadCpus().rbegin();
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: 'in'
+        executor {
+          name: 'pinned'
+          type: 'ThreadPoolExecutor'
+          options {
+            [mediapipe.ThreadPoolExecutorOptions.ext] {
+              num_threads: 2
+              pin_one_thread_per_cpu: true
+            }
+          }
+        }
+        node {
+          calculator: 'CpuAffinityCalculator'
+          executor: 'pinned'
+          input_stream: 'in'
+          output_stream: 'cpus'
+        }
+      )");
+  config.mutable_executor(0)
+      ->mutable_options()
+      ->MutableExtension(ThreadPoolExecutorOptions::ext)
+      ->add_cpu(cpu);
+  std::vector<Packet> cpus_packets;
+  tool::AddVectorSink("cpus", &config, &cpus_packets);
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < 10; ++i) {
+    MEDIAPIPE_EXPECT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MEDIAPIPE_ASSERT_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+  ASSERT_EQ(10, cpus_packets.size());
+  for (const Packet& packet : cpus_packets) {
+    EXPECT_THAT(packet.Get<std::set<int>>(), testing::ElementsAre(cpu));
+  }
+}
+
+// Without a cpu field, the threads are pinned to the processors the process
+// is allowed to run on.
+TEST(CalculatorGraph, ExecutorPinnedToAllowedCpus) {
+  const std::set<int> allowed_cpus = GetCurrentThreadCpus();
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: 'in'
+        executor {
+          name: 'pinned'
+          type: 'ThreadPoolExecutor'
+          options {
+            [mediapipe.ThreadPoolExecutorOptions.ext] {
+              num_threads: 2
+              pin_one_thread_per_cpu: true
+            }
+          }
+        }
+        node {
+          calculator: 'CpuAffinityCalculator'
+          executor: 'pinned'
+          input_stream: 'in'
+          output_stream: 'cpus'
+        }
+      )");
+  std::vector<Packet> cpus_packets;
+  tool::AddVectorSink("cpus", &config, &cpus_packets);
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < 10; ++i) {
+    MEDIAPIPE_EXPECT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MEDIAPIPE_ASSERT_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+  ASSERT_EQ(10, cpus_packets.size());
+  for (const Packet& packet : cpus_packets) {
+    const std::set<int>& cpus = packet.Get<std::set<int>>();
+    ASSERT_EQ(1, cpus.size());
+    EXPECT_EQ(1, allowed_cpus.count(*cpus.begin()));
+  }
+}
+
+TEST(CalculatorGraph, ExecutorWithCpuOutsideAffinityMask) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: 'in'
+        executor {
+          name: 'pinned'
+          type: 'ThreadPoolExecutor'
+          options {
+            [mediapipe.ThreadPoolExecutorOptions.ext] {
+              num_threads: 1
+            }
+          }
+        }
+        node {
+          calculator: 'PassThroughCalculator'
+          executor: 'pinned'
+          input_stream: 'in'
+          output_stream: 'out'
+        }
+      )");
+  config.mutable_executor(0)
+      ->mutable_options()
+      ->MutableExtension(ThreadPoolExecutorOptions::ext)
+      ->add_cpu(CPU_SETSIZE);
+  CalculatorGraph graph;
+  ::mediapipe::Status status = graph.Initialize(config);
+  EXPECT_EQ(status.code(), ::mediapipe::StatusCode::kInvalidArgument);
+  EXPECT_THAT(status.message(), testing::HasSubstr("cpu"));
+}
+#endif  // defined(__linux__)
+
+TEST(CalculatorGraph, ExecutorWithNegativeCpu) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: 'in'
+        executor {
+          name: 'pinned'
+          type: 'ThreadPoolExecutor'
+          options {
+            [mediapipe.ThreadPoolExecutorOptions.ext] {
+              num_threads: 1
+              cpu: -1
+            }
+          }
+        }
+        node {
+          calculator: 'PassThroughCalculator'
+          executor: 'pinned'
+          input_stream: 'in'
+          output_stream: 'out'
+        }
+      )");
+  CalculatorGraph graph;
+  ::mediapipe::Status status = graph.Initialize(config);
+  EXPECT_EQ(status.code(), ::mediapipe::StatusCode::kInvalidArgument);
+  EXPECT_THAT(status.message(), testing::HasSubstr("cpu"));
+}
+
 // Packet generator for an arbitrary unit64 packet.
 class Uint64PacketGenerator : public PacketGenerator {
  public:
@@ -3944,6 +4285,175 @@ TEST(CalculatorGraph, SetInputStreamMaxQueueSizeWorksSlowCalculator) {
   MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
 }
 
+TEST(CalculatorGraph, AddPacketsToInputStreams) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: 'in'
+        input_stream: 'in_2'
+        node {
+          calculator: 'PassThroughCalculator'
+          input_stream: 'in'
+          output_stream: 'out'
+        }
+        node {
+          calculator: 'PassThroughCalculator'
+          input_stream: 'in_2'
+          output_stream: 'out_2'
+        }
+      )");
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  std::vector<Packet> out_packets;
+  std::vector<Packet> out_2_packets;
+  MEDIAPIPE_ASSERT_OK(
+      graph.ObserveOutputStream("out", [&out_packets](const Packet& packet) {
+        out_packets.push_back(packet);
+        return ::mediapipe::OkStatus();
+      }));
+  MEDIAPIPE_ASSERT_OK(graph.ObserveOutputStream(
+      "out_2", [&out_2_packets](const Packet& packet) {
+        out_2_packets.push_back(packet);
+        return ::mediapipe::OkStatus();
+      }));
+  MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+
+  const int kBatchSize = 5;
+  for (int batch = 0; batch < 3; ++batch) {
+    std::map<std::string, std::vector<Packet>> packets;
+    for (int i = 0; i < kBatchSize; ++i) {
+      const int count = batch * kBatchSize + i;
+      packets["in"].push_back(MakePacket<int>(count).At(Timestamp(count)));
+      packets["in_2"].push_back(
+          MakePacket<int>(-count).At(Timestamp(count)));
+    }
+    MEDIAPIPE_EXPECT_OK(graph.AddPacketsToInputStreams(std::move(packets)));
+  }
+  MEDIAPIPE_ASSERT_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+
+  ASSERT_EQ(3 * kBatchSize, out_packets.size());
+  ASSERT_EQ(3 * kBatchSize, out_2_packets.size());
+  for (int i = 0; i < 3 * kBatchSize; ++i) {
+    EXPECT_EQ(i, out_packets[i].Get<int>());
+    EXPECT_EQ(Timestamp(i), out_packets[i].Timestamp());
+    EXPECT_EQ(-i, out_2_packets[i].Get<int>());
+    EXPECT_EQ(Timestamp(i), out_2_packets[i].Timestamp());
+  }
+}
+
+// A batch that names an unknown stream is rejected as a whole.
+TEST(CalculatorGraph, AddPacketsToInputStreamsUnknownStream) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: 'in'
+        node {
+          calculator: 'PassThroughCalculator'
+          input_stream: 'in'
+          output_stream: 'out'
+        }
+      )");
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  std::vector<Packet> out_packets;
+  MEDIAPIPE_ASSERT_OK(
+      graph.ObserveOutputStream("out", [&out_packets](const Packet& packet) {
+        out_packets.push_back(packet);
+        return ::mediapipe::OkStatus();
+      }));
+  MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+  std::map<std::string, std::vector<Packet>> packets;
+  packets["in"].push_back(MakePacket<int>(0).At(Timestamp(0)));
+  packets["unknown"].push_back(MakePacket<int>(0).At(Timestamp(0)));
+  ::mediapipe::Status status = graph.AddPacketsToInputStreams(packets);
+  EXPECT_FALSE(status.ok());
+  MEDIAPIPE_ASSERT_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_TRUE(out_packets.empty());
+}
+
+// In ADD_IF_NOT_FULL mode, a whole batch is rejected while any of its streams
+// is throttled.
+TEST(CalculatorGraph, AddPacketsToInputStreamsIfNotFull) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: 'in'
+        node {
+          calculator: 'PassThroughCalculator'
+          input_stream: 'in'
+          output_stream: 'out'
+        }
+        executor { type: 'ApplicationThreadExecutor' }
+      )");
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  graph.SetGraphInputStreamAddMode(
+      CalculatorGraph::GraphInputStreamAddMode::ADD_IF_NOT_FULL);
+  MEDIAPIPE_ASSERT_OK(graph.SetInputStreamMaxQueueSize("in", 2));
+  std::vector<Packet> out_packets;
+  MEDIAPIPE_ASSERT_OK(
+      graph.ObserveOutputStream("out", [&out_packets](const Packet& packet) {
+        out_packets.push_back(packet);
+        return ::mediapipe::OkStatus();
+      }));
+  MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+  // The ApplicationThreadExecutor runs nothing until WaitUntilDone(), so the
+  // first batch fills the queue of "in".
+  std::vector<Packet> batch;
+  for (int i = 0; i < 3; ++i) {
+    batch.push_back(MakePacket<int>(i).At(Timestamp(i)));
+  }
+  MEDIAPIPE_EXPECT_OK(graph.AddPacketsToInputStream("in", batch));
+  ::mediapipe::Status status = graph.AddPacketsToInputStream(
+      "in", {MakePacket<int>(3).At(Timestamp(3))});
+  EXPECT_EQ(::mediapipe::StatusCode::kUnavailable, status.code());
+  MEDIAPIPE_ASSERT_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+  ASSERT_EQ(3, out_packets.size());
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(i, out_packets[i].Get<int>());
+  }
+}
+
+// With a queue_size_budget, a full input stream grows instead of throttling
+// its sources, until the budget is used up.
+TEST(CalculatorGraph, QueueSizeBudget) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: 'in'
+        node {
+          calculator: 'PassThroughCalculator'
+          input_stream: 'in'
+          output_stream: 'out'
+        }
+        max_queue_size: 2
+        queue_size_budget: 8
+        executor { type: 'ApplicationThreadExecutor' }
+      )");
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  graph.SetGraphInputStreamAddMode(
+      CalculatorGraph::GraphInputStreamAddMode::ADD_IF_NOT_FULL);
+  std::vector<Packet> out_packets;
+  MEDIAPIPE_ASSERT_OK(
+      graph.ObserveOutputStream("out", [&out_packets](const Packet& packet) {
+        out_packets.push_back(packet);
+        return ::mediapipe::OkStatus();
+      }));
+  MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+  // The ApplicationThreadExecutor runs nothing until WaitUntilDone(), so the
+  // queue of "in" grows from 2 to 4 to 8 packets and then stays full.
+  for (int i = 0; i < 8; ++i) {
+    MEDIAPIPE_EXPECT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  ::mediapipe::Status status = graph.AddPacketToInputStream(
+      "in", MakePacket<int>(8).At(Timestamp(8)));
+  EXPECT_EQ(::mediapipe::StatusCode::kUnavailable, status.code());
+  MEDIAPIPE_ASSERT_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_EQ(8, out_packets.size());
+}
+
 // Verify the scheduler unthrottles the graph input stream to avoid a deadlock,
 // and won't enter a busy loop.
 TEST(CalculatorGraph, AddPacketNoBusyLoop) {
@@ -5370,6 +5880,168 @@ TEST(CalculatorGraph, OutputSummarySidePacketInClose) {
   }
 }
 
+// Counts the calculators constructed, opened, and reset.
+std::atomic<int> g_num_constructed(0);
+std::atomic<int> g_num_opened(0);
+std::atomic<int> g_num_reset(0);
+
+// Outputs the number of packets it has processed during the current run,
+// and fails on negative input values.  Can be reset for the next run.
+class ResettableCounterCalculator : public CalculatorBase {
+ public:
+  ResettableCounterCalculator() { ++g_num_constructed; }
+
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    ++g_num_opened;
+    cc->SetOffset(TimestampDiff(0));
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    RET_CHECK_GE(cc->Inputs().Index(0).Get<int>(), 0);
+    ++num_packets_;
+    cc->Outputs().Index(0).AddPacket(
+        MakePacket<int>(num_packets_).At(cc->InputTimestamp()));
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Reset() override {
+    ++g_num_reset;
+    num_packets_ = 0;
+    return ::mediapipe::OkStatus();
+  }
+
+ private:
+  int num_packets_ = 0;
+};
+REGISTER_CALCULATOR(ResettableCounterCalculator);
+
+// Runs "graph" once with the given input values, and returns the output
+// values in "output_values".
+::mediapipe::Status RunCounterGraph(CalculatorGraph* graph,
+                                    const std::vector<int>& input_values,
+                                    std::vector<int>* output_values) {
+  output_values->clear();
+  RETURN_IF_ERROR(graph->StartRun({}));
+  for (int i = 0; i < input_values.size(); ++i) {
+    RETURN_IF_ERROR(graph->AddPacketToInputStream(
+        "input", MakePacket<int>(input_values[i]).At(Timestamp(i))));
+  }
+  RETURN_IF_ERROR(graph->CloseInputStream("input"));
+  return graph->WaitUntilDone();
+}
+
+// A calculator implementing Reset() is kept across successful graph runs.
+TEST(CalculatorGraph, ReusesResettableCalculator) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "input"
+        node {
+          calculator: "ResettableCounterCalculator"
+          input_stream: "input"
+          output_stream: "counter"
+        }
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "input"
+          output_stream: "passed"
+        }
+      )");
+  g_num_constructed = 0;
+  g_num_opened = 0;
+  g_num_reset = 0;
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  std::vector<int> output_values;
+  MEDIAPIPE_ASSERT_OK(graph.ObserveOutputStream(
+      "counter", [&output_values](const Packet& packet) {
+        output_values.push_back(packet.Get<int>());
+        return ::mediapipe::OkStatus();
+      }));
+
+  for (int run = 0; run < 3; ++run) {
+    MEDIAPIPE_ASSERT_OK(RunCounterGraph(&graph, {1, 2, 3}, &output_values));
+    EXPECT_THAT(output_values, testing::ElementsAre(1, 2, 3));
+  }
+  EXPECT_EQ(1, g_num_constructed);
+  EXPECT_EQ(3, g_num_opened);
+  EXPECT_EQ(3, g_num_reset);
+
+  // A calculator is not kept after a failed run.
+  EXPECT_FALSE(RunCounterGraph(&graph, {1, -1}, &output_values).ok());
+  MEDIAPIPE_ASSERT_OK(RunCounterGraph(&graph, {1, 2}, &output_values));
+  EXPECT_THAT(output_values, testing::ElementsAre(1, 2));
+  EXPECT_EQ(2, g_num_constructed);
+  EXPECT_EQ(5, g_num_opened);
+  EXPECT_EQ(4, g_num_reset);
+}
+
+// Shows that input streams connected to an output stream of an implying type
+// skip packet type validation when skip_implied_packet_type_checks is set.
+TEST(CalculatorGraph, SkipsImpliedPacketTypeChecks) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "in"
+        node {
+          calculator: "SquareIntCalculator"
+          input_stream: "in"
+          output_stream: "squared"
+        }
+        node {
+          calculator: "IntAdderCalculator"
+          input_stream: "squared"
+          input_stream: "in"
+          output_stream: "sum"
+        }
+        output_stream: "sum"
+        skip_implied_packet_type_checks: true
+      )");
+  ValidatedGraphConfig validated_graph;
+  MEDIAPIPE_ASSERT_OK(validated_graph.Initialize(config));
+  // The graph input stream "in" takes on the int type of its consumers, so
+  // every packet on it is validated as an int when it is added.
+  for (const EdgeInfo& edge_info : validated_graph.InputStreamInfos()) {
+    EXPECT_TRUE(edge_info.implied_by_upstream_type) << edge_info.name;
+  }
+  const int num_implied = validated_graph.InputStreamInfos().size();
+  EXPECT_EQ(3, num_implied);
+
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+#ifdef NDEBUG
+  EXPECT_EQ(num_implied, graph.NumUncheckedInputStreams());
+#else
+  EXPECT_EQ(0, graph.NumUncheckedInputStreams());
+#endif  // NDEBUG
+  std::vector<Packet> sums;
+  MEDIAPIPE_ASSERT_OK(
+      graph.ObserveOutputStream("sum", [&sums](const Packet& packet) {
+        sums.push_back(packet);
+        return ::mediapipe::OkStatus();
+      }));
+  MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < 3; ++i) {
+    MEDIAPIPE_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MEDIAPIPE_ASSERT_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+  ASSERT_EQ(3, sums.size());
+  EXPECT_EQ(6, sums[2].Get<int>());
+
+  // Without the flag, every input stream validates packet types.
+  config.set_skip_implied_packet_type_checks(false);
+  CalculatorGraph checked_graph;
+  MEDIAPIPE_ASSERT_OK(checked_graph.Initialize(config));
+  EXPECT_EQ(0, checked_graph.NumUncheckedInputStreams());
+}
+
 TEST(CalculatorGraph, GetOutputSidePacket) {
   CalculatorGraphConfig config =
       ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
@@ -5554,6 +6226,84 @@ TEST(CalculatorGraph, TestPollPacketsFromMultipleStreams) {
   EXPECT_EQ(kDefaultMaxCount, num_packets2);
 }
 
+TEST(CalculatorGraph, TestPollPacketBatches) {
+  CalculatorGraphConfig config;
+  CalculatorGraphConfig::Node* node = config.add_node();
+  node->set_calculator("CountingSourceCalculator");
+  node->add_output_stream("output");
+  node->add_input_side_packet("MAX_COUNT:max_count");
+
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  auto status_or_poller = graph.AddOutputStreamPoller("output");
+  ASSERT_TRUE(status_or_poller.ok());
+  OutputStreamPoller poller = std::move(status_or_poller.ValueOrDie());
+  MEDIAPIPE_ASSERT_OK(
+      graph.StartRun({{"max_count", MakePacket<int>(kDefaultMaxCount)}}));
+  std::vector<Packet> packets;
+  int num_packets = 0;
+  while (poller.NextBatch(&packets, 7)) {
+    EXPECT_LE(packets.size(), 7);
+    for (const Packet& packet : packets) {
+      EXPECT_EQ(num_packets, packet.Get<int>());
+      ++num_packets;
+    }
+  }
+  EXPECT_TRUE(packets.empty());
+  MEDIAPIPE_ASSERT_OK(graph.CloseAllPacketSources());
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_FALSE(poller.NextBatch(&packets, 7));
+  EXPECT_EQ(kDefaultMaxCount, num_packets);
+}
+
+TEST(CalculatorGraph, TestPollPacketBatchesWithLowWatermark) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: 'in'
+        node {
+          calculator: 'PassThroughCalculator'
+          input_stream: 'in'
+          output_stream: 'out'
+        }
+      )");
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  auto status_or_poller = graph.AddOutputStreamPoller("out");
+  ASSERT_TRUE(status_or_poller.ok());
+  OutputStreamPoller poller = std::move(status_or_poller.ValueOrDie());
+  poller.SetLowWatermark(4);
+  MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+
+  // Times out with no packets while the stream is open.
+  std::vector<Packet> packets;
+  EXPECT_TRUE(poller.NextBatch(&packets, 10, absl::Milliseconds(10)));
+  EXPECT_TRUE(packets.empty());
+
+  // Wakes once four packets are queued.
+  for (int i = 0; i < 4; ++i) {
+    MEDIAPIPE_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  ASSERT_TRUE(poller.NextBatch(&packets, 10));
+  ASSERT_EQ(4, packets.size());
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(i, packets[i].Get<int>());
+  }
+
+  // Wakes below the watermark once the stream is done.
+  for (int i = 4; i < 6; ++i) {
+    MEDIAPIPE_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MEDIAPIPE_ASSERT_OK(graph.CloseAllInputStreams());
+  ASSERT_TRUE(poller.NextBatch(&packets, 10));
+  ASSERT_EQ(2, packets.size());
+  EXPECT_EQ(4, packets[0].Get<int>());
+  EXPECT_EQ(5, packets[1].Get<int>());
+  EXPECT_FALSE(poller.NextBatch(&packets, 10));
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+}
+
 // Ensure that when a custom input stream handler is used to handle packets from
 // input streams, an error message is outputted with the appropriate link to
 // resolve the issue when the calculator doesn't handle inputs in monotonically
@@ -5614,5 +6364,78 @@ TEST(CalculatorGraph, SimpleMuxCalculatorWithCustomInputStreamHandler) {
           testing::HasSubstr("ImmediateInputStreamHandler class comment")));
 }
 
+// Simulates a calculator that loads a model in Open(), such as
+// TfLiteInferenceCalculator.  The model is loaded once per instance.
+class ModelLoadingCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).SetSameAs(&cc->Inputs().Index(0));
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    cc->SetOffset(TimestampDiff(0));
+    if (!model_loaded_) {
+      absl::SleepFor(absl::Milliseconds(1));
+      model_loaded_ = true;
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    cc->Outputs().Index(0).AddPacket(cc->Inputs().Index(0).Value());
+    return ::mediapipe::OkStatus();
+  }
+
+ private:
+  bool model_loaded_ = false;
+};
+REGISTER_CALCULATOR(ModelLoadingCalculator);
+
+// A ModelLoadingCalculator that keeps its model across graph runs.
+class ResettableModelLoadingCalculator : public ModelLoadingCalculator {
+ public:
+  ::mediapipe::Status Reset() override { return ::mediapipe::OkStatus(); }
+};
+REGISTER_CALCULATOR(ResettableModelLoadingCalculator);
+
+// Processes short clips of 10 packets, creating a new graph for each clip
+// (state.range(0) == 0), rerunning one graph (state.range(0) == 1), or
+// rerunning one graph with resettable calculators (state.range(0) == 2).
+void BM_ProcessClips(benchmark::State& state) {
+  const bool reuse_graph = state.range(0) >= 1;
+  const std::string calculator = state.range(0) == 2
+                                     ? "ResettableModelLoadingCalculator"
+                                     : "ModelLoadingCalculator";
+  CalculatorGraphConfig config;
+  config.add_input_stream("input");
+  std::string stream = "input";
+  for (int i = 0; i < 4; ++i) {
+    CalculatorGraphConfig::Node* node = config.add_node();
+    node->set_calculator(calculator);
+    node->add_input_stream(stream);
+    stream = absl::StrCat("stream_", i);
+    node->add_output_stream(stream);
+  }
+  std::unique_ptr<CalculatorGraph> graph;
+  for (auto _ : state) {
+    if (!graph || !reuse_graph) {
+      graph = absl::make_unique<CalculatorGraph>();
+      MEDIAPIPE_CHECK_OK(graph->Initialize(config));
+    }
+    MEDIAPIPE_CHECK_OK(graph->StartRun({}));
+    for (int i = 0; i < 10; ++i) {
+      MEDIAPIPE_CHECK_OK(graph->AddPacketToInputStream(
+          "input", MakePacket<int>(i).At(Timestamp(i))));
+    }
+    MEDIAPIPE_CHECK_OK(graph->CloseAllInputStreams());
+    MEDIAPIPE_CHECK_OK(graph->WaitUntilDone());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_ProcessClips)->Arg(0)->Arg(1)->Arg(2)->UseRealTime();
+
 }  // namespace
 }  // namespace mediapipe
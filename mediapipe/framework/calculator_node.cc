@@ -25,6 +25,7 @@
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_base.h"
 #include "mediapipe/framework/calculator_registry_util.h"
@@ -89,10 +90,23 @@ Timestamp CalculatorNode::SourceProcessOrder(
 
   max_in_flight_ = node_config.max_in_flight();
   max_in_flight_ = max_in_flight_ ? max_in_flight_ : 1;
+  adaptive_in_flight_ = node_config.adaptive_max_in_flight();
+  if (adaptive_in_flight_) {
+    RET_CHECK_GT(max_in_flight_, 1)
+        << "Node \"" << name_
+        << "\" sets adaptive_max_in_flight but its max_in_flight is not "
+           "greater than 1.";
+    RET_CHECK_EQ(node_config.output_stream_handler().output_stream_handler(),
+                 "InOrderOutputStreamHandler")
+        << "Node \"" << name_
+        << "\" sets adaptive_max_in_flight and must use the "
+           "InOrderOutputStreamHandler.";
+  }
   if (!node_config.executor().empty()) {
     executor_ = node_config.executor();
   }
   source_layer_ = node_config.source_layer();
+  priority_rank_ = validated_graph_->CalculatorInfos().size() - 1 - node_id_;
 
   const NodeTypeInfo& node_type_info =
       validated_graph_->CalculatorInfos()[node_id_];
@@ -364,15 +378,18 @@ void CalculatorNode::SetMaxInputStreamQueueSize(int max_queue_size) {
   RETURN_IF_ERROR(calculator_context_manager_.PrepareForRun(std::bind(
       &CalculatorNode::ConnectShardsToStreams, this, std::placeholders::_1)));
 
-  auto calculator_statusor = CreateCalculator(
-      input_stream_handler_->InputTagMap(),
-      output_stream_handler_->OutputTagMap(), validated_graph_->Package(),
-      calculator_state_.get(),
-      calculator_context_manager_.GetDefaultCalculatorContext());
-  if (!calculator_statusor.ok()) {
-    return calculator_statusor.status();
+  // A calculator kept from the previous run has been Reset() already.
+  if (!calculator_) {
+    auto calculator_statusor = CreateCalculator(
+        input_stream_handler_->InputTagMap(),
+        output_stream_handler_->OutputTagMap(), validated_graph_->Package(),
+        calculator_state_.get(),
+        calculator_context_manager_.GetDefaultCalculatorContext());
+    if (!calculator_statusor.ok()) {
+      return calculator_statusor.status();
+    }
+    calculator_ = std::move(calculator_statusor).ValueOrDie();
   }
-  calculator_ = std::move(calculator_statusor).ValueOrDie();
 
   needs_to_close_ = false;
 
@@ -381,6 +398,16 @@ void CalculatorNode::SetMaxInputStreamQueueSize(int max_queue_size) {
     status_ = kStatePrepared;
     scheduling_state_ = kIdle;
     current_in_flight_ = 0;
+    if (adaptive_in_flight_) {
+      if (!adaptive_in_flight_limit_) {
+        adaptive_in_flight_limit_ =
+            absl::make_unique<AdaptiveInFlightLimit>(max_in_flight_);
+      }
+      adaptive_in_flight_limit_->Reset();
+      in_flight_limit_ = adaptive_in_flight_limit_->limit();
+    } else {
+      in_flight_limit_ = max_in_flight_;
+    }
     input_stream_headers_ready_called_ = false;
     input_side_packets_ready_called_ = false;
     input_stream_headers_ready_ =
@@ -533,7 +560,17 @@ void CalculatorNode::CleanupAfterRun(const ::mediapipe::Status& graph_status) {
         Timestamp::Done());
     CloseNode(graph_status, /*graph_run_ended=*/true).IgnoreError();
   }
-  calculator_ = nullptr;
+  // Keep the calculator for the next run if it was closed normally in a
+  // successful run and it can be reset.
+  bool keep_calculator = false;
+  {
+    absl::MutexLock lock(&status_mutex_);
+    keep_calculator = status_ == kStateClosed;
+  }
+  if (!(keep_calculator && graph_status.ok() && calculator_ &&
+        calculator_->Reset().ok())) {
+    calculator_ = nullptr;
+  }
   // All pending output packets are automatically dropped when calculator
   // context manager destroys all calculator context objects.
   calculator_context_manager_.CleanupAfterRun();
@@ -558,7 +595,7 @@ void CalculatorNode::SchedulingLoop() {
       scheduling_state_ = kIdle;
       return;
     }
-    max_allowance = max_in_flight_ - current_in_flight_;
+    max_allowance = in_flight_limit_ - current_in_flight_;
   }
   while (true) {
     Timestamp input_bound;
@@ -574,8 +611,8 @@ void CalculatorNode::SchedulingLoop() {
     {
       absl::MutexLock lock(&status_mutex_);
       if (scheduling_state_ == kSchedulingPending &&
-          current_in_flight_ < max_in_flight_) {
-        max_allowance = max_in_flight_ - current_in_flight_;
+          current_in_flight_ < in_flight_limit_) {
+        max_allowance = in_flight_limit_ - current_in_flight_;
         scheduling_state_ = kScheduling;
       } else {
         scheduling_state_ = kIdle;
@@ -628,7 +665,7 @@ void CalculatorNode::CheckIfBecameReady() {
     if (status_ != kStateOpened) {
       return;
     }
-    if (scheduling_state_ == kIdle && current_in_flight_ < max_in_flight_) {
+    if (scheduling_state_ == kIdle && current_in_flight_ < in_flight_limit_) {
       scheduling_state_ = kScheduling;
     } else {
       if (scheduling_state_ == kScheduling) {
@@ -678,7 +715,7 @@ void CalculatorNode::EndScheduling() {
 
 bool CalculatorNode::TryToBeginScheduling() {
   absl::MutexLock lock(&status_mutex_);
-  if (current_in_flight_ < max_in_flight_) {
+  if (current_in_flight_ < in_flight_limit_) {
     ++current_in_flight_;
     return true;
   }
@@ -770,6 +807,8 @@ std::string CalculatorNode::DebugName() const {
 
         VLOG(2) << "Calling Calculator::Process() for node: " << DebugName();
 
+        const int64 start_time_ns =
+            adaptive_in_flight_ ? absl::GetCurrentTimeNanos() : 0;
         {
           MEDIAPIPE_PROFILING(PROCESS, calculator_context);
           LegacyCalculatorSupport::Scoped<CalculatorContext> s(
@@ -780,6 +819,9 @@ std::string CalculatorNode::DebugName() const {
         // Removes one packet from each shard and progresses to the next input
         // timestamp.
         input_stream_handler_->ClearCurrentInputs(calculator_context);
+        if (adaptive_in_flight_) {
+          RecordProcessTime(absl::GetCurrentTimeNanos() - start_time_ns);
+        }
 
         // Nodes are allowed to return StatusStop() to cause the termination
         // of the graph. This is different from an error in that it will
@@ -814,6 +856,17 @@ std::string CalculatorNode::DebugName() const {
   }
 }
 
+void CalculatorNode::RecordProcessTime(int64 process_time_ns) {
+  const int queue_size = input_stream_handler_->MinQueueSize();
+  absl::MutexLock lock(&status_mutex_);
+  if (adaptive_in_flight_limit_->RecordInvocation(process_time_ns,
+                                                  queue_size)) {
+    in_flight_limit_ = adaptive_in_flight_limit_->limit();
+    VLOG(1) << "Node \"" << DebugName() << "\" now runs up to "
+            << in_flight_limit_ << " invocations in parallel.";
+  }
+}
+
 void CalculatorNode::SetQueueSizeCallbacks(
     InputStreamManager::QueueSizeCallback becomes_full_callback,
     InputStreamManager::QueueSizeCallback becomes_not_full_callback) {
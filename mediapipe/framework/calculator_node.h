@@ -29,6 +29,7 @@
 
 #include "absl/base/macros.h"
 #include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/adaptive_in_flight_limit.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_base.h"
 #include "mediapipe/framework/calculator_context.h"
@@ -160,6 +161,13 @@ class CalculatorNode {
 
   int source_layer() const { return source_layer_; }
 
+  // The scheduling priority of a non-source node among the other nodes of
+  // the graph. Nodes with lower ranks run first. By default the rank is
+  // derived from the node id, so that nodes closer to the leaves run first.
+  int priority_rank() const { return priority_rank_; }
+  // Must not be called while the graph is running.
+  void SetPriorityRank(int priority_rank) { priority_rank_ = priority_rank; }
+
   // Checks if the node can be scheduled; if so, increases current_in_flight_
   // and returns true; otherwise, returns false.
   // If true is returned, the scheduler must commit to executing the node, and
@@ -273,6 +281,10 @@ class CalculatorNode {
   // the latest input timestamp bound if no invocations can be scheduled.
   void SchedulingLoop();
 
+  // Feeds the Process() time of an invocation and the current input queue
+  // depth to adaptive_in_flight_limit_. Only called if adaptive_in_flight_.
+  void RecordProcessTime(int64 process_time_ns) LOCKS_EXCLUDED(status_mutex_);
+
   // Closes the input and output streams.
   void CloseInputStreams() LOCKS_EXCLUDED(status_mutex_);
   void CloseOutputStreams(OutputStreamShardSet* outputs)
@@ -292,6 +304,8 @@ class CalculatorNode {
   std::string executor_;
   // The layer a source calculator operates on.
   int source_layer_ = 0;
+  // See priority_rank().
+  int priority_rank_ = 0;
   // The status of the current Calculator that this CalculatorNode
   // is wrapping.  kStateActive is currently used only for source nodes.
   enum NodeStatus {
@@ -305,6 +319,14 @@ class CalculatorNode {
 
   // The max number of invocations that can be scheduled in parallel.
   int max_in_flight_ = 1;
+  // The number of invocations that may currently be scheduled in parallel.
+  // Equal to max_in_flight_ unless adaptive_in_flight_limit_ is set.
+  int in_flight_limit_ GUARDED_BY(status_mutex_) = 1;
+  // Adjusts in_flight_limit_ if the node sets adaptive_max_in_flight.
+  std::unique_ptr<AdaptiveInFlightLimit> adaptive_in_flight_limit_
+      GUARDED_BY(status_mutex_);
+  // True if adaptive_in_flight_limit_ is set. Read without locking.
+  bool adaptive_in_flight_ = false;
   // The following two variables are used for the concurrency control of node
   // scheduling.
   //
@@ -19,22 +19,30 @@
 //
 // TODO: Add more tests to verify the correctness of parallel execution.
 
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
 #include <memory>
+#include <new>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/thread_pool_executor.pb.h"
 
 namespace mediapipe {
 
@@ -42,6 +50,10 @@ namespace {
 
 using RandomEngine = std::mt19937_64;
 
+// The number of calls to the global operator new, which is replaced at the
+// end of this file.
+std::atomic<int64> allocation_count(0);
+
 inline void BusySleep(absl::Duration duration) {
   absl::Time start_time = absl::Now();
   while (absl::Now() - start_time < duration) {
@@ -77,6 +89,71 @@ class SlowPlusOneCalculator : public CalculatorBase {
 
 REGISTER_CALCULATOR(SlowPlusOneCalculator);
 
+// Passes its input through after busy-waiting for the duration given by the
+// input side packet.
+class BusyPassThroughCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).SetSameAs(&cc->Inputs().Index(0));
+    cc->InputSidePackets().Index(0).Set<absl::Duration>();
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    cc->SetOffset(mediapipe::TimestampDiff(0));
+    duration_ = cc->InputSidePackets().Index(0).Get<absl::Duration>();
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    BusySleep(duration_);
+    cc->Outputs().Index(0).AddPacket(cc->Inputs().Index(0).Value());
+    return ::mediapipe::OkStatus();
+  }
+
+ private:
+  absl::Duration duration_;
+};
+
+REGISTER_CALCULATOR(BusyPassThroughCalculator);
+
+// Passes its input through after sleeping for 2 ms, and records the largest
+// number of Process() calls that have run at the same time.
+class SleepingPassThroughCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).SetSameAs(&cc->Inputs().Index(0));
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override {
+    cc->SetOffset(mediapipe::TimestampDiff(0));
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    const int running = num_running_.fetch_add(1) + 1;
+    int max_running = max_running_.load();
+    while (running > max_running &&
+           !max_running_.compare_exchange_weak(max_running, running)) {
+    }
+    absl::SleepFor(absl::Milliseconds(2));
+    num_running_.fetch_sub(1);
+    cc->Outputs().Index(0).AddPacket(cc->Inputs().Index(0).Value());
+    return ::mediapipe::OkStatus();
+  }
+
+  static std::atomic<int> num_running_;
+  static std::atomic<int> max_running_;
+};
+
+std::atomic<int> SleepingPassThroughCalculator::num_running_(0);
+std::atomic<int> SleepingPassThroughCalculator::max_running_(0);
+
+REGISTER_CALCULATOR(SleepingPassThroughCalculator);
+
 class ParallelExecutionTest : public testing::Test {
  public:
   void AddThreadSafeVectorSink(const Packet& packet) {
@@ -153,5 +230,279 @@ TEST_F(ParallelExecutionTest, SlowPlusOneCalculatorsTest) {
   }
 }
 
+// A node with a backlog of inputs raises its number of parallel invocations
+// on its own, and still emits its outputs in timestamp order.
+TEST_F(ParallelExecutionTest, AdaptiveMaxInFlight) {
+  CalculatorGraphConfig graph_config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "input"
+        node {
+          calculator: "SleepingPassThroughCalculator"
+          input_stream: "input"
+          output_stream: "passed"
+          max_in_flight: 4
+          adaptive_max_in_flight: true
+        }
+        node {
+          calculator: "CallbackCalculator"
+          input_stream: "passed"
+          input_side_packet: "CALLBACK:callback"
+        }
+        num_threads: 4
+      )");
+  SleepingPassThroughCalculator::max_running_ = 0;
+  CalculatorGraph graph(graph_config);
+  MEDIAPIPE_ASSERT_OK(graph.StartRun(
+      {{"callback", MakePacket<std::function<void(const Packet&)>>(std::bind(
+                        &ParallelExecutionTest::AddThreadSafeVectorSink, this,
+                        std::placeholders::_1))}}));
+  const int kTotalNums = 100;
+  std::vector<Packet> packets;
+  for (int i = 0; i < kTotalNums; ++i) {
+    packets.push_back(MakePacket<int>(i).At(Timestamp(i)));
+  }
+  MEDIAPIPE_ASSERT_OK(graph.AddPacketsToInputStream("input", packets));
+  MEDIAPIPE_ASSERT_OK(graph.CloseInputStream("input"));
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+
+  EXPECT_GT(SleepingPassThroughCalculator::max_running_, 1);
+  EXPECT_LE(SleepingPassThroughCalculator::max_running_, 4);
+  absl::ReaderMutexLock lock(&output_packets_mutex_);
+  ASSERT_EQ(kTotalNums, output_packets_.size());
+  for (int i = 0; i < kTotalNums; ++i) {
+    EXPECT_EQ(i, output_packets_[i].Get<int>());
+    EXPECT_EQ(Timestamp(i), output_packets_[i].Timestamp());
+  }
+}
+
+TEST(ParallelExecutionConfigTest, AdaptiveMaxInFlightNeedsMaxInFlight) {
+  CalculatorGraphConfig graph_config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "input"
+        node {
+          calculator: "SleepingPassThroughCalculator"
+          input_stream: "input"
+          output_stream: "passed"
+          adaptive_max_in_flight: true
+        }
+      )");
+  CalculatorGraph graph;
+  EXPECT_FALSE(graph.Initialize(graph_config).ok());
+}
+
+// Runs packets through a graph of 10 parallel chains of 10
+// BusyPassThroughCalculators each, on an 8-thread ThreadPoolExecutor.
+// Arguments: queueing policy (0 = SHARED_QUEUE, 1 = WORK_STEALING) and the
+// Process() duration of every node in microseconds.
+void BM_ThreadPoolExecutorQueueingPolicy(benchmark::State& state) {
+  constexpr int kNumChains = 10;
+  constexpr int kChainLength = 10;
+  constexpr int kNumPackets = 100;
+  CalculatorGraphConfig config;
+  config.add_input_stream("input");
+  ExecutorConfig* executor = config.add_executor();
+  ThreadPoolExecutorOptions* executor_options =
+      executor->mutable_options()->MutableExtension(
+          ThreadPoolExecutorOptions::ext);
+  executor_options->set_num_threads(8);
+  executor_options->set_queueing_policy(
+      static_cast<ThreadPoolExecutorOptions::QueueingPolicy>(state.range(0)));
+  for (int chain = 0; chain < kNumChains; ++chain) {
+    std::string input_stream = "input";
+    for (int i = 0; i < kChainLength; ++i) {
+      CalculatorGraphConfig::Node* node = config.add_node();
+      node->set_calculator("BusyPassThroughCalculator");
+      node->add_input_stream(input_stream);
+      input_stream = absl::StrCat("chain", chain, "_", i);
+      node->add_output_stream(input_stream);
+      node->add_input_side_packet("node_duration");
+    }
+  }
+
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  const Packet node_duration =
+      MakePacket<absl::Duration>(absl::Microseconds(state.range(1)));
+  for (auto _ : state) {
+    MEDIAPIPE_ASSERT_OK(graph.StartRun({{"node_duration", node_duration}}));
+    for (int i = 0; i < kNumPackets; ++i) {
+      MEDIAPIPE_ASSERT_OK(graph.AddPacketToInputStream(
+          "input", MakePacket<int>(i).At(Timestamp(i))));
+    }
+    MEDIAPIPE_ASSERT_OK(graph.CloseInputStream("input"));
+    MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumPackets * kNumChains *
+                          kChainLength);
+}
+
+BENCHMARK(BM_ThreadPoolExecutorQueueingPolicy)
+    ->Args({0, 1})
+    ->Args({1, 1})
+    ->Args({0, 10})
+    ->Args({1, 10})
+    ->Args({0, 100})
+    ->Args({1, 100})
+    ->UseRealTime();
+
+// Runs packets through a single chain of kChainLength PassThroughCalculators
+// on an ApplicationThreadExecutor and reports the heap allocations per packet
+// per node, excluding the allocation of the packets themselves. The chain
+// keeps up to state.range(0) packets queued at every input stream.
+void BM_PassThroughChainAllocations(benchmark::State& state) {
+  constexpr int kChainLength = 10;
+  const int kNumPackets = 1000;
+  const int queued_packets = state.range(0);
+  CalculatorGraphConfig config;
+  config.add_input_stream("input");
+  config.add_executor()->set_type("ApplicationThreadExecutor");
+  std::string input_stream = "input";
+  for (int i = 0; i < kChainLength; ++i) {
+    CalculatorGraphConfig::Node* node = config.add_node();
+    node->set_calculator("PassThroughCalculator");
+    node->add_input_stream(input_stream);
+    input_stream = absl::StrCat("chain_", i);
+    node->add_output_stream(input_stream);
+  }
+
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  std::vector<Packet> packets;
+  for (int i = 0; i < kNumPackets; ++i) {
+    packets.push_back(MakePacket<int>(i).At(Timestamp(i)));
+  }
+  int64 total_allocations = 0;
+  for (auto _ : state) {
+    MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+    const int64 start_allocations =
+        allocation_count.load(std::memory_order_relaxed);
+    for (int i = 0; i < kNumPackets; i += queued_packets) {
+      for (int j = i; j < std::min(i + queued_packets, kNumPackets); ++j) {
+        MEDIAPIPE_ASSERT_OK(graph.AddPacketToInputStream("input", packets[j]));
+      }
+      MEDIAPIPE_ASSERT_OK(graph.WaitUntilIdle());
+    }
+    total_allocations +=
+        allocation_count.load(std::memory_order_relaxed) - start_allocations;
+    MEDIAPIPE_ASSERT_OK(graph.CloseInputStream("input"));
+    MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumPackets * kChainLength);
+  state.counters["allocs_per_packet_per_node"] =
+      static_cast<double>(total_allocations) /
+      (state.iterations() * kNumPackets * kChainLength);
+}
+
+BENCHMARK(BM_PassThroughChainAllocations)->Arg(1)->Arg(10)->Arg(100);
+
+// Feeds kNumPackets packets into a PassThroughCalculator from a single thread,
+// either one packet per call (batch size 1) or state.range(0) packets per
+// AddPacketsToInputStream call.
+void BM_AddPacketsToInputStream(benchmark::State& state) {
+  const int kNumPackets = 10000;
+  const int batch_size = state.range(0);
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: 'input'
+        node {
+          calculator: 'PassThroughCalculator'
+          input_stream: 'input'
+          output_stream: 'output'
+        }
+        num_threads: 1
+      )");
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  graph.SetGraphInputStreamAddMode(
+      CalculatorGraph::GraphInputStreamAddMode::WAIT_TILL_NOT_FULL);
+  for (auto _ : state) {
+    MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+    for (int i = 0; i < kNumPackets; i += batch_size) {
+      const int end = std::min(i + batch_size, kNumPackets);
+      if (batch_size == 1) {
+        MEDIAPIPE_ASSERT_OK(graph.AddPacketToInputStream(
+            "input", MakePacket<int>(i).At(Timestamp(i))));
+        continue;
+      }
+      std::vector<Packet> packets;
+      packets.reserve(end - i);
+      for (int j = i; j < end; ++j) {
+        packets.push_back(MakePacket<int>(j).At(Timestamp(j)));
+      }
+      MEDIAPIPE_ASSERT_OK(
+          graph.AddPacketsToInputStream("input", std::move(packets)));
+    }
+    MEDIAPIPE_ASSERT_OK(graph.CloseInputStream("input"));
+    MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumPackets);
+}
+
+BENCHMARK(BM_AddPacketsToInputStream)->Arg(1)->Arg(16)->Arg(256);
+
+// Polls kNumPackets packets that a feeder thread sends through a
+// PassThroughCalculator, either with Next() (batch size 1) or with
+// NextBatch() and a low watermark of state.range(0) packets.
+void BM_PollPackets(benchmark::State& state) {
+  const int kNumPackets = 10000;
+  const int batch_size = state.range(0);
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: 'input'
+        node {
+          calculator: 'PassThroughCalculator'
+          input_stream: 'input'
+          output_stream: 'output'
+        }
+        num_threads: 1
+      )");
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  auto status_or_poller = graph.AddOutputStreamPoller("output");
+  MEDIAPIPE_ASSERT_OK(status_or_poller.status());
+  OutputStreamPoller poller = std::move(status_or_poller.ValueOrDie());
+  poller.SetLowWatermark(batch_size);
+  for (auto _ : state) {
+    MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+    std::thread feeder([&graph]() {
+      for (int i = 0; i < kNumPackets; ++i) {
+        MEDIAPIPE_ASSERT_OK(graph.AddPacketToInputStream(
+            "input", MakePacket<int>(i).At(Timestamp(i))));
+      }
+      MEDIAPIPE_ASSERT_OK(graph.CloseInputStream("input"));
+    });
+    int num_polled = 0;
+    if (batch_size == 1) {
+      Packet packet;
+      while (poller.Next(&packet)) {
+        ++num_polled;
+      }
+    } else {
+      std::vector<Packet> packets;
+      while (poller.NextBatch(&packets, batch_size)) {
+        num_polled += packets.size();
+      }
+    }
+    feeder.join();
+    MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+    ASSERT_EQ(kNumPackets, num_polled);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumPackets);
+}
+
+BENCHMARK(BM_PollPackets)->Arg(1)->Arg(16)->Arg(64);
+
 }  // namespace
 }  // namespace mediapipe
+
+// Counts heap allocations for BM_PassThroughChainAllocations.
+void* operator new(size_t size) {
+  mediapipe::allocation_count.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
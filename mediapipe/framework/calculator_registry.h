@@ -17,6 +17,10 @@
 #ifndef MEDIAPIPE_FRAMEWORK_CALCULATOR_REGISTRY_H_
 #define MEDIAPIPE_FRAMEWORK_CALCULATOR_REGISTRY_H_
 
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
 #include "mediapipe/framework/calculator_base.h"
 
 #define REGISTER_CALCULATOR(name)                                          \
@@ -29,4 +33,60 @@
       absl::make_unique<                                                   \
           ::mediapipe::internal::StaticAccessToCalculatorBaseTyped<name>>)
 
+// Registers a statically linked set of calculators with a single static
+// initializer, instead of one per calculator.
+//
+//   static constexpr ::mediapipe::internal::CalculatorRegistration
+//       kMyCalculators[] = {
+//           MEDIAPIPE_CALCULATOR_REGISTRATION(::my_ns::FooCalculator),
+//           MEDIAPIPE_CALCULATOR_REGISTRATION(BarCalculator),
+//   };
+//   REGISTER_CALCULATORS(my_calculators, kMyCalculators);
+#define MEDIAPIPE_CALCULATOR_REGISTRATION(name)                      \
+  {                                                                  \
+    #name, &::mediapipe::internal::CreateCalculator<name>,           \
+        &::mediapipe::internal::CreateStaticAccessToCalculator<name> \
+  }
+
+#define REGISTER_CALCULATORS(var_name, registrations)    \
+  static auto* REGISTRY_STATIC_VAR(var_name, __LINE__) = \
+      new ::mediapipe::RegistrationToken(                \
+          ::mediapipe::internal::RegisterCalculators(registrations))
+
+namespace mediapipe {
+namespace internal {
+
+template <class T>
+std::unique_ptr<CalculatorBase> CreateCalculator() {
+  return absl::make_unique<T>();
+}
+
+template <class T>
+std::unique_ptr<StaticAccessToCalculatorBase> CreateStaticAccessToCalculator() {
+  return absl::make_unique<StaticAccessToCalculatorBaseTyped<T>>();
+}
+
+// A calculator registration known at compile time.
+struct CalculatorRegistration {
+  const char* name;
+  std::unique_ptr<CalculatorBase> (*create)();
+  std::unique_ptr<StaticAccessToCalculatorBase> (*create_static_access)();
+};
+
+template <int N>
+RegistrationToken RegisterCalculators(
+    const CalculatorRegistration (&registrations)[N]) {
+  std::vector<RegistrationToken> tokens;
+  for (const CalculatorRegistration& registration : registrations) {
+    tokens.push_back(CalculatorBaseRegistry::Register(registration.name,
+                                                      registration.create));
+    tokens.push_back(StaticAccessToCalculatorBaseRegistry::Register(
+        registration.name, registration.create_static_access));
+  }
+  return RegistrationToken::Combine(std::move(tokens));
+}
+
+}  // namespace internal
+}  // namespace mediapipe
+
 #endif  // MEDIAPIPE_FRAMEWORK_CALCULATOR_REGISTRY_H_
@@ -57,8 +57,8 @@ namespace file {
   }
 
   fwrite(content.data(), sizeof(char), content.size(), fp);
-  size_t ret = fclose(fp);
-  if (ret == 0 && ferror(fp)) {
+  bool write_error = ferror(fp);
+  if (fclose(fp) != 0 || write_error) {
     return ::mediapipe::InternalErrorBuilder(MEDIAPIPE_LOC)
            << "Error while writing file: " << file_name;
   }
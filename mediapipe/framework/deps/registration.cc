@@ -14,6 +14,11 @@
 
 #include "mediapipe/framework/deps/registration.h"
 
+#include <algorithm>
+#include <numeric>
+
+#include "absl/hash/hash.h"
+
 namespace mediapipe {
 
 namespace {
@@ -27,8 +32,82 @@ inline size_t array_size(T (&arr)[SIZE]) {
   return SIZE;
 }
 
+// The largest seed tried for a bucket of PerfectHashIndex.
+constexpr uint32 kMaxSeed = 1 << 20;
+
 }  // namespace
 
+namespace registration_internal {
+
+/*static*/
+uint64 PerfectHashIndex::Hash(absl::string_view key) {
+  return absl::Hash<absl::string_view>()(key);
+}
+
+bool PerfectHashIndex::Build(const std::vector<absl::string_view>& keys,
+                             std::vector<int>* slots) {
+  const int num_keys = keys.size();
+  num_slots_ = num_keys;
+  seeds_.assign(std::max(num_keys, 1), 0);
+  slots->assign(num_keys, -1);
+  if (num_keys == 0) {
+    return true;
+  }
+
+  // Group the keys by bucket, and place the largest buckets first.
+  std::vector<uint64> hashes(num_keys);
+  std::vector<std::vector<int>> buckets(seeds_.size());
+  for (int i = 0; i < num_keys; ++i) {
+    hashes[i] = Hash(keys[i]);
+    buckets[hashes[i] % seeds_.size()].push_back(i);
+  }
+  std::vector<int> order(buckets.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&buckets](int a, int b) {
+    return buckets[a].size() > buckets[b].size();
+  });
+
+  std::vector<bool> occupied(num_slots_, false);
+  std::vector<int> bucket_slots;
+  for (int bucket : order) {
+    const std::vector<int>& members = buckets[bucket];
+    if (members.empty()) {
+      break;
+    }
+    // Find a seed that maps every key in the bucket to a distinct free slot.
+    bool placed = false;
+    for (uint32 seed = 0; seed < kMaxSeed && !placed; ++seed) {
+      bucket_slots.clear();
+      placed = true;
+      for (int member : members) {
+        int slot = SlotForSeed(hashes[member], seed);
+        if (occupied[slot] || std::find(bucket_slots.begin(),
+                                        bucket_slots.end(),
+                                        slot) != bucket_slots.end()) {
+          placed = false;
+          break;
+        }
+        bucket_slots.push_back(slot);
+      }
+      if (placed) {
+        seeds_[bucket] = seed;
+      }
+    }
+    if (!placed) {
+      seeds_.clear();
+      num_slots_ = 0;
+      return false;
+    }
+    for (int i = 0; i < members.size(); ++i) {
+      occupied[bucket_slots[i]] = true;
+      (*slots)[members[i]] = bucket_slots[i];
+    }
+  }
+  return true;
+}
+
+}  // namespace registration_internal
+
 /*static*/
 const std::unordered_set<std::string>& NamespaceWhitelist::TopNamespaces() {
   static std::unordered_set<std::string>* result =
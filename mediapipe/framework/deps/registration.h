@@ -16,22 +16,27 @@
 #define MEDIAPIPE_DEPS_REGISTRATION_H_
 
 #include <algorithm>
+#include <atomic>
 #include <functional>
+#include <memory>
 #include <string>
 #include <tuple>
 #include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "absl/base/macros.h"
 #include "absl/base/thread_annotations.h"
 #include "absl/meta/type_traits.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/deps/registration_token.h"
 #include "mediapipe/framework/port/canonical_errors.h"
+#include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/statusor.h"
 
@@ -119,6 +124,16 @@ namespace mediapipe {
 //    ...
 //  }
 //
+// === Registering a statically linked set of implementations =============
+//
+//  // The entries are constant-initialized, so the whole set is registered
+//  // at once without a static initializer per implementation.
+//  static constexpr WidgetRegistry::StaticEntry kWidgets[] = {
+//      {"my_ns::MyWidget", &MyWidget::Create},
+//      {"my_ns::OtherWidget", &OtherWidget::Create},
+//  };
+//  MEDIAPIPE_REGISTER_FACTORY_FUNCTIONS(WidgetRegistry, widgets, kWidgets);
+//
 // === Injecting instances for testing =====================================
 //
 // Unregister unregisterer(WidgetRegistry::Register(
@@ -126,6 +141,16 @@ namespace mediapipe {
 //      [](unique_ptr<Gadget> arg, const Thing* thing) {
 //        ...
 //      }));
+//
+// === Lookup performance ==================================================
+//
+// The first lookup, normally after static initialization, freezes the
+// registered functions into an immutable table indexed by a minimal perfect
+// hash, which later lookups read without locking.  The table is built only
+// once.  Registering or unregistering a function afterwards, as tests do,
+// discards it, and later lookups use the mutable map under a reader lock.
+// The discarded table is kept until the registry is destroyed, since
+// lock-free readers may still be using it.
 
 namespace registration_internal {
 constexpr char kCxxSep[] = "::";
@@ -141,6 +166,47 @@ template <typename T>
 struct WrapStatusOr<::mediapipe::StatusOr<T>> {
   using type = ::mediapipe::StatusOr<T>;
 };
+
+// A minimal perfect hash function over a fixed set of distinct keys, built
+// with the hash-and-displace method.  Each key is hashed into a bucket, and
+// each bucket stores a seed that maps its keys to distinct free slots.
+class PerfectHashIndex {
+ public:
+  // Builds the index for "keys", and sets (*slots)[i] to the slot of keys[i].
+  // The slots are a permutation of [0, keys.size()).  Returns false if no
+  // perfect hash function was found, which can happen only for keys with
+  // colliding 64-bit hashes.
+  bool Build(const std::vector<absl::string_view>& keys,
+             std::vector<int>* slots);
+
+  // Returns the slot of "key" if it is one of the keys, or else any slot
+  // in [0, size()).  Returns -1 if the index is empty.
+  int Slot(absl::string_view key) const {
+    if (num_slots_ == 0) {
+      return -1;
+    }
+    uint64 hash = Hash(key);
+    uint64 seed = seeds_[hash % seeds_.size()];
+    return SlotForSeed(hash, seed);
+  }
+
+  int size() const { return num_slots_; }
+
+ private:
+  static uint64 Hash(absl::string_view key);
+  int SlotForSeed(uint64 hash, uint64 seed) const {
+    // The splitmix64 finalizer.
+    uint64 x = hash ^ (seed * 0x9E3779B97F4A7C15ULL);
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return static_cast<int>(x % num_slots_);
+  }
+
+  std::vector<uint32> seeds_;
+  int num_slots_ = 0;
+};
+
 }  // namespace registration_internal
 
 class NamespaceWhitelist {
@@ -154,6 +220,12 @@ class FunctionRegistry {
   using Function = std::function<R(Args...)>;
   using ReturnType = typename registration_internal::WrapStatusOr<R>::type;
 
+  // A registration whose name and function are known at compile time.
+  struct StaticEntry {
+    const char* name;
+    R (*function)(Args...);
+  };
+
   FunctionRegistry() {}
   FunctionRegistry(const FunctionRegistry&) = delete;
   FunctionRegistry& operator=(const FunctionRegistry&) = delete;
@@ -168,6 +240,7 @@ class FunctionRegistry {
     }
     if (functions_.insert(std::make_pair(normalized_name, std::move(func)))
             .second) {
+      Unfreeze();
       return RegistrationToken(
           [this, normalized_name]() { Unregister(normalized_name); });
     }
@@ -175,6 +248,16 @@ class FunctionRegistry {
     return RegistrationToken([]() {});
   }
 
+  // Registers "count" functions named at compile time.
+  RegistrationToken Register(const StaticEntry* entries, int count) {
+    std::vector<RegistrationToken> tokens;
+    tokens.reserve(count);
+    for (int i = 0; i < count; ++i) {
+      tokens.push_back(Register(entries[i].name, entries[i].function));
+    }
+    return RegistrationToken::Combine(std::move(tokens));
+  }
+
   // Force 'args' to be deduced by templating the function, instead of just
   // accepting Args. This is necessary to make 'args' a forwarding reference as
   // opposed to a plain rvalue reference.
@@ -190,6 +273,14 @@ class FunctionRegistry {
                               int> = 0>
   ReturnType Invoke(const std::string& name, Args2&&... args)
       LOCKS_EXCLUDED(lock_) {
+    if (const FrozenFunctions* frozen = GetFrozenFunctions()) {
+      const Function* function = frozen->Find(name);
+      if (function == nullptr) {
+        return ::mediapipe::NotFoundError("No registered object with name: " +
+                                          name);
+      }
+      return (*function)(std::forward<Args2>(args)...);
+    }
     Function function;
     {
       absl::ReaderMutexLock lock(&lock_);
@@ -215,6 +306,9 @@ class FunctionRegistry {
   // unregistered, though this will never happen with registrations made via
   // MEDIAPIPE_REGISTER_FACTORY_FUNCTION.
   bool IsRegistered(const std::string& name) const LOCKS_EXCLUDED(lock_) {
+    if (const FrozenFunctions* frozen = GetFrozenFunctions()) {
+      return frozen->Find(name) != nullptr;
+    }
     absl::ReaderMutexLock lock(&lock_);
     return functions_.count(name) != 0;
   }
@@ -273,11 +367,10 @@ class FunctionRegistry {
       return cxx_name;
     }
     std::vector<std::string> spaces = absl::StrSplit(ns, kNameSep);
-    absl::ReaderMutexLock lock(&lock_);
     while (!spaces.empty()) {
       std::string cxx_ns = absl::StrJoin(spaces, kCxxSep);
       std::string qualified_name = absl::StrCat(cxx_ns, kCxxSep, cxx_name);
-      if (functions_.count(qualified_name)) {
+      if (IsRegistered(qualified_name)) {
         return qualified_name;
       }
       spaces.pop_back();
@@ -285,9 +378,96 @@ class FunctionRegistry {
     return cxx_name;
   }
 
+  // Builds the lock-free lookup table now, rather than on the first lookup.
+  // Has no effect if the table was already built or discarded.
+  void Freeze() LOCKS_EXCLUDED(lock_) { GetFrozenFunctions(); }
+
  private:
+  // An immutable snapshot of functions_, indexed by a perfect hash.
+  class FrozenFunctions {
+   public:
+    // Returns the function registered as "name", or nullptr.
+    const Function* Find(absl::string_view name) const {
+      int slot = index_.Slot(name);
+      if (slot < 0 || entries_[slot].first != name) {
+        return nullptr;
+      }
+      return &entries_[slot].second;
+    }
+
+    // Builds the snapshot of "functions".  Returns nullptr if no perfect
+    // hash function was found.
+    static std::unique_ptr<FrozenFunctions> Create(
+        const std::unordered_map<std::string, Function>& functions) {
+      std::vector<absl::string_view> keys;
+      keys.reserve(functions.size());
+      for (const auto& entry : functions) {
+        keys.push_back(entry.first);
+      }
+      std::unique_ptr<FrozenFunctions> result(new FrozenFunctions);
+      std::vector<int> slots;
+      if (!result->index_.Build(keys, &slots)) {
+        return nullptr;
+      }
+      result->entries_.resize(functions.size());
+      int i = 0;
+      for (const auto& entry : functions) {
+        result->entries_[slots[i++]] = entry;
+      }
+      return result;
+    }
+
+   private:
+    FrozenFunctions() = default;
+
+    registration_internal::PerfectHashIndex index_;
+    // The registered functions, ordered by slot.
+    std::vector<std::pair<std::string, Function>> entries_;
+  };
+
+  // Returns the snapshot of functions_, building it on the first call.
+  // Returns nullptr if the snapshot cannot be built or was discarded, in
+  // which case lookups use functions_ under lock_.
+  const FrozenFunctions* GetFrozenFunctions() const LOCKS_EXCLUDED(lock_) {
+    const FrozenFunctions* frozen = frozen_.load(std::memory_order_acquire);
+    if (frozen != nullptr || unfrozen_.load(std::memory_order_relaxed)) {
+      return frozen;
+    }
+    absl::MutexLock lock(&lock_);
+    frozen = frozen_.load(std::memory_order_relaxed);
+    if (frozen != nullptr || unfrozen_.load(std::memory_order_relaxed)) {
+      return frozen;
+    }
+    frozen_snapshot_ = FrozenFunctions::Create(functions_);
+    if (frozen_snapshot_ == nullptr) {
+      LOG(WARNING) << "Could not build a perfect hash of "
+                   << functions_.size() << " registered names.";
+      unfrozen_.store(true, std::memory_order_relaxed);
+      return nullptr;
+    }
+    frozen_.store(frozen_snapshot_.get(), std::memory_order_release);
+    return frozen_snapshot_.get();
+  }
+
+  // Discards the snapshot of functions_ after a change, if it was built.
+  void Unfreeze() EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+    if (frozen_snapshot_ != nullptr) {
+      frozen_.store(nullptr, std::memory_order_release);
+      unfrozen_.store(true, std::memory_order_relaxed);
+    }
+  }
+
   mutable absl::Mutex lock_;
   std::unordered_map<std::string, Function> functions_ GUARDED_BY(lock_);
+  // The snapshot of functions_ used by lookups, or nullptr.
+  mutable std::atomic<const FrozenFunctions*> frozen_{nullptr};
+  // The only snapshot ever built.  It outlives frozen_, since lock-free
+  // readers may still use it after it is discarded.
+  mutable std::unique_ptr<const FrozenFunctions> frozen_snapshot_
+      GUARDED_BY(lock_);
+  // True if the snapshot could not be built or was discarded, so that
+  // lookups use functions_ under lock_ without trying to build it.
+  mutable std::atomic<bool> unfrozen_{false};
 
   // For names included in NamespaceWhitelist, strips the namespace.
   std::string GetAdjustedName(const std::string& name) {
@@ -309,6 +489,7 @@ class FunctionRegistry {
       functions_.erase(adjusted_name);
     }
     functions_.erase(name);
+    Unfreeze();
   }
 };
 
@@ -317,11 +498,18 @@ class GlobalFactoryRegistry {
   using Functions = FunctionRegistry<R, Args...>;
 
  public:
+  using StaticEntry = typename Functions::StaticEntry;
+
   static RegistrationToken Register(const std::string& name,
                                     typename Functions::Function func) {
     return functions()->Register(name, std::move(func));
   }
 
+  template <int N>
+  static RegistrationToken Register(const StaticEntry (&entries)[N]) {
+    return functions()->Register(entries, N);
+  }
+
   // Same as CreateByNameInNamespace but without a namespace.
   template <typename... Args2>
   static typename Functions::ReturnType CreateByName(const std::string& name,
@@ -382,6 +570,12 @@ class GlobalFactoryRegistry {
       new ::mediapipe::RegistrationToken(                                      \
           RegistryType::Register(#name, __VA_ARGS__))
 
+// Registers an array of RegistryType::StaticEntry with a single static
+// initializer.
+#define MEDIAPIPE_REGISTER_FACTORY_FUNCTIONS(RegistryType, var_name, entries) \
+  static auto* REGISTRY_STATIC_VAR(var_name, __LINE__) =                      \
+      new ::mediapipe::RegistrationToken(RegistryType::Register(entries))
+
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_DEPS_REGISTRATION_H_
@@ -0,0 +1,141 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/deps/registration.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe {
+namespace {
+
+using IntRegistry = FunctionRegistry<int, int>;
+
+int Double(int x) { return 2 * x; }
+int Negate(int x) { return -x; }
+
+using TestRegistry = GlobalFactoryRegistry<int, int>;
+
+constexpr TestRegistry::StaticEntry kStaticEntries[] = {
+    {"::mediapipe::Double", &Double},
+    {"::test_ns::Negate", &Negate},
+};
+MEDIAPIPE_REGISTER_FACTORY_FUNCTIONS(TestRegistry, static_entries,
+                                     kStaticEntries);
+
+TEST(RegistrationTest, InvokesRegisteredFunctions) {
+  IntRegistry registry;
+  RegistrationToken add_one =
+      registry.Register("AddOne", [](int x) { return x + 1; });
+  RegistrationToken double_it = registry.Register("::my_ns::Double", Double);
+
+  EXPECT_EQ(4, registry.Invoke("AddOne", 3).ValueOrDie());
+  EXPECT_EQ(6, registry.Invoke("my_ns::Double", 3).ValueOrDie());
+  EXPECT_EQ(6, registry.Invoke("my_ns", "Double", 3).ValueOrDie());
+  EXPECT_EQ(6, registry.Invoke("my_ns.sub_ns", "Double", 3).ValueOrDie());
+  EXPECT_TRUE(registry.IsRegistered("AddOne"));
+  EXPECT_FALSE(registry.IsRegistered("Double"));
+  EXPECT_EQ(::mediapipe::StatusCode::kNotFound,
+            registry.Invoke("Double", 3).status().code());
+}
+
+// Registrations made after the first lookup are seen by later lookups.
+TEST(RegistrationTest, RegisterAfterLookup) {
+  IntRegistry registry;
+  RegistrationToken add_one =
+      registry.Register("AddOne", [](int x) { return x + 1; });
+  registry.Freeze();
+  EXPECT_FALSE(registry.IsRegistered("AddTwo"));
+
+  RegistrationToken add_two =
+      registry.Register("AddTwo", [](int x) { return x + 2; });
+  EXPECT_EQ(5, registry.Invoke("AddTwo", 3).ValueOrDie());
+  EXPECT_EQ(4, registry.Invoke("AddOne", 3).ValueOrDie());
+
+  add_one.Unregister();
+  EXPECT_FALSE(registry.IsRegistered("AddOne"));
+  EXPECT_TRUE(registry.IsRegistered("AddTwo"));
+  add_two.Unregister();
+  EXPECT_FALSE(registry.Invoke("AddTwo", 3).ok());
+}
+
+TEST(RegistrationTest, EmptyRegistry) {
+  IntRegistry registry;
+  EXPECT_FALSE(registry.IsRegistered("AddOne"));
+  EXPECT_FALSE(registry.Invoke("AddOne", 3).ok());
+}
+
+TEST(RegistrationTest, RegistersStaticEntries) {
+  // Names in the "mediapipe" namespace are also registered unqualified.
+  EXPECT_EQ(6, TestRegistry::CreateByName("Double", 3).ValueOrDie());
+  EXPECT_EQ(6, TestRegistry::CreateByName("mediapipe.Double", 3).ValueOrDie());
+  EXPECT_EQ(-3, TestRegistry::CreateByNameInNamespace("test_ns", "Negate", 3)
+                    .ValueOrDie());
+  EXPECT_FALSE(TestRegistry::IsRegistered("Negate"));
+}
+
+TEST(PerfectHashIndexTest, MapsKeysToDistinctSlots) {
+  for (int num_keys : {1, 2, 10, 1000}) {
+    std::vector<std::string> names;
+    for (int i = 0; i < num_keys; ++i) {
+      names.push_back(absl::StrCat("Calculator", i));
+    }
+    std::vector<absl::string_view> keys(names.begin(), names.end());
+    registration_internal::PerfectHashIndex index;
+    std::vector<int> slots;
+    ASSERT_TRUE(index.Build(keys, &slots));
+    EXPECT_EQ(num_keys, index.size());
+    std::set<int> distinct_slots(slots.begin(), slots.end());
+    EXPECT_EQ(num_keys, distinct_slots.size());
+    for (int i = 0; i < num_keys; ++i) {
+      EXPECT_EQ(slots[i], index.Slot(keys[i]));
+    }
+    EXPECT_LT(index.Slot("NoSuchCalculator"), num_keys);
+  }
+}
+
+// Looks up names in a registry of 500 functions from state.threads threads,
+// as done for every node when graphs are initialized.
+void BM_Invoke(benchmark::State& state) {
+  constexpr int kNumFunctions = 500;
+  static IntRegistry* registry = [] {
+    auto* registry = new IntRegistry;
+    for (int i = 0; i < kNumFunctions; ++i) {
+      new RegistrationToken(registry->Register(
+          absl::StrCat("::mediapipe::Calculator", i), Double));
+    }
+    return registry;
+  }();
+  std::vector<std::string> names;
+  for (int i = 0; i < kNumFunctions; ++i) {
+    names.push_back(absl::StrCat("Calculator", i));
+  }
+  int i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        registry->Invoke("mediapipe", names[i], i).ValueOrDie());
+    i = (i + 1) % kNumFunctions;
+  }
+}
+
+BENCHMARK(BM_Invoke)->ThreadRange(1, 4);
+
+}  // namespace
+}  // namespace mediapipe
@@ -26,7 +26,10 @@ namespace mediapipe {
 // the field descriptions.
 class ThreadOptions {
  public:
-  ThreadOptions() : stack_size_(0), nice_priority_level_(0) {}
+  ThreadOptions()
+      : stack_size_(0),
+        nice_priority_level_(0),
+        pin_one_thread_per_cpu_(false) {}
 
   // Set the thread stack size (in bytes).  Passing stack_size==0 resets
   // the stack size to the default value for the system. The system default
@@ -46,6 +49,21 @@ class ThreadOptions {
     return *this;
   }
 
+  // If true, each thread of a thread pool is pinned to a single CPU of
+  // cpu_set instead of to the whole set: the i-th thread runs on the i-th
+  // CPU in cpu_set, wrapping around if there are more threads than CPUs.
+  ThreadOptions& set_pin_one_thread_per_cpu(bool pin_one_thread_per_cpu) {
+    pin_one_thread_per_cpu_ = pin_one_thread_per_cpu;
+    return *this;
+  }
+
+  // Restricts the memory allocations of the threads to the given NUMA nodes.
+  // If empty, the system's default memory policy is used.
+  ThreadOptions& set_numa_memory_nodes(const std::set<int>& numa_memory_nodes) {
+    numa_memory_nodes_ = numa_memory_nodes;
+    return *this;
+  }
+
   ThreadOptions& set_name_prefix(const std::string& name_prefix) {
     name_prefix_ = name_prefix;
     return *this;
@@ -57,6 +75,10 @@ class ThreadOptions {
 
   const std::set<int>& cpu_set() const { return cpu_set_; }
 
+  bool pin_one_thread_per_cpu() const { return pin_one_thread_per_cpu_; }
+
+  const std::set<int>& numa_memory_nodes() const { return numa_memory_nodes_; }
+
   std::string name_prefix() const { return name_prefix_; }
 
  private:
@@ -64,6 +86,10 @@ class ThreadOptions {
   int nice_priority_level_;  // Nice priority level of the workers
   std::set<int> cpu_set_;    // CPU set for affinity setting
   std::string name_prefix_;  // Name of the thread
+  // Whether each thread is pinned to a single CPU of cpu_set_.
+  bool pin_one_thread_per_cpu_;
+  // NUMA nodes for memory allocation.
+  std::set<int> numa_memory_nodes_;
 };
 
 }  // namespace mediapipe
@@ -19,6 +19,13 @@
 #include <string.h>
 #include <sys/syscall.h>
 #include <unistd.h>
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#endif  // __linux__
+
+#include <iterator>
+#include <set>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
@@ -29,7 +36,8 @@ namespace mediapipe {
 class ThreadPool::WorkerThread {
  public:
   // Creates and starts a thread that runs pool->RunWorker().
-  WorkerThread(ThreadPool* pool, const std::string& name_prefix);
+  WorkerThread(ThreadPool* pool, const std::string& name_prefix,
+               int thread_index);
 
   // REQUIRES: Join() must have been called.
   ~WorkerThread();
@@ -42,12 +50,14 @@ class ThreadPool::WorkerThread {
 
   ThreadPool* pool_;
   std::string name_prefix_;
+  int thread_index_;
   pthread_t thread_;
 };
 
 ThreadPool::WorkerThread::WorkerThread(ThreadPool* pool,
-                                       const std::string& name_prefix)
-    : pool_(pool), name_prefix_(name_prefix) {
+                                       const std::string& name_prefix,
+                                       int thread_index)
+    : pool_(pool), name_prefix_(name_prefix), thread_index_(thread_index) {
   pthread_create(&thread_, nullptr, ThreadBody, this);
 }
 
@@ -57,54 +67,8 @@ void ThreadPool::WorkerThread::Join() { pthread_join(thread_, nullptr); }
 
 void* ThreadPool::WorkerThread::ThreadBody(void* arg) {
   auto thread = reinterpret_cast<WorkerThread*>(arg);
-  int nice_priority_level =
-      thread->pool_->thread_options().nice_priority_level();
-  const std::set<int> selected_cpus = thread->pool_->thread_options().cpu_set();
-  const std::string name =
-      internal::CreateThreadName(thread->name_prefix_, syscall(SYS_gettid));
-#if defined(__linux__)
-  if (nice_priority_level != 0) {
-    if (nice(nice_priority_level) != -1 || errno == 0) {
-      VLOG(1) << "Changed the nice priority level by " << nice_priority_level;
-    } else {
-      LOG(ERROR) << "Error : " << strerror(errno) << std::endl
-                 << "Could not change the nice priority level by "
-                 << nice_priority_level;
-    }
-  }
-  if (!selected_cpus.empty()) {
-    cpu_set_t cpu_set;
-    CPU_ZERO(&cpu_set);
-    for (const int cpu : selected_cpus) {
-      CPU_SET(cpu, &cpu_set);
-    }
-    if (sched_setaffinity(syscall(SYS_gettid), sizeof(cpu_set_t), &cpu_set) !=
-            -1 ||
-        errno == 0) {
-      VLOG(1) << "Pinned the thread pool executor to processor "
-              << absl::StrJoin(selected_cpus, ", processor ") << ".";
-    } else {
-      LOG(ERROR) << "Error : " << strerror(errno) << std::endl
-                 << "Failed to set processor affinity. Ignore processor "
-                    "affinity setting for now.";
-    }
-  }
-  int error = pthread_setname_np(pthread_self(), name.c_str());
-  if (error != 0) {
-    LOG(ERROR) << "Error : " << strerror(error) << std::endl
-               << "Failed to set name for thread: " << name;
-  }
-#else
-  if (nice_priority_level != 0 || !selected_cpus.empty()) {
-    LOG(ERROR) << "Thread priority and processor affinity feature aren't "
-                  "supported on the current platform.";
-  }
-  int error = pthread_setname_np(name.c_str());
-  if (error != 0) {
-    LOG(ERROR) << "Error : " << strerror(error) << std::endl
-               << "Failed to set name for thread: " << name;
-  }
-#endif
+  internal::ConfigureCurrentThread(thread->pool_->thread_options(),
+                                   thread->name_prefix_, thread->thread_index_);
   thread->pool_->RunWorker();
   return nullptr;
 }
@@ -140,7 +104,7 @@ ThreadPool::~ThreadPool() {
 
 void ThreadPool::StartWorkers() {
   for (int i = 0; i < num_threads_; ++i) {
-    threads_.push_back(new WorkerThread(this, name_prefix_));
+    threads_.push_back(new WorkerThread(this, name_prefix_, i));
   }
 }
 
@@ -179,6 +143,81 @@ const ThreadOptions& ThreadPool::thread_options() const {
 
 namespace internal {
 
+void ConfigureCurrentThread(const ThreadOptions& thread_options,
+                            const std::string& name_prefix, int thread_index) {
+  int nice_priority_level = thread_options.nice_priority_level();
+  std::set<int> selected_cpus = thread_options.cpu_set();
+  if (thread_options.pin_one_thread_per_cpu() && !selected_cpus.empty()) {
+    auto cpu = selected_cpus.begin();
+    std::advance(cpu, thread_index % selected_cpus.size());
+    selected_cpus = {*cpu};
+  }
+  const std::set<int>& numa_nodes = thread_options.numa_memory_nodes();
+  const std::string name = CreateThreadName(name_prefix, syscall(SYS_gettid));
+#if defined(__linux__)
+  if (nice_priority_level != 0) {
+    if (nice(nice_priority_level) != -1 || errno == 0) {
+      VLOG(1) << "Changed the nice priority level by " << nice_priority_level;
+    } else {
+      LOG(ERROR) << "Error : " << strerror(errno) << std::endl
+                 << "Could not change the nice priority level by "
+                 << nice_priority_level;
+    }
+  }
+  if (!selected_cpus.empty()) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (const int cpu : selected_cpus) {
+      CPU_SET(cpu, &cpu_set);
+    }
+    if (sched_setaffinity(syscall(SYS_gettid), sizeof(cpu_set_t), &cpu_set) !=
+            -1 ||
+        errno == 0) {
+      VLOG(1) << "Pinned the thread pool executor to processor "
+              << absl::StrJoin(selected_cpus, ", processor ") << ".";
+    } else {
+      LOG(ERROR) << "Error : " << strerror(errno) << std::endl
+                 << "Failed to set processor affinity. Ignore processor "
+                    "affinity setting for now.";
+    }
+  }
+  if (!numa_nodes.empty()) {
+    constexpr int kBitsPerWord = 8 * sizeof(unsigned long);  // NOLINT
+    std::vector<unsigned long> node_mask(  // NOLINT
+        *numa_nodes.rbegin() / kBitsPerWord + 1, 0);
+    for (const int node : numa_nodes) {
+      node_mask[node / kBitsPerWord] |= 1UL << (node % kBitsPerWord);
+    }
+    // The kernel reads one bit less than the maxnode argument.
+    if (syscall(SYS_set_mempolicy, MPOL_BIND, node_mask.data(),
+                node_mask.size() * kBitsPerWord + 1) == 0) {
+      VLOG(1) << "Bound the memory of the thread to NUMA node "
+              << absl::StrJoin(numa_nodes, ", NUMA node ") << ".";
+    } else {
+      LOG(ERROR) << "Error : " << strerror(errno) << std::endl
+                 << "Failed to set the NUMA memory policy. Ignore NUMA "
+                    "memory setting for now.";
+    }
+  }
+  int error = pthread_setname_np(pthread_self(), name.c_str());
+  if (error != 0) {
+    LOG(ERROR) << "Error : " << strerror(error) << std::endl
+               << "Failed to set name for thread: " << name;
+  }
+#else
+  if (nice_priority_level != 0 || !selected_cpus.empty() ||
+      !numa_nodes.empty()) {
+    LOG(ERROR) << "Thread priority, processor affinity and NUMA memory "
+                  "features aren't supported on the current platform.";
+  }
+  int error = pthread_setname_np(name.c_str());
+  if (error != 0) {
+    LOG(ERROR) << "Error : " << strerror(error) << std::endl
+               << "Failed to set name for thread: " << name;
+  }
+#endif
+}
+
 std::string CreateThreadName(const std::string& prefix, int thread_id) {
   std::string name = absl::StrCat(prefix, "/", thread_id);
   // 16 is the limit allowed by `pthread_setname_np`, including
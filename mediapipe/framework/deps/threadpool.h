@@ -110,6 +110,14 @@ namespace internal {
 // name_prefix_long, 1234  -> name_prefix_lon
 std::string CreateThreadName(const std::string& prefix, int thread_id);
 
+// Applies the nice priority level, the processor affinity and the NUMA
+// memory policy from "thread_options" to the calling thread, and names it
+// after "name_prefix". "thread_index" is the index of the thread in its pool,
+// which selects its CPU if pin_one_thread_per_cpu is set. Used by the worker
+// threads of the thread pools in this directory.
+void ConfigureCurrentThread(const ThreadOptions& thread_options,
+                            const std::string& name_prefix, int thread_index);
+
 }  // namespace internal
 
 }  // namespace mediapipe
@@ -14,7 +14,10 @@
 
 #include "mediapipe/framework/deps/threadpool.h"
 
+#include <sched.h>
+
 #include <set>
+#include <vector>
 
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/port/gtest.h"
@@ -91,6 +94,82 @@ TEST(ThreadPoolTest, CreateWithCPUAffinity) {
   thread_pool.StartWorkers();
 }
 
+#if defined(__linux__)
+// Returns the processors that the calling thread may run on.
+std::set<int> GetCurrentThreadCpus() {
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  EXPECT_EQ(0, sched_getaffinity(0, sizeof(cpu_set), &cpu_set));
+  std::set<int> cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &cpu_set)) {
+      cpus.insert(cpu);
+    }
+  }
+  return cpus;
+}
+
+// The processors that the threads of a thread pool may run on, one entry per
+// thread.
+struct WorkerCpus {
+  bool AllRecorded() EXCLUSIVE_LOCKS_REQUIRED(mu) {
+    return cpus.size() == num_threads;
+  }
+
+  absl::Mutex mu;
+  int num_threads = 0;
+  std::vector<std::set<int>> cpus GUARDED_BY(mu);
+};
+
+// Runs one callback on each of the "num_threads" threads of a thread pool
+// created with "thread_options", and returns the processors that each thread
+// may run on.
+std::vector<std::set<int>> GetWorkerCpus(const ThreadOptions& thread_options,
+                                         int num_threads) {
+  WorkerCpus worker_cpus;
+  worker_cpus.num_threads = num_threads;
+  {
+    ThreadPool thread_pool(thread_options, "testpool", num_threads);
+    thread_pool.StartWorkers();
+    for (int i = 0; i < num_threads; ++i) {
+      thread_pool.Schedule([&worker_cpus]() {
+        absl::MutexLock l(&worker_cpus.mu);
+        worker_cpus.cpus.push_back(GetCurrentThreadCpus());
+        // Block until every thread has taken a callback, so that no thread
+        // runs two of them.
+        worker_cpus.mu.Await(
+            absl::Condition(&worker_cpus, &WorkerCpus::AllRecorded));
+      });
+    }
+  }
+  absl::MutexLock l(&worker_cpus.mu);
+  return worker_cpus.cpus;
+}
+
+TEST(ThreadPoolTest, CpuSetAppliesToAllThreads) {
+  const std::set<int> cpus = {*GetCurrentThreadCpus().begin()};
+  for (const std::set<int>& worker_cpus :
+       GetWorkerCpus(ThreadOptions().set_cpu_set(cpus), 3)) {
+    EXPECT_EQ(cpus, worker_cpus);
+  }
+}
+
+TEST(ThreadPoolTest, PinOneThreadPerCpu) {
+  const std::set<int> cpus = GetCurrentThreadCpus();
+  std::multiset<int> used_cpus;
+  for (const std::set<int>& worker_cpus : GetWorkerCpus(
+           ThreadOptions().set_cpu_set(cpus).set_pin_one_thread_per_cpu(true),
+           cpus.size() * 2)) {
+    ASSERT_EQ(1, worker_cpus.size());
+    used_cpus.insert(*worker_cpus.begin());
+  }
+  // Every processor runs exactly two threads.
+  for (const int cpu : cpus) {
+    EXPECT_EQ(2, used_cpus.count(cpu));
+  }
+}
+#endif  // defined(__linux__)
+
 TEST(ThreadPoolTest, CreateThreadName) {
   ASSERT_EQ("name_prefix/123", internal::CreateThreadName("name_prefix", 1234));
   ASSERT_EQ("name_prefix/123",
@@ -0,0 +1,196 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/deps/work_stealing_threadpool.h"
+
+#include <pthread.h>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/deps/threadpool.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Identifies the pool and the queue owned by the calling worker thread, so
+// that callbacks scheduled from a worker stay on that worker's queue.
+struct CurrentWorker {
+  const WorkStealingThreadPool* pool = nullptr;
+  int index = -1;
+};
+
+thread_local CurrentWorker current_worker;
+
+// A xorshift generator, used to pick steal victims without sharing state
+// between workers.
+inline uint32_t NextRandom(uint32_t* state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+}  // namespace
+
+class WorkStealingThreadPool::WorkerThread {
+ public:
+  // Creates and starts a thread that runs pool->RunWorker(worker_index).
+  WorkerThread(WorkStealingThreadPool* pool, int worker_index);
+
+  // Joins with the running thread.
+  void Join();
+
+ private:
+  static void* ThreadBody(void* arg);
+
+  WorkStealingThreadPool* pool_;
+  int worker_index_;
+  pthread_t thread_;
+};
+
+WorkStealingThreadPool::WorkerThread::WorkerThread(WorkStealingThreadPool* pool,
+                                                   int worker_index)
+    : pool_(pool), worker_index_(worker_index) {
+  pthread_create(&thread_, nullptr, ThreadBody, this);
+}
+
+void WorkStealingThreadPool::WorkerThread::Join() {
+  pthread_join(thread_, nullptr);
+}
+
+void* WorkStealingThreadPool::WorkerThread::ThreadBody(void* arg) {
+  auto thread = reinterpret_cast<WorkerThread*>(arg);
+  internal::ConfigureCurrentThread(thread->pool_->thread_options(),
+                                   thread->pool_->name_prefix_,
+                                   thread->worker_index_);
+  current_worker.pool = thread->pool_;
+  current_worker.index = thread->worker_index_;
+  thread->pool_->RunWorker(thread->worker_index_);
+  current_worker = CurrentWorker();
+  return nullptr;
+}
+
+WorkStealingThreadPool::WorkStealingThreadPool(const std::string& name_prefix,
+                                               int num_threads)
+    : WorkStealingThreadPool(ThreadOptions(), name_prefix, num_threads) {}
+
+WorkStealingThreadPool::WorkStealingThreadPool(
+    const ThreadOptions& thread_options, const std::string& name_prefix,
+    int num_threads)
+    : name_prefix_(name_prefix), thread_options_(thread_options) {
+  num_threads_ = (num_threads == 0) ? 1 : num_threads;
+  for (int i = 0; i < num_threads_; ++i) {
+    queues_.push_back(absl::make_unique<WorkerQueue>());
+  }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  {
+    absl::MutexLock lock(&park_mutex_);
+    stopped_ = true;
+    park_condition_.SignalAll();
+  }
+  for (auto& thread : threads_) {
+    thread->Join();
+  }
+  threads_.clear();
+}
+
+void WorkStealingThreadPool::StartWorkers() {
+  for (int i = 0; i < num_threads_; ++i) {
+    threads_.push_back(absl::make_unique<WorkerThread>(this, i));
+  }
+}
+
+void WorkStealingThreadPool::Schedule(std::function<void()> callback) {
+  int index;
+  if (current_worker.pool == this) {
+    index = current_worker.index;
+  } else {
+    index = next_queue_.fetch_add(1, std::memory_order_relaxed) % num_threads_;
+  }
+  {
+    WorkerQueue* queue = queues_[index].get();
+    absl::MutexLock lock(&queue->mutex);
+    queue->tasks.push_back(std::move(callback));
+  }
+  // Paired with the sequentially consistent accesses in Park(): either the
+  // parking worker sees the new pending task, or we see the parked worker.
+  pending_tasks_.fetch_add(1);
+  if (num_parked_.load() > 0) {
+    absl::MutexLock lock(&park_mutex_);
+    park_condition_.Signal();
+  }
+}
+
+void WorkStealingThreadPool::RunWorker(int worker_index) {
+  uint32_t random_state = 2654435761u * (worker_index + 1);
+  std::function<void()> task;
+  while (true) {
+    if (FindTask(worker_index, &random_state, &task)) {
+      task();
+      task = nullptr;
+    } else if (!Park()) {
+      break;
+    }
+  }
+}
+
+bool WorkStealingThreadPool::FindTask(int worker_index, uint32_t* random_state,
+                                      std::function<void()>* task) {
+  {
+    WorkerQueue* own = queues_[worker_index].get();
+    absl::MutexLock lock(&own->mutex);
+    if (!own->tasks.empty()) {
+      *task = std::move(own->tasks.front());
+      own->tasks.pop_front();
+      pending_tasks_.fetch_sub(1);
+      return true;
+    }
+  }
+  if (num_threads_ == 1) {
+    return false;
+  }
+  const int start = NextRandom(random_state) % num_threads_;
+  for (int i = 0; i < num_threads_; ++i) {
+    const int victim_index = (start + i) % num_threads_;
+    if (victim_index == worker_index) {
+      continue;
+    }
+    WorkerQueue* victim = queues_[victim_index].get();
+    absl::MutexLock lock(&victim->mutex);
+    if (!victim->tasks.empty()) {
+      *task = std::move(victim->tasks.back());
+      victim->tasks.pop_back();
+      pending_tasks_.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool WorkStealingThreadPool::Park() {
+  absl::MutexLock lock(&park_mutex_);
+  num_parked_.fetch_add(1);
+  while (pending_tasks_.load() == 0 && !stopped_) {
+    park_condition_.Wait(&park_mutex_);
+  }
+  num_parked_.fetch_sub(1);
+  // Keep draining the queues after the pool is stopped.
+  return pending_tasks_.load() > 0 || !stopped_;
+}
+
+}  // namespace mediapipe
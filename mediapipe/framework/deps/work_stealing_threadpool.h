@@ -0,0 +1,122 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_DEPS_WORK_STEALING_THREADPOOL_H_
+#define MEDIAPIPE_DEPS_WORK_STEALING_THREADPOOL_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/deps/thread_options.h"
+
+namespace mediapipe {
+
+// A thread pool in which every worker thread owns a queue of callbacks.
+//
+// Callbacks scheduled from a worker thread of the pool are appended to that
+// worker's own queue; callbacks scheduled from any other thread are
+// distributed round-robin over the worker queues. A worker runs the callbacks
+// in its own queue in FIFO order, and when its queue is empty it steals from
+// the back of the queue of a randomly chosen victim. A worker that finds no
+// work anywhere parks on a condition variable until a new callback arrives.
+//
+// Compared to ThreadPool, which has a single queue guarded by a single mutex,
+// this avoids contention on a shared lock when many workers run many short
+// callbacks. The interface mirrors ThreadPool.
+//
+// The thread pool is shut down when the pool is destroyed. Callbacks that
+// are still queued at that point are run before the destructor returns.
+class WorkStealingThreadPool {
+ public:
+  // Create a thread pool that provides a concurrency of "num_threads"
+  // threads. If num_threads is 1, the callbacks are run in FIFO order.
+  WorkStealingThreadPool(const std::string& name_prefix, int num_threads);
+
+  // Like the constructor above, except that the worker threads are also
+  // configured with "thread_options".
+  WorkStealingThreadPool(const ThreadOptions& thread_options,
+                         const std::string& name_prefix, int num_threads);
+
+  WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+  WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+
+  // Waits for closures (if any) to complete. May be called without
+  // having called StartWorkers().
+  ~WorkStealingThreadPool();
+
+  // REQUIRES: StartWorkers has not been called
+  // Actually start the worker threads.
+  void StartWorkers();
+
+  // REQUIRES: StartWorkers has been called
+  // Add specified callback to one of the worker queues. Eventually a
+  // thread will pull this callback off a queue and execute it.
+  void Schedule(std::function<void()> callback);
+
+  // Provided for debugging and testing only.
+  int num_threads() const { return num_threads_; }
+
+  // Standard thread options.  Use this accessor to get them.
+  const ThreadOptions& thread_options() const { return thread_options_; }
+
+ private:
+  class WorkerThread;
+
+  // The queue of callbacks owned by one worker thread. The owner takes
+  // callbacks from the front and thieves take them from the back.
+  struct WorkerQueue {
+    absl::Mutex mutex;
+    std::deque<std::function<void()>> tasks GUARDED_BY(mutex);
+  };
+
+  void RunWorker(int worker_index);
+
+  // Takes a callback from the front of the worker's own queue, or steals one
+  // from another queue. Returns false if all queues were found empty.
+  bool FindTask(int worker_index, uint32_t* random_state,
+                std::function<void()>* task);
+
+  // Blocks the calling worker until a callback is pending or the pool is
+  // stopped. Returns false if the worker should exit.
+  bool Park();
+
+  std::string name_prefix_;
+  int num_threads_;
+  ThreadOptions thread_options_;
+
+  std::vector<std::unique_ptr<WorkerQueue>> queues_;
+  std::vector<std::unique_ptr<WorkerThread>> threads_;
+
+  // Number of callbacks that are queued but not yet taken by a worker.
+  std::atomic<int64_t> pending_tasks_{0};
+  // Number of workers that are about to block or blocked on park_condition_.
+  std::atomic<int> num_parked_{0};
+  // Used to distribute callbacks scheduled from outside of the pool.
+  std::atomic<uint32_t> next_queue_{0};
+
+  absl::Mutex park_mutex_;
+  absl::CondVar park_condition_;
+  bool stopped_ GUARDED_BY(park_mutex_) = false;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_DEPS_WORK_STEALING_THREADPOOL_H_
@@ -0,0 +1,112 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/deps/work_stealing_threadpool.h"
+
+#include <atomic>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+
+TEST(WorkStealingThreadPoolTest, DestroyWithoutStart) {
+  WorkStealingThreadPool thread_pool("testpool", 10);
+}
+
+TEST(WorkStealingThreadPoolTest, EmptyThread) {
+  WorkStealingThreadPool thread_pool("testpool", 0);
+  ASSERT_EQ(1, thread_pool.num_threads());
+  thread_pool.StartWorkers();
+}
+
+TEST(WorkStealingThreadPoolTest, SingleThreadRunsInFifoOrder) {
+  std::vector<int> order;
+  {
+    WorkStealingThreadPool thread_pool("testpool", 1);
+    thread_pool.StartWorkers();
+    for (int i = 0; i < 100; ++i) {
+      thread_pool.Schedule([&order, i]() { order.push_back(i); });
+    }
+  }
+  ASSERT_EQ(100, order.size());
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(i, order[i]);
+  }
+}
+
+TEST(WorkStealingThreadPoolTest, MultiThreads) {
+  absl::Mutex mu;
+  int n = 1000;
+  {
+    WorkStealingThreadPool thread_pool("testpool", 10);
+    ASSERT_EQ(10, thread_pool.num_threads());
+    thread_pool.StartWorkers();
+
+    for (int i = 0; i < 1000; ++i) {
+      thread_pool.Schedule([&n, &mu]() mutable {
+        absl::MutexLock l(&mu);
+        --n;
+      });
+    }
+  }
+
+  EXPECT_EQ(0, n);
+}
+
+// Callbacks scheduled from a worker go to that worker's own queue; the idle
+// workers must steal them for all callbacks to run.
+TEST(WorkStealingThreadPoolTest, ScheduleFromWorker) {
+  std::atomic<int> n(0);
+  {
+    WorkStealingThreadPool thread_pool("testpool", 4);
+    thread_pool.StartWorkers();
+    thread_pool.Schedule([&thread_pool, &n]() {
+      for (int i = 0; i < 1000; ++i) {
+        thread_pool.Schedule([&n]() { n.fetch_add(1); });
+      }
+    });
+  }
+  EXPECT_EQ(1000, n.load());
+}
+
+// Idle workers park and must be woken up by later callbacks.
+TEST(WorkStealingThreadPoolTest, WakeUpParkedWorkers) {
+  WorkStealingThreadPool thread_pool("testpool", 4);
+  thread_pool.StartWorkers();
+  for (int round = 0; round < 100; ++round) {
+    absl::Mutex mu;
+    int done = 0;
+    for (int i = 0; i < 4; ++i) {
+      thread_pool.Schedule([&mu, &done]() {
+        absl::MutexLock l(&mu);
+        ++done;
+      });
+    }
+    absl::MutexLock l(&mu);
+    mu.Await(absl::Condition(
+        +[](int* done) { return *done == 4; }, &done));
+  }
+}
+
+TEST(WorkStealingThreadPoolTest, CreateWithThreadOptions) {
+  ThreadOptions thread_options = ThreadOptions().set_nice_priority_level(-10);
+  WorkStealingThreadPool thread_pool(thread_options, "testpool", 10);
+  ASSERT_EQ(10, thread_pool.num_threads());
+  ASSERT_EQ(-10, thread_pool.thread_options().nice_priority_level());
+  thread_pool.StartWorkers();
+}
+
+}  // namespace mediapipe
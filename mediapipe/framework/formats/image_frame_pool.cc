@@ -0,0 +1,145 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/image_frame_pool.h"
+
+#include <algorithm>
+#include <tuple>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/aligned_malloc_and_free.h"
+#include "mediapipe/framework/port/logging.h"
+
+namespace mediapipe {
+
+// The maximum number of ImageFrameSpecs in an ImageFramePool.  When the limit
+// is reached, the oldest ImageFrameSpec will be dropped.
+static constexpr int kMaxPoolCount = 20;
+
+constexpr int ImageFramePool::kDefaultKeepCount;
+
+namespace {
+
+// Creates the pool of a graph that uses kImageFramePoolService without
+// setting it.
+std::shared_ptr<ImageFramePool> CreateDefaultImageFramePool() {
+  return std::make_shared<ImageFramePool>();
+}
+
+int AlignedWidthStep(const ImageFrameSpec& spec) {
+  int width_step = spec.width *
+                   ImageFrame::NumberOfChannelsForFormat(spec.format) *
+                   ImageFrame::ByteDepthForFormat(spec.format);
+  // Rounds up to a multiple of alignment_boundary, as in ImageFrame::Reset.
+  return ((width_step - 1) | (spec.alignment_boundary - 1)) + 1;
+}
+
+}  // namespace
+
+const GraphService<ImageFramePool> kImageFramePoolService(
+    "kImageFramePoolService", CreateDefaultImageFramePool);
+
+ImageFrameBufferPool::ImageFrameBufferPool(const ImageFrameSpec& spec,
+                                           int keep_count)
+    : spec_(spec),
+      width_step_(AlignedWidthStep(spec)),
+      keep_count_(keep_count) {
+  CHECK_NE(ImageFormat::UNKNOWN, spec.format);
+  CHECK_GT(spec.alignment_boundary, 0);
+  CHECK_EQ(spec.alignment_boundary & (spec.alignment_boundary - 1), 0)
+      << "alignment_boundary must be a power of 2";
+}
+
+ImageFrameBufferPool::~ImageFrameBufferPool() {
+  for (uint8* buffer : available_) {
+    aligned_free(buffer);
+  }
+}
+
+std::unique_ptr<ImageFrame> ImageFrameBufferPool::GetFrame() {
+  uint8* buffer = nullptr;
+  {
+    absl::MutexLock lock(&mutex_);
+    if (!available_.empty()) {
+      buffer = available_.back();
+      available_.pop_back();
+    }
+    ++in_use_count_;
+  }
+  if (buffer == nullptr) {
+    buffer = reinterpret_cast<uint8*>(
+        aligned_malloc(spec_.height * width_step_, spec_.alignment_boundary));
+  }
+
+  // Returns a frame with a custom deleter that adds the buffer back to our
+  // available list.
+  std::weak_ptr<ImageFrameBufferPool> weak_pool(shared_from_this());
+  return absl::make_unique<ImageFrame>(
+      spec_.format, spec_.width, spec_.height, width_step_, buffer,
+      [weak_pool](uint8* buffer) {
+        auto pool = weak_pool.lock();
+        if (pool) {
+          pool->Return(buffer);
+        } else {
+          aligned_free(buffer);
+        }
+      });
+}
+
+std::pair<int, int> ImageFrameBufferPool::GetInUseAndAvailableCounts() {
+  absl::MutexLock lock(&mutex_);
+  return {in_use_count_, available_.size()};
+}
+
+void ImageFrameBufferPool::Return(uint8* buffer) {
+  absl::MutexLock lock(&mutex_);
+  --in_use_count_;
+  available_.push_back(buffer);
+  TrimAvailable();
+}
+
+void ImageFrameBufferPool::TrimAvailable() {
+  int keep = std::max(keep_count_ - in_use_count_, 0);
+  while (available_.size() > keep) {
+    aligned_free(available_.back());
+    available_.pop_back();
+  }
+}
+
+std::unique_ptr<ImageFrame> ImageFramePool::GetFrame(
+    ImageFormat::Format format, int width, int height,
+    uint32 alignment_boundary) {
+  SimplePool pool;
+  {
+    absl::MutexLock lock(&mutex_);
+    ImageFrameSpec key(format, width, height, alignment_boundary);
+    auto pool_it = pools_.find(key);
+    if (pool_it == pools_.end()) {
+      // Discard the oldest pool in order of creation.
+      if (pools_.size() >= kMaxPoolCount) {
+        auto old_spec = frame_specs_.front();
+        frame_specs_.pop();
+        pools_.erase(old_spec);
+      }
+      frame_specs_.push(key);
+      std::tie(pool_it, std::ignore) =
+          pools_.emplace(key, ImageFrameBufferPool::Create(key, keep_count_));
+    }
+    pool = pool_it->second;
+  }
+  return pool->GetFrame();
+}
+
+}  // namespace mediapipe
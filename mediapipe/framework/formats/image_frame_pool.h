@@ -0,0 +1,159 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This class lets calculators allocate ImageFrames of various sizes, caching
+// and reusing their pixel buffers as needed.  It is the CPU counterpart of
+// GpuBufferMultiPool.  A graph provides one ImageFramePool to all of its
+// calculators as the service kImageFramePoolService.
+//
+// Example usage:
+//
+//   static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+//     cc->UseService(kImageFramePoolService);
+//     ...
+//   }
+//
+//   ::mediapipe::Status Process(CalculatorContext* cc) {
+//     std::unique_ptr<ImageFrame> output_frame =
+//         cc->Service(kImageFramePoolService).GetObject().GetFrame(
+//             ImageFormat::SRGB, width, height);
+//     ...
+//   }
+
+#ifndef MEDIAPIPE_FRAMEWORK_FORMATS_IMAGE_FRAME_POOL_H_
+#define MEDIAPIPE_FRAMEWORK_FORMATS_IMAGE_FRAME_POOL_H_
+
+#include <cstddef>
+#include <memory>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/graph_service.h"
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+
+struct ImageFrameSpec {
+  ImageFrameSpec(ImageFormat::Format f, int w, int h, uint32 a)
+      : format(f), width(w), height(h), alignment_boundary(a) {}
+  ImageFormat::Format format;
+  int width;
+  int height;
+  uint32 alignment_boundary;
+};
+
+inline bool operator==(const ImageFrameSpec& lhs, const ImageFrameSpec& rhs) {
+  return lhs.format == rhs.format && lhs.width == rhs.width &&
+         lhs.height == rhs.height &&
+         lhs.alignment_boundary == rhs.alignment_boundary;
+}
+inline bool operator!=(const ImageFrameSpec& lhs, const ImageFrameSpec& rhs) {
+  return !operator==(lhs, rhs);
+}
+
+struct ImageFrameSpecHash {
+  std::size_t operator()(const ImageFrameSpec& spec) const {
+    return std::hash<uint64>{}((static_cast<uint64>(spec.width) << 32) ^
+                               (static_cast<uint64>(spec.height) << 8) ^
+                               (static_cast<uint64>(spec.format) << 56) ^
+                               spec.alignment_boundary);
+  }
+};
+
+// Recycles the pixel buffers of ImageFrames of a single ImageFrameSpec.
+// The buffers are returned to the pool by the ImageFrame::Deleter of each
+// frame.
+class ImageFrameBufferPool
+    : public std::enable_shared_from_this<ImageFrameBufferPool> {
+ public:
+  // Creates a pool.  This pool will manage buffers for the specified frames,
+  // and will keep keep_count buffers around for reuse.
+  // We enforce creation as a shared_ptr so that we can use a weak reference in
+  // the frames' deleters.
+  static std::shared_ptr<ImageFrameBufferPool> Create(
+      const ImageFrameSpec& spec, int keep_count) {
+    return std::shared_ptr<ImageFrameBufferPool>(
+        new ImageFrameBufferPool(spec, keep_count));
+  }
+  ~ImageFrameBufferPool();
+
+  // Obtains a frame.  Its pixel buffer may either be reused or created anew,
+  // and its pixel values are undefined.
+  std::unique_ptr<ImageFrame> GetFrame();
+
+  const ImageFrameSpec& spec() const { return spec_; }
+
+  // This method is meant for testing.
+  std::pair<int, int> GetInUseAndAvailableCounts();
+
+ private:
+  ImageFrameBufferPool(const ImageFrameSpec& spec, int keep_count);
+
+  // Return a buffer to the pool.
+  void Return(uint8* buffer);
+
+  // If the total number of buffers is greater than keep_count, frees any
+  // surplus buffers that are no longer in use.
+  void TrimAvailable() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const ImageFrameSpec spec_;
+  const int width_step_;
+  const int keep_count_;
+
+  absl::Mutex mutex_;
+  int in_use_count_ GUARDED_BY(mutex_) = 0;
+  std::vector<uint8*> available_ GUARDED_BY(mutex_);
+};
+
+class ImageFramePool {
+ public:
+  // Keep this many buffers allocated for a given frame spec.
+  static constexpr int kDefaultKeepCount = 4;
+
+  explicit ImageFramePool(int keep_count = kDefaultKeepCount)
+      : keep_count_(keep_count) {}
+
+  // Obtains a frame.  Its pixel buffer may either be reused or created anew,
+  // and its pixel values are undefined.
+  std::unique_ptr<ImageFrame> GetFrame(
+      ImageFormat::Format format, int width, int height,
+      uint32 alignment_boundary = ImageFrame::kDefaultAlignmentBoundary);
+
+ private:
+  typedef std::shared_ptr<ImageFrameBufferPool> SimplePool;
+
+  const int keep_count_;
+
+  absl::Mutex mutex_;
+  std::unordered_map<ImageFrameSpec, SimplePool, ImageFrameSpecHash> pools_
+      GUARDED_BY(mutex_);
+  // A queue of ImageFrameSpecs to keep track of the age of each spec added to
+  // the pool.
+  std::queue<ImageFrameSpec> frame_specs_ GUARDED_BY(mutex_);
+};
+
+// The ImageFramePool shared by the calculators of a graph.  CalculatorGraph
+// creates it when a calculator requests it, unless the application sets one
+// with CalculatorGraph::SetServiceObject.
+extern const GraphService<ImageFramePool> kImageFramePoolService;
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_FORMATS_IMAGE_FRAME_POOL_H_
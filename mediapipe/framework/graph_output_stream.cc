@@ -14,6 +14,10 @@
 
 #include "mediapipe/framework/graph_output_stream.h"
 
+#include <algorithm>
+
+#include "absl/time/clock.h"
+
 namespace mediapipe {
 
 namespace internal {
@@ -116,10 +120,41 @@ void OutputStreamPollerImpl::SetMaxQueueSize(int queue_size) {
 
 int OutputStreamPollerImpl::QueueSize() { return input_stream_->QueueSize(); }
 
-::mediapipe::Status OutputStreamPollerImpl::Notify() {
+void OutputStreamPollerImpl::SetLowWatermark(int low_watermark) {
+  CHECK_GE(low_watermark, 1) << "Low watermark must be positive.";
+  input_stream_->SetNotifyQueueSize(low_watermark);
   mutex_.Lock();
+  low_watermark_ = low_watermark;
   handler_condvar_.Signal();
   mutex_.Unlock();
+}
+
+bool OutputStreamPollerImpl::ReadyToWake() {
+  if (graph_has_error_) {
+    return true;
+  }
+  const int queue_size = input_stream_->QueueSize();
+  if (queue_size == 0) {
+    return input_stream_->NextTimestampBound() == Timestamp::Done();
+  }
+  if (low_watermark_ <= 1) {
+    return true;
+  }
+  int low_watermark = low_watermark_;
+  const int max_queue_size = input_stream_->MaxQueueSize();
+  if (max_queue_size > 0) {
+    low_watermark = std::min(low_watermark, max_queue_size);
+  }
+  return queue_size >= low_watermark ||
+         input_stream_->NextTimestampBound() == Timestamp::Done();
+}
+
+::mediapipe::Status OutputStreamPollerImpl::Notify() {
+  mutex_.Lock();
+  if (low_watermark_ <= 1 || ReadyToWake()) {
+    handler_condvar_.Signal();
+  }
+  mutex_.Unlock();
   return ::mediapipe::OkStatus();
 }
 
@@ -162,5 +197,26 @@ bool OutputStreamPollerImpl::Next(Packet* packet) {
   return true;
 }
 
+bool OutputStreamPollerImpl::NextBatch(std::vector<Packet>* packets,
+                                       int max_count, absl::Duration timeout) {
+  CHECK(packets);
+  CHECK_GT(max_count, 0);
+  packets->clear();
+  const absl::Time deadline = absl::Now() + timeout;
+  mutex_.Lock();
+  while (!ReadyToWake()) {
+    if (handler_condvar_.WaitWithDeadline(&mutex_, deadline)) {
+      break;
+    }
+  }
+  const bool graph_has_error = graph_has_error_;
+  mutex_.Unlock();
+  bool stream_is_done = false;
+  if (input_stream_->PopQueueHeads(max_count, packets, &stream_is_done) > 0) {
+    return true;
+  }
+  return !graph_has_error && !stream_is_done;
+}
+
 }  // namespace internal
 }  // namespace mediapipe
@@ -24,6 +24,7 @@
 #include "absl/base/thread_annotations.h"
 #include "absl/strings/substitute.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "mediapipe/framework/input_stream_handler.h"
 #include "mediapipe/framework/input_stream_manager.h"
 #include "mediapipe/framework/output_stream_manager.h"
@@ -161,10 +162,30 @@ class OutputStreamPollerImpl : public GraphOutputStream {
   // done).  Returns true if successful.
   ABSL_MUST_USE_RESULT bool Next(Packet* packet);
 
+  // Replaces the contents of "packets" with up to "max_count" packets from
+  // the head of the queue, moving them out of the queue under a single lock.
+  // Blocks until the low watermark is reached, the stream is done, or
+  // "timeout" expires; on timeout returns whatever packets are queued, which
+  // may be none. Returns false if no packets are returned because the stream
+  // is done or the graph has an error.
+  ABSL_MUST_USE_RESULT bool NextBatch(
+      std::vector<Packet>* packets, int max_count,
+      absl::Duration timeout = absl::InfiniteDuration());
+
+  // Sets the number of queued packets needed to wake a blocked Next() or
+  // NextBatch() call. The poller is also woken when the stream is done or the
+  // graph has an error, and the watermark never exceeds the max queue size.
+  // The default of 1 wakes the poller on every packet.
+  void SetLowWatermark(int low_watermark);
+
  private:
+  // Returns true if a blocked Next() or NextBatch() call should return.
+  bool ReadyToWake() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   absl::Mutex mutex_;
   absl::CondVar handler_condvar_ GUARDED_BY(mutex_);
   bool graph_has_error_ GUARDED_BY(mutex_);
+  int low_watermark_ GUARDED_BY(mutex_) = 1;
 };
 
 }  // namespace internal
@@ -17,6 +17,8 @@
 
 #include <memory>
 
+#include "mediapipe/framework/packet.h"
+
 namespace mediapipe {
 
 // The GraphService API can be used to define extensions to a graph's execution
@@ -28,17 +30,38 @@ namespace mediapipe {
 // if you want to use it. In most cases, you should use a side packet instead.
 
 struct GraphServiceBase {
-  constexpr GraphServiceBase(const char* key) : key(key) {}
+  // Returns a packet holding a new service object for the given service.
+  using DefaultPacketFactory = Packet (*)(const GraphServiceBase& service);
+
+  constexpr GraphServiceBase(
+      const char* key, DefaultPacketFactory create_default_packet = nullptr)
+      : key(key), create_default_packet(create_default_packet) {}
 
   const char* key;
+  // If set, the graph uses a new object from this factory when a calculator
+  // requires the service and the application has not set its object.
+  DefaultPacketFactory create_default_packet;
 };
 
 template <typename T>
 struct GraphService : public GraphServiceBase {
   using type = T;
   using packet_type = std::shared_ptr<T>;
+  // Returns a new service object.
+  using DefaultFactory = std::shared_ptr<T> (*)();
 
   constexpr GraphService(const char* key) : GraphServiceBase(key) {}
+  constexpr GraphService(const char* key, DefaultFactory create_default)
+      : GraphServiceBase(key, &CreateDefaultPacket),
+        create_default(create_default) {}
+
+  DefaultFactory create_default = nullptr;
+
+ private:
+  static Packet CreateDefaultPacket(const GraphServiceBase& service) {
+    return MakePacket<packet_type>(
+        static_cast<const GraphService<T>&>(service).create_default());
+  }
 };
 
 }  // namespace mediapipe
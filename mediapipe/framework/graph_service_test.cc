@@ -150,5 +150,60 @@ TEST_F(GraphServiceTest, OptionalIsAvailable) {
   EXPECT_EQ(PacketValues<int>(output_packets_), (std::vector<int>{108}));
 }
 
+std::shared_ptr<int> CreateDefaultCounter() {
+  return std::make_shared<int>(0);
+}
+
+const GraphService<int> kDefaultedService("defaulted_service",
+                                          CreateDefaultCounter);
+
+// Counts its Process() calls in the object of kDefaultedService.
+class DefaultedServiceCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->UseService(kDefaultedService);
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) final {
+    ++cc->Service(kDefaultedService).GetObject();
+    return ::mediapipe::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(DefaultedServiceCalculator);
+
+// A required service with a default is created by the graph, unless the
+// application sets it.
+TEST(GraphServiceDefaultTest, CreatesDefaultObject) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "in"
+        node { calculator: "DefaultedServiceCalculator" input_stream: "in" }
+      )");
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  EXPECT_EQ(graph.GetServiceObject(kDefaultedService), nullptr);
+  for (int run = 0; run < 2; ++run) {
+    MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+    MEDIAPIPE_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(3).At(Timestamp(0))));
+    MEDIAPIPE_ASSERT_OK(graph.CloseAllInputStreams());
+    MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+  }
+  // The default object is kept across runs.
+  ASSERT_NE(graph.GetServiceObject(kDefaultedService), nullptr);
+  EXPECT_EQ(2, *graph.GetServiceObject(kDefaultedService));
+
+  auto counter = std::make_shared<int>(10);
+  MEDIAPIPE_ASSERT_OK(graph.SetServiceObject(kDefaultedService, counter));
+  MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+  MEDIAPIPE_ASSERT_OK(
+      graph.AddPacketToInputStream("in", MakePacket<int>(3).At(Timestamp(0))));
+  MEDIAPIPE_ASSERT_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_EQ(11, *counter);
+}
+
 }  // namespace
 }  // namespace mediapipe
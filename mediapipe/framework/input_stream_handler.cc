@@ -14,6 +14,9 @@
 
 #include "mediapipe/framework/input_stream_handler.h"
 
+#include <algorithm>
+#include <limits>
+
 #include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
 #include "mediapipe/framework/collection_item_id.h"
@@ -126,6 +129,17 @@ void InputStreamHandler::SetMaxQueueSize(int max_queue_size) {
   }
 }
 
+int InputStreamHandler::MinQueueSize() const {
+  if (NumInputStreams() == 0) {
+    return 0;
+  }
+  int min_queue_size = std::numeric_limits<int>::max();
+  for (const auto& stream : input_stream_managers_) {
+    min_queue_size = std::min(min_queue_size, stream->QueueSize());
+  }
+  return min_queue_size;
+}
+
 std::string InputStreamHandler::DebugStreamNames() const {
   std::vector<absl::string_view> stream_names;
   for (const auto& stream : input_stream_managers_) {
@@ -229,7 +243,7 @@ void InputStreamHandler::FinalizeInputSet(Timestamp timestamp,
 }
 
 void InputStreamHandler::AddPackets(CollectionItemId id,
-                                    const std::list<Packet>& packets) {
+                                    const RingBuffer<Packet>& packets) {
   bool notify = false;
   ::mediapipe::Status result =
       input_stream_managers_.Get(id)->AddPackets(packets, &notify);
@@ -242,7 +256,7 @@ void InputStreamHandler::AddPackets(CollectionItemId id,
 }
 
 void InputStreamHandler::MovePackets(CollectionItemId id,
-                                     std::list<Packet>* packets) {
+                                     RingBuffer<Packet>* packets) {
   bool notify = false;
   ::mediapipe::Status result =
       input_stream_managers_.Get(id)->MovePackets(packets, &notify);
@@ -254,6 +268,25 @@ void InputStreamHandler::MovePackets(CollectionItemId id,
   }
 }
 
+void InputStreamHandler::AddPackets(CollectionItemId id,
+                                    const std::list<Packet>& packets) {
+  RingBuffer<Packet> buffer(packets.size());
+  for (const Packet& packet : packets) {
+    buffer.push_back(packet);
+  }
+  AddPackets(id, buffer);
+}
+
+void InputStreamHandler::MovePackets(CollectionItemId id,
+                                     std::list<Packet>* packets) {
+  RingBuffer<Packet> buffer(packets->size());
+  for (Packet& packet : *packets) {
+    buffer.push_back(std::move(packet));
+  }
+  packets->clear();
+  MovePackets(id, &buffer);
+}
+
 void InputStreamHandler::SetNextTimestampBound(CollectionItemId id,
                                                Timestamp bound) {
   bool notify = false;
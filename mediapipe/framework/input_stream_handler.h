@@ -36,6 +36,7 @@
 #include "mediapipe/framework/packet_set.h"
 #include "mediapipe/framework/packet_type.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/ring_buffer.h"
 #include "mediapipe/framework/tool/tag_map.h"
 
 namespace mediapipe {
@@ -112,6 +113,11 @@ class InputStreamHandler {
 
   int NumInputStreams() const { return input_stream_managers_.NumEntries(); }
 
+  // Returns the smallest number of packets queued on any input stream, an
+  // estimate of the number of invocations that are ready to run. Returns 0 if
+  // there are no input streams.
+  int MinQueueSize() const;
+
   // Returns the tag map of the input streams.
   const std::shared_ptr<tool::TagMap>& InputTagMap() const {
     return input_stream_managers_.TagMap();
@@ -134,11 +140,23 @@ class InputStreamHandler {
       InputStreamManager::QueueSizeCallback becomes_not_full_callback);
 
   // Add packets into a particular stream.
+  // Subclasses that need to see added packets override this RingBuffer
+  // version, which the std::list version below also calls. Such subclasses
+  // should also declare "using InputStreamHandler::AddPackets;", so that the
+  // override does not hide the std::list version.
   virtual void AddPackets(CollectionItemId id,
-                          const std::list<Packet>& packets);
+                          const RingBuffer<Packet>& packets);
 
   // Moves packets into a particular stream.
-  virtual void MovePackets(CollectionItemId id, std::list<Packet>* packets);
+  // Overridden like AddPackets() above.
+  virtual void MovePackets(CollectionItemId id, RingBuffer<Packet>* packets);
+
+  // Same as AddPackets() and MovePackets() above, for callers that still hold
+  // their packets in a std::list. The packets are copied (or moved) into a
+  // RingBuffer first, so these cost one extra pass over the packets. These
+  // are not virtual.
+  void AddPackets(CollectionItemId id, const std::list<Packet>& packets);
+  void MovePackets(CollectionItemId id, std::list<Packet>* packets);
 
   // Sets next timestamp bound in a particular stream.
   void SetNextTimestampBound(CollectionItemId id, Timestamp bound);
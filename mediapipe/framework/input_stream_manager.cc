@@ -14,11 +14,14 @@
 
 #include "mediapipe/framework/input_stream_manager.h"
 
+#include <algorithm>
+#include <iterator>
 #include <type_traits>
 #include <utility>
 
 #include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
 #include "mediapipe/framework/packet.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/source_location.h"
@@ -27,6 +30,16 @@
 
 namespace mediapipe {
 
+namespace {
+
+// The largest number of packet slots that SetMaxQueueSize() preallocates.
+// Queues that grow beyond this size allocate on demand.
+constexpr int kMaxPreallocatedQueueSize = 128;
+
+}  // namespace
+
+constexpr int InputStreamManager::kNumQueueSizeBuckets;
+
 ::mediapipe::Status InputStreamManager::Initialize(
     const std::string& name, const PacketType* packet_type, bool back_edge) {
   name_ = name;
@@ -38,6 +51,11 @@ namespace mediapipe {
 
 const std::string& InputStreamManager::Name() const { return name_; }
 
+void InputStreamManager::SetNotifyQueueSize(int queue_size) {
+  absl::MutexLock lock(&stream_mutex_);
+  notify_queue_size_ = queue_size;
+}
+
 void InputStreamManager::SetQueueSizeCallbacks(
     QueueSizeCallback becomes_full_callback,
     QueueSizeCallback becomes_not_full_callback) {
@@ -54,6 +72,11 @@ void InputStreamManager::PrepareForRun() {
   last_select_timestamp_ = Timestamp::Unstarted();
   closed_ = false;
   header_ = Packet();
+  std::fill(std::begin(queue_size_counts_), std::end(queue_size_counts_), 0);
+  max_queue_size_seen_ = 0;
+  throttled_count_ = 0;
+  throttled_time_ns_ = 0;
+  throttled_since_ns_ = -1;
 }
 
 bool InputStreamManager::IsEmpty() const {
@@ -61,6 +84,11 @@ bool InputStreamManager::IsEmpty() const {
   return queue_.empty();
 }
 
+Timestamp InputStreamManager::NextTimestampBound() const {
+  absl::MutexLock stream_lock(&stream_mutex_);
+  return next_timestamp_bound_;
+}
+
 Packet InputStreamManager::QueueHead() const {
   absl::MutexLock stream_lock(&stream_mutex_);
   if (queue_.empty()) {
@@ -80,13 +108,13 @@ Packet InputStreamManager::QueueHead() const {
 }
 
 ::mediapipe::Status InputStreamManager::AddPackets(
-    const std::list<Packet>& container, bool* notify) {
-  return AddOrMovePacketsInternal<const std::list<Packet>&>(container, notify);
+    const RingBuffer<Packet>& container, bool* notify) {
+  return AddOrMovePacketsInternal<const RingBuffer<Packet>&>(container, notify);
 }
 
 ::mediapipe::Status InputStreamManager::MovePackets(
-    std::list<Packet>* container, bool* notify) {
-  return AddOrMovePacketsInternal<std::list<Packet>&>(*container, notify);
+    RingBuffer<Packet>* container, bool* notify) {
+  return AddOrMovePacketsInternal<RingBuffer<Packet>&>(*container, notify);
 }
 
 template <typename Container>
@@ -94,6 +122,7 @@ template <typename Container>
     Container container, bool* notify) {
   *notify = false;
   bool queue_became_non_empty = false;
+  bool queue_reached_notify_size = false;
   bool queue_became_full = false;
   {
     // Scope to prevent locking the stream when notification is called.
@@ -106,14 +135,17 @@ template <typename Container>
         (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
     // Check if the queue becomes non-empty.
     queue_became_non_empty = queue_.empty() && !container.empty();
+    const size_t old_queue_size = queue_.size();
     for (auto& packet : container) {
-      ::mediapipe::Status result = packet_type_->Validate(packet);
-      if (!result.ok()) {
-        return tool::AddStatusPrefix(
-            absl::StrCat(
-                "Packet type mismatch on a calculator receiving from stream \"",
-                name_, "\": "),
-            result);
+      if (validate_packet_types_) {
+        ::mediapipe::Status result = packet_type_->Validate(packet);
+        if (!result.ok()) {
+          return tool::AddStatusPrefix(
+              absl::StrCat("Packet type mismatch on a calculator receiving "
+                           "from stream \"",
+                           name_, "\": "),
+              result);
+        }
       }
 
       const Timestamp timestamp = packet.Timestamp();
@@ -163,6 +195,16 @@ template <typename Container>
     }
     queue_became_full = (!was_queue_full && max_queue_size_ != -1 &&
                          queue_.size() >= max_queue_size_);
+    RecordQueueSize();
+    if (notify_queue_size_ > 1) {
+      size_t notify_queue_size = notify_queue_size_;
+      if (max_queue_size_ > 0) {
+        notify_queue_size =
+            std::min<size_t>(notify_queue_size, max_queue_size_);
+      }
+      queue_reached_notify_size = (old_queue_size < notify_queue_size &&
+                                   queue_.size() >= notify_queue_size);
+    }
     VLOG_IF(2, queue_.size() > 1)
         << "Queue size greater than 1: stream name: " << name_
         << " queue_size: " << queue_.size();
@@ -174,7 +216,7 @@ template <typename Container>
     VLOG(2) << "Queue became full: " << Name();
     becomes_full_callback_(this, &last_reported_stream_full_);
   }
-  *notify = queue_became_non_empty;
+  *notify = queue_became_non_empty || queue_reached_notify_size;
   return ::mediapipe::OkStatus();
 }
 
@@ -206,6 +248,10 @@ template <typename Container>
         // If the queue was not empty then a change to the next_timestamp_bound_
         // is not detectable by the consumer.
         *notify = true;
+      } else if (notify_queue_size_ > 1 && bound == Timestamp::Done()) {
+        // A consumer waiting for a batch must learn that no more packets
+        // will arrive.
+        *notify = true;
       }
     }
   }
@@ -320,6 +366,46 @@ Packet InputStreamManager::PopQueueHead(bool* stream_is_done) {
   return packet;
 }
 
+int InputStreamManager::PopQueueHeads(int max_count,
+                                      std::vector<Packet>* packets,
+                                      bool* stream_is_done) {
+  CHECK(packets);
+  *stream_is_done = false;
+  bool queue_became_non_full = false;
+  int num_popped = 0;
+  {
+    absl::MutexLock stream_lock(&stream_mutex_);
+
+    // Check if queue is full.
+    bool was_queue_full =
+        (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
+
+    while (num_popped < max_count && !queue_.empty()) {
+      packets->push_back(std::move(queue_.front()));
+      queue_.pop_front();
+      ++num_popped;
+    }
+    if (enable_timestamps_ && num_popped > 0) {
+      const Timestamp timestamp = packets->back().Timestamp();
+      CHECK_LE(last_select_timestamp_, timestamp);
+      last_select_timestamp_ = timestamp;
+      if (next_timestamp_bound_ <= timestamp) {
+        next_timestamp_bound_ = timestamp.NextAllowedInStream();
+      }
+    }
+
+    VLOG(2) << "Input stream removed " << num_popped << " packets:" << name_
+            << " Size:" << queue_.size();
+    queue_became_non_full = (was_queue_full && queue_.size() < max_queue_size_);
+    *stream_is_done = IsDone();
+  }
+  if (queue_became_non_full) {
+    VLOG(2) << "Queue became non-full: " << Name();
+    becomes_not_full_callback_(this, &last_reported_stream_full_);
+  }
+  return num_popped;
+}
+
 int InputStreamManager::QueueSize() const {
   absl::MutexLock lock(&stream_mutex_);
   return static_cast<int>(queue_.size());
@@ -338,6 +424,11 @@ void InputStreamManager::SetMaxQueueSize(int max_queue_size) {
     was_full = (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
     max_queue_size_ = max_queue_size;
     is_full = (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
+    if (max_queue_size_ != -1) {
+      // Room for one packet beyond the limit, since a full queue still
+      // accepts packets from non-throttled producers.
+      queue_.reserve(std::min(max_queue_size_ + 1, kMaxPreallocatedQueueSize));
+    }
   }
 
   // QueueSizeCallback is called with no mutexes held.
@@ -350,6 +441,46 @@ void InputStreamManager::SetMaxQueueSize(int max_queue_size) {
   }
 }
 
+InputStreamManager::QueueStats InputStreamManager::GetQueueStats() const {
+  absl::MutexLock lock(&stream_mutex_);
+  QueueStats stats;
+  stats.queue_size_counts.assign(std::begin(queue_size_counts_),
+                                 std::end(queue_size_counts_));
+  stats.max_queue_size_seen = max_queue_size_seen_;
+  stats.throttled_count = throttled_count_;
+  stats.throttled_time_ns = throttled_time_ns_;
+  if (throttled_since_ns_ >= 0) {
+    stats.throttled_time_ns +=
+        absl::GetCurrentTimeNanos() - throttled_since_ns_;
+  }
+  return stats;
+}
+
+void InputStreamManager::RecordQueueSize() {
+  const size_t queue_size = queue_.size();
+  if (queue_size == 0) {
+    return;
+  }
+  int bucket = 0;
+  while (bucket < kNumQueueSizeBuckets - 1 && (queue_size >> (bucket + 1))) {
+    ++bucket;
+  }
+  ++queue_size_counts_[bucket];
+  max_queue_size_seen_ =
+      std::max(max_queue_size_seen_, static_cast<int>(queue_size));
+}
+
+void InputStreamManager::SetThrottling(bool throttling) {
+  absl::MutexLock lock(&stream_mutex_);
+  if (throttling && throttled_since_ns_ < 0) {
+    ++throttled_count_;
+    throttled_since_ns_ = absl::GetCurrentTimeNanos();
+  } else if (!throttling && throttled_since_ns_ >= 0) {
+    throttled_time_ns_ += absl::GetCurrentTimeNanos() - throttled_since_ns_;
+    throttled_since_ns_ = -1;
+  }
+}
+
 bool InputStreamManager::IsFull() const {
   absl::MutexLock lock(&stream_mutex_);
   return max_queue_size_ != -1 && queue_.size() >= max_queue_size_;
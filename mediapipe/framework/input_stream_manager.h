@@ -15,10 +15,9 @@
 #ifndef MEDIAPIPE_FRAMEWORK_INPUT_STREAM_MANAGER_H_
 #define MEDIAPIPE_FRAMEWORK_INPUT_STREAM_MANAGER_H_
 
-#include <deque>
 #include <functional>
-#include <list>
 #include <string>
+#include <vector>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/synchronization/mutex.h"
@@ -27,6 +26,7 @@
 #include "mediapipe/framework/port.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/ring_buffer.h"
 #include "mediapipe/framework/timestamp.h"
 
 namespace mediapipe {
@@ -87,13 +87,13 @@ class InputStreamManager {
   //   Timestamp::PostStream(), the packet must be the only packet in the
   //   stream.
   // Violation of any of these conditions causes an error status.
-  ::mediapipe::Status AddPackets(const std::list<Packet>& container,
+  ::mediapipe::Status AddPackets(const RingBuffer<Packet>& container,
                                  bool* notify);
 
   // Move a list of timestamped packets. Sets "notify" to true if the queue
   // becomes non-empty. Does nothing if the input stream is closed. After the
   // move, all packets in the container must be empty.
-  ::mediapipe::Status MovePackets(std::list<Packet>* container, bool* notify);
+  ::mediapipe::Status MovePackets(RingBuffer<Packet>* container, bool* notify);
 
   // Closes the input stream.  This function can be called multiple times.
   void Close() LOCKS_EXCLUDED(stream_mutex_);
@@ -119,6 +119,9 @@ class InputStreamManager {
   // Returns true iff the queue is empty.
   bool IsEmpty() const LOCKS_EXCLUDED(stream_mutex_);
 
+  // Returns the bound on the next timestamp to be added to the input stream.
+  Timestamp NextTimestampBound() const LOCKS_EXCLUDED(stream_mutex_);
+
   // If the queue is not empty, returns the packet at the front of the queue.
   // Otherwise, returns an empty packet.
   Packet QueueHead() const LOCKS_EXCLUDED(stream_mutex_);
@@ -141,9 +144,46 @@ class InputStreamManager {
   // Timestamp::Done() after the pop.
   Packet PopQueueHead(bool* stream_is_done) LOCKS_EXCLUDED(stream_mutex_);
 
+  // Moves up to "max_count" packets from the head of the queue to the end of
+  // "packets" and returns the number of packets moved. If timestamps are
+  // enabled, time advances to the timestamp of the last packet moved, as if
+  // PopPacketAtTimestamp() had been called for each of them. Sets
+  // "stream_is_done" if the next timestamp bound reaches Timestamp::Done()
+  // after the pop.
+  int PopQueueHeads(int max_count, std::vector<Packet>* packets,
+                    bool* stream_is_done) LOCKS_EXCLUDED(stream_mutex_);
+
   // Returns the number of packets in the queue.
   int QueueSize() const LOCKS_EXCLUDED(stream_mutex_);
 
+  // The number of buckets of QueueStats::queue_size_counts.
+  static constexpr int kNumQueueSizeBuckets = 16;
+
+  // Back-pressure statistics of the stream since the last PrepareForRun().
+  struct QueueStats {
+    // queue_size_counts[i] is the number of AddPackets() and MovePackets()
+    // calls that left between 2^i and 2^(i+1) - 1 packets in the queue. The
+    // last bucket also counts all larger queue sizes.
+    std::vector<int64> queue_size_counts;
+    // The largest number of packets that were in the queue.
+    int max_queue_size_seen = 0;
+    // The number of times the full queue started throttling its producers.
+    // A queue that grows within the graph's queue_size_budget instead is not
+    // counted.
+    int64 throttled_count = 0;
+    // The total time the queue throttled its producers, including the current
+    // throttled period.
+    int64 throttled_time_ns = 0;
+  };
+
+  // Returns the back-pressure statistics of the stream.
+  QueueStats GetQueueStats() const LOCKS_EXCLUDED(stream_mutex_);
+
+  // Records whether the full queue is throttling its producers, for
+  // QueueStats.  Called by the graph when it starts or stops throttling the
+  // producers of this stream.
+  void SetThrottling(bool throttling) LOCKS_EXCLUDED(stream_mutex_);
+
   // Returns true iff the queue is full.
   bool IsFull() const LOCKS_EXCLUDED(stream_mutex_);
 
@@ -152,9 +192,23 @@ class InputStreamManager {
 
   // Sets the maximum queue size for the stream. Used to determine when the
   // callbacks for becomes_full and becomes_not_full should be invoked. A value
-  // of -1 means that there is no maximum queue size.
+  // of -1 means that there is no maximum queue size. Otherwise preallocates
+  // the queue for up to max_queue_size packets.
   void SetMaxQueueSize(int max_queue_size) LOCKS_EXCLUDED(stream_mutex_);
 
+  // Makes AddPackets() and MovePackets() accept packets without validating
+  // them against the stream type.  Only for streams whose packets are already
+  // validated against a type that implies the stream type.
+  void DisablePacketTypeValidation() { validate_packet_types_ = false; }
+
+  // Makes AddPackets() and MovePackets() also set "notify" when the queue
+  // grows to "queue_size" packets (capped at the max queue size), and makes
+  // SetNextTimestampBound() set it when the stream is done with packets still
+  // queued. This lets a consumer that waits for batches of packets be woken
+  // once per batch. A value of 1 restores the default of notifying only when
+  // the queue becomes non-empty.
+  void SetNotifyQueueSize(int queue_size) LOCKS_EXCLUDED(stream_mutex_);
+
   // If there are equal to or more than n packets in the queue, this function
   // returns the min timestamp of among the latest n packets of the queue.  If
   // there are fewer than n packets in the queue, this function returns
@@ -189,8 +243,13 @@ class InputStreamManager {
   // Returns true if the next timestamp bound reaches Timestamp::Done().
   bool IsDone() const EXCLUSIVE_LOCKS_REQUIRED(stream_mutex_);
 
+  // Updates the queue statistics after packets were added.
+  void RecordQueueSize() EXCLUSIVE_LOCKS_REQUIRED(stream_mutex_);
+
   mutable absl::Mutex stream_mutex_;
-  std::deque<Packet> queue_ GUARDED_BY(stream_mutex_);
+  // The queued packets. Keeps its capacity across runs, so that a stream in
+  // steady state adds and removes packets without allocating.
+  RingBuffer<Packet> queue_ GUARDED_BY(stream_mutex_);
   // The number of packets added to queue_.  Used to verify a packet at
   // Timestamp::PostStream() is the only Packet in the stream.
   int64 num_packets_added_ GUARDED_BY(stream_mutex_);
@@ -203,6 +262,8 @@ class InputStreamManager {
   bool enable_timestamps_ = true;
   std::string name_;
   const PacketType* packet_type_;
+  // True if arriving packets are validated against packet_type_.
+  bool validate_packet_types_ = true;
   bool back_edge_;
   // The header packet of the input stream.
   Packet header_;
@@ -210,6 +271,17 @@ class InputStreamManager {
   // The maximum queue size for this stream if set.
   int max_queue_size_ GUARDED_BY(stream_mutex_) = -1;
 
+  // The queue size that triggers a notification. See SetNotifyQueueSize().
+  int notify_queue_size_ GUARDED_BY(stream_mutex_) = 1;
+
+  // Queue statistics. See QueueStats.
+  int64 queue_size_counts_[kNumQueueSizeBuckets] GUARDED_BY(stream_mutex_) = {};
+  int max_queue_size_seen_ GUARDED_BY(stream_mutex_) = 0;
+  int64 throttled_count_ GUARDED_BY(stream_mutex_) = 0;
+  int64 throttled_time_ns_ GUARDED_BY(stream_mutex_) = 0;
+  // The time the queue started throttling, or -1 if it is not throttling.
+  int64 throttled_since_ns_ GUARDED_BY(stream_mutex_) = -1;
+
   // Callback to notify the framework that we have hit the maximum queue size.
   QueueSizeCallback becomes_full_callback_;
 
@@ -15,6 +15,8 @@
 #include "mediapipe/framework/input_stream_manager.h"
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "absl/memory/memory.h"
 #include "mediapipe/framework/input_stream_shard.h"
@@ -93,7 +95,7 @@ class InputStreamManagerTest : public ::testing::Test {
 TEST_F(InputStreamManagerTest, Init) {}
 
 TEST_F(InputStreamManagerTest, AddPackets) {
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
   packets.push_back(MakePacket<std::string>("packet 3").At(Timestamp(30)));
@@ -110,7 +112,7 @@ TEST_F(InputStreamManagerTest, AddPackets) {
 }
 
 TEST_F(InputStreamManagerTest, MovePackets) {
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
   packets.push_back(MakePacket<std::string>("packet 3").At(Timestamp(30)));
@@ -130,7 +132,7 @@ TEST_F(InputStreamManagerTest, MovePackets) {
 // a stream: Timestamp::Unset(), Timestamp::Unstarted(),
 // Timestamp::OneOverPostStream(), and Timestamp::Done().
 TEST_F(InputStreamManagerTest, AddPacketUnset) {
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp::Unset()));
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
 
@@ -141,7 +143,7 @@ TEST_F(InputStreamManagerTest, AddPacketUnset) {
 }
 
 TEST_F(InputStreamManagerTest, AddPacketUnstarted) {
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   packets.push_back(
       MakePacket<std::string>("packet 1").At(Timestamp::Unstarted()));
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
@@ -153,7 +155,7 @@ TEST_F(InputStreamManagerTest, AddPacketUnstarted) {
 }
 
 TEST_F(InputStreamManagerTest, AddPacketOneOverPostStream) {
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   packets.push_back(
       MakePacket<std::string>("packet 1").At(Timestamp::OneOverPostStream()));
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
@@ -166,7 +168,7 @@ TEST_F(InputStreamManagerTest, AddPacketOneOverPostStream) {
 }
 
 TEST_F(InputStreamManagerTest, AddPacketDone) {
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp::Done()));
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
 
@@ -177,7 +179,7 @@ TEST_F(InputStreamManagerTest, AddPacketDone) {
 }
 
 TEST_F(InputStreamManagerTest, AddPacketsOnlyPreStream) {
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   packets.push_back(
       MakePacket<std::string>("packet 1").At(Timestamp::PreStream()));
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
@@ -191,7 +193,7 @@ TEST_F(InputStreamManagerTest, AddPacketsOnlyPreStream) {
 // An attempt to add a packet after Timestamp::PreStream() should be rejected
 // because the next timestamp bound is Timestamp::OneOverPostStream().
 TEST_F(InputStreamManagerTest, AddPacketsAfterPreStream) {
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   packets.push_back(
       MakePacket<std::string>("packet 1").At(Timestamp::PreStream()));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(10)));
@@ -205,7 +207,7 @@ TEST_F(InputStreamManagerTest, AddPacketsAfterPreStream) {
 }
 
 TEST_F(InputStreamManagerTest, AddPacketsOnlyPostStream) {
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   packets.push_back(
       MakePacket<std::string>("packet 1").At(Timestamp::PostStream()));
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
@@ -219,7 +221,7 @@ TEST_F(InputStreamManagerTest, AddPacketsOnlyPostStream) {
 // A packet at Timestamp::PostStream() must be the only Packet in an input
 // stream.
 TEST_F(InputStreamManagerTest, AddPacketsBeforePostStream) {
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(
       MakePacket<std::string>("packet 2").At(Timestamp::PostStream()));
@@ -232,7 +234,7 @@ TEST_F(InputStreamManagerTest, AddPacketsBeforePostStream) {
 }
 
 TEST_F(InputStreamManagerTest, AddPacketsReverseTimestamps) {
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(20)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 3").At(Timestamp(30)));
@@ -250,7 +252,7 @@ TEST_F(InputStreamManagerTest, PopPacketAtTimestamp) {
   std::string expected_value_at_10("packet 1");
   std::string expected_value_at_20("packet 2");
   std::string expected_value_at_30("packet 3");
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   packets.push_back(
       MakePacket<std::string>(expected_value_at_10).At(Timestamp(10)));
   packets.push_back(
@@ -335,7 +337,7 @@ TEST_F(InputStreamManagerTest, PopQueueHead) {
   std::string expected_value_at_10("packet 1");
   std::string expected_value_at_20("packet 2");
   std::string expected_value_at_30("packet 3");
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   packets.push_back(
       MakePacket<std::string>(expected_value_at_10).At(Timestamp(10)));
   packets.push_back(
@@ -395,7 +397,7 @@ TEST_F(InputStreamManagerTest, PopQueueHead) {
 }
 
 TEST_F(InputStreamManagerTest, BadPacketType) {
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   packets.push_back(MakePacket<int>(10).At(Timestamp(10)));
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
 
@@ -405,8 +407,18 @@ TEST_F(InputStreamManagerTest, BadPacketType) {
   EXPECT_FALSE(notify_);
 }
 
+TEST_F(InputStreamManagerTest, DisablePacketTypeValidation) {
+  RingBuffer<Packet> packets;
+  packets.push_back(MakePacket<int>(10).At(Timestamp(10)));
+  input_stream_manager_->DisablePacketTypeValidation();
+
+  MEDIAPIPE_ASSERT_OK(input_stream_manager_->AddPackets(packets, &notify_));
+  EXPECT_TRUE(notify_);
+  EXPECT_EQ(1, input_stream_manager_->QueueSize());
+}
+
 TEST_F(InputStreamManagerTest, Close) {
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
   packets.push_back(MakePacket<std::string>("packet 3").At(Timestamp(30)));
@@ -429,7 +441,7 @@ TEST_F(InputStreamManagerTest, Close) {
 }
 
 TEST_F(InputStreamManagerTest, ReuseInputStreamManager) {
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
   packets.push_back(MakePacket<std::string>("packet 3").At(Timestamp(30)));
@@ -482,7 +494,7 @@ TEST_F(InputStreamManagerTest, ReuseInputStreamManager) {
 }
 
 TEST_F(InputStreamManagerTest, MultipleNotifications) {
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
@@ -527,7 +539,7 @@ TEST_F(InputStreamManagerTest, SetHeader) {
 }
 
 TEST_F(InputStreamManagerTest, BackwardsInTime) {
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
@@ -594,7 +606,7 @@ TEST_F(InputStreamManagerTest, BackwardsInTime) {
 }
 
 TEST_F(InputStreamManagerTest, SelectBackwardsInTime) {
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
@@ -638,7 +650,7 @@ TEST_F(InputStreamManagerTest, SelectBackwardsInTime) {
 }
 
 TEST_F(InputStreamManagerTest, TimestampBound) {
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
@@ -747,8 +759,55 @@ TEST_F(InputStreamManagerTest, TimestampBound) {
             input_stream_manager_->MinTimestampOrBound(&is_empty));
 }
 
+TEST_F(InputStreamManagerTest, PopQueueHeads) {
+  RingBuffer<Packet> packets;
+  for (int i = 1; i <= 5; ++i) {
+    packets.push_back(
+        MakePacket<std::string>(std::to_string(i)).At(Timestamp(i * 10)));
+  }
+  MEDIAPIPE_ASSERT_OK(input_stream_manager_->AddPackets(packets, &notify_));
+
+  std::vector<Packet> popped_packets;
+  EXPECT_EQ(3, input_stream_manager_->PopQueueHeads(3, &popped_packets,
+                                                    &stream_is_done_));
+  ASSERT_EQ(3, popped_packets.size());
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(std::to_string(i + 1), popped_packets[i].Get<std::string>());
+  }
+  EXPECT_FALSE(stream_is_done_);
+  EXPECT_EQ(2, input_stream_manager_->QueueSize());
+  EXPECT_EQ(Timestamp(40), input_stream_manager_->MinTimestampOrBound(nullptr));
+
+  MEDIAPIPE_ASSERT_OK(input_stream_manager_->SetNextTimestampBound(
+      Timestamp::Done(), &notify_));
+  EXPECT_EQ(2, input_stream_manager_->PopQueueHeads(10, &popped_packets,
+                                                    &stream_is_done_));
+  ASSERT_EQ(5, popped_packets.size());
+  EXPECT_EQ("5", popped_packets.back().Get<std::string>());
+  EXPECT_TRUE(stream_is_done_);
+  EXPECT_EQ(0, input_stream_manager_->PopQueueHeads(10, &popped_packets,
+                                                    &stream_is_done_));
+}
+
+TEST_F(InputStreamManagerTest, NotifyQueueSize) {
+  input_stream_manager_->SetNotifyQueueSize(3);
+  for (int i = 0; i < 4; ++i) {
+    notify_ = false;
+    RingBuffer<Packet> packets;
+    packets.push_back(MakePacket<std::string>("packet").At(Timestamp(i)));
+    MEDIAPIPE_ASSERT_OK(input_stream_manager_->AddPackets(packets, &notify_));
+    // Notifies when the queue becomes non-empty and when it reaches three
+    // packets.
+    EXPECT_EQ(i == 0 || i == 2, notify_) << i;
+  }
+  notify_ = false;
+  MEDIAPIPE_ASSERT_OK(input_stream_manager_->SetNextTimestampBound(
+      Timestamp::Done(), &notify_));
+  EXPECT_TRUE(notify_);
+}
+
 TEST_F(InputStreamManagerTest, QueueSizeTest) {
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   int max_queue_size = 2;
   input_stream_manager_->SetMaxQueueSize(max_queue_size);
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
@@ -782,6 +841,56 @@ TEST_F(InputStreamManagerTest, QueueSizeTest) {
   expected_queue_becomes_not_full_count_ = 1;
 }
 
+TEST_F(InputStreamManagerTest, QueueStats) {
+  RingBuffer<Packet> packets;
+  input_stream_manager_->SetMaxQueueSize(2);
+  packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
+  MEDIAPIPE_ASSERT_OK(input_stream_manager_->AddPackets(packets, &notify_));
+  packets.clear();
+  packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
+  packets.push_back(MakePacket<std::string>("packet 3").At(Timestamp(30)));
+  MEDIAPIPE_ASSERT_OK(
+      input_stream_manager_->AddPackets(packets, &notify_));  // Becomes full.
+
+  InputStreamManager::QueueStats stats =
+      input_stream_manager_->GetQueueStats();
+  ASSERT_EQ(InputStreamManager::kNumQueueSizeBuckets,
+            stats.queue_size_counts.size());
+  EXPECT_EQ(1, stats.queue_size_counts[0]);  // Queue size 1.
+  EXPECT_EQ(1, stats.queue_size_counts[1]);  // Queue size 3.
+  EXPECT_EQ(0, stats.queue_size_counts[2]);
+  EXPECT_EQ(3, stats.max_queue_size_seen);
+  // A full queue is not counted until the graph throttles its producers.
+  EXPECT_EQ(0, stats.throttled_count);
+  EXPECT_EQ(0, stats.throttled_time_ns);
+
+  input_stream_manager_->SetThrottling(true);
+  input_stream_manager_->SetThrottling(true);
+  stats = input_stream_manager_->GetQueueStats();
+  EXPECT_EQ(1, stats.throttled_count);
+  EXPECT_LE(0, stats.throttled_time_ns);
+
+  popped_packet_ = input_stream_manager_->PopPacketAtTimestamp(
+      Timestamp(30), &num_packets_dropped_, &stream_is_done_);  // Not full.
+  input_stream_manager_->SetThrottling(false);
+  InputStreamManager::QueueStats later_stats =
+      input_stream_manager_->GetQueueStats();
+  EXPECT_EQ(1, later_stats.throttled_count);
+  EXPECT_LE(stats.throttled_time_ns, later_stats.throttled_time_ns);
+  EXPECT_EQ(later_stats.throttled_time_ns,
+            input_stream_manager_->GetQueueStats().throttled_time_ns);
+
+  input_stream_manager_->PrepareForRun();
+  stats = input_stream_manager_->GetQueueStats();
+  EXPECT_EQ(0, stats.queue_size_counts[0]);
+  EXPECT_EQ(0, stats.max_queue_size_seen);
+  EXPECT_EQ(0, stats.throttled_count);
+  EXPECT_EQ(0, stats.throttled_time_ns);
+
+  expected_queue_becomes_full_count_ = 1;
+  expected_queue_becomes_not_full_count_ = 1;
+}
+
 TEST_F(InputStreamManagerTest, InputReleaseTest) {
   packet_type_.Set<LifetimeTracker::Object>();
   input_stream_manager_ = absl::make_unique<InputStreamManager>();
@@ -837,7 +946,7 @@ TEST_F(InputStreamManagerTest, InputReleaseTest) {
 // if packet timestamps don't need to be increasing.
 TEST_F(InputStreamManagerTest, AddPacketsAfterPreStreamUntimed) {
   input_stream_manager_->DisableTimestamps();
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   packets.push_back(
       MakePacket<std::string>("packet 1").At(Timestamp::PreStream()));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(10)));
@@ -853,7 +962,7 @@ TEST_F(InputStreamManagerTest, AddPacketsAfterPreStreamUntimed) {
 // an input stream if packet timestamps don't need to be increasing.
 TEST_F(InputStreamManagerTest, AddPacketsBeforePostStreamUntimed) {
   input_stream_manager_->DisableTimestamps();
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(
       MakePacket<std::string>("packet 2").At(Timestamp::PostStream()));
@@ -867,7 +976,7 @@ TEST_F(InputStreamManagerTest, AddPacketsBeforePostStreamUntimed) {
 
 TEST_F(InputStreamManagerTest, BackwardsInTimeUntimed) {
   input_stream_manager_->DisableTimestamps();
-  std::list<Packet> packets;
+  RingBuffer<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
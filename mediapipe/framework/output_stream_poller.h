@@ -16,6 +16,7 @@
 #define MEDIAPIPE_FRAMEWORK_OUTPUT_STREAM_POLLER_H_
 
 #include <memory>
+#include <vector>
 
 #include "mediapipe/framework/graph_output_stream.h"
 
@@ -45,6 +46,31 @@ class OutputStreamPoller {
     return poller->Next(packet);
   }
 
+  // Gets up to "max_count" packets at once, replacing the contents of
+  // "packets". Blocks until the low watermark is reached, the stream is done,
+  // or "timeout" expires, in which case "packets" may be empty. Returns false
+  // if no packets are returned because the stream is done or the graph has an
+  // error.
+  ABSL_MUST_USE_RESULT bool NextBatch(
+      std::vector<Packet>* packets, int max_count,
+      absl::Duration timeout = absl::InfiniteDuration()) {
+    auto poller = internal_poller_impl_.lock();
+    if (!poller) {
+      packets->clear();
+      return false;
+    }
+    return poller->NextBatch(packets, max_count, timeout);
+  }
+
+  // Sets the number of queued packets needed to wake a blocked Next() or
+  // NextBatch() call, so that a high-rate consumer is woken once per batch
+  // rather than once per packet. The default is 1.
+  void SetLowWatermark(int low_watermark) {
+    auto poller = internal_poller_impl_.lock();
+    CHECK(poller) << "OutputStreamPollerImpl is already destroyed.";
+    poller->SetLowWatermark(low_watermark);
+  }
+
   void SetMaxQueueSize(int queue_size) {
     auto poller = internal_poller_impl_.lock();
     CHECK(poller) << "OutputStreamPollerImpl is already destroyed.";
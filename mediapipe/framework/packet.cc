@@ -14,7 +14,14 @@
 
 #include "mediapipe/framework/packet.h"
 
+#include <new>
+#include <vector>
+
+#include "absl/base/attributes.h"
+#include "absl/base/optimization.h"
+#include "absl/base/thread_annotations.h"
 #include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/port.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/integral_types.h"
@@ -24,9 +31,178 @@
 
 namespace mediapipe {
 namespace packet_internal {
+namespace {
+
+// Every Holder<T> and ForeignHolder<T> has the same layout, so a single size
+// class serves all holder types. Larger holders bypass the pool.
+constexpr size_t kBlockSize = sizeof(Holder<char>);
+// The number of free blocks moved at once between a thread's cache and the
+// shared pool.
+constexpr int kBatchSize = 64;
+// The maximum number of batches kept in the shared pool. Further batches are
+// returned to the heap.
+constexpr int kMaxSharedBatches = 256;
+
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+// Unlinks and returns the first kBatchSize blocks of the list at "*head".
+FreeBlock* SplitBatch(FreeBlock** head) {
+  FreeBlock* batch = *head;
+  FreeBlock* last = batch;
+  for (int i = 1; i < kBatchSize; ++i) {
+    last = last->next;
+  }
+  *head = last->next;
+  last->next = nullptr;
+  return batch;
+}
+
+void DeleteBlocks(FreeBlock* block) {
+  while (block) {
+    FreeBlock* next = block->next;
+    ::operator delete(block);
+    block = next;
+  }
+}
+
+// Batches of free blocks shared between threads.
+class SharedPool {
+ public:
+  // Returns a list of kBatchSize free blocks, or nullptr if there is none.
+  FreeBlock* TakeBatch() LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    if (batches_.empty()) {
+      return nullptr;
+    }
+    FreeBlock* batch = batches_.back();
+    batches_.pop_back();
+    return batch;
+  }
+
+  // Adds a list of kBatchSize free blocks.
+  void PutBatch(FreeBlock* batch) LOCKS_EXCLUDED(mutex_) {
+    {
+      absl::MutexLock lock(&mutex_);
+      if (batches_.size() < kMaxSharedBatches) {
+        batches_.push_back(batch);
+        return;
+      }
+    }
+    DeleteBlocks(batch);
+  }
+
+ private:
+  absl::Mutex mutex_;
+  std::vector<FreeBlock*> batches_ GUARDED_BY(mutex_);
+};
+
+SharedPool& GetSharedPool() {
+  // Never destroyed, since holders may be freed during static destruction.
+  static SharedPool* pool = new SharedPool;
+  return *pool;
+}
+
+// Per-thread cache of free blocks. Allocation and deallocation touch only the
+// calling thread's cache, except when a whole batch of blocks is exchanged
+// with the shared pool. This lets a block freed on a consumer thread be reused
+// by a producer thread.
+//
+// The cache state is trivially destructible, so that it remains usable while
+// other thread_local objects are destroyed. A separate CacheFlusher returns
+// the cached blocks when the thread exits.
+struct ThreadCache {
+  FreeBlock* head;
+  int count;
+  enum State { kUninitialized, kActive, kFlushed } state;
+};
+
+ABSL_CONST_INIT thread_local ThreadCache thread_cache = {
+    nullptr, 0, ThreadCache::kUninitialized};
+
+void FlushThreadCache() {
+  ThreadCache& cache = thread_cache;
+  while (cache.count >= kBatchSize) {
+    GetSharedPool().PutBatch(SplitBatch(&cache.head));
+    cache.count -= kBatchSize;
+  }
+  DeleteBlocks(cache.head);
+  cache.head = nullptr;
+  cache.count = 0;
+  cache.state = ThreadCache::kFlushed;
+}
+
+struct CacheFlusher {
+  ~CacheFlusher() { FlushThreadCache(); }
+};
+
+// Returns the calling thread's cache, or nullptr if the thread is exiting.
+ThreadCache* GetThreadCache() {
+  ThreadCache& cache = thread_cache;
+  if (ABSL_PREDICT_FALSE(cache.state != ThreadCache::kActive)) {
+    if (cache.state == ThreadCache::kFlushed) {
+      return nullptr;
+    }
+    static thread_local CacheFlusher flusher;
+    (void)flusher;
+    cache.state = ThreadCache::kActive;
+  }
+  return &cache;
+}
+
+void* AllocateBlock() {
+  ThreadCache* cache = GetThreadCache();
+  if (cache == nullptr) {
+    return ::operator new(kBlockSize);
+  }
+  if (cache->head == nullptr) {
+    cache->head = GetSharedPool().TakeBatch();
+    if (cache->head == nullptr) {
+      return ::operator new(kBlockSize);
+    }
+    cache->count = kBatchSize;
+  }
+  FreeBlock* block = cache->head;
+  cache->head = block->next;
+  --cache->count;
+  return block;
+}
+
+void DeallocateBlock(void* ptr) {
+  ThreadCache* cache = GetThreadCache();
+  if (cache == nullptr) {
+    ::operator delete(ptr);
+    return;
+  }
+  FreeBlock* block = static_cast<FreeBlock*>(ptr);
+  block->next = cache->head;
+  cache->head = block;
+  if (++cache->count >= 2 * kBatchSize) {
+    GetSharedPool().PutBatch(SplitBatch(&cache->head));
+    cache->count -= kBatchSize;
+  }
+}
+
+}  // namespace
 
 HolderBase::~HolderBase() {}
 
+void* HolderBase::operator new(size_t size) {
+  if (size > kBlockSize) {
+    return ::operator new(size);
+  }
+  return AllocateBlock();
+}
+
+void HolderBase::operator delete(void* ptr, size_t size) {
+  if (size > kBlockSize) {
+    ::operator delete(ptr);
+    return;
+  }
+  DeallocateBlock(ptr);
+}
+
 Packet Create(HolderBase* holder) {
   Packet result;
   result.holder_.reset(holder);
@@ -17,6 +17,7 @@
 #ifndef MEDIAPIPE_FRAMEWORK_PACKET_H_
 #define MEDIAPIPE_FRAMEWORK_PACKET_H_
 
+#include <atomic>
 #include <cstddef>
 #include <memory>
 #include <string>
@@ -46,6 +47,42 @@ class Packet;
 namespace packet_internal {
 class HolderBase;
 
+// An intrusive reference-counted pointer to a HolderBase. The reference count
+// lives in the holder itself, so unlike std::shared_ptr no separate control
+// block is allocated per Packet.
+class HolderPtr {
+ public:
+  HolderPtr() = default;
+  HolderPtr(const HolderPtr& other);
+  HolderPtr(HolderPtr&& other) : holder_(other.holder_) {
+    other.holder_ = nullptr;
+  }
+  HolderPtr& operator=(const HolderPtr& other);
+  HolderPtr& operator=(HolderPtr&& other);
+  ~HolderPtr() { reset(); }
+
+  // Releases the current holder, deleting it if this was the last reference,
+  // and takes a reference to "holder".
+  void reset(HolderBase* holder = nullptr);
+
+  HolderBase* get() const { return holder_; }
+  HolderBase* operator->() const { return holder_; }
+  explicit operator bool() const { return holder_ != nullptr; }
+
+  // Returns true if this is the only reference to the holder.
+  bool unique() const;
+
+  friend bool operator==(const HolderPtr& ptr, std::nullptr_t) {
+    return ptr.holder_ == nullptr;
+  }
+  friend bool operator!=(const HolderPtr& ptr, std::nullptr_t) {
+    return ptr.holder_ != nullptr;
+  }
+
+ private:
+  HolderBase* holder_ = nullptr;
+};
+
 Packet Create(HolderBase* holder);
 Packet Create(HolderBase* holder, Timestamp timestamp);
 const HolderBase* GetHolder(const Packet& packet);
@@ -196,7 +233,7 @@ class Packet {
                                         class Timestamp timestamp);
   friend const packet_internal::HolderBase* packet_internal::GetHolder(
       const Packet& packet);
-  std::shared_ptr<packet_internal::HolderBase> holder_;
+  packet_internal::HolderPtr holder_;
   class Timestamp timestamp_;
 };
 
@@ -319,6 +356,12 @@ class HolderBase {
   HolderBase(const HolderBase&) = delete;
   HolderBase& operator=(const HolderBase&) = delete;
   virtual ~HolderBase();
+
+  // Holders are allocated from a free-list pool shared by all holder types,
+  // which avoids a heap allocation per Packet in steady state. See packet.cc.
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr, size_t size);
+
   template <typename T>
   void SetHolderTypeId() {
     type_id_ = tool::GetTypeHash<T>();
@@ -348,9 +391,57 @@ class HolderBase {
   virtual const proto_ns::MessageLite* GetProtoMessageLite() = 0;
 
  private:
+  friend class HolderPtr;
+
   size_t type_id_;
+  // The number of HolderPtrs referring to this holder.
+  std::atomic<int> ref_count_{0};
 };
 
+inline HolderPtr::HolderPtr(const HolderPtr& other) : holder_(other.holder_) {
+  if (holder_) {
+    holder_->ref_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+inline HolderPtr& HolderPtr::operator=(const HolderPtr& other) {
+  if (other.holder_) {
+    other.holder_->ref_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+  HolderBase* old_holder = holder_;
+  holder_ = other.holder_;
+  if (old_holder &&
+      old_holder->ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete old_holder;
+  }
+  return *this;
+}
+
+inline HolderPtr& HolderPtr::operator=(HolderPtr&& other) {
+  if (this != &other) {
+    reset();
+    holder_ = other.holder_;
+    other.holder_ = nullptr;
+  }
+  return *this;
+}
+
+inline void HolderPtr::reset(HolderBase* holder) {
+  if (holder) {
+    holder->ref_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+  HolderBase* old_holder = holder_;
+  holder_ = holder;
+  if (old_holder &&
+      old_holder->ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete old_holder;
+  }
+}
+
+inline bool HolderPtr::unique() const {
+  return holder_ && holder_->ref_count_.load(std::memory_order_acquire) == 1;
+}
+
 // Two helper functions to get the proto base pointers.
 template <typename T>
 const proto_ns::MessageLite* ConvertToProtoMessageLite(const T* data,
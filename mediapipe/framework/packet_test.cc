@@ -14,23 +14,33 @@
 
 #include "mediapipe/framework/packet.h"
 
+#include <atomic>
+#include <cstdlib>
 #include <map>
 #include <memory>
+#include <new>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
 #include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "mediapipe/framework/packet_test.pb.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/core_proto_inc.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/status_matchers.h"
 #include "mediapipe/framework/type_map.h"
 
 namespace mediapipe {
 namespace {
 
+// The number of calls to the global operator new, which is replaced at the
+// end of this file.
+std::atomic<int64> allocation_count(0);
+
 class MyClassBase {
  public:
   virtual ~MyClassBase() {}
@@ -455,5 +465,138 @@ TEST(PacketTest, TestConsumeOrCopyBoundedArray) {
   EXPECT_TRUE(packet2.IsEmpty());
 }
 
+TEST(PacketTest, ReusesHolderStorage) {
+  const packet_internal::HolderBase* holder;
+  {
+    Packet packet = MakePacket<int>(1);
+    holder = packet_internal::GetHolder(packet);
+  }
+  // The freed holder is the first one handed out again on this thread, even
+  // for a different type.
+  Packet packet = MakePacket<std::string>("reused");
+  EXPECT_EQ(holder, packet_internal::GetHolder(packet));
+  EXPECT_EQ("reused", packet.Get<std::string>());
+}
+
+TEST(PacketTest, SharesPacketsAcrossThreads) {
+  constexpr int kNumThreads = 4;
+  constexpr int kNumCopies = 10000;
+  bool exist = false;
+  Packet packet = Adopt(new MyClass(&exist));
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([packet]() {
+      std::vector<Packet> copies;
+      for (int i = 0; i < kNumCopies; ++i) {
+        copies.push_back(packet);
+        copies.push_back(MakePacket<int>(i));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_TRUE(exist);
+  packet = Packet();
+  EXPECT_FALSE(exist);
+}
+
+TEST(PacketTest, FreesPacketsOnAnotherThread) {
+  constexpr int kNumPackets = 10000;
+  for (int round = 0; round < 3; ++round) {
+    std::vector<Packet> packets;
+    for (int i = 0; i < kNumPackets; ++i) {
+      packets.push_back(MakePacket<int>(i).At(Timestamp(i)));
+    }
+    std::thread consumer([&packets]() {
+      for (int i = 0; i < kNumPackets; ++i) {
+        EXPECT_EQ(i, packets[i].Get<int>());
+      }
+      packets.clear();
+    });
+    consumer.join();
+    EXPECT_TRUE(packets.empty());
+  }
+}
+
+// Creates and destroys a Packet holding a T per iteration and reports the
+// heap allocations per packet.
+template <typename T>
+void BM_MakePacket(benchmark::State& state) {
+  const int64 start_allocations =
+      allocation_count.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    Packet packet = MakePacket<T>();
+    benchmark::DoNotOptimize(packet);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["allocs_per_packet"] =
+      static_cast<double>(allocation_count.load(std::memory_order_relaxed) -
+                          start_allocations) /
+      state.iterations();
+}
+
+BENCHMARK_TEMPLATE(BM_MakePacket, int);
+BENCHMARK_TEMPLATE(BM_MakePacket, float);
+BENCHMARK_TEMPLATE(BM_MakePacket, Timestamp);
+BENCHMARK_TEMPLATE(BM_MakePacket, std::vector<float>);
+
+// Copies a timestamped Packet, as done for every packet sent to more than one
+// input stream.
+void BM_CopyPacket(benchmark::State& state) {
+  const Packet packet = MakePacket<int>(1).At(Timestamp(1));
+  for (auto _ : state) {
+    Packet copy = packet;
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_CopyPacket);
+
+// Creates packets on one thread and destroys them on state.range(0) other
+// threads, with state.range(1) packets per batch.
+void BM_MakePacketAcrossThreads(benchmark::State& state) {
+  const int num_consumers = state.range(0);
+  const int batch_size = state.range(1);
+  const int64 start_allocations =
+      allocation_count.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    std::vector<std::vector<Packet>> batches(num_consumers);
+    for (auto& batch : batches) {
+      for (int i = 0; i < batch_size; ++i) {
+        batch.push_back(MakePacket<int>(i).At(Timestamp(i)));
+      }
+    }
+    std::vector<std::thread> consumers;
+    for (auto& batch : batches) {
+      consumers.emplace_back([&batch]() { batch.clear(); });
+    }
+    for (auto& consumer : consumers) {
+      consumer.join();
+    }
+  }
+  const int64 num_packets = state.iterations() * num_consumers * batch_size;
+  state.SetItemsProcessed(num_packets);
+  state.counters["allocs_per_packet"] =
+      static_cast<double>(allocation_count.load(std::memory_order_relaxed) -
+                          start_allocations) /
+      num_packets;
+}
+
+BENCHMARK(BM_MakePacketAcrossThreads)->Args({1, 1000})->Args({4, 1000});
+
 }  // namespace
 }  // namespace mediapipe
+
+// Counts heap allocations for the benchmarks above.
+void* operator new(size_t size) {
+  mediapipe::allocation_count.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
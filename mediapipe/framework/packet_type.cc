@@ -176,6 +176,20 @@ bool PacketType::IsConsistentWith(const PacketType& other) const {
   return type1->validate_method_ == type2->validate_method_;
 }
 
+bool PacketType::Implies(const PacketType& other) const {
+  const PacketType* type1 = GetSameAs();
+  const PacketType* type2 = other.GetSameAs();
+  if (!type1->initialized_ || !type2->initialized_) {
+    return false;
+  }
+  if (type2->IsAny() || type1->no_packets_allowed_) {
+    // type2 accepts anything, or type1 accepts nothing.
+    return true;
+  }
+  return type1->validate_method_ != nullptr &&
+         type1->validate_method_ == type2->validate_method_;
+}
+
 ::mediapipe::Status ValidatePacketTypeSet(
     const PacketTypeSet& packet_type_set) {
   std::vector<std::string> errors;
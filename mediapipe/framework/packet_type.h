@@ -84,6 +84,11 @@ class PacketType {
   // IsNone() is only consistent with IsNone() and IsAny().
   bool IsConsistentWith(const PacketType& other) const;
 
+  // Returns true iff every packet that is valid for this type is also valid
+  // for other, so that validating a packet against other after validating it
+  // against this type is redundant.
+  bool Implies(const PacketType& other) const;
+
   // Returns OK if the packet contains an object of the appropriate type.
   ::mediapipe::Status Validate(const Packet& packet) const;
 
@@ -0,0 +1,42 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/packet_type.h"
+
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(PacketTypeTest, Implies) {
+  PacketType any_type, int_type, float_type, none_type, same_as_int_type;
+  any_type.SetAny();
+  int_type.Set<int>();
+  float_type.Set<float>();
+  none_type.SetNone();
+  same_as_int_type.SetSameAs(&int_type);
+
+  EXPECT_TRUE(int_type.Implies(int_type));
+  EXPECT_TRUE(int_type.Implies(any_type));
+  EXPECT_TRUE(int_type.Implies(same_as_int_type));
+  EXPECT_TRUE(same_as_int_type.Implies(int_type));
+  EXPECT_TRUE(none_type.Implies(int_type));
+  EXPECT_TRUE(any_type.Implies(any_type));
+  EXPECT_FALSE(any_type.Implies(int_type));
+  EXPECT_FALSE(int_type.Implies(float_type));
+  EXPECT_FALSE(int_type.Implies(PacketType()));
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,170 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PRIORITY_BUCKET_QUEUE_H_
+#define MEDIAPIPE_FRAMEWORK_PRIORITY_BUCKET_QUEUE_H_
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+#include "absl/types/optional.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/logging.h"
+
+namespace mediapipe {
+namespace internal {
+
+// A multi-producer, single-consumer queue with a fixed number of priority
+// levels ("buckets"). Bucket 0 has the highest priority. Items within a bucket
+// are returned in FIFO order.
+//
+// Push() is lock-free and may be called from any number of threads. Pop() and
+// Clear() must not run concurrently with each other; callers serialize them.
+//
+// Every bucket is a linked list in the style of Dmitry Vyukov's
+// MPSC queue: a producer publishes its item with a single atomic exchange. A
+// bitmap of possibly non-empty buckets lets Pop() find the highest-priority
+// item without visiting every bucket.
+template <typename T>
+class PriorityBucketQueue {
+ public:
+  explicit PriorityBucketQueue(int num_buckets)
+      : num_buckets_(num_buckets),
+        num_words_((num_buckets + 63) / 64),
+        buckets_(new Bucket[num_buckets]),
+        non_empty_(new std::atomic<uint64>[num_words_]) {
+    for (int i = 0; i < num_words_; ++i) {
+      non_empty_[i].store(0, std::memory_order_relaxed);
+    }
+  }
+  PriorityBucketQueue(const PriorityBucketQueue&) = delete;
+  PriorityBucketQueue& operator=(const PriorityBucketQueue&) = delete;
+
+  ~PriorityBucketQueue() {
+    Clear();
+    for (int i = 0; i < num_buckets_; ++i) {
+      delete buckets_[i].tail;
+    }
+  }
+
+  int num_buckets() const { return num_buckets_; }
+
+  // Adds "value" to "bucket". Thread-safe and lock-free.
+  void Push(int bucket, T value) {
+    DCHECK_GE(bucket, 0);
+    DCHECK_LT(bucket, num_buckets_);
+    Node* node = new Node;
+    node->value.emplace(std::move(value));
+    Node* prev =
+        buckets_[bucket].head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+    // Set the bit only after the node is linked, so that Pop() never clears
+    // the bit of a bucket that it cannot see the new node in.
+    non_empty_[bucket / 64].fetch_or(uint64{1} << (bucket % 64),
+                                     std::memory_order_release);
+  }
+
+  // Removes the item with the highest priority and stores it in "value",
+  // which points to a T or to an absl::optional<T>. Returns false if no item
+  // was found. An item whose Push() is still in progress may be missed; the
+  // caller can retry.
+  template <typename U>
+  bool Pop(U* value) {
+    for (int word = 0; word < num_words_; ++word) {
+      uint64 bits = non_empty_[word].load(std::memory_order_acquire);
+      while (bits != 0) {
+        const int bit = __builtin_ctzll(bits);
+        const int bucket = word * 64 + bit;
+        if (PopFromBucket(bucket, value)) {
+          return true;
+        }
+        // The bucket looks empty: clear its bit, then check again in case a
+        // producer linked a node before we cleared the bit.
+        const uint64 mask = uint64{1} << bit;
+        non_empty_[word].fetch_and(~mask, std::memory_order_acq_rel);
+        if (!BucketEmpty(bucket)) {
+          non_empty_[word].fetch_or(mask, std::memory_order_release);
+          if (PopFromBucket(bucket, value)) {
+            return true;
+          }
+        }
+        bits &= ~mask;
+      }
+    }
+    return false;
+  }
+
+  // Removes all items and returns the number of items removed. Must not be
+  // called concurrently with Push().
+  int Clear() {
+    int count = 0;
+    absl::optional<T> value;
+    for (int i = 0; i < num_buckets_; ++i) {
+      while (PopFromBucket(i, &value)) {
+        ++count;
+      }
+    }
+    for (int i = 0; i < num_words_; ++i) {
+      non_empty_[i].store(0, std::memory_order_relaxed);
+    }
+    return count;
+  }
+
+ private:
+  struct Node {
+    std::atomic<Node*> next{nullptr};
+    absl::optional<T> value;
+  };
+
+  // Producers append at head; the consumer removes after tail. tail always
+  // points to a node whose value has already been consumed (initially a
+  // stub node).
+  struct Bucket {
+    Bucket() : head(new Node), tail(head.load(std::memory_order_relaxed)) {}
+    std::atomic<Node*> head;
+    Node* tail;
+  };
+
+  template <typename U>
+  bool PopFromBucket(int bucket, U* value) {
+    Bucket& b = buckets_[bucket];
+    Node* tail = b.tail;
+    Node* next = tail->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      return false;
+    }
+    *value = std::move(*next->value);
+    next->value.reset();
+    b.tail = next;
+    delete tail;
+    return true;
+  }
+
+  bool BucketEmpty(int bucket) const {
+    return buckets_[bucket].tail->next.load(std::memory_order_acquire) ==
+           nullptr;
+  }
+
+  const int num_buckets_;
+  const int num_words_;
+  std::unique_ptr<Bucket[]> buckets_;
+  // Bit i is set if bucket i may be non-empty.
+  std::unique_ptr<std::atomic<uint64>[]> non_empty_;
+};
+
+}  // namespace internal
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PRIORITY_BUCKET_QUEUE_H_
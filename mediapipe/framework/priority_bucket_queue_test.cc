@@ -0,0 +1,104 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/priority_bucket_queue.h"
+
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace internal {
+namespace {
+
+TEST(PriorityBucketQueueTest, EmptyQueue) {
+  PriorityBucketQueue<int> queue(10);
+  int value;
+  EXPECT_FALSE(queue.Pop(&value));
+  EXPECT_EQ(0, queue.Clear());
+}
+
+TEST(PriorityBucketQueueTest, PopsByBucketThenFifo) {
+  PriorityBucketQueue<int> queue(130);
+  queue.Push(129, 1);
+  queue.Push(5, 2);
+  queue.Push(64, 3);
+  queue.Push(5, 4);
+  queue.Push(0, 5);
+  std::vector<int> popped;
+  int value;
+  while (queue.Pop(&value)) {
+    popped.push_back(value);
+  }
+  EXPECT_EQ(std::vector<int>({5, 2, 4, 3, 1}), popped);
+}
+
+TEST(PriorityBucketQueueTest, MoveOnlyValues) {
+  PriorityBucketQueue<std::unique_ptr<int>> queue(2);
+  queue.Push(1, absl::make_unique<int>(7));
+  std::unique_ptr<int> value;
+  ASSERT_TRUE(queue.Pop(&value));
+  EXPECT_EQ(7, *value);
+}
+
+TEST(PriorityBucketQueueTest, ClearRemovesAll) {
+  PriorityBucketQueue<int> queue(3);
+  for (int i = 0; i < 10; ++i) {
+    queue.Push(i % 3, i);
+  }
+  EXPECT_EQ(10, queue.Clear());
+  int value;
+  EXPECT_FALSE(queue.Pop(&value));
+  queue.Push(2, 42);
+  ASSERT_TRUE(queue.Pop(&value));
+  EXPECT_EQ(42, value);
+}
+
+TEST(PriorityBucketQueueTest, ConcurrentProducers) {
+  constexpr int kNumProducers = 8;
+  constexpr int kItemsPerProducer = 10000;
+  PriorityBucketQueue<int> queue(kNumProducers);
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kNumProducers; ++p) {
+    producers.emplace_back([&queue, p]() {
+      for (int i = 0; i < kItemsPerProducer; ++i) {
+        queue.Push(p, p * kItemsPerProducer + i);
+      }
+    });
+  }
+  // Items of one producer must come out in the order they were pushed.
+  std::vector<int> next_expected(kNumProducers, 0);
+  int num_popped = 0;
+  int value;
+  while (num_popped < kNumProducers * kItemsPerProducer) {
+    if (!queue.Pop(&value)) {
+      std::this_thread::yield();
+      continue;
+    }
+    const int producer = value / kItemsPerProducer;
+    EXPECT_EQ(next_expected[producer]++, value % kItemsPerProducer);
+    ++num_popped;
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  EXPECT_FALSE(queue.Pop(&value));
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace mediapipe
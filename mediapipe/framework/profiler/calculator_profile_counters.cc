@@ -0,0 +1,146 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/calculator_profile_counters.h"
+
+#include <algorithm>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/port/logging.h"
+
+namespace mediapipe {
+
+AtomicTimeHistogram::AtomicTimeHistogram(const TimeHistogram& histogram)
+    : interval_size_usec_(std::max<int64>(histogram.interval_size_usec(), 1)),
+      num_intervals_(std::max<int64>(histogram.num_intervals(), 1)),
+      total_(0),
+      counts_(new std::atomic<int64>[num_intervals_]) {
+  Reset();
+}
+
+void AtomicTimeHistogram::AddTo(TimeHistogram* histogram) const {
+  CHECK_EQ(histogram->count_size(), num_intervals_);
+  histogram->set_total(histogram->total() +
+                       total_.load(std::memory_order_relaxed));
+  for (int i = 0; i < num_intervals_; ++i) {
+    histogram->set_count(
+        i, histogram->count(i) + counts_[i].load(std::memory_order_relaxed));
+  }
+}
+
+void AtomicTimeHistogram::Reset() {
+  total_.store(0, std::memory_order_relaxed);
+  for (int i = 0; i < num_intervals_; ++i) {
+    counts_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+CalculatorProfileDistributions::CalculatorProfileDistributions(
+    const CalculatorProfile& profile) {
+  if (profile.has_process_input_latency()) {
+    process_input_latency = absl::make_unique<AtomicLatencyHistogram>();
+    process_output_latency = absl::make_unique<AtomicLatencyHistogram>();
+  }
+  for (const StreamProfile& stream_profile : profile.input_stream_profiles()) {
+    input_stream_latency.push_back(
+        stream_profile.back_edge()
+            ? nullptr
+            : absl::make_unique<AtomicLatencyHistogram>());
+  }
+}
+
+void CalculatorProfileDistributions::AddTo(CalculatorProfile* profile) const {
+  process_runtime.AddTo(profile->mutable_process_runtime_distribution());
+  if (process_input_latency) {
+    process_input_latency->AddTo(
+        profile->mutable_process_input_latency_distribution());
+    process_output_latency->AddTo(
+        profile->mutable_process_output_latency_distribution());
+  }
+  for (int i = 0; i < input_stream_latency.size(); ++i) {
+    if (input_stream_latency[i]) {
+      input_stream_latency[i]->AddTo(profile->mutable_input_stream_profiles(i)
+                                         ->mutable_latency_distribution());
+    }
+  }
+}
+
+void CalculatorProfileDistributions::Reset() {
+  process_runtime.Reset();
+  if (process_input_latency) {
+    process_input_latency->Reset();
+    process_output_latency->Reset();
+  }
+  for (auto& latency : input_stream_latency) {
+    if (latency) {
+      latency->Reset();
+    }
+  }
+}
+
+CalculatorProfileCounters::CalculatorProfileCounters(
+    const CalculatorProfile& profile,
+    CalculatorProfileDistributions* distributions)
+    : process_runtime(profile.process_runtime(),
+                      &distributions->process_runtime) {
+  if (profile.has_process_input_latency()) {
+    CHECK(distributions->process_input_latency);
+    process_input_latency = absl::make_unique<DurationCounters>(
+        profile.process_input_latency(),
+        distributions->process_input_latency.get());
+    process_output_latency = absl::make_unique<DurationCounters>(
+        profile.process_output_latency(),
+        distributions->process_output_latency.get());
+  }
+  CHECK_EQ(profile.input_stream_profiles_size(),
+           distributions->input_stream_latency.size());
+  for (int i = 0; i < profile.input_stream_profiles_size(); ++i) {
+    const StreamProfile& stream_profile = profile.input_stream_profiles(i);
+    input_stream_latency.push_back(
+        stream_profile.back_edge()
+            ? nullptr
+            : absl::make_unique<DurationCounters>(
+                  stream_profile.latency(),
+                  distributions->input_stream_latency[i].get()));
+  }
+}
+
+void CalculatorProfileCounters::AddTo(CalculatorProfile* profile) const {
+  process_runtime.AddTo(profile->mutable_process_runtime());
+  if (process_input_latency) {
+    process_input_latency->AddTo(profile->mutable_process_input_latency());
+    process_output_latency->AddTo(profile->mutable_process_output_latency());
+  }
+  for (int i = 0; i < input_stream_latency.size(); ++i) {
+    if (input_stream_latency[i]) {
+      input_stream_latency[i]->AddTo(
+          profile->mutable_input_stream_profiles(i)->mutable_latency());
+    }
+  }
+}
+
+void CalculatorProfileCounters::Reset() {
+  process_runtime.Reset();
+  if (process_input_latency) {
+    process_input_latency->Reset();
+    process_output_latency->Reset();
+  }
+  for (auto& latency : input_stream_latency) {
+    if (latency) {
+      latency->Reset();
+    }
+  }
+}
+
+}  // namespace mediapipe
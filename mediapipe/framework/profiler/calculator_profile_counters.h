@@ -0,0 +1,135 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PROFILER_CALCULATOR_PROFILE_COUNTERS_H_
+#define MEDIAPIPE_FRAMEWORK_PROFILER_CALCULATOR_PROFILE_COUNTERS_H_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/profiler/latency_histogram.h"
+
+namespace mediapipe {
+
+// Accumulates the samples of a TimeHistogram in atomic counters, so that
+// samples can be added by many threads without locking.
+class AtomicTimeHistogram {
+ public:
+  // Creates counters for the intervals defined in "histogram".
+  explicit AtomicTimeHistogram(const TimeHistogram& histogram);
+
+  // Not copyable or movable.
+  AtomicTimeHistogram(const AtomicTimeHistogram&) = delete;
+  AtomicTimeHistogram& operator=(const AtomicTimeHistogram&) = delete;
+
+  // Records a sample of "time_usec" microseconds.
+  inline void AddSample(int64 time_usec) {
+    total_.fetch_add(time_usec, std::memory_order_relaxed);
+    int64 interval_index = time_usec / interval_size_usec_;
+    if (interval_index > num_intervals_ - 1) {
+      interval_index = num_intervals_ - 1;
+    }
+    counts_[interval_index].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Adds the recorded total and counts to "histogram".
+  void AddTo(TimeHistogram* histogram) const;
+
+  // Clears the recorded total and counts.
+  void Reset();
+
+ private:
+  const int64 interval_size_usec_;
+  const int64 num_intervals_;
+  std::atomic<int64> total_;
+  std::unique_ptr<std::atomic<int64>[]> counts_;
+};
+
+// Accumulates the samples of one duration in a TimeHistogram, and in a
+// LatencyHistogram that may be shared with other DurationCounters.
+class DurationCounters {
+ public:
+  // Creates counters for the intervals defined in "histogram".  Samples are
+  // also added to "distribution", which must outlive this object.
+  DurationCounters(const TimeHistogram& histogram,
+                   AtomicLatencyHistogram* distribution)
+      : histogram_(histogram), distribution_(distribution) {}
+
+  // Records a sample of "time_usec" microseconds.
+  inline void AddSample(int64 time_usec) {
+    histogram_.AddSample(time_usec);
+    distribution_->AddSample(time_usec);
+  }
+
+  // Adds the recorded samples to "histogram".  The samples in the shared
+  // distribution are added by CalculatorProfileDistributions::AddTo().
+  void AddTo(TimeHistogram* histogram) const { histogram_.AddTo(histogram); }
+
+  // Clears the recorded samples, except for the shared distribution.
+  void Reset() { histogram_.Reset(); }
+
+ private:
+  AtomicTimeHistogram histogram_;
+  AtomicLatencyHistogram* distribution_;
+};
+
+// Accumulates the LatencyHistograms of one CalculatorProfile.  Each
+// AtomicLatencyHistogram holds kNumLatencyBuckets counters, so there is a
+// single copy per calculator, shared by all of its CalculatorProfileCounters.
+struct CalculatorProfileDistributions {
+  // Creates counters for the latency distributions recorded in "profile".
+  explicit CalculatorProfileDistributions(const CalculatorProfile& profile);
+
+  // Adds the recorded samples to the LatencyHistograms in "profile".
+  void AddTo(CalculatorProfile* profile) const;
+
+  // Clears the recorded samples.
+  void Reset();
+
+  AtomicLatencyHistogram process_runtime;
+  // The process latencies, or nullptr if stream latency is not profiled.
+  std::unique_ptr<AtomicLatencyHistogram> process_input_latency;
+  std::unique_ptr<AtomicLatencyHistogram> process_output_latency;
+  // The latency of each input stream, or nullptr for back edges.
+  std::vector<std::unique_ptr<AtomicLatencyHistogram>> input_stream_latency;
+};
+
+// Accumulates the TimeHistograms of one CalculatorProfile.
+struct CalculatorProfileCounters {
+  // Creates counters for the histograms defined in "profile".  Samples are
+  // also added to "distributions", which must have been created for the same
+  // profile, and must outlive this object.
+  CalculatorProfileCounters(const CalculatorProfile& profile,
+                            CalculatorProfileDistributions* distributions);
+
+  // Adds the recorded samples to the TimeHistograms in "profile".
+  void AddTo(CalculatorProfile* profile) const;
+
+  // Clears the recorded samples, except for the shared distributions.
+  void Reset();
+
+  DurationCounters process_runtime;
+  // The process latencies, or nullptr if stream latency is not profiled.
+  std::unique_ptr<DurationCounters> process_input_latency;
+  std::unique_ptr<DurationCounters> process_output_latency;
+  // The latency of each input stream, or nullptr for back edges.
+  std::vector<std::unique_ptr<DurationCounters>> input_stream_latency;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PROFILER_CALCULATOR_PROFILE_COUNTERS_H_
@@ -0,0 +1,179 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/calculator_profile_counters.h"
+
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/profiler/sharded_map.h"
+
+namespace mediapipe {
+namespace {
+
+TimeHistogram MakeHistogram(int64 interval_size_usec, int64 num_intervals) {
+  TimeHistogram histogram;
+  histogram.set_interval_size_usec(interval_size_usec);
+  histogram.set_num_intervals(num_intervals);
+  histogram.mutable_count()->Resize(num_intervals, 0);
+  return histogram;
+}
+
+TEST(CalculatorProfileCountersTest, AddSample) {
+  AtomicTimeHistogram counters(MakeHistogram(100, 3));
+  counters.AddSample(0);
+  counters.AddSample(150);
+  counters.AddSample(250);
+  counters.AddSample(10000);
+  TimeHistogram histogram = MakeHistogram(100, 3);
+  counters.AddTo(&histogram);
+  counters.AddTo(&histogram);
+  EXPECT_EQ(2 * 10400, histogram.total());
+  EXPECT_EQ(2, histogram.count(0));
+  EXPECT_EQ(2, histogram.count(1));
+  EXPECT_EQ(4, histogram.count(2));
+
+  counters.Reset();
+  histogram = MakeHistogram(100, 3);
+  counters.AddTo(&histogram);
+  EXPECT_EQ(0, histogram.total());
+  EXPECT_EQ(0, histogram.count(2));
+}
+
+TEST(CalculatorProfileCountersTest, ParallelAddSample) {
+  constexpr int kNumThreads = 8;
+  constexpr int kNumSamples = 10000;
+  AtomicTimeHistogram counters(MakeHistogram(10, 2));
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&counters] {
+      for (int i = 0; i < kNumSamples; ++i) {
+        counters.AddSample(i % 20);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  TimeHistogram histogram = MakeHistogram(10, 2);
+  counters.AddTo(&histogram);
+  EXPECT_EQ(kNumThreads * kNumSamples / 2, histogram.count(0));
+  EXPECT_EQ(kNumThreads * kNumSamples / 2, histogram.count(1));
+  EXPECT_EQ(kNumThreads * kNumSamples / 20 * 190, histogram.total());
+}
+
+// Back edges have no latency counters.
+TEST(CalculatorProfileCountersTest, CalculatorProfile) {
+  CalculatorProfile profile = ParseTextProtoOrDie<CalculatorProfile>(R"(
+    name: "Calculator"
+    process_runtime { interval_size_usec: 10 num_intervals: 1 count: 0 }
+    input_stream_profiles {
+      name: "input"
+      latency { interval_size_usec: 10 num_intervals: 1 count: 0 }
+    }
+    input_stream_profiles {
+      name: "loop"
+      back_edge: true
+      latency { interval_size_usec: 10 num_intervals: 1 count: 0 }
+    }
+  )");
+  CalculatorProfileDistributions distributions(profile);
+  CalculatorProfileCounters counters(profile, &distributions);
+  ASSERT_EQ(2, counters.input_stream_latency.size());
+  ASSERT_NE(nullptr, counters.input_stream_latency[0]);
+  EXPECT_EQ(nullptr, counters.input_stream_latency[1]);
+  counters.process_runtime.AddSample(5);
+  counters.input_stream_latency[0]->AddSample(7);
+  counters.AddTo(&profile);
+  distributions.AddTo(&profile);
+  EXPECT_EQ(5, profile.process_runtime().total());
+  EXPECT_EQ(1, profile.process_runtime().count(0));
+  EXPECT_EQ(7, profile.input_stream_profiles(0).latency().total());
+  EXPECT_EQ(0, profile.input_stream_profiles(1).latency().total());
+  EXPECT_FALSE(profile.has_process_input_latency());
+  EXPECT_EQ(1, profile.process_runtime_distribution().num_samples());
+  EXPECT_EQ(5, profile.process_runtime_distribution().p50());
+  EXPECT_EQ(7, profile.input_stream_profiles(0).latency_distribution().max());
+  EXPECT_FALSE(profile.input_stream_profiles(1).has_latency_distribution());
+  EXPECT_FALSE(profile.has_process_input_latency_distribution());
+}
+
+// The counters of all shards add samples to one shared distribution.
+TEST(CalculatorProfileCountersTest, SharedDistributions) {
+  CalculatorProfile profile = ParseTextProtoOrDie<CalculatorProfile>(R"(
+    name: "Calculator"
+    process_runtime { interval_size_usec: 10 num_intervals: 1 count: 0 }
+  )");
+  CalculatorProfileDistributions distributions(profile);
+  CalculatorProfileCounters shard_1(profile, &distributions);
+  CalculatorProfileCounters shard_2(profile, &distributions);
+  shard_1.process_runtime.AddSample(5);
+  shard_2.process_runtime.AddSample(9);
+  shard_1.AddTo(&profile);
+  shard_2.AddTo(&profile);
+  distributions.AddTo(&profile);
+  EXPECT_EQ(2, profile.process_runtime().count(0));
+  EXPECT_EQ(2, profile.process_runtime_distribution().num_samples());
+  EXPECT_EQ(14, profile.process_runtime_distribution().total());
+
+  // Resetting a shard keeps the shared samples.
+  shard_1.Reset();
+  profile.clear_process_runtime_distribution();
+  distributions.AddTo(&profile);
+  EXPECT_EQ(2, profile.process_runtime_distribution().num_samples());
+  distributions.Reset();
+  profile.clear_process_runtime_distribution();
+  distributions.AddTo(&profile);
+  EXPECT_EQ(0, profile.process_runtime_distribution().num_samples());
+}
+
+// Adds samples to a TimeHistogram in a ShardedMap, as GraphProfiler did
+// before it used CalculatorProfileCounters.
+void BM_ShardedMapAddSample(benchmark::State& state) {
+  static auto* profiles = [] {
+    auto* profiles = new ShardedMap<std::string, CalculatorProfile>(1000);
+    CalculatorProfile profile;
+    *profile.mutable_process_runtime() = MakeHistogram(1000000, 2);
+    profiles->insert({"Calculator", profile});
+    return profiles;
+  }();
+  const std::string name = "Calculator";
+  for (auto _ : state) {
+    auto iter = profiles->find(name);
+    TimeHistogram* histogram = iter->second.mutable_process_runtime();
+    histogram->set_total(histogram->total() + 10);
+    histogram->set_count(0, histogram->count(0) + 1);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_ShardedMapAddSample)->Threads(1)->Threads(8);
+
+void BM_AtomicTimeHistogramAddSample(benchmark::State& state) {
+  static auto* counters = new AtomicTimeHistogram(MakeHistogram(1000000, 2));
+  for (auto _ : state) {
+    counters->AddSample(10);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_AtomicTimeHistogramAddSample)->Threads(1)->Threads(8);
+
+}  // namespace
+}  // namespace mediapipe
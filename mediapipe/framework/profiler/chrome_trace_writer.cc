@@ -0,0 +1,260 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/chrome_trace_writer.h"
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "mediapipe/framework/port/logging.h"
+
+namespace mediapipe {
+
+namespace {
+
+// All events are shown as belonging to a single process.
+constexpr int kProcessId = 1;
+
+// Returns "value" as a quoted JSON string.
+std::string JsonString(const std::string& value) {
+  std::string result = "\"";
+  for (char c : value) {
+    switch (c) {
+      case '"':
+        result += "\\\"";
+        break;
+      case '\\':
+        result += "\\\\";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          absl::StrAppendFormat(&result, "\\u%04x", c);
+        } else {
+          result += c;
+        }
+    }
+  }
+  result += "\"";
+  return result;
+}
+
+// Returns the display name of a calculator node.
+std::string NodeName(const GraphTrace& trace, int node_id) {
+  if (node_id >= 0 && node_id < trace.calculator_name_size()) {
+    return trace.calculator_name(node_id);
+  }
+  return absl::StrCat("node_", node_id);
+}
+
+}  // namespace
+
+constexpr int ChromeTraceWriter::kDefaultMaxPendingTraces;
+
+ChromeTraceWriter::ChromeTraceWriter(int max_pending_traces)
+    : max_pending_traces_(max_pending_traces) {
+  CHECK_GT(max_pending_traces_, 0);
+  writer_thread_ = std::thread([this] { Run(); });
+}
+
+ChromeTraceWriter::~ChromeTraceWriter() {
+  {
+    absl::MutexLock lock(&mutex_);
+    is_stopping_ = true;
+  }
+  writer_thread_.join();
+  CloseFile();
+  int64 dropped = dropped_count();
+  if (dropped > 0) {
+    LOG(WARNING) << "ChromeTraceWriter dropped " << dropped
+                 << " trace intervals that could not be written in time.";
+  }
+}
+
+bool ChromeTraceWriter::Write(const std::string& path, bool is_new_file,
+                              GraphTrace trace) {
+  absl::MutexLock lock(&mutex_);
+  if (pending_traces_.size() >= max_pending_traces_) {
+    ++dropped_count_;
+    return false;
+  }
+  pending_traces_.push_back({path, is_new_file, std::move(trace)});
+  return true;
+}
+
+void ChromeTraceWriter::Flush() {
+  absl::MutexLock lock(&mutex_);
+  auto is_idle = [this]() EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return pending_traces_.empty() && !is_writing_;
+  };
+  mutex_.Await(absl::Condition(&is_idle));
+}
+
+int64 ChromeTraceWriter::dropped_count() {
+  absl::MutexLock lock(&mutex_);
+  return dropped_count_;
+}
+
+void ChromeTraceWriter::Run() {
+  while (true) {
+    PendingTrace pending;
+    {
+      absl::MutexLock lock(&mutex_);
+      is_writing_ = false;
+      auto has_work = [this]() EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+        return !pending_traces_.empty() || is_stopping_;
+      };
+      mutex_.Await(absl::Condition(&has_work));
+      if (pending_traces_.empty()) {
+        return;
+      }
+      pending = std::move(pending_traces_.front());
+      pending_traces_.pop_front();
+      is_writing_ = true;
+    }
+    WriteTrace(pending);
+  }
+}
+
+void ChromeTraceWriter::WriteTrace(const PendingTrace& pending) {
+  std::string json;
+  if (pending.is_new_file || pending.path != file_path_) {
+    CloseFile();
+    file_.open(pending.path, std::ofstream::out | std::ofstream::trunc);
+    if (!file_.is_open()) {
+      LOG(ERROR) << "Could not open Chrome trace file: " << pending.path;
+      return;
+    }
+    file_path_ = pending.path;
+    json = "[\n";
+    AppendEvent(absl::StrCat(R"({"name":"process_name","ph":"M","pid":)",
+                             kProcessId, R"(,"args":{"name":"MediaPipe"}})"),
+                &json);
+  }
+  if (!file_.is_open()) {
+    return;
+  }
+  AppendEvents(pending.trace, &json);
+  file_ << json;
+  file_.flush();
+}
+
+void ChromeTraceWriter::AppendEvents(const GraphTrace& trace,
+                                     std::string* json) {
+  const int64 base_time = trace.base_time();
+  const int64 base_timestamp = trace.base_timestamp();
+
+  // Record the source of each packet produced in this GraphTrace.
+  previous_packet_sources_.swap(packet_sources_);
+  packet_sources_.clear();
+  for (const auto& calculator_trace : trace.calculator_trace()) {
+    const int64 time = calculator_trace.has_start_time()
+                           ? calculator_trace.start_time()
+                           : calculator_trace.finish_time();
+    for (const auto& output_trace : calculator_trace.output_trace()) {
+      PacketKey key{output_trace.stream_id(),
+                    base_timestamp + output_trace.packet_timestamp()};
+      packet_sources_[key] = {calculator_trace.thread_id(), base_time + time};
+    }
+  }
+
+  for (const auto& calculator_trace : trace.calculator_trace()) {
+    const int32 thread_id = calculator_trace.thread_id();
+    if (named_threads_.insert(thread_id).second) {
+      AppendEvent(absl::StrCat(R"({"name":"thread_name","ph":"M","pid":)",
+                               kProcessId, R"(,"tid":)", thread_id,
+                               R"(,"args":{"name":"Thread )", thread_id,
+                               R"("}})"),
+                  json);
+    }
+
+    // A slice for each calculator invocation, or an instant event for each
+    // event without both a start and a finish time.
+    const int64 start_time = base_time + calculator_trace.start_time();
+    const int64 finish_time = base_time + calculator_trace.finish_time();
+    std::string event = absl::StrCat(
+        R"({"name":)", JsonString(NodeName(trace, calculator_trace.node_id())),
+        R"(,"cat":)",
+        JsonString(GraphTrace::EventType_Name(calculator_trace.event_type())),
+        R"(,"pid":)", kProcessId, R"(,"tid":)", thread_id);
+    if (calculator_trace.has_start_time() &&
+        calculator_trace.has_finish_time()) {
+      absl::StrAppend(&event, R"(,"ph":"X","ts":)", start_time, R"(,"dur":)",
+                      finish_time - start_time);
+    } else {
+      absl::StrAppend(
+          &event, R"(,"ph":"i","s":"t","ts":)",
+          calculator_trace.has_start_time() ? start_time : finish_time);
+    }
+    if (calculator_trace.has_input_timestamp()) {
+      absl::StrAppend(&event, R"(,"args":{"input_timestamp":)",
+                      base_timestamp + calculator_trace.input_timestamp(),
+                      "}");
+    }
+    absl::StrAppend(&event, "}");
+    AppendEvent(event, json);
+
+    // A flow arrow from the producer to the consumer of each input packet.
+    if (!calculator_trace.has_start_time()) {
+      continue;
+    }
+    for (const auto& input_trace : calculator_trace.input_trace()) {
+      PacketKey key{input_trace.stream_id(),
+                    base_timestamp + input_trace.packet_timestamp()};
+      auto source = packet_sources_.find(key);
+      if (source == packet_sources_.end()) {
+        source = previous_packet_sources_.find(key);
+        if (source == previous_packet_sources_.end()) {
+          continue;
+        }
+      }
+      const int64 flow_id = next_flow_id_++;
+      std::string flow_name =
+          input_trace.stream_id() < trace.stream_name_size()
+              ? JsonString(trace.stream_name(input_trace.stream_id()))
+              : JsonString("packet");
+      AppendEvent(absl::StrCat(R"({"name":)", flow_name,
+                               R"(,"cat":"packet","ph":"s","id":)", flow_id,
+                               R"(,"pid":)", kProcessId, R"(,"tid":)",
+                               source->second.thread_id, R"(,"ts":)",
+                               source->second.time_usec, "}"),
+                  json);
+      AppendEvent(absl::StrCat(R"({"name":)", flow_name,
+                               R"(,"cat":"packet","ph":"f","bp":"e","id":)",
+                               flow_id, R"(,"pid":)", kProcessId,
+                               R"(,"tid":)", thread_id, R"(,"ts":)",
+                               start_time, "}"),
+                  json);
+    }
+  }
+}
+
+void ChromeTraceWriter::AppendEvent(const std::string& event,
+                                    std::string* json) {
+  if (file_has_events_) {
+    absl::StrAppend(json, ",\n");
+  }
+  absl::StrAppend(json, event);
+  file_has_events_ = true;
+}
+
+void ChromeTraceWriter::CloseFile() {
+  if (file_.is_open()) {
+    file_ << "\n]\n";
+    file_.close();
+  }
+  file_path_.clear();
+  file_has_events_ = false;
+  named_threads_.clear();
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,125 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PROFILER_CHROME_TRACE_WRITER_H_
+#define MEDIAPIPE_FRAMEWORK_PROFILER_CHROME_TRACE_WRITER_H_
+
+#include <deque>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+
+// Writes GraphTraces to files in the Chrome trace event JSON format, which
+// can be opened in chrome://tracing and in the Perfetto UI.
+//
+// Each calculator invocation is shown as a slice on the track of the thread
+// that ran it. Each packet passed from one calculator invocation to another
+// is shown as a flow arrow between the two slices.
+//
+// The JSON is formatted and written by a background thread. At most
+// |max_pending_traces| GraphTraces wait to be written. Further GraphTraces
+// are dropped, so that Write() never waits for the file system.
+class ChromeTraceWriter {
+ public:
+  static constexpr int kDefaultMaxPendingTraces = 16;
+
+  explicit ChromeTraceWriter(int max_pending_traces = kDefaultMaxPendingTraces);
+
+  // Writes the remaining GraphTraces and closes the current file.
+  ~ChromeTraceWriter();
+
+  ChromeTraceWriter(const ChromeTraceWriter&) = delete;
+  ChromeTraceWriter& operator=(const ChromeTraceWriter&) = delete;
+
+  // Queues a GraphTrace to be appended to the file at "path". If
+  // "is_new_file" is true, or if "path" differs from the previous path, the
+  // file is replaced. Returns false if the GraphTrace is dropped.
+  bool Write(const std::string& path, bool is_new_file, GraphTrace trace)
+      LOCKS_EXCLUDED(mutex_);
+
+  // Waits until all queued GraphTraces are written to their files.
+  void Flush() LOCKS_EXCLUDED(mutex_);
+
+  // Returns the number of GraphTraces dropped so far.
+  int64 dropped_count() LOCKS_EXCLUDED(mutex_);
+
+ private:
+  // A GraphTrace waiting to be written.
+  struct PendingTrace {
+    std::string path;
+    bool is_new_file;
+    GraphTrace trace;
+  };
+
+  // The thread and time at which a packet was produced.
+  struct PacketSource {
+    int32 thread_id;
+    int64 time_usec;
+  };
+
+  // Identifies a packet by stream id and packet timestamp.
+  using PacketKey = std::pair<int32, int64>;
+
+  // Writes queued GraphTraces until the ChromeTraceWriter is destroyed.
+  void Run() LOCKS_EXCLUDED(mutex_);
+
+  // Opens the file at "path" if needed, and appends the events of "trace".
+  void WriteTrace(const PendingTrace& pending);
+
+  // Appends the JSON trace events for "trace" to "json".
+  void AppendEvents(const GraphTrace& trace, std::string* json);
+
+  // Appends one JSON trace event to "json".
+  void AppendEvent(const std::string& event, std::string* json);
+
+  // Terminates the JSON array and closes the current file.
+  void CloseFile();
+
+  const int max_pending_traces_;
+
+  absl::Mutex mutex_;
+  std::deque<PendingTrace> pending_traces_ GUARDED_BY(mutex_);
+  // True while the writer thread is writing a GraphTrace.
+  bool is_writing_ GUARDED_BY(mutex_) = false;
+  bool is_stopping_ GUARDED_BY(mutex_) = false;
+  int64 dropped_count_ GUARDED_BY(mutex_) = 0;
+
+  // The following are accessed only by the writer thread.
+  std::ofstream file_;
+  std::string file_path_;
+  bool file_has_events_ = false;
+  // The threads named so far in the current file.
+  std::set<int32> named_threads_;
+  // The sources of the packets in the current and previous GraphTrace, so
+  // that packets consumed in the next GraphTrace still get flow arrows.
+  std::map<PacketKey, PacketSource> packet_sources_;
+  std::map<PacketKey, PacketSource> previous_packet_sources_;
+  int64 next_flow_id_ = 0;
+
+  std::thread writer_thread_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PROFILER_CHROME_TRACE_WRITER_H_
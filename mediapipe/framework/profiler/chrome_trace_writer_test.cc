@@ -0,0 +1,153 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/chrome_trace_writer.h"
+
+#include <cstdlib>
+#include <string>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+// A trace in which node 0 on thread 1 produces a packet on stream 1,
+// which node 1 on thread 2 consumes.
+GraphTrace MakeTrace() {
+  return ParseTextProtoOrDie<GraphTrace>(R"(
+    base_time: 1000000
+    base_timestamp: 100
+    calculator_name: "Source"
+    calculator_name: "Sink \"1\""
+    stream_name: ""
+    stream_name: "packets"
+    calculator_trace {
+      node_id: 0
+      input_timestamp: 0
+      event_type: PROCESS
+      start_time: 10
+      finish_time: 15
+      output_trace { packet_timestamp: 0 stream_id: 1 }
+      thread_id: 1
+    }
+    calculator_trace {
+      node_id: 1
+      input_timestamp: 0
+      event_type: PROCESS
+      start_time: 20
+      finish_time: 30
+      input_trace {
+        start_time: 15
+        finish_time: 20
+        packet_timestamp: 0
+        stream_id: 1
+      }
+      thread_id: 2
+    }
+    calculator_trace {
+      node_id: 1
+      input_timestamp: 10
+      event_type: NOT_READY
+      start_time: 40
+      thread_id: 2
+    }
+  )");
+}
+
+std::string ReadFile(const std::string& path) {
+  std::string contents;
+  MEDIAPIPE_EXPECT_OK(file::GetContents(path, &contents));
+  return contents;
+}
+
+TEST(ChromeTraceWriterTest, WritesSlicesAndFlows) {
+  std::string path =
+      absl::StrCat(getenv("TEST_TMPDIR"), "/chrome_trace_writer_test.json");
+  {
+    ChromeTraceWriter writer;
+    EXPECT_TRUE(writer.Write(path, /*is_new_file=*/true, MakeTrace()));
+    writer.Flush();
+    std::string contents = ReadFile(path);
+    EXPECT_TRUE(absl::StartsWith(contents, "[\n")) << contents;
+    EXPECT_TRUE(absl::StrContains(
+        contents,
+        R"({"name":"thread_name","ph":"M","pid":1,"tid":2,)"
+        R"("args":{"name":"Thread 2"}})"))
+        << contents;
+    EXPECT_TRUE(absl::StrContains(
+        contents,
+        R"({"name":"Source","cat":"PROCESS","pid":1,"tid":1,"ph":"X",)"
+        R"("ts":1000010,"dur":5,"args":{"input_timestamp":100}})"))
+        << contents;
+    EXPECT_TRUE(absl::StrContains(
+        contents,
+        R"({"name":"Sink \"1\"","cat":"NOT_READY","pid":1,"tid":2,)"
+        R"("ph":"i","s":"t","ts":1000040,"args":{"input_timestamp":110}})"))
+        << contents;
+    EXPECT_TRUE(absl::StrContains(
+        contents,
+        R"({"name":"packets","cat":"packet","ph":"s","id":0,"pid":1,)"
+        R"("tid":1,"ts":1000010})"))
+        << contents;
+    EXPECT_TRUE(absl::StrContains(
+        contents,
+        R"({"name":"packets","cat":"packet","ph":"f","bp":"e","id":0,)"
+        R"("pid":1,"tid":2,"ts":1000020})"))
+        << contents;
+    EXPECT_EQ(0, writer.dropped_count());
+  }
+  // The JSON array is terminated when the writer is destroyed.
+  EXPECT_TRUE(absl::EndsWith(ReadFile(path), "}\n]\n"));
+}
+
+// Packets produced in one GraphTrace and consumed in the next one are still
+// connected by flow arrows.
+TEST(ChromeTraceWriterTest, ConnectsFlowsAcrossTraces) {
+  std::string path =
+      absl::StrCat(getenv("TEST_TMPDIR"), "/chrome_trace_writer_flows.json");
+  GraphTrace producer = MakeTrace();
+  producer.mutable_calculator_trace()->DeleteSubrange(1, 2);
+  GraphTrace consumer = MakeTrace();
+  consumer.mutable_calculator_trace()->DeleteSubrange(0, 1);
+  ChromeTraceWriter writer;
+  writer.Write(path, /*is_new_file=*/true, producer);
+  writer.Write(path, /*is_new_file=*/false, consumer);
+  writer.Flush();
+  std::string contents = ReadFile(path);
+  EXPECT_TRUE(absl::StrContains(contents, R"("ph":"s","id":0)")) << contents;
+  EXPECT_TRUE(absl::StrContains(contents, R"("ph":"f","bp":"e","id":0)"))
+      << contents;
+}
+
+TEST(ChromeTraceWriterTest, StartsNewFile) {
+  std::string path =
+      absl::StrCat(getenv("TEST_TMPDIR"), "/chrome_trace_writer_new.json");
+  ChromeTraceWriter writer;
+  writer.Write(path, /*is_new_file=*/true, MakeTrace());
+  writer.Write(path, /*is_new_file=*/true, GraphTrace());
+  writer.Flush();
+  EXPECT_EQ(
+      "[\n"
+      R"({"name":"process_name","ph":"M","pid":1,"args":{"name":"MediaPipe"}})",
+      ReadFile(path));
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -16,10 +16,12 @@
 
 #include <fstream>
 #include <list>
+#include <map>
 
 #include "absl/strings/substitute.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
+#include "mediapipe/framework/input_stream_manager.h"
 #include "mediapipe/framework/port/advanced_proto_lite_inc.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/logging.h"
@@ -43,6 +45,17 @@ const char kDefaultLogFilePrefix[] = "mediapipe_trace_";
 // The number of recent timestamps tracked for each input stream.
 const int kPacketInfoRecentCount = 100;
 
+// The number of copies of the histogram counters of each calculator.
+const int kNumCounterShards = 8;
+
+// Returns the counter shard used by the calling thread.
+int GetCounterShard() {
+  static std::atomic<int> next_shard(0);
+  static thread_local int shard =
+      next_shard.fetch_add(1, std::memory_order_relaxed) % kNumCounterShards;
+  return shard;
+}
+
 std::string PacketIdToString(const PacketId& packet_id) {
   return absl::Substitute("stream_name: $0, timestamp_usec: $1",
                           packet_id.stream_name, packet_id.timestamp_usec);
@@ -130,6 +143,10 @@ void GraphProfiler::Initialize(
   if (IsTracerEnabled(profiler_config_)) {
     packet_tracer_ = absl::make_unique<GraphTracer>(profiler_config_);
   }
+  if (IsTraceLogEnabled(profiler_config_) &&
+      profiler_config_.trace_log_format() == ProfilerConfig::CHROME_JSON) {
+    chrome_trace_writer_ = absl::make_unique<ChromeTraceWriter>();
+  }
   for (int node_id = 0;
        node_id < validated_graph_config.CalculatorInfos().size(); ++node_id) {
     std::string node_name =
@@ -151,10 +168,23 @@ void GraphProfiler::Initialize(
                              &profile);
     }
 
+    node_ids_[node_name] = node_id;
     auto iter = calculator_profiles_.insert({node_name, profile});
     CHECK(iter.second) << absl::Substitute(
         "Calculator \"$0\" has already been added.", node_name);
   }
+  profile_counters_.resize(kNumCounterShards);
+  profile_distributions_.resize(node_ids_.size());
+  for (auto& entry : calculator_profiles_) {
+    const int node_id = node_ids_[entry.first];
+    profile_distributions_[node_id] =
+        absl::make_unique<CalculatorProfileDistributions>(entry.second);
+    for (auto& shard : profile_counters_) {
+      shard.resize(node_ids_.size());
+      shard[node_id] = absl::make_unique<CalculatorProfileCounters>(
+          entry.second, profile_distributions_[node_id].get());
+    }
+  }
   is_initialized_ = true;
 }
 
@@ -180,17 +210,14 @@ void GraphProfiler::Resume() {
 
 void GraphProfiler::Reset() {
   absl::WriterMutexLock lock(&profiler_mutex_);
-  for (auto iter = calculator_profiles_.begin();
-       iter != calculator_profiles_.end(); ++iter) {
-    CalculatorProfile* calculator_profile = &iter->second;
-    ResetTimeHistogram(calculator_profile->mutable_process_runtime());
-    ResetTimeHistogram(calculator_profile->mutable_process_input_latency());
-    ResetTimeHistogram(calculator_profile->mutable_process_output_latency());
-    for (auto& input_stream_profile :
-         *(calculator_profile->mutable_input_stream_profiles())) {
-      ResetTimeHistogram(input_stream_profile.mutable_latency());
+  for (auto& shard : profile_counters_) {
+    for (auto& counters : shard) {
+      counters->Reset();
     }
   }
+  for (auto& distributions : profile_distributions_) {
+    distributions->Reset();
+  }
 }
 
 // Begins profiling for a single graph run.
@@ -200,11 +227,15 @@ void GraphProfiler::Reset() {
   if (is_tracing_ && IsTraceIntervalEnabled(profiler_config_, tracer()) &&
       executor != nullptr) {
     is_running_ = true;
-    executor->Schedule([this] {
+    // The task holds a reference to the profiler, since the executor can
+    // outlive the graph, and the task can still be sleeping after Stop().
+    std::shared_ptr<ProfilingContext> self = shared_from_this();
+    executor->Schedule([this, self] {
       absl::Time deadline = clock_->TimeNow() + tracer()->GetTraceLogInterval();
       while (is_running_) {
         clock_->SleepUntil(deadline);
         deadline = clock_->TimeNow() + tracer()->GetTraceLogInterval();
+        absl::MutexLock lock(&periodic_output_mutex_);
         if (is_running_) {
           WriteProfile().IgnoreError();
         }
@@ -216,12 +247,19 @@ void GraphProfiler::Reset() {
 
 // Ends profiling for a single graph run.
 ::mediapipe::Status GraphProfiler::Stop() {
-  is_running_ = false;
+  {
+    // Waits for any periodic profile output, which reads the graph.
+    absl::MutexLock lock(&periodic_output_mutex_);
+    is_running_ = false;
+  }
   Pause();
   // If specified, write a final profile.
   if (IsTraceLogEnabled(profiler_config_)) {
     RETURN_IF_ERROR(WriteProfile());
   }
+  if (chrome_trace_writer_) {
+    chrome_trace_writer_->Flush();
+  }
   return ::mediapipe::OkStatus();
 }
 
@@ -279,10 +317,69 @@ void GraphProfiler::AddPacketInfo(const TraceEvent& packet_info) {
       << "GetCalculatorProfiles can only be called after Initialize()";
   for (auto& entry : calculator_profiles_) {
     profiles->push_back(entry.second);
+    int node_id = node_ids_.at(entry.first);
+    for (const auto& shard : profile_counters_) {
+      shard[node_id]->AddTo(&profiles->back());
+    }
+    profile_distributions_[node_id]->AddTo(&profiles->back());
+  }
+  if (input_stream_managers_ != nullptr) {
+    AddQueueStats(profiles);
   }
   return ::mediapipe::OkStatus();
 }
 
+void GraphProfiler::SetInputStreamManagers(
+    const InputStreamManager* input_stream_managers) {
+  absl::WriterMutexLock lock(&profiler_mutex_);
+  input_stream_managers_ = input_stream_managers;
+}
+
+void GraphProfiler::AddQueueStats(
+    std::vector<CalculatorProfile>* profiles) const {
+  std::map<std::string, CalculatorProfile*> profiles_by_name;
+  for (CalculatorProfile& profile : *profiles) {
+    profiles_by_name[profile.name()] = &profile;
+  }
+  const auto& input_stream_infos = validated_graph_->InputStreamInfos();
+  for (int index = 0; index < input_stream_infos.size(); ++index) {
+    const EdgeInfo& edge_info = input_stream_infos[index];
+    if (edge_info.parent_node.type != NodeTypeInfo::NodeType::CALCULATOR) {
+      continue;
+    }
+    auto iter = profiles_by_name.find(CanonicalNodeName(
+        validated_graph_->Config(), edge_info.parent_node.index));
+    if (iter == profiles_by_name.end()) {
+      continue;
+    }
+    CalculatorProfile* calculator_profile = iter->second;
+    StreamProfile* stream_profile = nullptr;
+    for (StreamProfile& profile :
+         *calculator_profile->mutable_input_stream_profiles()) {
+      if (profile.name() == edge_info.name) {
+        stream_profile = &profile;
+        break;
+      }
+    }
+    if (stream_profile == nullptr) {
+      stream_profile = calculator_profile->add_input_stream_profiles();
+      stream_profile->set_name(edge_info.name);
+      stream_profile->set_back_edge(edge_info.back_edge);
+    }
+    const InputStreamManager& stream = input_stream_managers_[index];
+    InputStreamManager::QueueStats stats = stream.GetQueueStats();
+    QueueSizeHistogram* queue_size = stream_profile->mutable_queue_size();
+    queue_size->mutable_count()->Clear();
+    for (int64 count : stats.queue_size_counts) {
+      queue_size->add_count(count);
+    }
+    queue_size->set_max(stats.max_queue_size_seen);
+    stream_profile->set_max_queue_size(stream.MaxQueueSize());
+    stream_profile->set_throttled_count(stats.throttled_count);
+    stream_profile->set_throttled_time_usec(stats.throttled_time_ns / 1000);
+  }
+}
+
 void GraphProfiler::InitializeTimeHistogram(int64 interval_size_usec,
                                             int64 num_intervals,
                                             TimeHistogram* histogram) {
@@ -366,10 +463,10 @@ void GraphProfiler::AddPacketInfoForOutputPackets(
 
 int64 GraphProfiler::AddStreamLatencies(
     const CalculatorContext& calculator_context, int64 start_time_usec,
-    int64 end_time_usec, CalculatorProfile* calculator_profile) {
+    int64 end_time_usec, CalculatorProfileCounters* counters) {
   // Update input streams profiles.
   int64 min_source_process_start_usec = AddInputStreamTimeSamples(
-      calculator_context, start_time_usec, calculator_profile);
+      calculator_context, start_time_usec, counters);
 
   // Update output production times.
   AddPacketInfoForOutputPackets(calculator_context.Outputs(), end_time_usec,
@@ -395,7 +492,7 @@ void GraphProfiler::SetOpenRuntime(const CalculatorContext& calculator_context,
 
   if (profiler_config_.enable_stream_latency()) {
     AddStreamLatencies(calculator_context, start_time_usec, end_time_usec,
-                       calculator_profile);
+                       GetProfileCounters(calculator_context));
   }
 }
 
@@ -417,7 +514,7 @@ void GraphProfiler::SetCloseRuntime(const CalculatorContext& calculator_context,
 
   if (profiler_config_.enable_stream_latency()) {
     AddStreamLatencies(calculator_context, start_time_usec, end_time_usec,
-                       calculator_profile);
+                       GetProfileCounters(calculator_context));
   }
 }
 
@@ -435,16 +532,17 @@ void GraphProfiler::AddTimeSample(int64 start_time_usec, int64 end_time_usec,
 
 int64 GraphProfiler::AddInputStreamTimeSamples(
     const CalculatorContext& calculator_context, int64 start_time_usec,
-    CalculatorProfile* calculator_profile) {
+    CalculatorProfileCounters* counters) {
   int64 input_timestamp_usec = calculator_context.InputTimestamp().Value();
   int64 min_source_process_start_usec = start_time_usec;
   int64 input_stream_counter = -1;
   for (CollectionItemId id = calculator_context.Inputs().BeginId();
        id < calculator_context.Inputs().EndId(); ++id) {
     ++input_stream_counter;
+    DurationCounters* latency =
+        counters->input_stream_latency[input_stream_counter].get();
     if (calculator_context.Inputs().Get(id).Value().IsEmpty() ||
-        calculator_profile->input_stream_profiles(input_stream_counter)
-            .back_edge()) {
+        latency == nullptr) {
       continue;
     }
 
@@ -459,10 +557,8 @@ int64 GraphProfiler::AddInputStreamTimeSamples(
                                 << PacketIdToString(packet_id);
       continue;
     }
-    AddTimeSample(
-        packet_info->production_time_usec, start_time_usec,
-        calculator_profile->mutable_input_stream_profiles(input_stream_counter)
-            ->mutable_latency());
+    AddTimeSample(packet_info->production_time_usec, start_time_usec,
+                  latency);
 
     min_source_process_start_usec = std::min(
         min_source_process_start_usec, packet_info->source_process_start_usec);
@@ -471,33 +567,40 @@ int64 GraphProfiler::AddInputStreamTimeSamples(
   return min_source_process_start_usec;
 }
 
+void GraphProfiler::AddTimeSample(int64 start_time_usec, int64 end_time_usec,
+                                  DurationCounters* counters) {
+  CHECK_GE(end_time_usec, start_time_usec);
+  counters->AddSample(end_time_usec - start_time_usec);
+}
+
+CalculatorProfileCounters* GraphProfiler::GetProfileCounters(
+    const CalculatorContext& calculator_context) {
+  int node_id = calculator_context.NodeId();
+  CHECK(0 <= node_id && node_id < node_ids_.size()) << absl::Substitute(
+      "Calculator \"$0\" has not been added during initialization.",
+      calculator_context.NodeName());
+  return profile_counters_[GetCounterShard()][node_id].get();
+}
+
 void GraphProfiler::AddProcessSample(
     const CalculatorContext& calculator_context, int64 start_time_usec,
     int64 end_time_usec) {
-  absl::ReaderMutexLock lock(&profiler_mutex_);
   if (!is_profiling_) {
     return;
   }
-
-  const std::string& node_name = calculator_context.NodeName();
-  auto profile_iter = calculator_profiles_.find(node_name);
-  CHECK(profile_iter != calculator_profiles_.end()) << absl::Substitute(
-      "Calculator \"$0\" has not been added during initialization.",
-      calculator_context.NodeName());
-  CalculatorProfile* calculator_profile = &profile_iter->second;
+  CalculatorProfileCounters* counters = GetProfileCounters(calculator_context);
 
   // Update Process() runtime.
-  AddTimeSample(start_time_usec, end_time_usec,
-                calculator_profile->mutable_process_runtime());
+  AddTimeSample(start_time_usec, end_time_usec, &counters->process_runtime);
 
   if (profiler_config_.enable_stream_latency()) {
     int64 min_source_process_start_usec = AddStreamLatencies(
-        calculator_context, start_time_usec, end_time_usec, calculator_profile);
+        calculator_context, start_time_usec, end_time_usec, counters);
     // Update input and output trace latencies.
     AddTimeSample(min_source_process_start_usec, start_time_usec,
-                  calculator_profile->mutable_process_input_latency());
+                  counters->process_input_latency.get());
     AddTimeSample(min_source_process_start_usec, end_time_usec,
-                  calculator_profile->mutable_process_output_latency());
+                  counters->process_output_latency.get());
   }
 }
 
@@ -592,6 +695,24 @@ void AssignNodeNames(GraphProfile* profile) {
     tracer()->GetLog(previous_log_end_time_, end_time, trace);
   }
   previous_log_end_time_ = end_time;
+  bool is_new_file = (previous_log_index_ % log_interval_count == 0);
+  int log_index = previous_log_index_ / log_interval_count % log_file_count;
+
+  // Queue the GraphTrace to be written as Chrome trace event JSON.
+  // If too many GraphTraces are queued, the ChromeTraceWriter drops this one
+  // and reports it when it is destroyed.
+  if (chrome_trace_writer_) {
+    for (int i = 0; i < validated_graph_->Config().node().size(); ++i) {
+      trace->add_calculator_name(
+          CanonicalNodeName(validated_graph_->Config(), i));
+    }
+    std::string log_path = absl::StrCat(trace_log_path, log_index, ".json");
+    chrome_trace_writer_->Write(log_path, is_new_file, std::move(*trace));
+    // CalculatorProfiles are not written, but each interval still starts
+    // from zero, as it does for the binary format.
+    this->Reset();
+    return ::mediapipe::OkStatus();
+  }
 
   // Record the latest CalculatorProfiles.
   Status status;
@@ -603,14 +724,12 @@ void AssignNodeNames(GraphProfile* profile) {
   this->Reset();
 
   // Record the CalculatorGraphConfig, once per log file.
-  bool is_new_file = (previous_log_index_ % log_interval_count == 0);
   if (is_new_file) {
     *profile.mutable_config() = validated_graph_->Config();
     AssignNodeNames(&profile);
   }
 
   // Write the GraphProfile to the trace_log_path.
-  int log_index = previous_log_index_ / log_interval_count % log_file_count;
   std::string log_path = absl::StrCat(trace_log_path, log_index, ".binarypb");
   std::ofstream ofs;
   if (is_new_file) {
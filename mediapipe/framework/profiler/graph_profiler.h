@@ -17,9 +17,11 @@
 
 #include <atomic>
 #include <cstddef>
+#include <list>
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "absl/time/time.h"
@@ -30,6 +32,8 @@
 #include "mediapipe/framework/deps/monotonic_clock.h"
 #include "mediapipe/framework/executor.h"
 #include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/profiler/calculator_profile_counters.h"
+#include "mediapipe/framework/profiler/chrome_trace_writer.h"
 #include "mediapipe/framework/profiler/graph_tracer.h"
 #include "mediapipe/framework/profiler/sharded_map.h"
 #include "mediapipe/framework/validated_graph_config.h"
@@ -37,6 +41,7 @@
 namespace mediapipe {
 
 class GlProfilingHelper;
+class InputStreamManager;
 
 struct PacketId {
   // Stream name, excluding TAG if available.
@@ -105,7 +110,8 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
         is_running_(false),
         previous_log_end_time_(absl::InfinitePast()),
         previous_log_index_(-1),
-        validated_graph_(nullptr) {
+        validated_graph_(nullptr),
+        input_stream_managers_(nullptr) {
     clock_ = std::shared_ptr<mediapipe::Clock>(
         mediapipe::MonotonicClock::CreateSynchronizedMonotonicClock());
   }
@@ -147,9 +153,17 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // Record a tracing event.
   void LogEvent(const TraceEvent& event);
 
+  // Sets the input streams of the graph, indexed like the InputStreamInfos()
+  // of the ValidatedGraphConfig. Their queue statistics are added to the
+  // input stream profiles returned by GetCalculatorProfiles(). The input
+  // streams must outlive the profiler.
+  void SetInputStreamManagers(const InputStreamManager* input_stream_managers)
+      LOCKS_EXCLUDED(profiler_mutex_);
+
   // Collects the runtime profile for Open(), Process(), and Close() of each
   // calculator in the graph. May be called at any time after the graph has been
-  // initialized.
+  // initialized. If input streams were set, the input stream profiles also
+  // report the queue sizes and throttling of the current or last graph run.
   ::mediapipe::Status GetCalculatorProfiles(
       std::vector<CalculatorProfile>*) const LOCKS_EXCLUDED(profiler_mutex_);
 
@@ -242,6 +256,8 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // Add a sample to a time histogram.
   static void AddTimeSample(int64 start_time_usec, int64 end_time_usec,
                             TimeHistogram* histogram);
+  static void AddTimeSample(int64 start_time_usec, int64 end_time_usec,
+                            DurationCounters* counters);
 
   // Add output streams to the stream consumer count map.
   // This is neeeded in case an output stream is not consumed by any calculator.
@@ -254,6 +270,9 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   void InitializeInputStreams(const CalculatorGraphConfig::Node& node_config,
                               int64 interval_size_usec, int64 num_intervals,
                               CalculatorProfile* calculator_profile);
+  // Adds the queue statistics of the input streams to "profiles".
+  void AddQueueStats(std::vector<CalculatorProfile>* profiles) const
+      SHARED_LOCKS_REQUIRED(profiler_mutex_);
   // Returns the input stream back edges for a calculator.
   std::set<int> GetBackEdgeIds(const CalculatorGraphConfig::Node& node_config,
                                const tool::TagMap& input_tag_map);
@@ -269,7 +288,7 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // Updates the production time for outputs and the stream profile for inputs.
   int64 AddStreamLatencies(const CalculatorContext& calculator_context,
                            int64 start_time_usec, int64 end_time_usec,
-                           CalculatorProfile* calculator_profile);
+                           CalculatorProfileCounters* counters);
 
   void SetOpenRuntime(const CalculatorContext& calculator_context,
                       int64 start_time_usec, int64 end_time_usec)
@@ -283,13 +302,16 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // packets and back-edge packets. Returns -1 if there is no input packets.
   int64 AddInputStreamTimeSamples(const CalculatorContext& calculator_context,
                                   int64 start_time_usec,
-                                  CalculatorProfile* calculator_profile);
+                                  CalculatorProfileCounters* counters);
 
   // Updates the Process() data for calculator.
-  // Requires ReaderLock for is_profiling_.
+  // Does not lock profiler_mutex_, since it only updates atomic counters.
   void AddProcessSample(const CalculatorContext& calculator_context,
-                        int64 start_time_usec, int64 end_time_usec)
-      LOCKS_EXCLUDED(profiler_mutex_);
+                        int64 start_time_usec, int64 end_time_usec);
+
+  // Returns the histogram counters of a calculator for the calling thread.
+  CalculatorProfileCounters* GetProfileCounters(
+      const CalculatorContext& calculator_context);
 
   // Helper method to get trace_log_path.  If the trace_log_path is empty and
   // tracing is enabled, this function returns a default platform dependent
@@ -313,8 +335,26 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   std::atomic_bool is_tracing_;
 
   // Stores all the calculator profiles with the calculator name as the key.
+  // The histograms in these profiles are empty. Their samples are recorded
+  // in |profile_counters_| and |profile_distributions_|, and added only by
+  // GetCalculatorProfiles().
   using CalculatorProfileMap = ShardedMap<std::string, CalculatorProfile>;
   CalculatorProfileMap calculator_profiles_;
+
+  // The histogram counters of each calculator, indexed by counter shard and
+  // by node id. Each thread adds samples to a single counter shard, so that
+  // threads rarely update the same counters.
+  std::vector<std::vector<std::unique_ptr<CalculatorProfileCounters>>>
+      profile_counters_;
+
+  // The latency distribution counters of each calculator, indexed by node id
+  // and shared by all counter shards, since each holds kNumLatencyBuckets
+  // counters per histogram.
+  std::vector<std::unique_ptr<CalculatorProfileDistributions>>
+      profile_distributions_;
+
+  // The node id of each calculator, indexed by canonical name.
+  std::unordered_map<std::string, int> node_ids_;
   // Stores the production time of a packet, based on profiler's clock.
   using PacketInfoMap =
       ShardedMap<std::string, std::list<std::pair<int64, PacketInfo>>>;
@@ -332,15 +372,27 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // Inidicates that profiling has started and not yet stopped.
   std::atomic_bool is_running_;
 
+  // Held while the periodic profile output writes a profile, so that Stop()
+  // returns only once no periodic output is in progress.
+  absl::Mutex periodic_output_mutex_;
+
   // The end time of the previous output log.
   absl::Time previous_log_end_time_;
 
   // The index number of the previous output log.
   int previous_log_index_;
 
+  // Writes the trace log in the background, if the trace_log_format is
+  // CHROME_JSON.
+  std::unique_ptr<ChromeTraceWriter> chrome_trace_writer_;
+
   // The configuration for the graph being profiled.
   const ValidatedGraphConfig* validated_graph_;
 
+  // The input streams of the graph being profiled, if set.
+  const InputStreamManager* input_stream_managers_
+      GUARDED_BY(profiler_mutex_);
+
   // For testing.
   friend GraphProfilerTestPeer;
 };
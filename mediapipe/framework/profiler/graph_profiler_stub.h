@@ -35,6 +35,7 @@ class Packet;
 class Clock;
 class GraphTracer;
 class GlProfilingHelper;
+class InputStreamManager;
 
 class TraceEvent {
  public:
@@ -78,6 +79,8 @@ class GraphProfilerStub {
   inline void Initialize(const ValidatedGraphConfig& validated_graph_config) {}
   inline void SetClock(const std::shared_ptr<mediapipe::Clock>& clock) {}
   inline void LogEvent(const TraceEvent& event) {}
+  inline void SetInputStreamManagers(
+      const InputStreamManager* input_stream_managers) {}
   inline ::mediapipe::Status GetCalculatorProfiles(
       std::vector<CalculatorProfile>*) const {
     return mediapipe::OkStatus();
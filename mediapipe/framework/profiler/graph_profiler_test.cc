@@ -1002,7 +1002,7 @@ TEST_F(GraphProfilerTestPeer, AddProcessSampleWithStreamLatency) {
             expected_packet_info);
 
   // Run process for consumer calculator and checks its profile.
-  TestContextBuilder consumer_context("consumer_calc", /*node_id=*/0,
+  TestContextBuilder consumer_context("consumer_calc", /*node_id=*/1,
                                       {"stream_0", "stream_1"}, {});
   consumer_context.AddInputs(
       {Packet(), MakePacket<std::string>("15").At(Timestamp(100))});
@@ -1113,5 +1113,56 @@ TEST(GraphProfilerTest, ParallelReads) {
   EXPECT_EQ(1001, out_1_packets.size());
 }
 
+// The input stream profiles report the queue sizes and throttling of the
+// input streams, even without enable_stream_latency.
+TEST(GraphProfilerTest, QueueStats) {
+  CalculatorGraphConfig config;
+  QCHECK(proto2::TextFormat::ParseFromString(R"(
+    profiler_config {
+     enable_profiler: true
+    }
+    input_stream: "in"
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "in"
+      output_stream: "out"
+    }
+    max_queue_size: 2
+    queue_size_budget: 8
+    executor { type: "ApplicationThreadExecutor" }
+    )",
+                                             &config));
+  CalculatorGraph graph;
+  ASSERT_OK(graph.Initialize(config));
+  graph.SetGraphInputStreamAddMode(
+      CalculatorGraph::GraphInputStreamAddMode::ADD_IF_NOT_FULL);
+  ASSERT_OK(graph.StartRun({}));
+  // Nothing runs before WaitUntilDone(), so the queue of "in" grows from 2 to
+  // 4 to 8 packets within the budget, and throttles the graph input only when
+  // it becomes full at 8 packets.
+  for (int i = 0; i < 8; ++i) {
+    ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  ASSERT_OK(graph.CloseAllInputStreams());
+  ASSERT_OK(graph.WaitUntilDone());
+
+  std::vector<CalculatorProfile> profiles;
+  ASSERT_OK(graph.profiler()->GetCalculatorProfiles(&profiles));
+  ASSERT_EQ(1, profiles.size());
+  ASSERT_EQ(1, profiles[0].input_stream_profiles_size());
+  const StreamProfile& stream_profile = profiles[0].input_stream_profiles(0);
+  EXPECT_EQ("in", stream_profile.name());
+  EXPECT_EQ(8, stream_profile.max_queue_size());
+  EXPECT_EQ(8, stream_profile.queue_size().max());
+  EXPECT_EQ(1, stream_profile.queue_size().count(0));  // Queue size 1.
+  EXPECT_EQ(7, stream_profile.queue_size().count(1) +
+                   stream_profile.queue_size().count(2) +
+                   stream_profile.queue_size().count(3));
+  EXPECT_EQ(1, stream_profile.queue_size().count(3));  // Queue size 8.
+  EXPECT_EQ(1, stream_profile.throttled_count());
+  EXPECT_LE(0, stream_profile.throttled_time_usec());
+}
+
 }  // namespace
 }  // namespace mediapipe
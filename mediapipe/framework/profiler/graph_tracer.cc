@@ -14,6 +14,12 @@
 
 #include "mediapipe/framework/profiler/graph_tracer.h"
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
 #include "absl/time/time.h"
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/calculator_profile.pb.h"
@@ -31,11 +37,55 @@ const absl::Duration kDefaultTraceLogInterval = absl::Milliseconds(500);
 
 // Returns a unique identifier for the current thread.
 inline int GetCurrentThreadId() {
-  static int next_thread_id = 0;
+  static std::atomic<int> next_thread_id(0);
   static thread_local int thread_id = next_thread_id++;
   return thread_id;
 }
 
+// Returns a unique identifier for a new GraphTracer.
+int64 NewTracerId() {
+  static std::atomic<int64> next_tracer_id(0);
+  return next_tracer_id++;
+}
+
+// The trace blocks that the current thread is logging to, one for each
+// TraceBlockPool. The blocks are released when the thread exits.
+class ThreadTraceBlocks {
+ public:
+  ~ThreadTraceBlocks() {
+    for (const Entry& entry : entries_) {
+      if (std::shared_ptr<TraceBlockPool> pool = entry.pool.lock()) {
+        pool->ReleaseBlock(entry.block);
+      }
+    }
+  }
+
+  // Returns the block of this thread from "pool", or nullptr.
+  TraceBlock** Get(const std::shared_ptr<TraceBlockPool>& pool) {
+    // Forget the blocks of destroyed pools.
+    entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                  [](const Entry& entry) {
+                                    return entry.pool.expired();
+                                  }),
+                   entries_.end());
+    for (Entry& entry : entries_) {
+      if (entry.pool_ptr == pool.get()) {
+        return &entry.block;
+      }
+    }
+    entries_.push_back({pool, pool.get(), nullptr});
+    return &entries_.back().block;
+  }
+
+ private:
+  struct Entry {
+    std::weak_ptr<TraceBlockPool> pool;
+    const TraceBlockPool* pool_ptr;
+    TraceBlock* block;
+  };
+  std::vector<Entry> entries_;
+};
+
 }  // namespace
 
 absl::Duration GraphTracer::GetTraceLogInterval() {
@@ -51,19 +101,39 @@ int64 GraphTracer::GetTraceLogCapacity() {
 }
 
 GraphTracer::GraphTracer(const ProfilerConfig& profiler_config)
-    : profiler_config_(profiler_config), trace_buffer_(GetTraceLogCapacity()) {
+    : profiler_config_(profiler_config),
+      tracer_id_(NewTracerId()),
+      block_pool_(std::make_shared<TraceBlockPool>(GetTraceLogCapacity())) {
   event_types_disabled_.resize(static_cast<int>(GraphTrace::EventType_MAX + 1));
   for (int32 event_type : profiler_config_.trace_event_types_disabled()) {
     event_types_disabled_[event_type] = true;
   }
 }
 
+// The trace block last used by this thread, and the id of its tracer.
+static thread_local int64 cached_tracer_id = -1;
+static thread_local TraceBlock* cached_block = nullptr;
+
 void GraphTracer::LogEvent(TraceEvent event) {
   if (event_types_disabled_[static_cast<int>(event.event_type)]) {
     return;
   }
-  event.set_thread_id(GetCurrentThreadId());
-  trace_buffer_.push_back(event);
+  TraceBlock* block = cached_block;
+  if (cached_tracer_id != tracer_id_ || block->full()) {
+    block = GetThreadTraceBlock();
+  }
+  block->push_back(event, GetCurrentThreadId());
+}
+
+TraceBlock* GraphTracer::GetThreadTraceBlock() {
+  static thread_local ThreadTraceBlocks thread_blocks;
+  TraceBlock** block = thread_blocks.Get(block_pool_);
+  if (*block == nullptr || (*block)->full()) {
+    *block = block_pool_->NextBlock(*block);
+  }
+  cached_tracer_id = tracer_id_;
+  cached_block = *block;
+  return *block;
 }
 
 void GraphTracer::LogInputEvents(GraphTrace::EventType event_type,
@@ -109,22 +179,37 @@ void GraphTracer::LogOutputEvents(GraphTrace::EventType event_type,
 }
 
 Timestamp GraphTracer::TimestampAfter(absl::Time begin_time) {
-  return TraceBuilder::TimestampAfter(trace_buffer_, begin_time);
+  return TraceBuilder::TimestampAfter(*GetTraceBuffer(), begin_time);
 }
 
 void GraphTracer::GetTrace(absl::Time begin_time, absl::Time end_time,
                            GraphTrace* result) {
-  trace_builder_.CreateTrace(trace_buffer_, begin_time, end_time, result);
+  trace_builder_.CreateTrace(*GetTraceBuffer(), begin_time, end_time, result);
   trace_builder_.Clear();
 }
 
 void GraphTracer::GetLog(absl::Time begin_time, absl::Time end_time,
                          GraphTrace* result) {
-  trace_builder_.CreateLog(trace_buffer_, begin_time, end_time, result);
+  trace_builder_.CreateLog(*GetTraceBuffer(), begin_time, end_time, result);
   trace_builder_.Clear();
 }
 
-const TraceBuffer& GraphTracer::GetTraceBuffer() { return trace_buffer_; }
+std::unique_ptr<TraceBuffer> GraphTracer::GetTraceBuffer() {
+  std::vector<TraceEventRecord> records;
+  block_pool_->GetRecords(&records);
+  std::sort(records.begin(), records.end());
+  // Extra blocks of concurrently logging threads can hold more events.
+  const size_t capacity = GetTraceLogCapacity();
+  if (records.size() > capacity) {
+    records.erase(records.begin(), records.end() - capacity);
+  }
+  auto result = absl::make_unique<TraceBuffer>(
+      std::max<size_t>(records.size(), 1), /*buffer_margin=*/0);
+  for (const TraceEventRecord& record : records) {
+    result->push_back(record.ToTraceEvent());
+  }
+  return result;
+}
 
 Timestamp GraphTracer::GetOutputTimestamp(const CalculatorContext* context) {
   for (const OutputStreamShard& out_stream : context->Outputs()) {
@@ -15,11 +15,15 @@
 #ifndef MEDIAPIPE_FRAMEWORK_PROFILER_GRAPH_TRACER_H_
 #define MEDIAPIPE_FRAMEWORK_PROFILER_GRAPH_TRACER_H_
 
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/profiler/thread_trace_buffer.h"
 #include "mediapipe/framework/profiler/trace_buffer.h"
 #include "mediapipe/framework/profiler/trace_builder.h"
 
@@ -30,6 +34,9 @@ namespace mediapipe {
 //
 // GraphTracer is thread-safe, and the Log* methods are also non-blocking
 // so they can be called during graph execution with mimimal overhead.
+// Each thread logs into its own TraceBlock, so logging threads contend with
+// each other only when they start a new block. The blocks are merged in event
+// time order only when the trace is read.
 //
 // The method GetTrace returns the events for a range of recent Timestamps.
 // The begin_ts should be the first timestamp completely enclosed in the
@@ -75,21 +82,29 @@ class GraphTracer {
   // Returns trace events between begin_time and end_time exclusive.
   void GetLog(absl::Time begin_time, absl::Time end_time, GraphTrace* result);
 
-  // Returns the logged TraceEvents.
-  const TraceBuffer& GetTraceBuffer();
+  // Returns a copy of the logged TraceEvents of all threads, ordered by
+  // event time.
+  std::unique_ptr<TraceBuffer> GetTraceBuffer();
 
  private:
   // Returns the timestamp of the first output packet.
   Timestamp GetOutputTimestamp(const CalculatorContext* context);
 
+  // Returns the trace block of the calling thread with room for one event.
+  TraceBlock* GetThreadTraceBlock();
+
   // The settings for this tracer.
   ProfilerConfig profiler_config_;
 
   // Indicates event types that will not be logged.
   std::vector<bool> event_types_disabled_;
 
-  // The circular buffer of TraceEvents.
-  TraceBuffer trace_buffer_;
+  // Identifies this tracer in the per-thread cache of trace buffers.
+  const int64 tracer_id_;
+
+  // The blocks of TraceEvents of all threads. Threads that log to this
+  // tracer keep a weak reference, to return their blocks when they exit.
+  std::shared_ptr<TraceBlockPool> block_pool_;
 
   // The builder for the GraphTrace protobuf.
   TraceBuilder trace_builder_;
@@ -16,11 +16,14 @@
 
 #include <fstream>
 #include <functional>
+#include <list>
 #include <map>
 #include <memory>
 #include <utility>
 #include <vector>
 
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/time/time.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
@@ -37,6 +40,7 @@
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/port/status_matchers.h"
 #include "mediapipe/framework/profiler/graph_profiler.h"
+#include "mediapipe/framework/profiler/latency_histogram.h"
 #include "mediapipe/framework/profiler/test_context_builder.h"
 #include "mediapipe/framework/tool/simulation_clock.h"
 #include "mediapipe/framework/tool/simulation_clock_executor.h"
@@ -604,6 +608,16 @@ void FillHistogram(const std::vector<int64>& values, TimeHistogram* result) {
   }
 }
 
+// Initialize a LatencyHistogram protobuf with some latency values.
+void FillDistribution(const std::vector<int64>& values,
+                      LatencyHistogram* result) {
+  AtomicLatencyHistogram counters;
+  for (int64 v : values) {
+    counters.AddSample(v);
+  }
+  counters.AddTo(result);
+}
+
 // Verify profiler histograms with the PassThrough graph.
 TEST_F(GraphTracerE2ETest, PassThroughGraphProfile) {
   SetUpPassThroughGraph();
@@ -622,7 +636,17 @@ TEST_F(GraphTracerE2ETest, PassThroughGraphProfile) {
         name: "LambdaCalculator"
         open_runtime: 0
         close_runtime: 0
-        input_stream_profiles { name: "input_0" back_edge: false })");
+        input_stream_profiles {
+          name: "input_0"
+          back_edge: false
+          queue_size {
+            count: [ 2, 3, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 ]
+            max: 4
+          }
+          max_queue_size: 100
+          throttled_count: 0
+          throttled_time_usec: 0
+        })");
 
   FillHistogram({20001, 20001, 20001, 20001, 20001, 20001},
                 expected.mutable_process_runtime());
@@ -632,8 +656,22 @@ TEST_F(GraphTracerE2ETest, PassThroughGraphProfile) {
                 expected.mutable_process_output_latency());
   FillHistogram({0, 15000, 30000, 45000, 60000, 75000},
                 expected.mutable_input_stream_profiles(0)->mutable_latency());
+  FillDistribution({20001, 20001, 20001, 20001, 20001, 20001},
+                   expected.mutable_process_runtime_distribution());
+  FillDistribution({0, 15000, 30000, 45000, 60000, 75000},
+                   expected.mutable_process_input_latency_distribution());
+  FillDistribution({20001, 35001, 50001, 65001, 80001, 95001},
+                   expected.mutable_process_output_latency_distribution());
+  FillDistribution({0, 15000, 30000, 45000, 60000, 75000},
+                   expected.mutable_input_stream_profiles(0)
+                       ->mutable_latency_distribution());
 
   EXPECT_THAT(profiles[0], EqualsProto(expected));
+  const LatencyHistogram& output_latency =
+      profiles[0].process_output_latency_distribution();
+  EXPECT_EQ(6, output_latency.num_samples());
+  EXPECT_NEAR(50001, output_latency.p50(), 50001 / 8);
+  EXPECT_NEAR(95001, output_latency.p99(), 95001 / 8);
   EXPECT_EQ(GraphProfilerTestPeer::GetPacketsInfoMap(graph_.profiler())->size(),
             2);
 }
@@ -932,6 +970,26 @@ TEST_F(GraphTracerE2ETest, DemuxGraphLogFile) {
   EXPECT_EQ(89, profile.graph_trace(0).calculator_trace().size());
 }
 
+TEST_F(GraphTracerE2ETest, DemuxGraphChromeTraceFile) {
+  std::string log_path = absl::StrCat(getenv("TEST_TMPDIR"), "/chrome_trace_");
+  SetUpDemuxInFlightGraph();
+  graph_config_.mutable_profiler_config()->set_trace_log_path(log_path);
+  graph_config_.mutable_profiler_config()->set_trace_log_interval_usec(-1);
+  graph_config_.mutable_profiler_config()->set_trace_log_format(
+      ProfilerConfig::CHROME_JSON);
+  RunDemuxInFlightGraph();
+  std::string contents;
+  MEDIAPIPE_ASSERT_OK(
+      file::GetContents(absl::StrCat(log_path, 0, ".json"), &contents));
+  EXPECT_TRUE(absl::StartsWith(contents, "[\n"));
+  EXPECT_TRUE(absl::StrContains(
+      contents, R"({"name":"RoundRobinDemuxCalculator","cat":"PROCESS",)"));
+  EXPECT_TRUE(absl::StrContains(contents, R"("cat":"packet","ph":"s")"));
+  EXPECT_TRUE(absl::StrContains(contents, R"("cat":"packet","ph":"f")"));
+  EXPECT_TRUE(mediapipe::IsNotFound(
+      mediapipe::file::Exists(absl::StrCat(log_path, 0, ".binarypb"))));
+}
+
 TEST_F(GraphTracerE2ETest, DemuxGraphLogFiles) {
   std::string log_path = absl::StrCat(getenv("TEST_TMPDIR"), "/log_files_");
   SetUpDemuxInFlightGraph();
@@ -0,0 +1,145 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "mediapipe/framework/port/logging.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Returns the counts of all buckets of "histogram".
+std::vector<int64> GetBucketCounts(const LatencyHistogram& histogram) {
+  std::vector<int64> counts(kNumLatencyBuckets, 0);
+  for (int i = 0; i < histogram.count_size(); ++i) {
+    int index = histogram.first_bucket() + i;
+    CHECK(0 <= index && index < kNumLatencyBuckets);
+    counts[index] = histogram.count(i);
+  }
+  return counts;
+}
+
+// Stores "counts" in "histogram", omitting empty leading and trailing
+// buckets, and updates the sample count and percentiles.
+void SetBucketCounts(const std::vector<int64>& counts,
+                     LatencyHistogram* histogram) {
+  histogram->clear_count();
+  auto first = std::find_if(counts.begin(), counts.end(),
+                            [](int64 count) { return count != 0; });
+  auto last = std::find_if(counts.rbegin(), counts.rend(),
+                           [](int64 count) { return count != 0; })
+                  .base();
+  int64 num_samples = 0;
+  histogram->set_first_bucket(first < last ? first - counts.begin() : 0);
+  for (auto iter = first; iter < last; ++iter) {
+    histogram->add_count(*iter);
+    num_samples += *iter;
+  }
+  histogram->set_num_samples(num_samples);
+  histogram->set_p50(LatencyPercentile(*histogram, 0.5));
+  histogram->set_p90(LatencyPercentile(*histogram, 0.9));
+  histogram->set_p99(LatencyPercentile(*histogram, 0.99));
+  histogram->set_p999(LatencyPercentile(*histogram, 0.999));
+}
+
+}  // namespace
+
+int64 LatencyBucketLowerBound(int index) {
+  constexpr int kNumSubBuckets = 1 << kLatencySubBucketBits;
+  if (index < kNumSubBuckets) {
+    return index;
+  }
+  int range = index >> kLatencySubBucketBits;
+  int64 sub_bucket = index & (kNumSubBuckets - 1);
+  return (kNumSubBuckets + sub_bucket) << (range - 1);
+}
+
+int64 LatencyBucketWidth(int index) {
+  constexpr int kNumSubBuckets = 1 << kLatencySubBucketBits;
+  if (index < kNumSubBuckets) {
+    return 1;
+  }
+  return int64{1} << ((index >> kLatencySubBucketBits) - 1);
+}
+
+int64 LatencyPercentile(const LatencyHistogram& histogram, double quantile) {
+  int64 num_samples = 0;
+  for (int64 count : histogram.count()) {
+    num_samples += count;
+  }
+  if (num_samples == 0) {
+    return 0;
+  }
+  int64 rank = std::max<int64>(1, std::ceil(quantile * num_samples));
+  int64 seen = 0;
+  for (int i = 0; i < histogram.count_size(); ++i) {
+    seen += histogram.count(i);
+    if (seen >= rank) {
+      int index = histogram.first_bucket() + i;
+      int64 middle =
+          LatencyBucketLowerBound(index) + LatencyBucketWidth(index) / 2;
+      return std::min(middle, histogram.max());
+    }
+  }
+  return histogram.max();
+}
+
+void MergeLatencyHistogram(const LatencyHistogram& from, LatencyHistogram* to) {
+  CHECK_EQ(from.sub_bucket_bits(), kLatencySubBucketBits);
+  CHECK_EQ(to->sub_bucket_bits(), kLatencySubBucketBits);
+  std::vector<int64> counts = GetBucketCounts(*to);
+  for (int i = 0; i < from.count_size(); ++i) {
+    int index = from.first_bucket() + i;
+    CHECK(0 <= index && index < kNumLatencyBuckets);
+    counts[index] += from.count(i);
+  }
+  to->set_total(to->total() + from.total());
+  to->set_max(std::max(to->max(), from.max()));
+  SetBucketCounts(counts, to);
+}
+
+AtomicLatencyHistogram::AtomicLatencyHistogram()
+    : total_(0),
+      max_(0),
+      counts_(new std::atomic<int64>[kNumLatencyBuckets]) {
+  Reset();
+}
+
+void AtomicLatencyHistogram::AddTo(LatencyHistogram* histogram) const {
+  CHECK_EQ(histogram->sub_bucket_bits(), kLatencySubBucketBits);
+  std::vector<int64> counts = GetBucketCounts(*histogram);
+  for (int i = 0; i < kNumLatencyBuckets; ++i) {
+    counts[i] += counts_[i].load(std::memory_order_relaxed);
+  }
+  histogram->set_total(histogram->total() +
+                       total_.load(std::memory_order_relaxed));
+  histogram->set_max(
+      std::max(histogram->max(), max_.load(std::memory_order_relaxed)));
+  SetBucketCounts(counts, histogram);
+}
+
+void AtomicLatencyHistogram::Reset() {
+  total_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+  for (int i = 0; i < kNumLatencyBuckets; ++i) {
+    counts_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,108 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Helpers for the log-linear LatencyHistogram in calculator_profile.proto.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PROFILER_LATENCY_HISTOGRAM_H_
+#define MEDIAPIPE_FRAMEWORK_PROFILER_LATENCY_HISTOGRAM_H_
+
+#include <atomic>
+#include <memory>
+
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+
+// The sub_bucket_bits of the LatencyHistograms recorded by GraphProfiler.
+// Each bucket is at most 1/8 of its values wide.
+constexpr int kLatencySubBucketBits = 3;
+
+// The number of buckets of a LatencyHistogram with kLatencySubBucketBits.
+constexpr int kNumLatencyBuckets = (32 - kLatencySubBucketBits + 1)
+                                   << kLatencySubBucketBits;
+
+// Returns the index of the bucket counting "time_usec".
+inline int LatencyBucketIndex(int64 time_usec) {
+  constexpr int64 kNumSubBuckets = int64{1} << kLatencySubBucketBits;
+  if (time_usec < kNumSubBuckets) {
+    return time_usec < 0 ? 0 : static_cast<int>(time_usec);
+  }
+  if (time_usec >= (int64{1} << 32)) {
+    return kNumLatencyBuckets - 1;
+  }
+  // Find the power of two range [2^log2, 2^(log2+1)) holding time_usec.
+  int log2 = 0;
+  for (int bits = 16; bits > 0; bits /= 2) {
+    if (time_usec >= (int64{1} << (log2 + bits))) {
+      log2 += bits;
+    }
+  }
+  int shift = log2 - kLatencySubBucketBits;
+  return static_cast<int>(((shift + 1) << kLatencySubBucketBits) +
+                          (time_usec >> shift) - kNumSubBuckets);
+}
+
+// Returns the smallest time counted by the bucket at "index".
+int64 LatencyBucketLowerBound(int index);
+
+// Returns the width of the bucket at "index".
+int64 LatencyBucketWidth(int index);
+
+// Returns the time below which "quantile" of the samples in "histogram" fall.
+// The result is the middle of the bucket holding that sample, but not more
+// than histogram.max().
+int64 LatencyPercentile(const LatencyHistogram& histogram, double quantile);
+
+// Adds the samples of "from" to "to", and updates the percentiles of "to".
+// Both histograms must have sub_bucket_bits kLatencySubBucketBits.
+void MergeLatencyHistogram(const LatencyHistogram& from, LatencyHistogram* to);
+
+// Accumulates the samples of a LatencyHistogram in atomic counters, so that
+// samples can be added by many threads without locking.
+class AtomicLatencyHistogram {
+ public:
+  AtomicLatencyHistogram();
+
+  // Not copyable or movable.
+  AtomicLatencyHistogram(const AtomicLatencyHistogram&) = delete;
+  AtomicLatencyHistogram& operator=(const AtomicLatencyHistogram&) = delete;
+
+  // Records a sample of "time_usec" microseconds.
+  inline void AddSample(int64 time_usec) {
+    counts_[LatencyBucketIndex(time_usec)].fetch_add(
+        1, std::memory_order_relaxed);
+    total_.fetch_add(time_usec, std::memory_order_relaxed);
+    int64 max = max_.load(std::memory_order_relaxed);
+    while (time_usec > max &&
+           !max_.compare_exchange_weak(max, time_usec,
+                                       std::memory_order_relaxed)) {
+    }
+  }
+
+  // Adds the recorded samples to "histogram", and updates its percentiles.
+  void AddTo(LatencyHistogram* histogram) const;
+
+  // Clears the recorded samples.
+  void Reset();
+
+ private:
+  std::atomic<int64> total_;
+  std::atomic<int64> max_;
+  std::unique_ptr<std::atomic<int64>[]> counts_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PROFILER_LATENCY_HISTOGRAM_H_
@@ -0,0 +1,114 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/latency_histogram.h"
+
+#include <algorithm>
+
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+
+namespace mediapipe {
+namespace {
+
+// Each bucket index maps to a bucket holding its lower bound, and buckets
+// are adjacent and at most 1/8 of their values wide.
+TEST(LatencyHistogramTest, BucketBounds) {
+  EXPECT_EQ(0, LatencyBucketIndex(-5));
+  EXPECT_EQ(0, LatencyBucketIndex(0));
+  EXPECT_EQ(7, LatencyBucketIndex(7));
+  EXPECT_EQ(8, LatencyBucketIndex(8));
+  EXPECT_EQ(15, LatencyBucketIndex(15));
+  EXPECT_EQ(16, LatencyBucketIndex(16));
+  EXPECT_EQ(16, LatencyBucketIndex(17));
+  EXPECT_EQ(kNumLatencyBuckets - 1, LatencyBucketIndex(int64{1} << 40));
+  for (int i = 0; i + 1 < kNumLatencyBuckets; ++i) {
+    int64 lower = LatencyBucketLowerBound(i);
+    int64 width = LatencyBucketWidth(i);
+    ASSERT_EQ(i, LatencyBucketIndex(lower));
+    ASSERT_EQ(i, LatencyBucketIndex(lower + width - 1));
+    ASSERT_EQ(lower + width, LatencyBucketLowerBound(i + 1));
+    ASSERT_LE(width * 8, std::max<int64>(lower, 8));
+  }
+}
+
+TEST(LatencyHistogramTest, Percentiles) {
+  AtomicLatencyHistogram counters;
+  for (int i = 1; i <= 1000; ++i) {
+    counters.AddSample(i);
+  }
+  LatencyHistogram histogram;
+  counters.AddTo(&histogram);
+  EXPECT_EQ(1000, histogram.num_samples());
+  EXPECT_EQ(500500, histogram.total());
+  EXPECT_EQ(1000, histogram.max());
+  EXPECT_EQ(1, histogram.first_bucket());
+  EXPECT_EQ(LatencyBucketIndex(1000), histogram.count_size());
+  EXPECT_NEAR(500, histogram.p50(), 500 / 8);
+  EXPECT_NEAR(900, histogram.p90(), 900 / 8);
+  EXPECT_NEAR(990, histogram.p99(), 990 / 8);
+  EXPECT_NEAR(999, histogram.p999(), 999 / 8);
+
+  counters.Reset();
+  histogram.Clear();
+  counters.AddTo(&histogram);
+  EXPECT_EQ(0, histogram.num_samples());
+  EXPECT_EQ(0, histogram.count_size());
+  EXPECT_EQ(0, histogram.p50());
+}
+
+// Histograms from separate runs can be merged.
+TEST(LatencyHistogramTest, MergeLatencyHistogram) {
+  AtomicLatencyHistogram fast;
+  AtomicLatencyHistogram slow;
+  for (int i = 0; i < 90; ++i) {
+    fast.AddSample(100);
+  }
+  for (int i = 0; i < 10; ++i) {
+    slow.AddSample(100000);
+  }
+  LatencyHistogram fast_histogram;
+  LatencyHistogram slow_histogram;
+  fast.AddTo(&fast_histogram);
+  slow.AddTo(&slow_histogram);
+  EXPECT_EQ(1, fast_histogram.count_size());
+  EXPECT_EQ(1, slow_histogram.count_size());
+
+  LatencyHistogram merged = fast_histogram;
+  MergeLatencyHistogram(slow_histogram, &merged);
+  EXPECT_EQ(100, merged.num_samples());
+  EXPECT_EQ(90 * 100 + 10 * 100000, merged.total());
+  EXPECT_EQ(100000, merged.max());
+  EXPECT_EQ(LatencyBucketIndex(100), merged.first_bucket());
+  EXPECT_EQ(LatencyBucketIndex(100000) - LatencyBucketIndex(100) + 1,
+            merged.count_size());
+  EXPECT_NEAR(100, merged.p50(), 100 / 8);
+  EXPECT_NEAR(100, merged.p90(), 100 / 8);
+  EXPECT_NEAR(100000, merged.p99(), 100000 / 8);
+}
+
+TEST(LatencyHistogramTest, ParsedHistogram) {
+  LatencyHistogram histogram = ParseTextProtoOrDie<LatencyHistogram>(R"(
+    first_bucket: 2
+    count: [ 1, 0, 3 ]
+    max: 4
+  )");
+  EXPECT_EQ(2, LatencyPercentile(histogram, 0.25));
+  EXPECT_EQ(4, LatencyPercentile(histogram, 0.5));
+  EXPECT_EQ(4, LatencyPercentile(histogram, 1.0));
+}
+
+}  // namespace
+}  // namespace mediapipe
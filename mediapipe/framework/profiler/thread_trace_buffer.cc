@@ -0,0 +1,74 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/thread_trace_buffer.h"
+
+#include <algorithm>
+
+#include "absl/memory/memory.h"
+
+namespace mediapipe {
+
+constexpr size_t TraceBlockPool::kMaxBlockSize;
+
+TraceBlockPool::TraceBlockPool(size_t capacity)
+    : block_size_(std::max<size_t>(1, std::min(kMaxBlockSize, capacity / 16))),
+      max_blocks_(std::max<size_t>(1, capacity / block_size_)) {}
+
+TraceBlock* TraceBlockPool::NextBlock(TraceBlock* full_block) {
+  absl::MutexLock lock(&mutex_);
+  if (full_block != nullptr) {
+    released_blocks_.push_back(full_block);
+  }
+  FreeExtraBlocks();
+  if (blocks_.size() < max_blocks_ || released_blocks_.empty()) {
+    blocks_.push_back(absl::make_unique<TraceBlock>(block_size_));
+    return blocks_.back().get();
+  }
+  TraceBlock* block = released_blocks_.front();
+  released_blocks_.pop_front();
+  block->clear();
+  return block;
+}
+
+void TraceBlockPool::ReleaseBlock(TraceBlock* block) {
+  absl::MutexLock lock(&mutex_);
+  released_blocks_.push_back(block);
+  FreeExtraBlocks();
+}
+
+void TraceBlockPool::GetRecords(std::vector<TraceEventRecord>* records) const {
+  absl::MutexLock lock(&mutex_);
+  for (const auto& block : blocks_) {
+    block->GetRecords(records);
+  }
+}
+
+size_t TraceBlockPool::num_blocks() const {
+  absl::MutexLock lock(&mutex_);
+  return blocks_.size();
+}
+
+void TraceBlockPool::FreeExtraBlocks() {
+  while (blocks_.size() > max_blocks_ && !released_blocks_.empty()) {
+    TraceBlock* block = released_blocks_.front();
+    released_blocks_.pop_front();
+    blocks_.erase(std::find_if(blocks_.begin(), blocks_.end(),
+                               [block](const std::unique_ptr<TraceBlock>& b) {
+                                 return b.get() == block;
+                               }));
+  }
+}
+
+}  // namespace mediapipe
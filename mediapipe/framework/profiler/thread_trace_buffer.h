@@ -0,0 +1,184 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PROFILER_THREAD_TRACE_BUFFER_H_
+#define MEDIAPIPE_FRAMEWORK_PROFILER_THREAD_TRACE_BUFFER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/profiler/trace_buffer.h"
+#include "mediapipe/framework/timestamp.h"
+
+namespace mediapipe {
+
+// A compact, fixed-size copy of a TraceEvent, filling one cache line.
+struct TraceEventRecord {
+  TraceEventRecord() = default;
+  TraceEventRecord(const TraceEvent& event, int thread_id, int64 log_time_ns)
+      : event_time_ns(absl::ToUnixNanos(event.event_time)),
+        log_time_ns(log_time_ns),
+        input_ts(event.input_ts.Value()),
+        packet_ts(event.packet_ts.Value()),
+        stream_id(event.stream_id),
+        packet_data_id(event.packet_data_id),
+        node_id(event.node_id),
+        thread_id(thread_id),
+        event_type(static_cast<int16>(event.event_type)),
+        is_finish(event.is_finish) {}
+
+  // Orders records by event time, and records with equal event times in the
+  // order in which they were logged.
+  bool operator<(const TraceEventRecord& other) const {
+    return event_time_ns != other.event_time_ns
+               ? event_time_ns < other.event_time_ns
+               : log_time_ns < other.log_time_ns;
+  }
+
+  TraceEvent ToTraceEvent() const {
+    TraceEvent event(static_cast<TraceEvent::EventType>(event_type));
+    event.event_time = absl::FromUnixNanos(event_time_ns);
+    event.is_finish = is_finish;
+    event.input_ts = Timestamp::CreateNoErrorChecking(input_ts);
+    event.packet_ts = Timestamp::CreateNoErrorChecking(packet_ts);
+    event.node_id = node_id;
+    event.stream_id = stream_id;
+    event.packet_data_id = packet_data_id;
+    event.thread_id = thread_id;
+    return event;
+  }
+
+  int64 event_time_ns = 0;
+  // The wall time when the event was logged. Under a simulated clock, many
+  // events share the same event time.
+  int64 log_time_ns = 0;
+  int64 input_ts = 0;
+  int64 packet_ts = 0;
+  const std::string* stream_id = nullptr;
+  PacketDataId packet_data_id = nullptr;
+  int32 node_id = -1;
+  int32 thread_id = 0;
+  int16 event_type = 0;
+  bool is_finish = false;
+};
+
+// A fixed-size block of trace event records, filled by one thread at a time.
+//
+// Only the thread that obtained the block from its TraceBlockPool may call
+// push_back(), which does not wait and does not contend with other threads.
+// A record is never modified after it is appended, until the pool hands the
+// block to a thread again. GetRecords() is called by TraceBlockPool while it
+// holds its lock, so that never happens during a copy.
+class TraceBlock {
+ public:
+  explicit TraceBlock(size_t capacity) : records_(capacity), size_(0) {
+    CHECK_GT(capacity, 0);
+  }
+
+  // Not copyable or movable.
+  TraceBlock(const TraceBlock&) = delete;
+  TraceBlock& operator=(const TraceBlock&) = delete;
+
+  size_t capacity() const { return records_.size(); }
+
+  // Returns true if no more events fit. Only called by the owning thread.
+  bool full() const {
+    return size_.load(std::memory_order_relaxed) == records_.size();
+  }
+
+  // Appends an event logged by thread "thread_id". The block must not be full.
+  inline void push_back(const TraceEvent& event, int thread_id) {
+    const size_t size = size_.load(std::memory_order_relaxed);
+    records_[size] =
+        TraceEventRecord(event, thread_id, absl::GetCurrentTimeNanos());
+    size_.store(size + 1, std::memory_order_release);
+  }
+
+  // Appends the records appended so far to "records".
+  void GetRecords(std::vector<TraceEventRecord>* records) const {
+    const size_t size = size_.load(std::memory_order_acquire);
+    records->insert(records->end(), records_.begin(), records_.begin() + size);
+  }
+
+  // Discards all records. Only called before the block is reused.
+  void clear() { size_.store(0, std::memory_order_relaxed); }
+
+ private:
+  std::vector<TraceEventRecord> records_;
+  // The number of records appended.
+  std::atomic<size_t> size_;
+};
+
+// The TraceBlocks of one GraphTracer, holding up to "capacity" events in
+// total.
+//
+// Blocks are allocated as threads log events. Each logging thread fills one
+// block at a time, and returns it through NextBlock() when it is full or
+// through ReleaseBlock() when the thread exits. Once "capacity" events are
+// allocated, the block released first is discarded and reused. If more
+// threads log at once than there are blocks, extra blocks are allocated, and
+// freed again as they are released.
+class TraceBlockPool {
+ public:
+  // The number of events in a block, for large capacities.
+  static constexpr size_t kMaxBlockSize = 256;
+
+  explicit TraceBlockPool(size_t capacity);
+
+  // Not copyable or movable.
+  TraceBlockPool(const TraceBlockPool&) = delete;
+  TraceBlockPool& operator=(const TraceBlockPool&) = delete;
+
+  size_t block_size() const { return block_size_; }
+
+  // Returns the number of blocks allocated.
+  size_t num_blocks() const LOCKS_EXCLUDED(mutex_);
+
+  // Releases "full_block", unless it is null, and returns an empty block for
+  // the calling thread.
+  TraceBlock* NextBlock(TraceBlock* full_block) LOCKS_EXCLUDED(mutex_);
+
+  // Releases the block of a thread that stops logging.
+  void ReleaseBlock(TraceBlock* block) LOCKS_EXCLUDED(mutex_);
+
+  // Appends the records of all blocks to "records", in no particular order.
+  void GetRecords(std::vector<TraceEventRecord>* records) const
+      LOCKS_EXCLUDED(mutex_);
+
+ private:
+  // Frees released blocks while more than max_blocks_ are allocated.
+  void FreeExtraBlocks() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const size_t block_size_;
+  const size_t max_blocks_;
+  mutable absl::Mutex mutex_;
+  std::vector<std::unique_ptr<TraceBlock>> blocks_ GUARDED_BY(mutex_);
+  // The blocks that no thread is logging to, in the order they were released.
+  std::deque<TraceBlock*> released_blocks_ GUARDED_BY(mutex_);
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PROFILER_THREAD_TRACE_BUFFER_H_
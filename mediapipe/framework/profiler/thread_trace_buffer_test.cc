@@ -0,0 +1,262 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/thread_trace_buffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/profiler/graph_tracer.h"
+#include "mediapipe/framework/profiler/trace_buffer.h"
+
+namespace mediapipe {
+namespace {
+
+// Returns a PROCESS event with "node_id" at "time_usec".
+TraceEvent MakeEvent(int node_id, int64 time_usec) {
+  return TraceEvent(TraceEvent::PROCESS)
+      .set_node_id(node_id)
+      .set_event_time(absl::FromUnixMicros(time_usec));
+}
+
+TEST(ThreadTraceBufferTest, RecordKeepsAllFields) {
+  const std::string stream_name = "stream";
+  int packet_data = 0;
+  TraceEvent event = TraceEvent(TraceEvent::CLOSE)
+                         .set_event_time(absl::FromUnixMicros(12345))
+                         .set_is_finish(true)
+                         .set_input_ts(Timestamp(10))
+                         .set_packet_ts(Timestamp::PostStream())
+                         .set_node_id(7)
+                         .set_stream_id(&stream_name);
+  event.packet_data_id = &packet_data;
+  TraceEvent copy =
+      TraceEventRecord(event, /*thread_id=*/3, /*log_time_ns=*/0)
+          .ToTraceEvent();
+  EXPECT_EQ(event.event_time, copy.event_time);
+  EXPECT_EQ(event.event_type, copy.event_type);
+  EXPECT_TRUE(copy.is_finish);
+  EXPECT_EQ(Timestamp(10), copy.input_ts);
+  EXPECT_EQ(Timestamp::PostStream(), copy.packet_ts);
+  EXPECT_EQ(7, copy.node_id);
+  EXPECT_EQ(&stream_name, copy.stream_id);
+  EXPECT_EQ(&packet_data, copy.packet_data_id);
+  EXPECT_EQ(3, copy.thread_id);
+  EXPECT_EQ(Timestamp::Unset(),
+            TraceEventRecord(TraceEvent(), 0, 0).ToTraceEvent().input_ts);
+}
+
+TEST(ThreadTraceBufferTest, BlockKeepsEvents) {
+  TraceBlock block(/*capacity=*/4);
+  std::vector<TraceEventRecord> records;
+  block.GetRecords(&records);
+  EXPECT_TRUE(records.empty());
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_FALSE(block.full());
+    block.push_back(MakeEvent(i, i), /*thread_id=*/5);
+  }
+  EXPECT_TRUE(block.full());
+  block.GetRecords(&records);
+  ASSERT_EQ(4, records.size());
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(i, records[i].node_id);
+    EXPECT_EQ(5, records[i].thread_id);
+  }
+  block.clear();
+  records.clear();
+  block.GetRecords(&records);
+  EXPECT_TRUE(records.empty());
+}
+
+// Once the capacity is allocated, the block released first is reused.
+TEST(ThreadTraceBufferTest, PoolReusesOldestBlock) {
+  TraceBlockPool pool(/*capacity=*/64);
+  ASSERT_EQ(4, pool.block_size());
+  TraceBlock* block = pool.NextBlock(nullptr);
+  for (int i = 0; i < 16 * 4 + 1; ++i) {
+    if (block->full()) {
+      block = pool.NextBlock(block);
+    }
+    block->push_back(MakeEvent(i, i), /*thread_id=*/0);
+  }
+  EXPECT_EQ(16, pool.num_blocks());
+  std::vector<TraceEventRecord> records;
+  pool.GetRecords(&records);
+  ASSERT_EQ(16 * 4 - 3, records.size());
+  std::sort(records.begin(), records.end());
+  EXPECT_EQ(4, records.front().node_id);
+  EXPECT_EQ(16 * 4, records.back().node_id);
+}
+
+// Blocks allocated beyond the capacity for concurrent threads are freed when
+// the threads release them.
+TEST(ThreadTraceBufferTest, PoolFreesExtraBlocks) {
+  TraceBlockPool pool(/*capacity=*/16);
+  ASSERT_EQ(1, pool.block_size());
+  std::vector<TraceBlock*> blocks;
+  for (int t = 0; t < 20; ++t) {
+    blocks.push_back(pool.NextBlock(nullptr));
+    blocks.back()->push_back(MakeEvent(t, t), /*thread_id=*/t);
+  }
+  EXPECT_EQ(20, pool.num_blocks());
+  for (TraceBlock* block : blocks) {
+    pool.ReleaseBlock(block);
+  }
+  EXPECT_EQ(16, pool.num_blocks());
+  std::vector<TraceEventRecord> records;
+  pool.GetRecords(&records);
+  EXPECT_EQ(16, records.size());
+}
+
+// A reader running alongside the writers sees every event of each thread at
+// most once, in the order it was logged.
+TEST(ThreadTraceBufferTest, ParallelWriteAndRead) {
+  constexpr int kNumThreads = 4;
+  constexpr int kNumEvents = 20000;
+  ProfilerConfig config;
+  config.set_trace_log_capacity(1024);
+  GraphTracer tracer(config);
+  std::atomic<int> num_done(0);
+  std::vector<std::thread> writers;
+  for (int t = 0; t < kNumThreads; ++t) {
+    writers.emplace_back([&tracer, &num_done, t] {
+      for (int i = 0; i < kNumEvents; ++i) {
+        tracer.LogEvent(MakeEvent(t, i));
+      }
+      ++num_done;
+    });
+  }
+  int num_reads = 0;
+  while (num_done < kNumThreads || num_reads == 0) {
+    std::unique_ptr<TraceBuffer> buffer = tracer.GetTraceBuffer();
+    int64 last_time[kNumThreads] = {-1, -1, -1, -1};
+    int num_events = 0;
+    for (auto iter = buffer->begin(); iter < buffer->end(); ++iter) {
+      TraceEvent event = *iter;
+      ASSERT_GE(event.node_id, 0);
+      ASSERT_LT(event.node_id, kNumThreads);
+      int64 time = absl::ToUnixMicros(event.event_time);
+      ASSERT_LT(last_time[event.node_id], time);
+      last_time[event.node_id] = time;
+      ++num_events;
+    }
+    ASSERT_LE(num_events, 1024);
+    ++num_reads;
+  }
+  for (std::thread& writer : writers) {
+    writer.join();
+  }
+}
+
+// trace_log_capacity limits the events of all threads together, and the
+// blocks of threads that exit are reused.
+TEST(ThreadTraceBufferTest, GraphTracerCapacityIsTotal) {
+  ProfilerConfig config;
+  config.set_trace_log_capacity(64);
+  GraphTracer tracer(config);
+  for (int t = 0; t < 100; ++t) {
+    std::thread([&tracer, t] {
+      for (int i = 0; i < 10; ++i) {
+        tracer.LogEvent(MakeEvent(t, t * 10 + i));
+      }
+    }).join();
+  }
+  std::unique_ptr<TraceBuffer> buffer = tracer.GetTraceBuffer();
+  int num_events = 0;
+  TraceEvent last_event;
+  for (auto iter = buffer->begin(); iter < buffer->end(); ++iter) {
+    last_event = *iter;
+    ++num_events;
+  }
+  EXPECT_LE(num_events, 64);
+  EXPECT_EQ(99, last_event.node_id);
+}
+
+// GraphTracer merges the events of all threads in event time order.
+TEST(ThreadTraceBufferTest, GraphTracerMergesThreads) {
+  constexpr int kNumThreads = 4;
+  constexpr int kNumEvents = 100;
+  GraphTracer tracer(ProfilerConfig{});
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&tracer, t] {
+      for (int i = 0; i < kNumEvents; ++i) {
+        tracer.LogEvent(MakeEvent(t, i * kNumThreads + t));
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  std::unique_ptr<TraceBuffer> buffer = tracer.GetTraceBuffer();
+  int64 expected_time_usec = 0;
+  for (auto iter = buffer->begin(); iter < buffer->end(); ++iter) {
+    TraceEvent event = *iter;
+    EXPECT_EQ(expected_time_usec, absl::ToUnixMicros(event.event_time));
+    EXPECT_EQ(expected_time_usec % kNumThreads, event.node_id);
+    ++expected_time_usec;
+  }
+  EXPECT_EQ(kNumThreads * kNumEvents, expected_time_usec);
+}
+
+// Events with equal event times stay in the order in which they were logged.
+TEST(ThreadTraceBufferTest, GraphTracerKeepsLogOrderForEqualTimes) {
+  GraphTracer tracer(ProfilerConfig{});
+  for (int i = 0; i < 4; ++i) {
+    std::thread([&tracer, i] { tracer.LogEvent(MakeEvent(i, 0)); }).join();
+  }
+  std::unique_ptr<TraceBuffer> buffer = tracer.GetTraceBuffer();
+  int node_id = 0;
+  for (auto iter = buffer->begin(); iter < buffer->end(); ++iter) {
+    EXPECT_EQ(node_id++, TraceEvent(*iter).node_id);
+  }
+  EXPECT_EQ(4, node_id);
+}
+
+// Logs events into one TraceBuffer shared by all threads, as GraphTracer did
+// before it used one TraceBlock per thread.
+void BM_SharedTraceBufferLogEvent(benchmark::State& state) {
+  static TraceBuffer* buffer = new TraceBuffer(20000);
+  TraceEvent event = MakeEvent(/*node_id=*/0, /*time_usec=*/0);
+  for (auto _ : state) {
+    event.set_thread_id(0);
+    buffer->push_back(event);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_SharedTraceBufferLogEvent)->Threads(8)->Threads(16)->Threads(32);
+
+// Logs events through GraphTracer, into one TraceBlock per thread.
+void BM_GraphTracerLogEvent(benchmark::State& state) {
+  static GraphTracer* tracer = new GraphTracer(ProfilerConfig{});
+  const TraceEvent event = MakeEvent(/*node_id=*/0, /*time_usec=*/0);
+  for (auto _ : state) {
+    tracer->LogEvent(event);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_GraphTracerLogEvent)->Threads(8)->Threads(16)->Threads(32);
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,316 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_RING_BUFFER_H_
+#define MEDIAPIPE_FRAMEWORK_RING_BUFFER_H_
+
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "mediapipe/framework/port/logging.h"
+
+namespace mediapipe {
+
+// A FIFO sequence container backed by a single contiguous, circular buffer.
+//
+// Unlike std::deque and std::list, a RingBuffer allocates nothing once its
+// capacity is large enough: push_back() and pop_front() only construct and
+// destroy elements in place, and clear() keeps the storage for reuse. The
+// capacity is always a power of two and doubles when a push_back() finds the
+// buffer full. Storage is only released by the destructor, shrink_to_fit(),
+// or by swapping it into another RingBuffer.
+//
+// Iterators are random access and are invalidated by any operation that
+// adds or removes elements.
+//
+// A RingBuffer is not thread-safe.
+template <typename T>
+class RingBuffer {
+ public:
+  using value_type = T;
+  using size_type = size_t;
+  using reference = T&;
+  using const_reference = const T&;
+
+  template <typename Buffer, typename Value>
+  class Iterator;
+  using iterator = Iterator<RingBuffer, T>;
+  using const_iterator = Iterator<const RingBuffer, const T>;
+
+  RingBuffer() = default;
+  // Preallocates room for at least "capacity" elements.
+  explicit RingBuffer(size_t capacity) { reserve(capacity); }
+  RingBuffer(std::initializer_list<T> values) {
+    reserve(values.size());
+    for (const T& value : values) {
+      push_back(value);
+    }
+  }
+
+  RingBuffer(const RingBuffer& other) {
+    reserve(other.size());
+    for (const T& value : other) {
+      push_back(value);
+    }
+  }
+  RingBuffer& operator=(const RingBuffer& other) {
+    if (this != &other) {
+      clear();
+      reserve(other.size());
+      for (const T& value : other) {
+        push_back(value);
+      }
+    }
+    return *this;
+  }
+  RingBuffer(RingBuffer&& other) noexcept { swap(other); }
+  RingBuffer& operator=(RingBuffer&& other) noexcept {
+    swap(other);
+    return *this;
+  }
+
+  ~RingBuffer() {
+    clear();
+    Deallocate(data_, capacity_);
+  }
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+  size_t capacity() const { return capacity_; }
+
+  T& front() {
+    DCHECK(!empty());
+    return data_[head_];
+  }
+  const T& front() const {
+    DCHECK(!empty());
+    return data_[head_];
+  }
+  T& back() {
+    DCHECK(!empty());
+    return data_[Slot(size_ - 1)];
+  }
+  const T& back() const {
+    DCHECK(!empty());
+    return data_[Slot(size_ - 1)];
+  }
+
+  // Returns the i-th element counting from the front.
+  T& operator[](size_t i) {
+    DCHECK_LT(i, size_);
+    return data_[Slot(i)];
+  }
+  const T& operator[](size_t i) const {
+    DCHECK_LT(i, size_);
+    return data_[Slot(i)];
+  }
+
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  template <typename... Args>
+  T& emplace_back(Args&&... args) {
+    if (size_ == capacity_) {
+      Grow(capacity_ == 0 ? kMinCapacity : capacity_ * 2);
+    }
+    T* slot = &data_[Slot(size_)];
+    new (slot) T(std::forward<Args>(args)...);
+    ++size_;
+    return *slot;
+  }
+
+  void pop_front() {
+    DCHECK(!empty());
+    data_[head_].~T();
+    head_ = (head_ + 1) & (capacity_ - 1);
+    --size_;
+  }
+
+  // Destroys all elements. The capacity is unchanged.
+  void clear() {
+    while (size_ > 0) {
+      pop_front();
+    }
+    head_ = 0;
+  }
+
+  // Ensures that at least "capacity" elements fit without reallocating.
+  void reserve(size_t capacity) {
+    if (capacity <= capacity_) {
+      return;
+    }
+    size_t new_capacity = kMinCapacity;
+    while (new_capacity < capacity) {
+      new_capacity *= 2;
+    }
+    Grow(new_capacity);
+  }
+
+  // Releases the storage if the buffer is empty.
+  void shrink_to_fit() {
+    if (size_ == 0 && capacity_ > 0) {
+      Deallocate(data_, capacity_);
+      data_ = nullptr;
+      capacity_ = 0;
+      head_ = 0;
+    }
+  }
+
+  // Exchanges the contents and the storage of two buffers. Never allocates.
+  void swap(RingBuffer& other) noexcept {
+    std::swap(data_, other.data_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(head_, other.head_);
+    std::swap(size_, other.size_);
+  }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, size_); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size_); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  // A random access iterator that addresses elements by their offset from
+  // the front of the buffer.
+  template <typename Buffer, typename Value>
+  class Iterator {
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Value*;
+    using reference = Value&;
+
+    Iterator() = default;
+    Iterator(Buffer* buffer, size_t index) : buffer_(buffer), index_(index) {}
+    // Allows conversion from iterator to const_iterator.
+    template <typename OtherBuffer, typename OtherValue>
+    Iterator(const Iterator<OtherBuffer, OtherValue>& other)  // NOLINT
+        : buffer_(other.buffer_), index_(other.index_) {}
+
+    reference operator*() const { return (*buffer_)[index_]; }
+    pointer operator->() const { return &(*buffer_)[index_]; }
+    reference operator[](difference_type n) const {
+      return (*buffer_)[index_ + n];
+    }
+
+    Iterator& operator++() {
+      ++index_;
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator result = *this;
+      ++index_;
+      return result;
+    }
+    Iterator& operator--() {
+      --index_;
+      return *this;
+    }
+    Iterator operator--(int) {
+      Iterator result = *this;
+      --index_;
+      return result;
+    }
+    Iterator& operator+=(difference_type n) {
+      index_ += n;
+      return *this;
+    }
+    Iterator& operator-=(difference_type n) {
+      index_ -= n;
+      return *this;
+    }
+    Iterator operator+(difference_type n) const {
+      return Iterator(buffer_, index_ + n);
+    }
+    Iterator operator-(difference_type n) const {
+      return Iterator(buffer_, index_ - n);
+    }
+    difference_type operator-(const Iterator& other) const {
+      return static_cast<difference_type>(index_) -
+             static_cast<difference_type>(other.index_);
+    }
+
+    bool operator==(const Iterator& other) const {
+      return index_ == other.index_ && buffer_ == other.buffer_;
+    }
+    bool operator!=(const Iterator& other) const { return !(*this == other); }
+    bool operator<(const Iterator& other) const {
+      return index_ < other.index_;
+    }
+    bool operator>(const Iterator& other) const { return other < *this; }
+    bool operator<=(const Iterator& other) const { return !(other < *this); }
+    bool operator>=(const Iterator& other) const { return !(*this < other); }
+
+   private:
+    template <typename OtherBuffer, typename OtherValue>
+    friend class Iterator;
+
+    Buffer* buffer_ = nullptr;
+    size_t index_ = 0;
+  };
+
+ private:
+  static constexpr size_t kMinCapacity = 4;
+
+  static T* Allocate(size_t capacity) {
+    return std::allocator<T>().allocate(capacity);
+  }
+  static void Deallocate(T* data, size_t capacity) {
+    if (data != nullptr) {
+      std::allocator<T>().deallocate(data, capacity);
+    }
+  }
+
+  // Maps an offset from the front to an index into data_.
+  size_t Slot(size_t i) const { return (head_ + i) & (capacity_ - 1); }
+
+  // Moves the elements into new storage of "new_capacity" elements, which
+  // must be a power of two no smaller than size_.
+  void Grow(size_t new_capacity) {
+    T* new_data = Allocate(new_capacity);
+    for (size_t i = 0; i < size_; ++i) {
+      T& value = data_[Slot(i)];
+      new (&new_data[i]) T(std::move(value));
+      value.~T();
+    }
+    Deallocate(data_, capacity_);
+    data_ = new_data;
+    capacity_ = new_capacity;
+    head_ = 0;
+  }
+
+  T* data_ = nullptr;
+  size_t capacity_ = 0;
+  // The index into data_ of the front element.
+  size_t head_ = 0;
+  size_t size_ = 0;
+};
+
+template <typename T>
+constexpr size_t RingBuffer<T>::kMinCapacity;
+
+template <typename T>
+void swap(RingBuffer<T>& a, RingBuffer<T>& b) noexcept {
+  a.swap(b);
+}
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_RING_BUFFER_H_
@@ -0,0 +1,196 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/ring_buffer.h"
+
+#include <deque>
+#include <list>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+std::vector<int> ToVector(const RingBuffer<int>& buffer) {
+  return std::vector<int>(buffer.begin(), buffer.end());
+}
+
+TEST(RingBufferTest, EmptyBuffer) {
+  RingBuffer<int> buffer;
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(0, buffer.size());
+  EXPECT_EQ(0, buffer.capacity());
+  EXPECT_TRUE(buffer.begin() == buffer.end());
+}
+
+TEST(RingBufferTest, FifoOrderAcrossWrapAround) {
+  RingBuffer<int> buffer(4);
+  ASSERT_EQ(4, buffer.capacity());
+  std::vector<int> popped;
+  int next = 0;
+  // Keeps two or three elements in the buffer so that head and tail wrap
+  // around the storage several times without growing it.
+  for (int round = 0; round < 10; ++round) {
+    buffer.push_back(next++);
+    buffer.push_back(next++);
+    popped.push_back(buffer.front());
+    buffer.pop_front();
+    popped.push_back(buffer.front());
+    buffer.pop_front();
+  }
+  EXPECT_EQ(4, buffer.capacity());
+  EXPECT_TRUE(buffer.empty());
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_EQ(i, popped[i]);
+  }
+}
+
+TEST(RingBufferTest, GrowsWhenFullAndKeepsOrder) {
+  RingBuffer<int> buffer(4);
+  buffer.push_back(0);
+  buffer.push_back(1);
+  buffer.pop_front();
+  for (int i = 2; i < 10; ++i) {
+    buffer.push_back(i);
+  }
+  EXPECT_EQ(16, buffer.capacity());
+  EXPECT_EQ(std::vector<int>({1, 2, 3, 4, 5, 6, 7, 8, 9}), ToVector(buffer));
+  EXPECT_EQ(1, buffer.front());
+  EXPECT_EQ(9, buffer.back());
+  EXPECT_EQ(5, buffer[4]);
+}
+
+TEST(RingBufferTest, ClearKeepsCapacity) {
+  RingBuffer<int> buffer;
+  for (int i = 0; i < 5; ++i) {
+    buffer.push_back(i);
+  }
+  const size_t capacity = buffer.capacity();
+  buffer.clear();
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(capacity, buffer.capacity());
+  buffer.shrink_to_fit();
+  EXPECT_EQ(0, buffer.capacity());
+}
+
+TEST(RingBufferTest, IteratorArithmetic) {
+  RingBuffer<int> buffer(8);
+  for (int i = 0; i < 6; ++i) {
+    buffer.push_back(i);
+  }
+  buffer.pop_front();
+  buffer.pop_front();
+  buffer.push_back(6);
+  buffer.push_back(7);
+  buffer.push_back(8);
+  EXPECT_EQ(7, buffer.cend() - buffer.cbegin());
+  EXPECT_EQ(6, *(buffer.cend() - 3));
+  EXPECT_EQ(4, buffer.begin()[2]);
+  RingBuffer<int>::const_iterator it = buffer.begin();
+  ++it;
+  EXPECT_EQ(3, *it);
+  for (int& value : buffer) {
+    value *= 10;
+  }
+  EXPECT_EQ(std::vector<int>({20, 30, 40, 50, 60, 70, 80}), ToVector(buffer));
+}
+
+TEST(RingBufferTest, MoveOnlyValues) {
+  RingBuffer<std::unique_ptr<int>> buffer;
+  for (int i = 0; i < 10; ++i) {
+    buffer.emplace_back(absl::make_unique<int>(i));
+  }
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(i, *buffer.front());
+    buffer.pop_front();
+  }
+}
+
+TEST(RingBufferTest, DestroysElements) {
+  auto value = std::make_shared<int>(1);
+  {
+    RingBuffer<std::shared_ptr<int>> buffer;
+    for (int i = 0; i < 5; ++i) {
+      buffer.push_back(value);
+    }
+    buffer.pop_front();
+    EXPECT_EQ(5, value.use_count());
+    buffer.clear();
+    EXPECT_EQ(1, value.use_count());
+    buffer.push_back(value);
+    buffer.push_back(value);
+  }
+  EXPECT_EQ(1, value.use_count());
+}
+
+TEST(RingBufferTest, CopyAndSwap) {
+  RingBuffer<int> a;
+  a.push_back(1);
+  a.push_back(2);
+  RingBuffer<int> b(a);
+  b.push_back(3);
+  EXPECT_EQ(std::vector<int>({1, 2}), ToVector(a));
+  EXPECT_EQ(std::vector<int>({1, 2, 3}), ToVector(b));
+  a.swap(b);
+  EXPECT_EQ(std::vector<int>({1, 2, 3}), ToVector(a));
+  EXPECT_EQ(std::vector<int>({1, 2}), ToVector(b));
+  RingBuffer<int> c(std::move(a));
+  EXPECT_EQ(std::vector<int>({1, 2, 3}), ToVector(c));
+  b = c;
+  EXPECT_EQ(std::vector<int>({1, 2, 3}), ToVector(b));
+}
+
+// Moves batches of state.range(0) elements from one queue into another and
+// then drains the second queue, the way packets travel from an output stream
+// shard into an input stream queue.
+template <typename SourceQueue, typename DestinationQueue>
+void BM_TransferBatches(benchmark::State& state) {
+  const int batch_size = state.range(0);
+  SourceQueue source;
+  DestinationQueue destination;
+  const auto value = std::make_shared<int>(0);
+  for (auto _ : state) {
+    for (int i = 0; i < batch_size; ++i) {
+      source.push_back(value);
+    }
+    for (auto& element : source) {
+      destination.push_back(std::move(element));
+    }
+    source.clear();
+    while (!destination.empty()) {
+      destination.pop_front();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size);
+}
+
+using SharedInt = std::shared_ptr<int>;
+BENCHMARK_TEMPLATE(BM_TransferBatches, std::list<SharedInt>,
+                   std::deque<SharedInt>)
+    ->Arg(1)
+    ->Arg(16)
+    ->Arg(256);
+BENCHMARK_TEMPLATE(BM_TransferBatches, RingBuffer<SharedInt>,
+                   RingBuffer<SharedInt>)
+    ->Arg(1)
+    ->Arg(16)
+    ->Arg(256);
+
+}  // namespace
+}  // namespace mediapipe
@@ -435,6 +435,22 @@ void Scheduler::AddNodeToSourcesQueue(CalculatorNode* node) {
   unopened_sources_.erase(node);
 }
 
+void Scheduler::UseLockFreeQueues(int num_nodes) {
+  CHECK_EQ(state_, STATE_NOT_STARTED)
+      << "UseLockFreeQueues must not be called after the scheduler has "
+         "started";
+  for (auto queue : scheduler_queues_) {
+    queue->UseLockFreeQueue(num_nodes);
+  }
+}
+
+void Scheduler::SetQueueTimingEnabled(bool enabled) {
+  CHECK_EQ(state_, STATE_NOT_STARTED)
+      << "SetQueueTimingEnabled must not be called after the scheduler has "
+         "started";
+  shared_.timer.SetQueueTimingEnabled(enabled);
+}
+
 void Scheduler::AssignNodeToSchedulerQueue(CalculatorNode* node) {
   SchedulerQueue* queue;
   if (!node->Executor().empty()) {
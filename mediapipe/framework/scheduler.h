@@ -16,6 +16,7 @@
 #define MEDIAPIPE_FRAMEWORK_SCHEDULER_H_
 
 #include <atomic>
+#include <deque>
 #include <functional>
 #include <map>
 #include <memory>
@@ -123,6 +124,16 @@ class Scheduler {
   // Assigns node to a scheduler queue.
   void AssignNodeToSchedulerQueue(CalculatorNode* node);
 
+  // Makes all scheduler queues add nodes without taking a lock, for a graph
+  // with |num_nodes| nodes. See SchedulerQueue::UseLockFreeQueue.
+  // This can only be called before the scheduler is started.
+  void UseLockFreeQueues(int num_nodes);
+
+  // Enables or disables timing of the scheduler queue operations reported in
+  // GetSchedulerTimes(). This can only be called before the scheduler is
+  // started.
+  void SetQueueTimingEnabled(bool enabled);
+
   // Pauses the scheduler.  Does nothing if Cancel has been called.
   void Pause() LOCKS_EXCLUDED(state_mutex_);
 
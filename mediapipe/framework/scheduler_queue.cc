@@ -16,9 +16,12 @@
 
 #include <memory>
 #include <queue>
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
 
+#include "absl/memory/memory.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/types/optional.h"
 #include "mediapipe/framework/calculator_node.h"
 #include "mediapipe/framework/executor.h"
 #include "mediapipe/framework/port/canonical_errors.h"
@@ -39,6 +42,8 @@ SchedulerQueue::Item::Item(CalculatorNode* node, CalculatorContext* cc)
   if (is_source_) {
     layer_ = node->source_layer();
     source_process_order_ = node->SourceProcessOrder(cc).Value();
+  } else {
+    priority_rank_ = node->priority_rank();
   }
 }
 
@@ -77,30 +82,41 @@ bool SchedulerQueue::Item::operator<(const SchedulerQueue::Item& that) const {
   } else {
     // Non-sources run before sources.
     if (that.is_source_) return false;
-    // For non-sources, higher ids run before lower ids.
-    return id_ < that.id_;
+    // For non-sources, lower ranks run before higher ranks.
+    return priority_rank_ > that.priority_rank_;
   }
 }
 
+int SchedulerQueue::Item::PriorityBucket(int num_nodes) const {
+  // OpenNode() items come first, lower ids first.
+  if (is_open_node_) return id_;
+  // Sources are ordered by the std::priority_queue.
+  if (is_source_) return -1;
+  // Then non-sources, lower ranks first.
+  return num_nodes + priority_rank_;
+}
+
 void SchedulerQueue::Reset() {
-  absl::MutexLock lock(&mutex_);
   num_pending_tasks_ = 0;
   num_tasks_to_add_ = 0;
   running_count_ = 0;
 }
 
-void SchedulerQueue::SetExecutor(Executor* executor) { executor_ = executor; }
-
-bool SchedulerQueue::IsIdle() {
-  VLOG(3) << "Scheduler queue empty: " << queue_.empty()
-          << ", # of pending tasks: " << num_pending_tasks_;
-  return queue_.empty() && num_pending_tasks_ == 0;
+void SchedulerQueue::UseLockFreeQueue(int num_nodes) {
+  absl::MutexLock lock(&mutex_);
+  CHECK(queue_.empty());
+  if (bucket_queue_ && num_nodes_ == num_nodes) {
+    return;
+  }
+  num_nodes_ = num_nodes;
+  bucket_queue_ = absl::make_unique<PriorityBucketQueue<Item>>(2 * num_nodes);
 }
 
+void SchedulerQueue::SetExecutor(Executor* executor) { executor_ = executor; }
+
 void SchedulerQueue::SetRunning(bool running) {
-  absl::MutexLock lock(&mutex_);
-  running_count_ += running ? 1 : -1;
-  DCHECK_LE(running_count_, 1);
+  const int running_count = running_count_.fetch_add(running ? 1 : -1);
+  DCHECK_LE(running_count + (running ? 1 : -1), 1);
 }
 
 void SchedulerQueue::AddNode(CalculatorNode* node, CalculatorContext* cc) {
@@ -126,23 +142,65 @@ void SchedulerQueue::AddNodeForOpen(CalculatorNode* node) {
   AddItemToQueue(Item(node));
 }
 
+void SchedulerQueue::PushItem(Item&& item) {
+  if (bucket_queue_) {
+    const int bucket = item.PriorityBucket(num_nodes_);
+    if (bucket >= 0) {
+      bucket_queue_->Push(bucket, std::move(item));
+      return;
+    }
+  }
+  absl::MutexLock lock(&mutex_);
+  queue_.push(std::move(item));
+}
+
+SchedulerQueue::Item SchedulerQueue::PopItem() {
+  while (true) {
+    {
+      absl::MutexLock lock(&mutex_);
+      if (bucket_queue_) {
+        absl::optional<Item> item;
+        if (bucket_queue_->Pop(&item)) {
+          return *item;
+        }
+      }
+      if (!bucket_queue_ || !queue_.empty()) {
+        CHECK(!queue_.empty()) << "Called RunNextTask when the queue is empty. "
+                                  "This should not happen.";
+        Item item = queue_.top();
+        queue_.pop();
+        return item;
+      }
+    }
+    // The item for this task is still being pushed by another thread. Other
+    // tasks may pop their items meanwhile.
+    std::this_thread::yield();
+  }
+}
+
 void SchedulerQueue::AddItemToQueue(Item&& item) {
   const CalculatorNode* node = item.Node();
-  bool was_idle;
+  const int64 start_time = shared_->timer.StartQueueOperation();
+  // Count the item before it becomes visible to RunNextTask, so that the
+  // queue cannot become idle while the item is queued.
+  const bool was_idle = num_unfinished_items_.fetch_add(1) == 0;
+  PushItem(std::move(item));
+  VLOG(4) << node->DebugName() << " was added to the scheduler queue.";
+
+  // The task for this item is submitted by this thread, so that it cannot run
+  // before idle_callback_(false) below. Any waiting tasks are gathered too.
   int tasks_to_add = 0;
-  {
-    absl::MutexLock lock(&mutex_);
-    was_idle = IsIdle();
-    queue_.push(item);
+  if (running_count_ > 0) {
+    num_pending_tasks_ += 1;
+    tasks_to_add = 1 + GetTasksToSubmitToExecutor();
+  } else {
     ++num_tasks_to_add_;
-    VLOG(4) << node->DebugName() << " was added to the scheduler queue.";
-
-    // Now grab the tasks to execute while still holding the lock. This will
-    // gather any waiting tasks, in addition to the one we just added.
+    // Pick up the task if SetRunning(true) happened since the check above.
     if (running_count_ > 0) {
       tasks_to_add = GetTasksToSubmitToExecutor();
     }
   }
+  shared_->timer.EndQueueOperation(start_time);
   if (was_idle && idle_callback_) {
     // Became not idle.
     idle_callback_(false);
@@ -158,8 +216,7 @@ void SchedulerQueue::AddItemToQueue(Item&& item) {
 }
 
 int SchedulerQueue::GetTasksToSubmitToExecutor() {
-  int tasks_to_add = num_tasks_to_add_;
-  num_tasks_to_add_ = 0;
+  const int tasks_to_add = num_tasks_to_add_.exchange(0);
   num_pending_tasks_ += tasks_to_add;
   return tasks_to_add;
 }
@@ -169,11 +226,8 @@ void SchedulerQueue::SubmitWaitingTasksToExecutor() {
   // we do not immediately submit tasks to the executor. Here we check for any
   // such waiting tasks, and submit them.
   int tasks_to_add = 0;
-  {
-    absl::MutexLock lock(&mutex_);
-    if (running_count_ > 0) {
-      tasks_to_add = GetTasksToSubmitToExecutor();
-    }
+  if (running_count_ > 0) {
+    tasks_to_add = GetTasksToSubmitToExecutor();
   }
   while (tasks_to_add > 0) {
     executor_->AddTask(this);
@@ -182,23 +236,14 @@ void SchedulerQueue::SubmitWaitingTasksToExecutor() {
 }
 
 void SchedulerQueue::RunNextTask() {
-  CalculatorNode* node;
-  CalculatorContext* calculator_context;
-  bool is_open_node;
-  {
-    absl::MutexLock lock(&mutex_);
-
-    CHECK(!queue_.empty()) << "Called RunNextTask when the queue is empty. "
-                              "This should not happen.";
-
-    node = queue_.top().Node();
-    calculator_context = queue_.top().Context();
-    is_open_node = queue_.top().IsOpenNode();
-    queue_.pop();
-
-    CHECK(!node->Closed())
-        << "Scheduled a node that was closed. This should not happen.";
-  }
+  const int64 start_time = shared_->timer.StartQueueOperation();
+  const Item item = PopItem();
+  shared_->timer.EndQueueOperation(start_time);
+  CalculatorNode* node = item.Node();
+  CalculatorContext* calculator_context = item.Context();
+  const bool is_open_node = item.IsOpenNode();
+  CHECK(!node->Closed())
+      << "Scheduled a node that was closed. This should not happen.";
 
   // On iOS, calculators may rely on the existence of an autorelease pool
   // (either directly, or because system code they call does). We do not
@@ -214,13 +259,11 @@ void SchedulerQueue::RunNextTask() {
     }
   }
 
-  bool is_idle;
-  {
-    absl::MutexLock lock(&mutex_);
-    DCHECK_GT(num_pending_tasks_, 0);
-    --num_pending_tasks_;
-    is_idle = IsIdle();
-  }
+  const int num_pending_tasks = num_pending_tasks_.fetch_sub(1);
+  DCHECK_GT(num_pending_tasks, 0);
+  const bool is_idle = num_unfinished_items_.fetch_sub(1) == 1;
+  VLOG(3) << "Scheduler queue idle: " << is_idle
+          << ", # of pending tasks: " << num_pending_tasks - 1;
   if (is_idle && idle_callback_) {
     // Became idle.
     idle_callback_(true);
@@ -294,13 +337,17 @@ void SchedulerQueue::CleanupAfterRun() {
   bool was_idle;
   {
     absl::MutexLock lock(&mutex_);
-    was_idle = IsIdle();
-    CHECK_EQ(num_pending_tasks_, 0);
-    CHECK_EQ(num_tasks_to_add_, queue_.size());
-    num_tasks_to_add_ = 0;
+    int num_items = queue_.size();
     while (!queue_.empty()) {
       queue_.pop();
     }
+    if (bucket_queue_) {
+      num_items += bucket_queue_->Clear();
+    }
+    CHECK_EQ(num_pending_tasks_.load(), 0);
+    CHECK_EQ(num_tasks_to_add_.load(), num_items);
+    num_tasks_to_add_ = 0;
+    was_idle = num_unfinished_items_.fetch_sub(num_items) == 0;
   }
   if (!was_idle && idle_callback_) {
     // Became idle.
@@ -26,6 +26,7 @@
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/executor.h"
 #include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/priority_bucket_queue.h"
 #include "mediapipe/framework/scheduler_shared.h"
 
 namespace mediapipe {
@@ -35,6 +36,13 @@ class CalculatorNode;
 namespace internal {
 
 // Manages a priority queue of nodes to be run on the associated executor.
+//
+// By default the queue is a std::priority_queue guarded by a mutex. After
+// UseLockFreeQueue() is called, OpenNode() and non-source items are kept in a
+// PriorityBucketQueue instead, with one bucket per node and kind of task, so
+// that adding them does not take a lock. Source items stay in the
+// std::priority_queue, which preserves their layer and SourceProcessOrder
+// ordering.
 class SchedulerQueue : public TaskQueue {
  public:
   // Callback to be invoked when the queue's idle state changes.
@@ -62,16 +70,23 @@ class SchedulerQueue : public TaskQueue {
     // - Sources are sorted by layer (lower layer numbers run first), then by
     //   Calculator::SourceProcessOrder (smaller values run first), then by
     //   node id: smaller ids run first, since they come earlier in the config.
-    // - Non-sources are sorted by node id: larger ids run first, because they
-    //   are closer to the leaves.
+    // - Non-sources are sorted by CalculatorNode::priority_rank(): lower ranks
+    //   run first. By default larger ids get lower ranks, because they are
+    //   closer to the leaves.
     bool operator<(const Item& that) const;
 
+    // Returns the PriorityBucketQueue bucket of this item in a graph with
+    // "num_nodes" nodes, or -1 for source items. Lower buckets run first,
+    // consistent with operator<.
+    int PriorityBucket(int num_nodes) const;
+
    private:
     int64 source_process_order_ = 0;
     CalculatorNode* node_;
     CalculatorContext* cc_;
     int id_ = 0;
     int layer_ = 0;
+    int priority_rank_ = 0;
     bool is_source_ = false;
     bool is_open_node_ = false;  // True if the task should run OpenNode().
   };
@@ -99,19 +114,24 @@ class SchedulerQueue : public TaskQueue {
   // Resets the data members at the beginning of each graph run.
   void Reset();
 
+  // Keeps OpenNode() and non-source items in a lock-free PriorityBucketQueue
+  // sized for "num_nodes" nodes. Must be called before the scheduler is
+  // started, while the queue is empty.
+  void UseLockFreeQueue(int num_nodes);
+
   // Implements the TaskQueue interface.
   void RunNextTask() override;
 
   // NOTE: After calling SetRunning(true), the caller must call
   // SubmitWaitingTasksToExecutor since tasks may have been added while the
   // queue was not running.
-  void SetRunning(bool running) LOCKS_EXCLUDED(mutex_);
+  void SetRunning(bool running);
 
   // Gets the number of tasks that need to be submitted to the executor, and
   // updates num_pending_tasks_. If this method is called and returns a
   // non-zero value, the executor's AddTask method *must* be called for each
-  // task returned, but it can be called without holding the lock.
-  int GetTasksToSubmitToExecutor() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // task returned.
+  int GetTasksToSubmitToExecutor();
 
   // Submits tasks that are waiting (e.g. that were added while the queue was
   // not running) if the queue is running. The caller must not hold any mutex.
@@ -142,8 +162,12 @@ class SchedulerQueue : public TaskQueue {
   // CheckIfBecameReady.
   void OpenCalculatorNode(CalculatorNode* node) LOCKS_EXCLUDED(mutex_);
 
-  // Checks whether the queue has no queued nodes or pending tasks.
-  bool IsIdle() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Stores "item" in bucket_queue_ or queue_.
+  void PushItem(Item&& item) LOCKS_EXCLUDED(mutex_);
+
+  // Removes the highest-priority item. An item must have been added for
+  // every call.
+  Item PopItem() LOCKS_EXCLUDED(mutex_);
 
   Executor* executor_ = nullptr;
 
@@ -154,19 +178,32 @@ class SchedulerQueue : public TaskQueue {
   // decrements it. The queue is running if running_count_ > 0. A running
   // queue will submit tasks to the executor.
   // Invariant: running_count_ <= 1.
-  int running_count_ GUARDED_BY(mutex_) = 0;
+  std::atomic<int> running_count_{0};
 
   // Number of tasks added to the Executor and not yet complete.
-  int num_pending_tasks_ GUARDED_BY(mutex_);
+  std::atomic<int> num_pending_tasks_{0};
 
   // Number of tasks that need to be added to the Executor.
-  int num_tasks_to_add_ GUARDED_BY(mutex_);
+  std::atomic<int> num_tasks_to_add_{0};
+
+  // Number of items that were added and whose task has not yet completed.
+  // The queue is idle when this is zero. An item is counted before it becomes
+  // visible to RunNextTask, so the queue never looks idle while it holds
+  // items.
+  std::atomic<int> num_unfinished_items_{0};
 
-  // Queue of nodes that need to be run.
+  // Queue of nodes that need to be run. In lock-free mode it only holds
+  // source nodes.
   std::priority_queue<Item> queue_ GUARDED_BY(mutex_);
 
+  // Lock-free queue of OpenNode() and non-source items, or null if
+  // UseLockFreeQueue() was not called. Popped while holding mutex_.
+  std::unique_ptr<PriorityBucketQueue<Item>> bucket_queue_;
+  int num_nodes_ = 0;
+
   SchedulerShared* const shared_;
 
+  // Guards queue_, and serializes removals from bucket_queue_.
   absl::Mutex mutex_;
 };
 
@@ -23,6 +23,7 @@
 
 #include "absl/base/macros.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
 #include "mediapipe/framework/deps/clock.h"
 #include "mediapipe/framework/deps/monotonic_clock.h"
 #include "mediapipe/framework/port/integral_types.h"
@@ -37,6 +38,14 @@ struct SchedulerTimes {
   int64 total_time;
   // Total time spent running nodes, in microseconds.
   int64 node_time;
+  // Total time spent adding nodes to and taking nodes from the scheduler
+  // queues, including time spent waiting for locks, in microseconds. Only
+  // measured with LOCK_FREE_BUCKETS scheduler queues or with the profiler
+  // enabled, and zero otherwise.
+  int64 queue_time;
+  // Number of times a node was added to or taken from a scheduler queue.
+  // Only counted when queue_time is measured.
+  int64 num_queue_operations;
   // The fraction of total time which was not spent running nodes. Only valid
   // when the graph is run on a single thread.
   double overhead() const {
@@ -62,6 +71,8 @@ class SchedulerTimer {
   void StartRun() {
     start_time_ = absl::ToUnixMicros(clock_->TimeNow());
     total_node_time_ = 0;
+    total_queue_time_ns_ = 0;
+    num_queue_operations_ = 0;
   }
   // Called when terminating the scheduler.
   void EndRun() {
@@ -77,10 +88,34 @@ class SchedulerTimer {
         std::memory_order_relaxed);
   }
 
+  // Enables or disables timing of scheduler queue operations. Called before
+  // starting the scheduler. Disabled by default, since it adds two clock
+  // reads and two atomic additions to every queue operation.
+  void SetQueueTimingEnabled(bool enabled) { queue_timing_enabled_ = enabled; }
+
+  // Called immediately before and after adding a node to or taking a node
+  // from a scheduler queue. These use absl::GetCurrentTimeNanos(), which
+  // unlike clock_ does not synchronize between threads. They do nothing
+  // unless queue timing is enabled.
+  int64 StartQueueOperation() {
+    return queue_timing_enabled_ ? absl::GetCurrentTimeNanos() : 0;
+  }
+  void EndQueueOperation(int64 operation_start_time) {
+    if (!queue_timing_enabled_) {
+      return;
+    }
+    total_queue_time_ns_.fetch_add(
+        absl::GetCurrentTimeNanos() - operation_start_time,
+        std::memory_order_relaxed);
+    num_queue_operations_.fetch_add(1, std::memory_order_relaxed);
+  }
+
   SchedulerTimes GetSchedulerTimes() {
     internal::SchedulerTimes result;
     result.total_time = total_run_time_;
     result.node_time = total_node_time_;
+    result.queue_time = total_queue_time_ns_ / 1000;
+    result.num_queue_operations = num_queue_operations_;
     return result;
   }
 
@@ -91,6 +126,14 @@ class SchedulerTimer {
   // Time spent actually running nodes, in microseconds.
   std::atomic<int64> total_node_time_;
 
+  // Whether scheduler queue operations are timed.
+  bool queue_timing_enabled_ = false;
+
+  // Time spent in scheduler queue operations, in nanoseconds.
+  std::atomic<int64> total_queue_time_ns_;
+  // Number of scheduler queue operations.
+  std::atomic<int64> num_queue_operations_;
+
   // The start time of the graph, in microseconds.
   int64 start_time_;
   // Total time spent running the graph, in microseconds.
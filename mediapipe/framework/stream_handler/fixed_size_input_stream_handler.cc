@@ -65,6 +65,10 @@ class FixedSizeInputStreamHandler : public DefaultInputStreamHandler {
     // implementation of SetLatePreparation.
   }
 
+  // Keeps the std::list overloads visible next to the overrides below.
+  using InputStreamHandler::AddPackets;
+  using InputStreamHandler::MovePackets;
+
  private:
   // Drops packets if all input streams exceed trigger_queue_size.
   void EraseAllSurplus() EXCLUSIVE_LOCKS_REQUIRED(erase_mutex_) {
@@ -174,7 +178,7 @@ class FixedSizeInputStreamHandler : public DefaultInputStreamHandler {
   }
 
   void AddPackets(CollectionItemId id,
-                  const std::list<Packet>& packets) override {
+                  const RingBuffer<Packet>& packets) override {
     InputStreamHandler::AddPackets(id, packets);
     absl::MutexLock lock(&erase_mutex_);
     if (!pending_) {
@@ -182,7 +186,7 @@ class FixedSizeInputStreamHandler : public DefaultInputStreamHandler {
     }
   }
 
-  void MovePackets(CollectionItemId id, std::list<Packet>* packets) override {
+  void MovePackets(CollectionItemId id, RingBuffer<Packet>* packets) override {
     InputStreamHandler::MovePackets(id, packets);
     absl::MutexLock lock(&erase_mutex_);
     if (!pending_) {
@@ -25,6 +25,7 @@
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/ring_buffer.h"
 #include "mediapipe/framework/tool/tag_map.h"
 #include "mediapipe/framework/tool/tag_map_helper.h"
 
@@ -173,6 +174,23 @@ TEST_F(ImmediateInputStreamHandlerTest, AnyPacketsReady) {
   ExpectPackets(cc_->Inputs(), {{"input_a", "packet 1"}});
 }
 
+// This test checks that packets held in a RingBuffer can be added and moved
+// into the input streams.
+TEST_F(ImmediateInputStreamHandlerTest, RingBufferPacketsReady) {
+  Timestamp min_stream_timestamp;
+  RingBuffer<Packet> packets;
+  packets.push_back(Adopt(new std::string("packet 1")).At(Timestamp(10)));
+  input_stream_handler_->AddPackets(name_to_id_["input_a"], packets);
+  EXPECT_EQ(1, packets.size());
+  packets.clear();
+  packets.push_back(Adopt(new std::string("packet 2")).At(Timestamp(10)));
+  input_stream_handler_->MovePackets(name_to_id_["input_b"], &packets);
+  ASSERT_TRUE(input_stream_handler_->ScheduleInvocations(
+      /*max_allowance=*/1, &min_stream_timestamp));
+  ExpectPackets(cc_->Inputs(),
+                {{"input_a", "packet 1"}, {"input_b", "packet 2"}});
+}
+
 // This test checks that a node is considered ready for Process() if any of the
 // input streams has become done.
 TEST_F(ImmediateInputStreamHandlerTest, StreamDoneReady) {
@@ -14,16 +14,83 @@
 
 #include "mediapipe/framework/thread_pool_executor.h"
 
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <set>
 #include <utility>
 
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include "absl/memory/memory.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/status_builder.h"
+#include "mediapipe/framework/port/status_macros.h"
 #include "mediapipe/framework/thread_pool_executor.pb.h"
 #include "mediapipe/util/cpu_util.h"
 
 namespace mediapipe {
 
+namespace {
+
+// The processor ids must be less than this to fit in an affinity mask.
+#if defined(__linux__)
+constexpr int kMaxCpuId = CPU_SETSIZE;
+#else
+constexpr int kMaxCpuId = std::numeric_limits<int>::max();
+#endif
+
+// Returns the processors listed in the cpu field of "options" that belong to
+// the NUMA nodes listed in its numa_node field. If one of the fields is empty,
+// it does not restrict the result.
+::mediapipe::StatusOr<std::set<int>> GetAllowedCpuIds(
+    const ThreadPoolExecutorOptions& options) {
+  std::set<int> cpu_set;
+  for (const int cpu : options.cpu()) {
+    if (cpu < 0) {
+      return ::mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "The cpu field in ThreadPoolExecutorOptions should be "
+                "non-negative but is "
+             << cpu;
+    }
+    if (cpu >= kMaxCpuId) {
+      return ::mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "The cpu field in ThreadPoolExecutorOptions should be less "
+                "than "
+             << kMaxCpuId << " but is " << cpu;
+    }
+    cpu_set.insert(cpu);
+  }
+  if (options.numa_node_size() == 0) {
+    return cpu_set;
+  }
+  std::set<int> numa_cpu_set;
+  for (const int numa_node : options.numa_node()) {
+    ASSIGN_OR_RETURN(std::set<int> node_cpu_set, GetNumaNodeCpuIds(numa_node));
+    // Processors that cannot be in an affinity mask are left out.
+    numa_cpu_set.insert(node_cpu_set.begin(),
+                        node_cpu_set.lower_bound(kMaxCpuId));
+  }
+  if (cpu_set.empty()) {
+    return numa_cpu_set;
+  }
+  std::set<int> allowed_cpu_set;
+  std::set_intersection(cpu_set.begin(), cpu_set.end(), numa_cpu_set.begin(),
+                        numa_cpu_set.end(),
+                        std::inserter(allowed_cpu_set, allowed_cpu_set.end()));
+  if (allowed_cpu_set.empty()) {
+    return ::mediapipe::InvalidArgumentError(
+        "None of the processors in the cpu field of ThreadPoolExecutorOptions "
+        "belong to the NUMA nodes in the numa_node field.");
+  }
+  return allowed_cpu_set;
+}
+
+}  // namespace
+
 // static
 ::mediapipe::StatusOr<Executor*> ThreadPoolExecutor::Create(
     const MediaPipeOptions& extendable_options) {
@@ -71,21 +138,43 @@ namespace mediapipe {
       break;
   }
 #endif
-  return new ThreadPoolExecutor(thread_options, options.num_threads());
+  if (options.cpu_size() > 0 || options.numa_node_size() > 0) {
+    ASSIGN_OR_RETURN(std::set<int> cpu_set, GetAllowedCpuIds(options));
+    thread_options.set_cpu_set(cpu_set);
+    thread_options.set_numa_memory_nodes(std::set<int>(
+        options.numa_node().begin(), options.numa_node().end()));
+  }
+  if (options.pin_one_thread_per_cpu()) {
+    if (thread_options.cpu_set().empty()) {
+      // Pins to the processors this process may run on, which may be fewer
+      // than NumCPUCores() or not numbered from 0, e.g. in a container.
+      thread_options.set_cpu_set(GetAffinityCpuIds());
+    }
+    thread_options.set_pin_one_thread_per_cpu(true);
+  }
+  return new ThreadPoolExecutor(
+      thread_options, options.num_threads(),
+      options.queueing_policy() == ThreadPoolExecutorOptions::WORK_STEALING);
 }
 
 ThreadPoolExecutor::ThreadPoolExecutor(int num_threads)
-    : thread_pool_("mediapipe", num_threads) {
-  Start();
-}
+    : ThreadPoolExecutor(num_threads, /*work_stealing=*/false) {}
+
+ThreadPoolExecutor::ThreadPoolExecutor(int num_threads, bool work_stealing)
+    : ThreadPoolExecutor(ThreadOptions(), num_threads, work_stealing) {}
 
 ThreadPoolExecutor::ThreadPoolExecutor(const ThreadOptions& thread_options,
-                                       int num_threads)
-    : thread_pool_(thread_options,
-                   thread_options.name_prefix().empty()
-                       ? "mediapipe"
-                       : thread_options.name_prefix(),
-                   num_threads) {
+                                       int num_threads, bool work_stealing) {
+  const std::string name_prefix = thread_options.name_prefix().empty()
+                                      ? "mediapipe"
+                                      : thread_options.name_prefix();
+  if (work_stealing) {
+    work_stealing_pool_ = absl::make_unique<WorkStealingThreadPool>(
+        thread_options, name_prefix, num_threads);
+  } else {
+    thread_pool_ = absl::make_unique<::mediapipe::ThreadPool>(
+        thread_options, name_prefix, num_threads);
+  }
   Start();
 }
 
@@ -94,14 +183,23 @@ ThreadPoolExecutor::~ThreadPoolExecutor() {
 }
 
 void ThreadPoolExecutor::Schedule(std::function<void()> task) {
-  thread_pool_.Schedule(std::move(task));
+  if (thread_pool_) {
+    thread_pool_->Schedule(std::move(task));
+  } else {
+    work_stealing_pool_->Schedule(std::move(task));
+  }
 }
 
 void ThreadPoolExecutor::Start() {
-  stack_size_ = thread_pool_.thread_options().stack_size();
-  thread_pool_.StartWorkers();
-  VLOG(2) << "Started thread pool with " << thread_pool_.num_threads()
-          << " threads.";
+  if (thread_pool_) {
+    stack_size_ = thread_pool_->thread_options().stack_size();
+    thread_pool_->StartWorkers();
+  } else {
+    stack_size_ = work_stealing_pool_->thread_options().stack_size();
+    work_stealing_pool_->StartWorkers();
+  }
+  VLOG(2) << "Started " << (work_stealing() ? "work-stealing " : "")
+          << "thread pool with " << num_threads() << " threads.";
 }
 
 REGISTER_EXECUTOR(ThreadPoolExecutor);
@@ -15,35 +15,50 @@
 #ifndef MEDIAPIPE_FRAMEWORK_THREAD_POOL_EXECUTOR_H_
 #define MEDIAPIPE_FRAMEWORK_THREAD_POOL_EXECUTOR_H_
 
+#include <memory>
+
 #include "mediapipe/framework/deps/thread_options.h"
+#include "mediapipe/framework/deps/work_stealing_threadpool.h"
 #include "mediapipe/framework/executor.h"
 #include "mediapipe/framework/port/statusor.h"
 #include "mediapipe/framework/port/threadpool.h"
 
 namespace mediapipe {
 
-// A multithreaded executor based on a thread pool.
+// A multithreaded executor based on a thread pool. Depending on the
+// queueing_policy in ThreadPoolExecutorOptions, tasks are run by a ThreadPool
+// with a single shared queue or by a WorkStealingThreadPool.
 class ThreadPoolExecutor : public Executor {
  public:
   static ::mediapipe::StatusOr<Executor*> Create(
       const MediaPipeOptions& extendable_options);
 
   explicit ThreadPoolExecutor(int num_threads);
+  // Creates an executor backed by a WorkStealingThreadPool if "work_stealing"
+  // is true.
+  ThreadPoolExecutor(int num_threads, bool work_stealing);
   ~ThreadPoolExecutor() override;
   void Schedule(std::function<void()> task) override;
 
   // For testing.
-  int num_threads() const { return thread_pool_.num_threads(); }
+  int num_threads() const {
+    return thread_pool_ ? thread_pool_->num_threads()
+                        : work_stealing_pool_->num_threads();
+  }
+  bool work_stealing() const { return work_stealing_pool_ != nullptr; }
   // Returns the thread stack size (in bytes).
   size_t stack_size() const { return stack_size_; }
 
  private:
-  ThreadPoolExecutor(const ThreadOptions& thread_options, int num_threads);
+  ThreadPoolExecutor(const ThreadOptions& thread_options, int num_threads,
+                     bool work_stealing);
 
   // Saves the value of the stack size option and starts the thread pool.
   void Start();
 
-  ::mediapipe::ThreadPool thread_pool_;
+  // Exactly one of the two thread pools is created.
+  std::unique_ptr<::mediapipe::ThreadPool> thread_pool_;
+  std::unique_ptr<WorkStealingThreadPool> work_stealing_pool_;
 
   // Records the stack size in ThreadOptions right before we call
   // thread_pool_.StartWorkers().
@@ -0,0 +1,261 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/tool/packet_codec.h"
+
+#include <cstring>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/formats/detection.pb.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/port/canonical_errors.h"
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+
+::mediapipe::Status SerializePacket(const Packet& packet,
+                                    std::string* type_name,
+                                    std::string* encoding) {
+  RET_CHECK(!packet.IsEmpty()) << "Cannot serialize an empty packet.";
+  const MediaPipeTypeData* type_data =
+      PacketTypeIdToMediaPipeTypeData::GetValue(packet.GetTypeId());
+  if (type_data == nullptr || !type_data->serialize_fn) {
+    return ::mediapipe::UnimplementedError(absl::StrCat(
+        "No serialization function is registered for type ",
+        packet.DebugTypeName(), "."));
+  }
+  *type_name = type_data->type_string;
+  encoding->clear();
+  return type_data->serialize_fn(*packet_internal::GetHolder(packet), encoding);
+}
+
+::mediapipe::StatusOr<Packet> DeserializePacket(const std::string& type_name,
+                                                const std::string& encoding,
+                                                Timestamp timestamp) {
+  const MediaPipeTypeData* type_data =
+      PacketTypeStringToMediaPipeTypeData::GetValue(type_name);
+  if (type_data == nullptr || !type_data->deserialize_fn) {
+    return ::mediapipe::UnimplementedError(absl::StrCat(
+        "No deserialization function is registered for type ", type_name,
+        "."));
+  }
+  std::unique_ptr<packet_internal::HolderBase> holder;
+  RETURN_IF_ERROR(type_data->deserialize_fn(encoding, &holder));
+  RET_CHECK(holder);
+  return packet_internal::Create(holder.release(), timestamp);
+}
+
+namespace {
+
+// Appends the bytes of a trivially copyable value to "output".
+template <typename T>
+void AppendRaw(const T& value, std::string* output) {
+  output->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Reads a trivially copyable value at "*offset" in "input", and advances
+// "*offset" past it.
+template <typename T>
+::mediapipe::Status ReadRaw(const std::string& input, size_t* offset,
+                            T* value) {
+  RET_CHECK_LE(*offset + sizeof(T), input.size()) << "Truncated encoding.";
+  std::memcpy(value, input.data() + *offset, sizeof(T));
+  *offset += sizeof(T);
+  return ::mediapipe::OkStatus();
+}
+
+template <typename T>
+::mediapipe::Status SerializeRaw(const packet_internal::HolderBase& holder_base,
+                                 std::string* output) {
+  const packet_internal::Holder<T>* holder = holder_base.As<T>();
+  RET_CHECK(holder);
+  AppendRaw(holder->data(), output);
+  return ::mediapipe::OkStatus();
+}
+
+template <typename T>
+::mediapipe::Status DeserializeRaw(
+    const std::string& encoding,
+    std::unique_ptr<packet_internal::HolderBase>* holder_base) {
+  std::unique_ptr<T> value(new T);
+  size_t offset = 0;
+  RETURN_IF_ERROR(ReadRaw(encoding, &offset, value.get()));
+  RET_CHECK_EQ(offset, encoding.size());
+  holder_base->reset(new packet_internal::Holder<T>(value.release()));
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status SerializeString(
+    const packet_internal::HolderBase& holder_base, std::string* output) {
+  const packet_internal::Holder<std::string>* holder =
+      holder_base.As<std::string>();
+  RET_CHECK(holder);
+  *output = holder->data();
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status DeserializeString(
+    const std::string& encoding,
+    std::unique_ptr<packet_internal::HolderBase>* holder_base) {
+  holder_base->reset(
+      new packet_internal::Holder<std::string>(new std::string(encoding)));
+  return ::mediapipe::OkStatus();
+}
+
+// An ImageFrame is encoded as its format, width and height followed by its
+// pixel data stored contiguously.
+::mediapipe::Status SerializeImageFrame(
+    const packet_internal::HolderBase& holder_base, std::string* output) {
+  const packet_internal::Holder<ImageFrame>* holder =
+      holder_base.As<ImageFrame>();
+  RET_CHECK(holder);
+  const ImageFrame& frame = holder->data();
+  AppendRaw<int32>(frame.Format(), output);
+  AppendRaw<int32>(frame.Width(), output);
+  AppendRaw<int32>(frame.Height(), output);
+  if (frame.IsEmpty()) {
+    return ::mediapipe::OkStatus();
+  }
+  const int row_size =
+      frame.Width() * frame.NumberOfChannels() * frame.ByteDepth();
+  output->reserve(output->size() + row_size * frame.Height());
+  const char* row = reinterpret_cast<const char*>(frame.PixelData());
+  for (int y = 0; y < frame.Height(); ++y, row += frame.WidthStep()) {
+    output->append(row, row_size);
+  }
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status DeserializeImageFrame(
+    const std::string& encoding,
+    std::unique_ptr<packet_internal::HolderBase>* holder_base) {
+  int32 format, width, height;
+  size_t offset = 0;
+  RETURN_IF_ERROR(ReadRaw(encoding, &offset, &format));
+  RETURN_IF_ERROR(ReadRaw(encoding, &offset, &width));
+  RETURN_IF_ERROR(ReadRaw(encoding, &offset, &height));
+  auto frame = absl::make_unique<ImageFrame>();
+  if (offset < encoding.size()) {
+    RET_CHECK(ImageFormat::Format_IsValid(format));
+    RET_CHECK(width > 0 && height > 0);
+    const auto image_format = static_cast<ImageFormat::Format>(format);
+    RET_CHECK_EQ(encoding.size() - offset,
+                 static_cast<size_t>(width) * height *
+                     ImageFrame::NumberOfChannelsForFormat(image_format) *
+                     ImageFrame::ByteDepthForFormat(image_format));
+    frame->CopyPixelData(
+        image_format, width, height,
+        reinterpret_cast<const uint8*>(encoding.data() + offset),
+        ImageFrame::kDefaultAlignmentBoundary);
+  }
+  holder_base->reset(new packet_internal::Holder<ImageFrame>(frame.release()));
+  return ::mediapipe::OkStatus();
+}
+
+// A Matrix is encoded as its row and column counts followed by its
+// column-major coefficients.
+::mediapipe::Status SerializeMatrix(
+    const packet_internal::HolderBase& holder_base, std::string* output) {
+  const packet_internal::Holder<Matrix>* holder = holder_base.As<Matrix>();
+  RET_CHECK(holder);
+  const Matrix& matrix = holder->data();
+  AppendRaw<int32>(matrix.rows(), output);
+  AppendRaw<int32>(matrix.cols(), output);
+  output->append(reinterpret_cast<const char*>(matrix.data()),
+                 matrix.size() * sizeof(float));
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status DeserializeMatrix(
+    const std::string& encoding,
+    std::unique_ptr<packet_internal::HolderBase>* holder_base) {
+  int32 rows, cols;
+  size_t offset = 0;
+  RETURN_IF_ERROR(ReadRaw(encoding, &offset, &rows));
+  RETURN_IF_ERROR(ReadRaw(encoding, &offset, &cols));
+  RET_CHECK(rows >= 0 && cols >= 0);
+  RET_CHECK_EQ(encoding.size() - offset,
+               static_cast<size_t>(rows) * cols * sizeof(float));
+  auto matrix = absl::make_unique<Matrix>(rows, cols);
+  std::memcpy(matrix->data(), encoding.data() + offset,
+              encoding.size() - offset);
+  holder_base->reset(new packet_internal::Holder<Matrix>(matrix.release()));
+  return ::mediapipe::OkStatus();
+}
+
+// A vector of protobuf messages is encoded as a sequence of length-prefixed
+// messages.
+template <typename T>
+::mediapipe::Status SerializeProtoVector(
+    const packet_internal::HolderBase& holder_base, std::string* output) {
+  const packet_internal::Holder<std::vector<T>>* holder =
+      holder_base.As<std::vector<T>>();
+  RET_CHECK(holder);
+  std::string message_encoding;
+  for (const T& message : holder->data()) {
+    RET_CHECK(message.SerializeToString(&message_encoding));
+    AppendRaw<uint32>(message_encoding.size(), output);
+    output->append(message_encoding);
+  }
+  return ::mediapipe::OkStatus();
+}
+
+template <typename T>
+::mediapipe::Status DeserializeProtoVector(
+    const std::string& encoding,
+    std::unique_ptr<packet_internal::HolderBase>* holder_base) {
+  auto messages = absl::make_unique<std::vector<T>>();
+  size_t offset = 0;
+  while (offset < encoding.size()) {
+    uint32 size;
+    RETURN_IF_ERROR(ReadRaw(encoding, &offset, &size));
+    RET_CHECK_LE(offset + size, encoding.size()) << "Truncated encoding.";
+    messages->emplace_back();
+    RET_CHECK(messages->back().ParseFromArray(encoding.data() + offset, size));
+    offset += size;
+  }
+  holder_base->reset(
+      new packet_internal::Holder<std::vector<T>>(messages.release()));
+  return ::mediapipe::OkStatus();
+}
+
+}  // namespace
+
+MEDIAPIPE_REGISTER_TYPE(bool, "bool", SerializeRaw<bool>, DeserializeRaw<bool>);
+MEDIAPIPE_REGISTER_TYPE(int, "int", SerializeRaw<int>, DeserializeRaw<int>);
+MEDIAPIPE_REGISTER_TYPE(::int64, "::int64", SerializeRaw<int64>,
+                        DeserializeRaw<int64>);
+MEDIAPIPE_REGISTER_TYPE(float, "float", SerializeRaw<float>,
+                        DeserializeRaw<float>);
+MEDIAPIPE_REGISTER_TYPE(double, "double", SerializeRaw<double>,
+                        DeserializeRaw<double>);
+MEDIAPIPE_REGISTER_TYPE(::std::string, "::std::string", SerializeString,
+                        DeserializeString);
+MEDIAPIPE_REGISTER_TYPE(::mediapipe::ImageFrame, "::mediapipe::ImageFrame",
+                        SerializeImageFrame, DeserializeImageFrame);
+MEDIAPIPE_REGISTER_TYPE(::mediapipe::Matrix, "::mediapipe::Matrix",
+                        SerializeMatrix, DeserializeMatrix);
+MEDIAPIPE_REGISTER_TYPE(::mediapipe::Detection, "::mediapipe::Detection",
+                        SerializeProtoMessage<Detection>,
+                        DeserializeProtoMessage<Detection>);
+MEDIAPIPE_REGISTER_TYPE(::std::vector<::mediapipe::Detection>,
+                        "::std::vector<::mediapipe::Detection>",
+                        SerializeProtoVector<Detection>,
+                        DeserializeProtoVector<Detection>);
+
+}  // namespace mediapipe
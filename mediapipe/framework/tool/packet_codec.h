@@ -0,0 +1,74 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Serializes packets using the serialization functions registered for their
+// types with MEDIAPIPE_REGISTER_TYPE.  Serialization functions are registered
+// in packet_codec.cc for bool, int, int64, float, double, std::string,
+// ImageFrame, Matrix, Detection and std::vector<Detection>.  Other types can
+// be registered like:
+//
+//   MEDIAPIPE_REGISTER_TYPE(::mediapipe::MyProto, "::mediapipe::MyProto",
+//                           ::mediapipe::SerializeProtoMessage<MyProto>,
+//                           ::mediapipe::DeserializeProtoMessage<MyProto>);
+
+#ifndef MEDIAPIPE_FRAMEWORK_TOOL_PACKET_CODEC_H_
+#define MEDIAPIPE_FRAMEWORK_TOOL_PACKET_CODEC_H_
+
+#include <memory>
+#include <string>
+
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/framework/timestamp.h"
+#include "mediapipe/framework/type_map.h"
+
+namespace mediapipe {
+
+// Serializes the payload of "packet", and sets "type_name" to the registered
+// name of its type.  Fails if no serialization functions are registered for
+// the type.
+::mediapipe::Status SerializePacket(const Packet& packet,
+                                    std::string* type_name,
+                                    std::string* encoding);
+
+// Deserializes a packet payload of the registered type "type_name".
+::mediapipe::StatusOr<Packet> DeserializePacket(const std::string& type_name,
+                                                const std::string& encoding,
+                                                Timestamp timestamp);
+
+// Serialization functions for protobuf message types.
+template <typename T>
+::mediapipe::Status SerializeProtoMessage(
+    const packet_internal::HolderBase& holder_base, std::string* output) {
+  const packet_internal::Holder<T>* holder = holder_base.As<T>();
+  RET_CHECK(holder);
+  RET_CHECK(holder->data().SerializeToString(output));
+  return ::mediapipe::OkStatus();
+}
+
+template <typename T>
+::mediapipe::Status DeserializeProtoMessage(
+    const std::string& encoding,
+    std::unique_ptr<packet_internal::HolderBase>* holder_base) {
+  std::unique_ptr<T> message(new T);
+  RET_CHECK(message->ParseFromString(encoding));
+  holder_base->reset(new packet_internal::Holder<T>(message.release()));
+  return ::mediapipe::OkStatus();
+}
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_TOOL_PACKET_CODEC_H_
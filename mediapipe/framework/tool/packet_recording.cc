@@ -0,0 +1,510 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/tool/packet_recording.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <tuple>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/port/canonical_errors.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/tool/packet_codec.h"
+
+namespace mediapipe {
+
+namespace {
+
+constexpr char kHeaderMagic[] = "MPPKTREC";
+constexpr char kFooterMagic[] = "MPPKTEND";
+constexpr size_t kMagicSize = 8;
+constexpr uint32 kVersion = 1;
+constexpr size_t kHeaderSize = kMagicSize + 2 * sizeof(uint32);
+constexpr size_t kChunkHeaderSize = 2 * sizeof(uint32) + sizeof(uint64);
+constexpr size_t kRecordHeaderSize = 2 * sizeof(uint32) + 2 * sizeof(uint64);
+constexpr size_t kFooterSize = sizeof(uint64) + kMagicSize;
+
+enum ChunkKind : uint32 {
+  kStreamChunk = 1,
+  kPacketChunk = 2,
+  kIndexChunk = 3,
+};
+
+template <typename T>
+void AppendRaw(const T& value, std::string* output) {
+  output->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void AppendString(const std::string& value, std::string* output) {
+  AppendRaw<uint32>(value.size(), output);
+  output->append(value);
+}
+
+// Reads values from a range of the mapped file, with bounds checking.  A
+// range with begin > end, as read from a corrupt file, has no readable bytes.
+class Cursor {
+ public:
+  Cursor(const char* data, size_t begin, size_t end)
+      : data_(data), offset_(begin), end_(end) {}
+
+  template <typename T>
+  ::mediapipe::Status Read(T* value) {
+    RETURN_IF_ERROR(CheckRemaining(sizeof(T)));
+    std::memcpy(value, data_ + offset_, sizeof(T));
+    offset_ += sizeof(T);
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status ReadString(std::string* value) {
+    uint32 size;
+    RETURN_IF_ERROR(Read(&size));
+    RETURN_IF_ERROR(CheckRemaining(size));
+    value->assign(data_ + offset_, size);
+    offset_ += size;
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Skip(uint64 size) {
+    RETURN_IF_ERROR(CheckRemaining(size));
+    offset_ += size;
+    return ::mediapipe::OkStatus();
+  }
+
+  size_t offset() const { return offset_; }
+
+  // Returns the number of bytes left in the range.
+  size_t remaining() const { return offset_ <= end_ ? end_ - offset_ : 0; }
+
+ private:
+  ::mediapipe::Status CheckRemaining(uint64 size) const {
+    RET_CHECK(offset_ <= end_) << "Invalid recording range.";
+    RET_CHECK_LE(size, end_ - offset_) << "Truncated recording.";
+    return ::mediapipe::OkStatus();
+  }
+
+  const char* data_;
+  size_t offset_;
+  const size_t end_;
+};
+
+// Calls "fn" with the stream and index of each packet of "streams" in
+// [start, end), in timestamp order.  Packets of equal timestamps are visited
+// in stream order.
+::mediapipe::Status ForEachPacket(
+    const PacketRecordingReader& reader, const std::vector<int>& streams,
+    Timestamp start, Timestamp end,
+    const std::function<::mediapipe::Status(int, int64)>& fn) {
+  // Holds the timestamp, stream and index of the next packet of each stream.
+  typedef std::tuple<Timestamp, int, int64> Next;
+  std::priority_queue<Next, std::vector<Next>, std::greater<Next>> queue;
+  for (int stream : streams) {
+    int64 index = reader.Seek(stream, start);
+    if (index < reader.NumPackets(stream)) {
+      queue.emplace(reader.PacketTimestamp(stream, index), stream, index);
+    }
+  }
+  while (!queue.empty()) {
+    Timestamp timestamp;
+    int stream;
+    int64 index;
+    std::tie(timestamp, stream, index) = queue.top();
+    if (timestamp >= end) {
+      break;
+    }
+    queue.pop();
+    RETURN_IF_ERROR(fn(stream, index));
+    if (++index < reader.NumPackets(stream)) {
+      queue.emplace(reader.PacketTimestamp(stream, index), stream, index);
+    }
+  }
+  return ::mediapipe::OkStatus();
+}
+
+}  // namespace
+
+constexpr int64 PacketRecordingWriter::kDefaultChunkSize;
+
+::mediapipe::StatusOr<std::unique_ptr<PacketRecordingWriter>>
+PacketRecordingWriter::Create(const std::string& path, int64 chunk_size) {
+  RET_CHECK_GT(chunk_size, 0);
+  std::FILE* file = std::fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    return ::mediapipe::InvalidArgumentError(
+        absl::StrCat("Cannot create recording file: ", path));
+  }
+  std::unique_ptr<PacketRecordingWriter> writer(
+      new PacketRecordingWriter(file, chunk_size));
+  std::string header(kHeaderMagic, kMagicSize);
+  AppendRaw<uint32>(kVersion, &header);
+  AppendRaw<uint32>(0, &header);
+  RET_CHECK_EQ(std::fwrite(header.data(), 1, header.size(), file),
+               header.size());
+  writer->offset_ = header.size();
+  return writer;
+}
+
+PacketRecordingWriter::PacketRecordingWriter(std::FILE* file,
+                                             int64 chunk_size)
+    : file_(file), chunk_size_(chunk_size) {}
+
+PacketRecordingWriter::~PacketRecordingWriter() {
+  if (file_ != nullptr) {
+    ::mediapipe::Status status = Close();
+    LOG_IF(ERROR, !status.ok()) << status;
+  }
+}
+
+::mediapipe::Status PacketRecordingWriter::WriteChunk(
+    uint32 kind, uint32 num_records, const std::string& payload) {
+  std::string header;
+  AppendRaw<uint32>(kind, &header);
+  AppendRaw<uint32>(num_records, &header);
+  AppendRaw<uint64>(payload.size(), &header);
+  RET_CHECK_EQ(std::fwrite(header.data(), 1, header.size(), file_),
+               header.size());
+  RET_CHECK_EQ(std::fwrite(payload.data(), 1, payload.size(), file_),
+               payload.size());
+  offset_ += header.size() + payload.size();
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status PacketRecordingWriter::FlushPackets() {
+  if (chunk_records_ == 0) {
+    return ::mediapipe::OkStatus();
+  }
+  RETURN_IF_ERROR(WriteChunk(kPacketChunk, chunk_records_, chunk_));
+  chunk_.clear();
+  chunk_records_ = 0;
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status PacketRecordingWriter::WritePacket(
+    const std::string& stream_name, const Packet& packet) {
+  RET_CHECK(file_ != nullptr) << "The recording is closed.";
+  std::string type_name;
+  RETURN_IF_ERROR(SerializePacket(packet, &type_name, &encoding_));
+
+  auto iter = streams_.find(stream_name);
+  if (iter == streams_.end()) {
+    // Buffered records must precede the new stream chunk, so that the
+    // offsets of new records can be computed from offset_.
+    RETURN_IF_ERROR(FlushPackets());
+    Stream stream;
+    stream.id = streams_.size();
+    stream.type_name = type_name;
+    std::string payload;
+    AppendRaw<uint32>(stream.id, &payload);
+    AppendString(stream_name, &payload);
+    AppendString(type_name, &payload);
+    RETURN_IF_ERROR(WriteChunk(kStreamChunk, 1, payload));
+    iter = streams_.emplace(stream_name, std::move(stream)).first;
+  }
+  Stream& stream = iter->second;
+  RET_CHECK_EQ(stream.type_name, type_name)
+      << "Packets of stream \"" << stream_name << "\" have differing types.";
+  RET_CHECK(stream.index.empty() || packet.Timestamp() > stream.last_timestamp)
+      << "Packets of stream \"" << stream_name
+      << "\" must have increasing timestamps.";
+  stream.last_timestamp = packet.Timestamp();
+  stream.index.emplace_back(packet.Timestamp().Value(),
+                            offset_ + kChunkHeaderSize + chunk_.size());
+
+  AppendRaw<uint32>(stream.id, &chunk_);
+  AppendRaw<uint32>(0, &chunk_);
+  AppendRaw<int64>(packet.Timestamp().Value(), &chunk_);
+  AppendRaw<uint64>(encoding_.size(), &chunk_);
+  chunk_.append(encoding_);
+  ++chunk_records_;
+  if (chunk_.size() >= chunk_size_) {
+    RETURN_IF_ERROR(FlushPackets());
+  }
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status PacketRecordingWriter::Close() {
+  RET_CHECK(file_ != nullptr) << "The recording is already closed.";
+  ::mediapipe::Status status = FlushPackets();
+  const uint64 index_offset = offset_;
+  if (status.ok()) {
+    std::string payload;
+    for (const auto& entry : streams_) {
+      const Stream& stream = entry.second;
+      AppendRaw<uint32>(stream.id, &payload);
+      AppendString(entry.first, &payload);
+      AppendString(stream.type_name, &payload);
+      AppendRaw<uint64>(stream.index.size(), &payload);
+      for (const auto& index_entry : stream.index) {
+        AppendRaw<int64>(index_entry.first, &payload);
+        AppendRaw<uint64>(index_entry.second, &payload);
+      }
+    }
+    status = WriteChunk(kIndexChunk, streams_.size(), payload);
+  }
+  if (status.ok()) {
+    std::string footer;
+    AppendRaw<uint64>(index_offset, &footer);
+    footer.append(kFooterMagic, kMagicSize);
+    if (std::fwrite(footer.data(), 1, footer.size(), file_) != footer.size()) {
+      status = ::mediapipe::InternalError("Cannot write recording footer.");
+    }
+  }
+  if (std::fclose(file_) != 0 && status.ok()) {
+    status = ::mediapipe::InternalError("Cannot close recording file.");
+  }
+  file_ = nullptr;
+  return status;
+}
+
+::mediapipe::StatusOr<std::unique_ptr<PacketRecordingReader>>
+PacketRecordingReader::Open(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return ::mediapipe::NotFoundError(
+        absl::StrCat("Cannot open recording file: ", path));
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size < kHeaderSize) {
+    close(fd);
+    return ::mediapipe::InvalidArgumentError(
+        absl::StrCat("Not a recording file: ", path));
+  }
+  void* data =
+      mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return ::mediapipe::InternalError(
+        absl::StrCat("Cannot map recording file: ", path));
+  }
+  std::unique_ptr<PacketRecordingReader> reader(new PacketRecordingReader(
+      static_cast<const char*>(data), file_stat.st_size));
+  if (std::memcmp(data, kHeaderMagic, kMagicSize) != 0) {
+    return ::mediapipe::InvalidArgumentError(
+        absl::StrCat("Not a recording file: ", path));
+  }
+  Cursor header(reader->data_, kMagicSize, kHeaderSize);
+  uint32 version;
+  RETURN_IF_ERROR(header.Read(&version));
+  RET_CHECK_EQ(version, kVersion) << "Unsupported recording version.";
+
+  const size_t footer_offset = reader->size_ - kFooterSize;
+  if (reader->size_ >= kHeaderSize + kFooterSize &&
+      std::memcmp(reader->data_ + footer_offset + sizeof(uint64), kFooterMagic,
+                  kMagicSize) == 0) {
+    uint64 index_offset;
+    std::memcpy(&index_offset, reader->data_ + footer_offset, sizeof(uint64));
+    RET_CHECK(kHeaderSize <= index_offset && index_offset <= footer_offset)
+        << "Invalid recording index offset: " << index_offset;
+    RETURN_IF_ERROR(reader->ReadIndex(index_offset));
+  } else {
+    LOG(WARNING) << "Recording file " << path
+                 << " has no index, scanning its chunks.";
+    RETURN_IF_ERROR(reader->ReadChunks());
+  }
+  return reader;
+}
+
+PacketRecordingReader::PacketRecordingReader(const char* data, size_t size)
+    : data_(data), size_(size) {}
+
+PacketRecordingReader::~PacketRecordingReader() {
+  munmap(const_cast<char*>(data_), size_);
+}
+
+::mediapipe::Status PacketRecordingReader::ReadIndex(uint64 index_offset) {
+  Cursor cursor(data_, index_offset, size_ - kFooterSize);
+  uint32 kind, num_streams;
+  uint64 size;
+  RETURN_IF_ERROR(cursor.Read(&kind));
+  RETURN_IF_ERROR(cursor.Read(&num_streams));
+  RETURN_IF_ERROR(cursor.Read(&size));
+  RET_CHECK_EQ(kind, kIndexChunk);
+  // Each stream entry holds at least an id, two string sizes and a count.
+  RET_CHECK_LE(num_streams, cursor.remaining() / (3 * sizeof(uint32) +
+                                                  sizeof(uint64)))
+      << "Corrupt recording index.";
+  streams_.resize(num_streams);
+  for (uint32 i = 0; i < num_streams; ++i) {
+    uint32 id;
+    RETURN_IF_ERROR(cursor.Read(&id));
+    RET_CHECK_LT(id, num_streams);
+    Stream& stream = streams_[id];
+    RETURN_IF_ERROR(cursor.ReadString(&stream.name));
+    RETURN_IF_ERROR(cursor.ReadString(&stream.type_name));
+    uint64 num_packets;
+    RETURN_IF_ERROR(cursor.Read(&num_packets));
+    RET_CHECK_LE(num_packets,
+                 cursor.remaining() / (sizeof(int64) + sizeof(uint64)))
+        << "Corrupt recording index.";
+    stream.index.resize(num_packets);
+    for (auto& entry : stream.index) {
+      RETURN_IF_ERROR(cursor.Read(&entry.first));
+      RETURN_IF_ERROR(cursor.Read(&entry.second));
+      // Each record header must precede the index.
+      RET_CHECK(entry.second >= kHeaderSize &&
+                index_offset >= kRecordHeaderSize &&
+                entry.second <= index_offset - kRecordHeaderSize)
+          << "Corrupt recording index.";
+    }
+  }
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status PacketRecordingReader::ReadChunks() {
+  Cursor cursor(data_, kHeaderSize, size_);
+  while (size_ - cursor.offset() >= kChunkHeaderSize) {
+    uint32 kind, num_records;
+    uint64 size;
+    RETURN_IF_ERROR(cursor.Read(&kind));
+    RETURN_IF_ERROR(cursor.Read(&num_records));
+    RETURN_IF_ERROR(cursor.Read(&size));
+    if (size > size_ - cursor.offset()) {
+      // The last chunk was not completely written.
+      break;
+    }
+    Cursor chunk(data_, cursor.offset(), cursor.offset() + size);
+    if (kind == kStreamChunk) {
+      uint32 id;
+      RETURN_IF_ERROR(chunk.Read(&id));
+      RET_CHECK_EQ(id, streams_.size());
+      streams_.emplace_back();
+      RETURN_IF_ERROR(chunk.ReadString(&streams_.back().name));
+      RETURN_IF_ERROR(chunk.ReadString(&streams_.back().type_name));
+    } else if (kind == kPacketChunk) {
+      for (uint32 i = 0; i < num_records; ++i) {
+        const uint64 record_offset = chunk.offset();
+        uint32 id, reserved;
+        int64 timestamp;
+        uint64 record_size;
+        RETURN_IF_ERROR(chunk.Read(&id));
+        RETURN_IF_ERROR(chunk.Read(&reserved));
+        RETURN_IF_ERROR(chunk.Read(&timestamp));
+        RETURN_IF_ERROR(chunk.Read(&record_size));
+        RETURN_IF_ERROR(chunk.Skip(record_size));
+        RET_CHECK_LT(id, streams_.size());
+        streams_[id].index.emplace_back(timestamp, record_offset);
+      }
+    } else if (kind == kIndexChunk) {
+      break;
+    }
+    RETURN_IF_ERROR(cursor.Skip(size));
+  }
+  return ::mediapipe::OkStatus();
+}
+
+int PacketRecordingReader::FindStream(const std::string& stream_name) const {
+  for (int i = 0; i < streams_.size(); ++i) {
+    if (streams_[i].name == stream_name) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+::mediapipe::StatusOr<Packet> PacketRecordingReader::ReadPacket(
+    int stream, int64 index) const {
+  RET_CHECK(stream >= 0 && stream < streams_.size());
+  RET_CHECK(index >= 0 && index < NumPackets(stream));
+  Cursor cursor(data_, streams_[stream].index[index].second, size_);
+  uint32 id, reserved;
+  int64 timestamp;
+  uint64 size;
+  RETURN_IF_ERROR(cursor.Read(&id));
+  RETURN_IF_ERROR(cursor.Read(&reserved));
+  RETURN_IF_ERROR(cursor.Read(&timestamp));
+  RETURN_IF_ERROR(cursor.Read(&size));
+  RET_CHECK_EQ(id, stream);
+  RET_CHECK_LE(size, size_ - cursor.offset()) << "Truncated recording.";
+  return DeserializePacket(streams_[stream].type_name,
+                           std::string(data_ + cursor.offset(), size),
+                           Timestamp::CreateNoErrorChecking(timestamp));
+}
+
+int64 PacketRecordingReader::Seek(int stream, Timestamp timestamp) const {
+  const auto& index = streams_[stream].index;
+  return std::lower_bound(index.begin(), index.end(), timestamp.Value(),
+                          [](const std::pair<int64, uint64>& entry,
+                             int64 value) { return entry.first < value; }) -
+         index.begin();
+}
+
+::mediapipe::StatusOr<std::vector<ReplayPacket>>
+PacketRecordingReader::ReadPackets(Timestamp start, Timestamp end) const {
+  std::vector<int> streams(streams_.size());
+  for (int i = 0; i < streams.size(); ++i) {
+    streams[i] = i;
+  }
+  std::vector<ReplayPacket> packets;
+  RETURN_IF_ERROR(ForEachPacket(
+      *this, streams, start, end,
+      [this, &packets](int stream, int64 index) -> ::mediapipe::Status {
+        ASSIGN_OR_RETURN(Packet packet, ReadPacket(stream, index));
+        packets.push_back({streams_[stream].name, std::move(packet)});
+        return ::mediapipe::OkStatus();
+      }));
+  return packets;
+}
+
+::mediapipe::Status ReplayRecording(const PacketRecordingReader& reader,
+                                    CalculatorGraph* graph,
+                                    const ReplayRecordingOptions& options) {
+  RET_CHECK_GE(options.speed, 0);
+  std::vector<int> streams;
+  if (options.stream_names.empty()) {
+    for (int i = 0; i < reader.NumStreams(); ++i) {
+      streams.push_back(i);
+    }
+  } else {
+    for (const std::string& name : options.stream_names) {
+      int stream = reader.FindStream(name);
+      RET_CHECK_GE(stream, 0) << "Stream \"" << name << "\" is not recorded.";
+      streams.push_back(stream);
+    }
+  }
+
+  Clock* clock = options.clock ? options.clock : Clock::RealClock();
+  absl::Time start_time;
+  Timestamp first_timestamp = Timestamp::Unset();
+  return ForEachPacket(
+      reader, streams, options.start, options.end,
+      [&](int stream, int64 index) -> ::mediapipe::Status {
+        const Timestamp timestamp = reader.PacketTimestamp(stream, index);
+        if (options.speed > 0 && timestamp.IsRangeValue()) {
+          if (first_timestamp == Timestamp::Unset()) {
+            first_timestamp = timestamp;
+            start_time = clock->TimeNow();
+          }
+          clock->SleepUntil(
+              start_time + absl::Microseconds((timestamp - first_timestamp)
+                                                  .Value()) /
+                               options.speed);
+        }
+        ASSIGN_OR_RETURN(Packet packet, reader.ReadPacket(stream, index));
+        return graph->AddPacketToInputStream(reader.StreamName(stream),
+                                             std::move(packet));
+      });
+}
+
+}  // namespace mediapipe
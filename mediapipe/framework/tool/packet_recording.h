@@ -0,0 +1,197 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// A file format for recording the packets of graph streams and replaying
+// them later into CalculatorGraph::AddPacketToInputStream, for instance to
+// load test a graph offline.  Packets are serialized with the functions
+// registered for their types, see packet_codec.h.
+//
+// A recording file is a header followed by a sequence of chunks:
+//
+//   header:  "MPPKTREC", uint32 version, uint32 reserved
+//   chunk:   uint32 kind, uint32 num_records, uint64 payload size, payload
+//   footer:  uint64 index chunk offset, "MPPKTEND"
+//
+// A stream chunk declares a stream id, name and type name.  A packet chunk
+// holds up to "chunk_size" bytes of packet records, each one a stream id,
+// a timestamp, a payload size and the serialized payload.  The index chunk
+// written by Close() repeats the stream declarations and lists the timestamp
+// and file offset of every packet of every stream, so that a reader can seek
+// within a stream without scanning the file.  A file without an index, for
+// instance one left by a crashed writer, is indexed by scanning its packet
+// chunks when opened.
+//
+// Usage example:
+//
+//   ASSIGN_OR_RETURN(auto writer, PacketRecordingWriter::Create(path));
+//   RETURN_IF_ERROR(writer->WritePacket("input_video", packet));
+//   RETURN_IF_ERROR(writer->Close());
+//
+//   ASSIGN_OR_RETURN(auto reader, PacketRecordingReader::Open(path));
+//   ReplayRecordingOptions options;
+//   options.speed = 4.0;
+//   RETURN_IF_ERROR(ReplayRecording(*reader, &graph, options));
+
+#ifndef MEDIAPIPE_FRAMEWORK_TOOL_PACKET_RECORDING_H_
+#define MEDIAPIPE_FRAMEWORK_TOOL_PACKET_RECORDING_H_
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_graph.h"
+#include "mediapipe/framework/deps/clock.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/framework/timestamp.h"
+#include "mediapipe/framework/tool/replay_executor.h"
+
+namespace mediapipe {
+
+// Writes packets to a recording file.  Not thread-safe.
+class PacketRecordingWriter {
+ public:
+  // The default number of payload bytes buffered per packet chunk.
+  static constexpr int64 kDefaultChunkSize = 1 << 20;
+
+  // Creates or truncates the recording file at "path".
+  static ::mediapipe::StatusOr<std::unique_ptr<PacketRecordingWriter>> Create(
+      const std::string& path, int64 chunk_size = kDefaultChunkSize);
+
+  PacketRecordingWriter(const PacketRecordingWriter&) = delete;
+  PacketRecordingWriter& operator=(const PacketRecordingWriter&) = delete;
+  ~PacketRecordingWriter();
+
+  // Appends "packet" to the stream "stream_name".  The stream is declared
+  // with the type of its first packet, and all of its packets must have
+  // that type.  Packets within a stream must have increasing timestamps.
+  ::mediapipe::Status WritePacket(const std::string& stream_name,
+                                  const Packet& packet);
+
+  // Writes the buffered packets, the index and the footer, and closes the
+  // file.
+  ::mediapipe::Status Close();
+
+ private:
+  struct Stream {
+    uint32 id;
+    std::string type_name;
+    Timestamp last_timestamp;
+    // The timestamp and file offset of each packet record.
+    std::vector<std::pair<int64, uint64>> index;
+  };
+
+  PacketRecordingWriter(std::FILE* file, int64 chunk_size);
+
+  ::mediapipe::Status WriteChunk(uint32 kind, uint32 num_records,
+                                 const std::string& payload);
+  ::mediapipe::Status FlushPackets();
+
+  std::FILE* file_;
+  const int64 chunk_size_;
+  // The file offset at which the next chunk is written.
+  uint64 offset_ = 0;
+  std::map<std::string, Stream> streams_;
+  // The packet records of the chunk being buffered.
+  std::string chunk_;
+  uint32 chunk_records_ = 0;
+  std::string encoding_;
+};
+
+// Reads packets from a recording file, which is mapped into memory.
+// Thread-safe once opened.
+class PacketRecordingReader {
+ public:
+  static ::mediapipe::StatusOr<std::unique_ptr<PacketRecordingReader>> Open(
+      const std::string& path);
+
+  PacketRecordingReader(const PacketRecordingReader&) = delete;
+  PacketRecordingReader& operator=(const PacketRecordingReader&) = delete;
+  ~PacketRecordingReader();
+
+  int NumStreams() const { return streams_.size(); }
+  const std::string& StreamName(int stream) const {
+    return streams_[stream].name;
+  }
+  const std::string& StreamTypeName(int stream) const {
+    return streams_[stream].type_name;
+  }
+  // Returns the stream id for "stream_name", or -1 if it is not recorded.
+  int FindStream(const std::string& stream_name) const;
+
+  int64 NumPackets(int stream) const { return streams_[stream].index.size(); }
+  Timestamp PacketTimestamp(int stream, int64 index) const {
+    return Timestamp::CreateNoErrorChecking(
+        streams_[stream].index[index].first);
+  }
+  // Deserializes the packet "index" of "stream".
+  ::mediapipe::StatusOr<Packet> ReadPacket(int stream, int64 index) const;
+
+  // Returns the index of the first packet of "stream" with a timestamp at
+  // or after "timestamp", or NumPackets(stream) if there is none.
+  int64 Seek(int stream, Timestamp timestamp) const;
+
+  // Returns the packets of all streams in [start, end), ordered by
+  // timestamp, for use with ReplayPackets().
+  ::mediapipe::StatusOr<std::vector<ReplayPacket>> ReadPackets(
+      Timestamp start = Timestamp::PreStream(),
+      Timestamp end = Timestamp::OneOverPostStream()) const;
+
+ private:
+  struct Stream {
+    std::string name;
+    std::string type_name;
+    // The timestamp and file offset of each packet record.
+    std::vector<std::pair<int64, uint64>> index;
+  };
+
+  PacketRecordingReader(const char* data, size_t size);
+
+  ::mediapipe::Status ReadChunks();
+  ::mediapipe::Status ReadIndex(uint64 index_offset);
+
+  const char* data_;
+  const size_t size_;
+  std::vector<Stream> streams_;
+};
+
+struct ReplayRecordingOptions {
+  // The replay speed relative to the packet timestamps, which are taken to
+  // be in microseconds.  For instance, 2.0 replays at twice real time.
+  // 0 adds packets as quickly as the graph accepts them.
+  double speed = 0;
+  // Only packets in [start, end) are replayed.
+  Timestamp start = Timestamp::PreStream();
+  Timestamp end = Timestamp::OneOverPostStream();
+  // The recorded streams to replay.  Empty replays all recorded streams.
+  std::vector<std::string> stream_names;
+  // The clock used to pace the replay.  Defaults to the real clock.
+  Clock* clock = nullptr;
+};
+
+// Adds the recorded packets to the graph input streams with the same names,
+// in timestamp order, without loading the whole recording into memory.
+// The graph must be running; its input streams are not closed.  Packets of
+// equal timestamps are added in stream order.
+::mediapipe::Status ReplayRecording(const PacketRecordingReader& reader,
+                                    CalculatorGraph* graph,
+                                    const ReplayRecordingOptions& options);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_TOOL_PACKET_RECORDING_H_
@@ -0,0 +1,379 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/tool/packet_recording.h"
+
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/detection.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/tool/packet_codec.h"
+
+namespace mediapipe {
+namespace {
+
+std::string TempPath(const std::string& name) {
+  return absl::StrCat(getenv("TEST_TMPDIR"), "/", name);
+}
+
+// Returns a frame whose rows are padded, with distinct pixel values.
+std::unique_ptr<ImageFrame> MakeImageFrame(int width, int height) {
+  auto frame = absl::make_unique<ImageFrame>(
+      ImageFormat::SRGB, width, height, ImageFrame::kDefaultAlignmentBoundary);
+  for (int y = 0; y < height; ++y) {
+    uint8* row = frame->MutablePixelData() + y * frame->WidthStep();
+    for (int x = 0; x < width * 3; ++x) {
+      row[x] = y * 31 + x;
+    }
+  }
+  return frame;
+}
+
+// Serializes and deserializes "packet".
+Packet RoundTrip(const Packet& packet) {
+  std::string type_name, encoding;
+  MEDIAPIPE_CHECK_OK(SerializePacket(packet, &type_name, &encoding));
+  auto result = DeserializePacket(type_name, encoding, packet.Timestamp());
+  MEDIAPIPE_CHECK_OK(result.status());
+  return result.ValueOrDie();
+}
+
+TEST(PacketCodecTest, RoundTripsRegisteredTypes) {
+  EXPECT_EQ(7, RoundTrip(MakePacket<int>(7)).Get<int>());
+  EXPECT_EQ(1.5, RoundTrip(MakePacket<double>(1.5)).Get<double>());
+  EXPECT_EQ("abc",
+            RoundTrip(MakePacket<std::string>("abc")).Get<std::string>());
+
+  std::unique_ptr<ImageFrame> frame = MakeImageFrame(5, 3);
+  Packet frame_packet = RoundTrip(Adopt(MakeImageFrame(5, 3).release()));
+  const ImageFrame& decoded = frame_packet.Get<ImageFrame>();
+  ASSERT_EQ(ImageFormat::SRGB, decoded.Format());
+  ASSERT_EQ(5, decoded.Width());
+  ASSERT_EQ(3, decoded.Height());
+  for (int y = 0; y < 3; ++y) {
+    EXPECT_EQ(0, std::memcmp(frame->PixelData() + y * frame->WidthStep(),
+                             decoded.PixelData() + y * decoded.WidthStep(),
+                             5 * 3));
+  }
+
+  Matrix matrix(2, 3);
+  matrix << 1, 2, 3, 4, 5, 6;
+  EXPECT_EQ(matrix, RoundTrip(MakePacket<Matrix>(matrix)).Get<Matrix>());
+
+  Detection detection = ParseTextProtoOrDie<Detection>(R"(
+    label: "face" score: 0.75
+  )");
+  Packet detections = RoundTrip(
+      MakePacket<std::vector<Detection>>(std::vector<Detection>(2, detection))
+          .At(Timestamp(20)));
+  EXPECT_EQ(Timestamp(20), detections.Timestamp());
+  ASSERT_EQ(2, detections.Get<std::vector<Detection>>().size());
+  EXPECT_EQ("face", detections.Get<std::vector<Detection>>()[1].label(0));
+  EXPECT_EQ(0.75f, RoundTrip(MakePacket<Detection>(detection))
+                       .Get<Detection>()
+                       .score(0));
+}
+
+TEST(PacketCodecTest, RejectsUnregisteredTypes) {
+  struct Unregistered {};
+  std::string type_name, encoding;
+  EXPECT_FALSE(
+      SerializePacket(MakePacket<Unregistered>(), &type_name, &encoding).ok());
+  EXPECT_FALSE(DeserializePacket("Unregistered", "", Timestamp(0)).ok());
+}
+
+// Writes 10 frames to "video" and 20 ints to "count" at twice the rate.
+void WriteRecording(const std::string& path, int64 chunk_size) {
+  auto writer_or = PacketRecordingWriter::Create(path, chunk_size);
+  MEDIAPIPE_CHECK_OK(writer_or.status());
+  std::unique_ptr<PacketRecordingWriter> writer =
+      std::move(writer_or).ValueOrDie();
+  for (int i = 0; i < 20; ++i) {
+    if (i % 2 == 0) {
+      MEDIAPIPE_CHECK_OK(writer->WritePacket(
+          "video",
+          Adopt(MakeImageFrame(8, 4).release()).At(Timestamp(i * 10))));
+    }
+    MEDIAPIPE_CHECK_OK(
+        writer->WritePacket("count", MakePacket<int>(i).At(Timestamp(i * 10))));
+  }
+  MEDIAPIPE_CHECK_OK(writer->Close());
+}
+
+void ExpectRecording(const PacketRecordingReader& reader) {
+  ASSERT_EQ(2, reader.NumStreams());
+  const int video = reader.FindStream("video");
+  const int count = reader.FindStream("count");
+  ASSERT_GE(video, 0);
+  ASSERT_GE(count, 0);
+  EXPECT_EQ(-1, reader.FindStream("audio"));
+  EXPECT_EQ("::mediapipe::ImageFrame", reader.StreamTypeName(video));
+  EXPECT_EQ(10, reader.NumPackets(video));
+  EXPECT_EQ(20, reader.NumPackets(count));
+
+  EXPECT_EQ(5, reader.Seek(count, Timestamp(50)));
+  EXPECT_EQ(3, reader.Seek(video, Timestamp(50)));
+  EXPECT_EQ(10, reader.Seek(video, Timestamp(1000)));
+  auto packet = reader.ReadPacket(count, 5);
+  MEDIAPIPE_ASSERT_OK(packet.status());
+  EXPECT_EQ(5, packet.ValueOrDie().Get<int>());
+  EXPECT_EQ(Timestamp(50), packet.ValueOrDie().Timestamp());
+  packet = reader.ReadPacket(video, 9);
+  MEDIAPIPE_ASSERT_OK(packet.status());
+  EXPECT_EQ(8, packet.ValueOrDie().Get<ImageFrame>().Width());
+  EXPECT_EQ(Timestamp(180), packet.ValueOrDie().Timestamp());
+}
+
+TEST(PacketRecordingTest, WritesAndSeeks) {
+  const std::string path = TempPath("writes_and_seeks.mprec");
+  WriteRecording(path, 100);
+  auto reader = PacketRecordingReader::Open(path);
+  MEDIAPIPE_ASSERT_OK(reader.status());
+  ExpectRecording(*reader.ValueOrDie());
+
+  auto packets = reader.ValueOrDie()->ReadPackets(Timestamp(40), Timestamp(60));
+  MEDIAPIPE_ASSERT_OK(packets.status());
+  ASSERT_EQ(3, packets.ValueOrDie().size());
+  EXPECT_EQ(Timestamp(40), packets.ValueOrDie()[0].packet.Timestamp());
+  EXPECT_EQ(Timestamp(40), packets.ValueOrDie()[1].packet.Timestamp());
+  EXPECT_EQ("count", packets.ValueOrDie()[2].stream_name);
+}
+
+TEST(PacketRecordingTest, ScansRecordingWithoutIndex) {
+  const std::string path = TempPath("without_index.mprec");
+  WriteRecording(path, 100);
+  // Drops the index chunk and the footer.
+  std::string contents;
+  MEDIAPIPE_ASSERT_OK(file::GetContents(path, &contents));
+  uint64 index_offset;
+  std::memcpy(&index_offset, contents.data() + contents.size() - 16, 8);
+  MEDIAPIPE_ASSERT_OK(
+      file::SetContents(path, contents.substr(0, index_offset)));
+
+  auto reader = PacketRecordingReader::Open(path);
+  MEDIAPIPE_ASSERT_OK(reader.status());
+  ExpectRecording(*reader.ValueOrDie());
+}
+
+TEST(PacketRecordingTest, RejectsInvalidFiles) {
+  const std::string path = TempPath("invalid.mprec");
+  MEDIAPIPE_ASSERT_OK(file::SetContents(path, "not a packet recording"));
+  EXPECT_FALSE(PacketRecordingReader::Open(path).ok());
+  EXPECT_FALSE(PacketRecordingReader::Open(TempPath("missing.mprec")).ok());
+
+  auto writer = PacketRecordingWriter::Create(path);
+  MEDIAPIPE_ASSERT_OK(writer.status());
+  MEDIAPIPE_EXPECT_OK(writer.ValueOrDie()->WritePacket(
+      "in", MakePacket<int>(1).At(Timestamp(1))));
+  // Wrong type.
+  EXPECT_FALSE(writer.ValueOrDie()
+                   ->WritePacket("in", MakePacket<float>(1).At(Timestamp(2)))
+                   .ok());
+  // Non increasing timestamp.
+  EXPECT_FALSE(writer.ValueOrDie()
+                   ->WritePacket("in", MakePacket<int>(1).At(Timestamp(1)))
+                   .ok());
+}
+
+// Writes a recording to "path", lets "corrupt" modify its contents given the
+// offset of the index chunk, and returns the result of opening it.
+::mediapipe::Status OpenCorrupted(
+    const std::string& path,
+    const std::function<void(uint64 index_offset, std::string* contents)>&
+        corrupt) {
+  WriteRecording(path, 100);
+  std::string contents;
+  MEDIAPIPE_CHECK_OK(file::GetContents(path, &contents));
+  uint64 index_offset;
+  std::memcpy(&index_offset, contents.data() + contents.size() - 16, 8);
+  corrupt(index_offset, &contents);
+  MEDIAPIPE_CHECK_OK(file::SetContents(path, contents));
+  return PacketRecordingReader::Open(path).status();
+}
+
+TEST(PacketRecordingTest, ScansRecordingWithTruncatedFooter) {
+  const std::string path = TempPath("truncated_footer.mprec");
+  MEDIAPIPE_EXPECT_OK(
+      OpenCorrupted(path, [](uint64, std::string* contents) {
+        contents->resize(contents->size() - 4);
+      }));
+  auto reader = PacketRecordingReader::Open(path);
+  MEDIAPIPE_ASSERT_OK(reader.status());
+  ExpectRecording(*reader.ValueOrDie());
+}
+
+// Sets the index offset in the footer of the recording "contents".
+void SetIndexOffset(uint64 index_offset, std::string* contents) {
+  std::memcpy(&(*contents)[contents->size() - 16], &index_offset, 8);
+}
+
+TEST(PacketRecordingTest, RejectsOutOfRangeIndexOffset) {
+  const std::string path = TempPath("out_of_range_footer.mprec");
+  for (uint64 bad_offset : {uint64{0}, uint64{4}, uint64{1} << 40,
+                            ~uint64{0}}) {
+    EXPECT_FALSE(OpenCorrupted(path,
+                               [bad_offset](uint64, std::string* contents) {
+                                 SetIndexOffset(bad_offset, contents);
+                               })
+                     .ok())
+        << bad_offset;
+  }
+  // An offset within the footer.
+  EXPECT_FALSE(OpenCorrupted(path, [](uint64, std::string* contents) {
+                 SetIndexOffset(contents->size() - 12, contents);
+               }).ok());
+}
+
+TEST(PacketRecordingTest, RejectsCorruptIndex) {
+  const std::string path = TempPath("corrupt_index.mprec");
+  // The index chunk header holds its kind, number of streams and size, and
+  // is followed by the id, name and type name of the first stream.
+  const auto first_stream_offset = [](uint64 index_offset,
+                                      const std::string& contents) {
+    uint64 offset = index_offset + 16 + 4;
+    for (int i = 0; i < 2; ++i) {
+      uint32 size;
+      std::memcpy(&size, contents.data() + offset, 4);
+      offset += 4 + size;
+    }
+    return offset;
+  };
+  // Too many streams.
+  EXPECT_FALSE(
+      OpenCorrupted(path, [](uint64 index_offset, std::string* contents) {
+        const uint32 num_streams = 0xffffffff;
+        std::memcpy(&(*contents)[index_offset + 4], &num_streams, 4);
+      }).ok());
+  // Too many packets.
+  EXPECT_FALSE(OpenCorrupted(path,
+                             [&](uint64 index_offset, std::string* contents) {
+                               const uint64 num_packets = uint64{1} << 60;
+                               std::memcpy(&(*contents)[first_stream_offset(
+                                               index_offset, *contents)],
+                                           &num_packets, 8);
+                             })
+                   .ok());
+  // Packet offsets past the index, including one that overflows.
+  for (uint64 bad_offset : {uint64{0}, ~uint64{0} - 8, uint64{1} << 40}) {
+    EXPECT_FALSE(OpenCorrupted(path,
+                               [&](uint64 index_offset, std::string* contents) {
+                                 const uint64 entry_offset =
+                                     first_stream_offset(index_offset,
+                                                         *contents) +
+                                     8 + 8;
+                                 std::memcpy(&(*contents)[entry_offset],
+                                             &bad_offset, 8);
+                               })
+                     .ok())
+        << bad_offset;
+  }
+  // A string size past the end of the index.
+  EXPECT_FALSE(
+      OpenCorrupted(path, [](uint64 index_offset, std::string* contents) {
+        const uint32 size = 0xfffffff0;
+        std::memcpy(&(*contents)[index_offset + 16 + 4], &size, 4);
+      }).ok());
+}
+
+// Records the graph input stream "in" with PacketRecorderCalculator, and
+// replays the recording into a new run.
+TEST(PacketRecordingTest, RecordsAndReplaysGraphInputs) {
+  const std::string path = TempPath("graph_inputs.mprec");
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "in"
+        input_side_packet: "recording_path"
+        node {
+          calculator: "PacketRecorderCalculator"
+          input_stream: "in"
+          input_side_packet: "OUTPUT_FILE_PATH:recording_path"
+        }
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "in"
+          output_stream: "out"
+        }
+      )");
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  std::vector<int> output;
+  MEDIAPIPE_ASSERT_OK(
+      graph.ObserveOutputStream("out", [&output](const Packet& packet) {
+        output.push_back(packet.Get<int>());
+        return ::mediapipe::OkStatus();
+      }));
+  MEDIAPIPE_ASSERT_OK(
+      graph.StartRun({{"recording_path", MakePacket<std::string>(path)}}));
+  for (int i = 0; i < 10; ++i) {
+    MEDIAPIPE_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i * i).At(Timestamp(i * 1000))));
+  }
+  MEDIAPIPE_ASSERT_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+  std::vector<int> recorded_output = output;
+  ASSERT_EQ(10, recorded_output.size());
+
+  auto reader = PacketRecordingReader::Open(path);
+  MEDIAPIPE_ASSERT_OK(reader.status());
+  output.clear();
+  MEDIAPIPE_ASSERT_OK(graph.StartRun(
+      {{"recording_path", MakePacket<std::string>(TempPath("unused.mprec"))}}));
+  ReplayRecordingOptions options;
+  // Replays the 9 ms of recording at 100 times real time.
+  options.speed = 100;
+  MEDIAPIPE_ASSERT_OK(ReplayRecording(*reader.ValueOrDie(), &graph, options));
+  MEDIAPIPE_ASSERT_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_EQ(recorded_output, output);
+}
+
+// Reads state.range(0) recorded 640x480 frames.
+void BM_ReadPacket(benchmark::State& state) {
+  const std::string path = TempPath("bm_read_packet.mprec");
+  auto writer = PacketRecordingWriter::Create(path);
+  MEDIAPIPE_CHECK_OK(writer.status());
+  for (int i = 0; i < state.range(0); ++i) {
+    MEDIAPIPE_CHECK_OK(writer.ValueOrDie()->WritePacket(
+        "video", Adopt(MakeImageFrame(640, 480).release()).At(Timestamp(i))));
+  }
+  MEDIAPIPE_CHECK_OK(writer.ValueOrDie()->Close());
+  auto reader = PacketRecordingReader::Open(path);
+  MEDIAPIPE_CHECK_OK(reader.status());
+  for (auto _ : state) {
+    for (int i = 0; i < state.range(0); ++i) {
+      benchmark::DoNotOptimize(reader.ValueOrDie()->ReadPacket(0, i));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * state.range(0) * 640 * 480 * 3);
+}
+
+BENCHMARK(BM_ReadPacket)->Arg(30);
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,141 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/tool/replay_executor.h"
+
+#include <algorithm>
+#include <set>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/timestamp.h"
+
+namespace mediapipe {
+
+ReplayExecutor::ReplayExecutor(int num_threads)
+    : ThreadPoolExecutor(num_threads), clock_(new SimulationClock()) {}
+
+void ReplayExecutor::Schedule(std::function<void()> task) {
+  num_tasks_.fetch_add(1, std::memory_order_relaxed);
+  ThreadPoolExecutor::Schedule(std::move(task));
+}
+
+std::shared_ptr<SimulationClock> ReplayExecutor::GetClock() { return clock_; }
+
+double ReplayReport::TimestampsPerSecond() const {
+  return num_timestamps / std::max(absl::ToDoubleSeconds(wall_time), 1e-9);
+}
+
+double ReplayReport::PacketsPerSecond() const {
+  return num_packets / std::max(absl::ToDoubleSeconds(wall_time), 1e-9);
+}
+
+std::string ReplayReport::DebugString() const {
+  std::string result = absl::StrCat(
+      num_packets, " packets at ", num_timestamps, " timestamps in ",
+      absl::FormatDuration(wall_time), " (", TimestampsPerSecond(),
+      " timestamps/s), ", num_tasks, " tasks");
+  for (const auto& entry : process_time) {
+    absl::StrAppend(&result, "\n  ", entry.first, ": ",
+                    absl::FormatDuration(entry.second));
+  }
+  return result;
+}
+
+::mediapipe::StatusOr<ReplayReport> ReplayPackets(
+    CalculatorGraph* graph, ReplayExecutor* executor,
+    const std::vector<ReplayPacket>& packets, const ReplayOptions& options) {
+  RET_CHECK(std::is_sorted(packets.begin(), packets.end(),
+                           [](const ReplayPacket& a, const ReplayPacket& b) {
+                             return a.packet.Timestamp() < b.packet.Timestamp();
+                           }))
+      << "Replayed packets must be ordered by timestamp.";
+  RET_CHECK_GE(options.max_in_flight, 1);
+  const bool pipelined = options.max_in_flight > 1;
+  if (pipelined) {
+    // Throttling bounds the timestamps waiting at each node.
+    std::set<std::string> stream_names;
+    for (const ReplayPacket& packet : packets) {
+      stream_names.insert(packet.stream_name);
+    }
+    for (const std::string& stream_name : stream_names) {
+      RETURN_IF_ERROR(graph->SetInputStreamMaxQueueSize(
+          stream_name, options.max_in_flight));
+    }
+  }
+  ReplayReport report;
+  const int64 start_tasks = executor->NumTasks();
+  const absl::Time start_time = absl::Now();
+  RETURN_IF_ERROR(graph->StartRun(options.side_packets));
+  const CalculatorGraph::GraphInputStreamAddMode add_mode =
+      graph->GetGraphInputStreamAddMode();
+  if (pipelined) {
+    graph->SetGraphInputStreamAddMode(
+        CalculatorGraph::GraphInputStreamAddMode::WAIT_TILL_NOT_FULL);
+  }
+
+  // This thread is the only one running on the clock, so SleepUntil advances
+  // the clock without waiting.
+  SimulationClock* clock = executor->GetClock().get();
+  clock->ThreadStart();
+  ::mediapipe::Status status;
+  for (int i = 0; i < packets.size() && status.ok();) {
+    const Timestamp timestamp = packets[i].packet.Timestamp();
+    if (timestamp.IsRangeValue()) {
+      clock->SleepUntil(std::max(clock->TimeNow(),
+                                 absl::FromUnixMicros(timestamp.Value())));
+    }
+    for (; i < packets.size() && packets[i].packet.Timestamp() == timestamp;
+         ++i) {
+      status = graph->AddPacketToInputStream(packets[i].stream_name,
+                                             packets[i].packet);
+      if (!status.ok()) {
+        break;
+      }
+      ++report.num_packets;
+    }
+    ++report.num_timestamps;
+    if (status.ok() && !pipelined) {
+      status = graph->WaitUntilIdle();
+    }
+  }
+  clock->ThreadFinish();
+  graph->SetGraphInputStreamAddMode(add_mode);
+  if (status.ok()) {
+    status = graph->CloseAllInputStreams();
+  }
+  if (!status.ok()) {
+    graph->Cancel();
+  }
+  ::mediapipe::Status run_status = graph->WaitUntilDone();
+  RETURN_IF_ERROR(status);
+  RETURN_IF_ERROR(run_status);
+  report.wall_time = absl::Now() - start_time;
+  report.num_tasks = executor->NumTasks() - start_tasks;
+
+  std::vector<CalculatorProfile> profiles;
+  if (graph->profiler() != nullptr &&
+      graph->profiler()->GetCalculatorProfiles(&profiles).ok()) {
+    for (const CalculatorProfile& profile : profiles) {
+      report.process_time[profile.name()] +=
+          absl::Microseconds(profile.process_runtime().total());
+    }
+  }
+  return report;
+}
+
+}  // namespace mediapipe
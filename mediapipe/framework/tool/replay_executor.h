@@ -0,0 +1,108 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_TOOL_REPLAY_EXECUTOR_H_
+#define MEDIAPIPE_FRAMEWORK_TOOL_REPLAY_EXECUTOR_H_
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_graph.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/framework/thread_pool_executor.h"
+#include "mediapipe/framework/tool/simulation_clock.h"
+
+namespace mediapipe {
+
+// A multithreaded executor for replaying recorded graph inputs as quickly as
+// possible.  It holds a SimulationClock, which ReplayPackets() advances to
+// each input timestamp as its packets are added.  Unlike
+// SimulationClockExecutor, tasks do not run on the clock, so all ready tasks
+// run in parallel, and tasks that do not belong to the graph run, such as the
+// periodic profile output, do not hold the clock back.  Calculators can read
+// the clock, but must not sleep on it.
+class ReplayExecutor : public ThreadPoolExecutor {
+ public:
+  explicit ReplayExecutor(int num_threads);
+  void Schedule(std::function<void()> task) override;
+
+  // Returns the SimulationClock used by this executor.  This instance can be
+  // passed down to graph nodes as input side packet.
+  std::shared_ptr<SimulationClock> GetClock();
+
+  // Returns the number of tasks scheduled so far.
+  int64 NumTasks() const { return num_tasks_.load(std::memory_order_relaxed); }
+
+ private:
+  std::shared_ptr<SimulationClock> clock_;
+  std::atomic<int64> num_tasks_{0};
+};
+
+// A recorded packet for a graph input stream.
+struct ReplayPacket {
+  std::string stream_name;
+  Packet packet;
+};
+
+// Throughput and per node time of a replay.
+struct ReplayReport {
+  int64 num_packets = 0;
+  int64 num_timestamps = 0;
+  int64 num_tasks = 0;
+  // The real time from StartRun() to WaitUntilDone().
+  absl::Duration wall_time;
+  // The total time spent in Process() by each calculator node, keyed by node
+  // name.  Empty unless the graph profiler is enabled.
+  std::map<std::string, absl::Duration> process_time;
+
+  double TimestampsPerSecond() const;
+  double PacketsPerSecond() const;
+  std::string DebugString() const;
+};
+
+// Options for ReplayPackets().
+struct ReplayOptions {
+  // The number of input timestamps that can be processed at once.  If 1, each
+  // timestamp is processed until the graph is idle before the packets of the
+  // next timestamp are added, so runs are reproducible: calculators see the
+  // same clock readings and the same input batches in every run.  Otherwise
+  // the packets are added without waiting, so that successive timestamps are
+  // processed in a pipeline, and calculators see a clock time at or after
+  // their input timestamp.  Up to max_in_flight timestamps then wait at each
+  // node reading a replayed input stream, and the graph's max_queue_size
+  // bounds the other input streams.
+  int max_in_flight = 1;
+  // The input side packets of the run.
+  std::map<std::string, Packet> side_packets;
+};
+
+// Runs "graph" once over "packets", which must be ordered by timestamp.
+// "graph" must be initialized with "executor" as its default executor, and
+// must not have source nodes if options.max_in_flight is 1.  Packets with
+// equal timestamps are added together.  If options.max_in_flight is more than
+// 1, this sets the max queue size of the replayed graph input streams.
+::mediapipe::StatusOr<ReplayReport> ReplayPackets(
+    CalculatorGraph* graph, ReplayExecutor* executor,
+    const std::vector<ReplayPacket>& packets,
+    const ReplayOptions& options = ReplayOptions());
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_TOOL_REPLAY_EXECUTOR_H_
@@ -0,0 +1,262 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/tool/replay_executor.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+// A Calculator::Process callback function.
+typedef std::function<::mediapipe::Status(const InputStreamShardSet&,
+                                          OutputStreamShardSet*)>
+    ProcessFunction;
+
+// Returns recorded packets for the streams "in" and "aux", with
+// "num_timestamps" timestamps 1 ms apart.
+std::vector<ReplayPacket> RecordedPackets(int num_timestamps) {
+  std::vector<ReplayPacket> packets;
+  for (int i = 0; i < num_timestamps; ++i) {
+    packets.push_back({"in", MakePacket<int>(i).At(Timestamp(i * 1000))});
+    packets.push_back({"aux", MakePacket<int>(i).At(Timestamp(i * 1000))});
+  }
+  return packets;
+}
+
+CalculatorGraphConfig ReplayGraphConfig() {
+  return ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+    input_stream: "in"
+    input_stream: "aux"
+    node {
+      calculator: "LambdaCalculator"
+      input_stream: "in"
+      output_stream: "clock_time"
+      input_side_packet: "callback"
+    }
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "aux"
+      output_stream: "aux_out"
+    }
+    profiler_config { enable_profiler: true }
+  )");
+}
+
+// Runs "config" over "packets", and returns the simulated clock time seen by
+// the LambdaCalculator for each input packet.
+std::vector<int64> ReplayClockTimes(const CalculatorGraphConfig& config,
+                                    const std::vector<ReplayPacket>& packets,
+                                    int num_threads,
+                                    const ReplayOptions& options,
+                                    ReplayReport* report) {
+  auto executor = std::make_shared<ReplayExecutor>(num_threads);
+  std::shared_ptr<SimulationClock> clock = executor->GetClock();
+  ProcessFunction read_clock = [clock](const InputStreamShardSet& inputs,
+                                       OutputStreamShardSet* outputs) {
+    outputs->Index(0).AddPacket(
+        MakePacket<int64>(absl::ToUnixMicros(clock->TimeNow()))
+            .At(inputs.Index(0).Value().Timestamp()));
+    return ::mediapipe::OkStatus();
+  };
+  CalculatorGraph graph;
+  MEDIAPIPE_CHECK_OK(graph.SetExecutor("", executor));
+  MEDIAPIPE_CHECK_OK(graph.Initialize(
+      config, {{"callback", MakePacket<ProcessFunction>(read_clock)}}));
+  std::vector<int64> clock_times;
+  MEDIAPIPE_CHECK_OK(graph.ObserveOutputStream(
+      "clock_time", [&clock_times](const Packet& packet) {
+        clock_times.push_back(packet.Get<int64>());
+        return ::mediapipe::OkStatus();
+      }));
+  auto status_or_report =
+      ReplayPackets(&graph, executor.get(), packets, options);
+  MEDIAPIPE_CHECK_OK(status_or_report.status());
+  *report = status_or_report.ValueOrDie();
+  return clock_times;
+}
+
+TEST(ReplayExecutorTest, ReplaysAtSimulatedTime) {
+  std::vector<ReplayPacket> packets = RecordedPackets(20);
+  ReplayReport report;
+  std::vector<int64> clock_times =
+      ReplayClockTimes(ReplayGraphConfig(), packets, 4, {}, &report);
+  ASSERT_EQ(20, clock_times.size());
+  for (int i = 0; i < clock_times.size(); ++i) {
+    EXPECT_EQ(i * 1000, clock_times[i]);
+  }
+  EXPECT_EQ(40, report.num_packets);
+  EXPECT_EQ(20, report.num_timestamps);
+  EXPECT_GT(report.num_tasks, 0);
+  EXPECT_GT(report.TimestampsPerSecond(), 0);
+
+  // Another run sees the same clock times.
+  ReplayReport report_2;
+  EXPECT_EQ(clock_times,
+            ReplayClockTimes(ReplayGraphConfig(), packets, 4, {}, &report_2));
+  EXPECT_EQ(report.num_packets, report_2.num_packets);
+#ifdef MEDIAPIPE_PROFILER_AVAILABLE
+  EXPECT_THAT(report.process_time,
+              testing::Contains(testing::Key("PassThroughCalculator")));
+#endif
+}
+
+TEST(ReplayExecutorTest, RejectsUnorderedPackets) {
+  std::vector<ReplayPacket> packets = RecordedPackets(2);
+  std::swap(packets[0], packets[3]);
+  auto executor = std::make_shared<ReplayExecutor>(2);
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.SetExecutor("", executor));
+  MEDIAPIPE_ASSERT_OK(
+      graph.Initialize(ReplayGraphConfig(),
+                       {{"callback", MakePacket<ProcessFunction>(nullptr)}}));
+  EXPECT_FALSE(ReplayPackets(&graph, executor.get(), packets).ok());
+}
+
+TEST(ReplayExecutorTest, AdvancesClockWhilePipelining) {
+  std::vector<ReplayPacket> packets = RecordedPackets(20);
+  ReplayOptions options;
+  options.max_in_flight = 4;
+  ReplayReport report;
+  std::vector<int64> clock_times =
+      ReplayClockTimes(ReplayGraphConfig(), packets, 4, options, &report);
+  ASSERT_EQ(20, clock_times.size());
+  for (int i = 0; i < clock_times.size(); ++i) {
+    EXPECT_GE(clock_times[i], i * 1000);
+  }
+  EXPECT_EQ(40, report.num_packets);
+  EXPECT_EQ(20, report.num_timestamps);
+}
+
+// Replays "num_timestamps" timestamps with "options" through a chain of two
+// nodes, and returns the number of Process calls of the second node that
+// overlap with a Process call of the first node for a later timestamp.  Each
+// call of the second node waits up to "wait" for such a call.
+int NumOverlappingProcessCalls(int num_timestamps, const ReplayOptions& options,
+                               absl::Duration wait) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "in"
+        node {
+          calculator: "LambdaCalculator"
+          input_stream: "in"
+          output_stream: "middle"
+          input_side_packet: "callback"
+        }
+        node {
+          calculator: "LambdaCalculator"
+          input_stream: "middle"
+          output_stream: "out"
+          input_side_packet: "callback"
+        }
+      )");
+  absl::Mutex mutex;
+  int64 first_node_timestamp = -1;
+  int num_overlaps = 0;
+  ProcessFunction pass_through = [&](const InputStreamShardSet& inputs,
+                                     OutputStreamShardSet* outputs) {
+    const Packet& packet = inputs.Index(0).Value();
+    const int64 timestamp = packet.Timestamp().Value();
+    absl::MutexLock lock(&mutex);
+    if (outputs->Index(0).Name() == "middle") {
+      first_node_timestamp = timestamp;
+    } else {
+      auto later_call = [&first_node_timestamp, timestamp]() {
+        return first_node_timestamp > timestamp;
+      };
+      if (mutex.AwaitWithTimeout(absl::Condition(&later_call), wait)) {
+        ++num_overlaps;
+      }
+    }
+    outputs->Index(0).AddPacket(packet);
+    return ::mediapipe::OkStatus();
+  };
+  std::vector<ReplayPacket> packets;
+  for (int i = 0; i < num_timestamps; ++i) {
+    packets.push_back({"in", MakePacket<int>(i).At(Timestamp(i))});
+  }
+  auto executor = std::make_shared<ReplayExecutor>(4);
+  CalculatorGraph graph;
+  MEDIAPIPE_CHECK_OK(graph.SetExecutor("", executor));
+  MEDIAPIPE_CHECK_OK(graph.Initialize(
+      config, {{"callback", MakePacket<ProcessFunction>(pass_through)}}));
+  MEDIAPIPE_CHECK_OK(
+      ReplayPackets(&graph, executor.get(), packets, options).status());
+  return num_overlaps;
+}
+
+TEST(ReplayExecutorTest, PipelinesTimestamps) {
+  ReplayOptions options;
+  options.max_in_flight = 4;
+  // The first node processes later timestamps while the second node waits,
+  // except after the last timestamp.
+  EXPECT_EQ(9, NumOverlappingProcessCalls(10, options, absl::Seconds(1)));
+  // Otherwise each timestamp is processed to completion first.
+  EXPECT_EQ(0, NumOverlappingProcessCalls(3, ReplayOptions(),
+                                          absl::Milliseconds(20)));
+}
+
+TEST(ReplayExecutorTest, ReplaysWithPeriodicTraceOutput) {
+  CalculatorGraphConfig config = ReplayGraphConfig();
+  ProfilerConfig* profiler_config = config.mutable_profiler_config();
+  profiler_config->set_trace_enabled(true);
+  profiler_config->set_trace_log_path(
+      absl::StrCat(getenv("TEST_TMPDIR"), "/replay_trace_"));
+  profiler_config->set_trace_log_interval_usec(1000);
+  std::vector<ReplayPacket> packets = RecordedPackets(20);
+  for (int max_in_flight : {1, 4}) {
+    ReplayOptions options;
+    options.max_in_flight = max_in_flight;
+    ReplayReport report;
+    EXPECT_EQ(20,
+              ReplayClockTimes(config, packets, 4, options, &report).size());
+  }
+}
+
+// Replays 100 timestamps on state.range(0) threads, with up to state.range(1)
+// timestamps in flight.
+void BM_ReplayPackets(benchmark::State& state) {
+  std::vector<ReplayPacket> packets = RecordedPackets(100);
+  ReplayOptions options;
+  options.max_in_flight = state.range(1);
+  ReplayReport report;
+  for (auto _ : state) {
+    ReplayClockTimes(ReplayGraphConfig(), packets, state.range(0), options,
+                     &report);
+  }
+  state.SetItemsProcessed(state.iterations() * report.num_timestamps);
+}
+
+BENCHMARK(BM_ReplayPackets)
+    ->Args({1, 1})
+    ->Args({4, 1})
+    ->Args({4, 8})
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
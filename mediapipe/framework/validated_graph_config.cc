@@ -913,7 +913,7 @@ NodeTypeInfo::NodeRef ValidatedGraphConfig::NodeForSorterIndex(
 }
 
 ::mediapipe::Status ValidatedGraphConfig::ValidateStreamTypes() {
-  for (const EdgeInfo& stream : input_streams_) {
+  for (EdgeInfo& stream : input_streams_) {
     RET_CHECK_NE(stream.upstream, -1);
     if (!stream.packet_type->IsConsistentWith(
             *output_streams_[stream.upstream].packet_type)) {
@@ -926,6 +926,9 @@ NodeTypeInfo::NodeRef ValidatedGraphConfig::NodeForSorterIndex(
           stream.packet_type->DebugTypeName(),
           output_streams_[stream.upstream].packet_type->DebugTypeName()));
     }
+    stream.implied_by_upstream_type =
+        output_streams_[stream.upstream].packet_type->Implies(
+            *stream.packet_type);
   }
   return ::mediapipe::OkStatus();
 }
@@ -230,6 +230,9 @@ struct EdgeInfo {
   std::string name;
   PacketType* packet_type = nullptr;
   bool back_edge = false;  // Only applicable to input streams.
+  // True if the packet type of the upstream output stream implies the packet
+  // type of this input stream.  Only applicable to input streams.
+  bool implied_by_upstream_type = false;
 };
 
 // This class is used to validate and canonicalize a CalculatorGraphConfig.
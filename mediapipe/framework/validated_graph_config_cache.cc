@@ -0,0 +1,111 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/validated_graph_config_cache.h"
+
+#include "absl/memory/memory.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "mediapipe/framework/deps/no_destructor.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Returns a serialization of "config" that is identical for equal configs.
+std::string CacheKey(const CalculatorGraphConfig& config) {
+  std::string key;
+  {
+    proto_ns::io::StringOutputStream string_stream(&key);
+    proto_ns::io::CodedOutputStream coded_stream(&string_stream);
+    coded_stream.SetSerializationDeterministic(true);
+    config.SerializeToCodedStream(&coded_stream);
+  }
+  return key;
+}
+
+}  // namespace
+
+constexpr int ValidatedGraphConfigCache::kDefaultMaxSize;
+
+ValidatedGraphConfigCache* ValidatedGraphConfigCache::Get() {
+  static NoDestructor<ValidatedGraphConfigCache> cache;
+  return cache.get();
+}
+
+ValidatedGraphConfigCache::ValidatedGraphConfigCache(int max_size)
+    : max_size_(max_size) {
+  CHECK_GT(max_size_, 0);
+}
+
+::mediapipe::StatusOr<std::shared_ptr<const ValidatedGraphConfig>>
+ValidatedGraphConfigCache::GetOrCreate(const CalculatorGraphConfig& config) {
+  std::string key = CacheKey(config);
+  {
+    absl::MutexLock lock(&mutex_);
+    auto iter = index_.find(key);
+    if (iter != index_.end()) {
+      ++hit_count_;
+      entries_.splice(entries_.begin(), entries_, iter->second);
+      return iter->second->second;
+    }
+    ++miss_count_;
+  }
+
+  // Validate without holding the lock, so that other configs can be served.
+  auto validated_graph = absl::make_unique<ValidatedGraphConfig>();
+  RETURN_IF_ERROR(validated_graph->Initialize(config));
+  std::shared_ptr<const ValidatedGraphConfig> result =
+      std::move(validated_graph);
+
+  absl::MutexLock lock(&mutex_);
+  auto iter = index_.find(key);
+  if (iter != index_.end()) {
+    // Another thread has cached the same config meanwhile.
+    entries_.splice(entries_.begin(), entries_, iter->second);
+    return iter->second->second;
+  }
+  entries_.emplace_front(std::move(key), result);
+  index_[entries_.front().first] = entries_.begin();
+  if (entries_.size() > max_size_) {
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+  return result;
+}
+
+void ValidatedGraphConfigCache::Clear() {
+  absl::MutexLock lock(&mutex_);
+  index_.clear();
+  entries_.clear();
+}
+
+int ValidatedGraphConfigCache::size() const {
+  absl::MutexLock lock(&mutex_);
+  return entries_.size();
+}
+
+int64 ValidatedGraphConfigCache::hit_count() const {
+  absl::MutexLock lock(&mutex_);
+  return hit_count_;
+}
+
+int64 ValidatedGraphConfigCache::miss_count() const {
+  absl::MutexLock lock(&mutex_);
+  return miss_count_;
+}
+
+}  // namespace mediapipe
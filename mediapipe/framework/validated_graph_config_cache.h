@@ -0,0 +1,100 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_VALIDATED_GRAPH_CONFIG_CACHE_H_
+#define MEDIAPIPE_FRAMEWORK_VALIDATED_GRAPH_CONFIG_CACHE_H_
+
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/framework/validated_graph_config.h"
+
+namespace mediapipe {
+
+// Caches the ValidatedGraphConfigs of recently used CalculatorGraphConfigs,
+// so that many CalculatorGraphs with an identical config can share one
+// ValidatedGraphConfig.  This avoids repeating subgraph expansion, stream
+// type validation, topological sorting, and calculator contract lookups for
+// every graph instance.
+//
+// Example:
+//   ASSIGN_OR_RETURN(auto validated_graph,
+//                    ValidatedGraphConfigCache::Get()->GetOrCreate(config));
+//   CalculatorGraph graph;
+//   RETURN_IF_ERROR(graph.Initialize(std::move(validated_graph), {}));
+//
+// Configs are validated against the global calculator and subgraph
+// registries, so registrations must be complete before a config is cached.
+// This class is thread-safe.
+class ValidatedGraphConfigCache {
+ public:
+  // The default maximum number of cached configs.
+  static constexpr int kDefaultMaxSize = 64;
+
+  // Returns the process-wide cache.
+  static ValidatedGraphConfigCache* Get();
+
+  // Creates a cache holding at most "max_size" configs.  When the cache is
+  // full the least recently used config is evicted.
+  explicit ValidatedGraphConfigCache(int max_size = kDefaultMaxSize);
+
+  ValidatedGraphConfigCache(const ValidatedGraphConfigCache&) = delete;
+  ValidatedGraphConfigCache& operator=(const ValidatedGraphConfigCache&) =
+      delete;
+
+  // Returns the ValidatedGraphConfig for "config", validating "config" only
+  // if no identical config is cached.  Configs that fail validation are not
+  // cached.
+  ::mediapipe::StatusOr<std::shared_ptr<const ValidatedGraphConfig>>
+  GetOrCreate(const CalculatorGraphConfig& config) LOCKS_EXCLUDED(mutex_);
+
+  // Removes all cached configs.
+  void Clear() LOCKS_EXCLUDED(mutex_);
+
+  // Returns the number of cached configs.
+  int size() const LOCKS_EXCLUDED(mutex_);
+
+  // Returns the number of GetOrCreate calls served from the cache.
+  int64 hit_count() const LOCKS_EXCLUDED(mutex_);
+
+  // Returns the number of GetOrCreate calls that validated a config.
+  int64 miss_count() const LOCKS_EXCLUDED(mutex_);
+
+ private:
+  using Entry =
+      std::pair<std::string, std::shared_ptr<const ValidatedGraphConfig>>;
+
+  const int max_size_;
+  mutable absl::Mutex mutex_;
+  // The cached configs, most recently used first, keyed by their
+  // deterministic serialization.
+  std::list<Entry> entries_ GUARDED_BY(mutex_);
+  // Maps each key in entries_ to its entry.
+  absl::flat_hash_map<absl::string_view, std::list<Entry>::iterator> index_
+      GUARDED_BY(mutex_);
+  int64 hit_count_ GUARDED_BY(mutex_) = 0;
+  int64 miss_count_ GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_VALIDATED_GRAPH_CONFIG_CACHE_H_
@@ -0,0 +1,146 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/validated_graph_config_cache.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+// Returns a graph with a chain of "num_nodes" PassThroughCalculators.
+CalculatorGraphConfig PassThroughChainConfig(int num_nodes) {
+  CalculatorGraphConfig config;
+  config.add_input_stream("in_0");
+  for (int i = 0; i < num_nodes; ++i) {
+    CalculatorGraphConfig::Node* node = config.add_node();
+    node->set_calculator("PassThroughCalculator");
+    node->add_input_stream(absl::StrCat("in_", i));
+    node->add_output_stream(absl::StrCat("in_", i + 1));
+  }
+  config.add_output_stream(absl::StrCat("in_", num_nodes));
+  return config;
+}
+
+TEST(ValidatedGraphConfigCacheTest, ReusesIdenticalConfigs) {
+  ValidatedGraphConfigCache cache;
+  auto first = cache.GetOrCreate(PassThroughChainConfig(2));
+  auto second = cache.GetOrCreate(PassThroughChainConfig(2));
+  auto other = cache.GetOrCreate(PassThroughChainConfig(3));
+  MEDIAPIPE_ASSERT_OK(first.status());
+  MEDIAPIPE_ASSERT_OK(second.status());
+  MEDIAPIPE_ASSERT_OK(other.status());
+  EXPECT_EQ(first.ValueOrDie().get(), second.ValueOrDie().get());
+  EXPECT_NE(first.ValueOrDie().get(), other.ValueOrDie().get());
+  EXPECT_EQ(2, cache.size());
+  EXPECT_EQ(1, cache.hit_count());
+  EXPECT_EQ(2, cache.miss_count());
+
+  cache.Clear();
+  EXPECT_EQ(0, cache.size());
+  auto third = cache.GetOrCreate(PassThroughChainConfig(2));
+  MEDIAPIPE_ASSERT_OK(third.status());
+  EXPECT_NE(first.ValueOrDie().get(), third.ValueOrDie().get());
+}
+
+TEST(ValidatedGraphConfigCacheTest, InvalidConfigIsNotCached) {
+  ValidatedGraphConfigCache cache;
+  CalculatorGraphConfig config = PassThroughChainConfig(1);
+  config.mutable_node(0)->set_calculator("NoSuchCalculator");
+  EXPECT_FALSE(cache.GetOrCreate(config).ok());
+  EXPECT_FALSE(cache.GetOrCreate(config).ok());
+  EXPECT_EQ(0, cache.size());
+  EXPECT_EQ(2, cache.miss_count());
+}
+
+TEST(ValidatedGraphConfigCacheTest, EvictsLeastRecentlyUsed) {
+  ValidatedGraphConfigCache cache(2);
+  auto one = cache.GetOrCreate(PassThroughChainConfig(1)).ValueOrDie();
+  auto two = cache.GetOrCreate(PassThroughChainConfig(2)).ValueOrDie();
+  EXPECT_EQ(one, cache.GetOrCreate(PassThroughChainConfig(1)).ValueOrDie());
+  cache.GetOrCreate(PassThroughChainConfig(3)).ValueOrDie();
+  EXPECT_EQ(2, cache.size());
+  EXPECT_EQ(one, cache.GetOrCreate(PassThroughChainConfig(1)).ValueOrDie());
+  EXPECT_NE(two, cache.GetOrCreate(PassThroughChainConfig(2)).ValueOrDie());
+}
+
+// Graphs sharing a ValidatedGraphConfig run independently.
+TEST(ValidatedGraphConfigCacheTest, GraphsShareValidatedGraphConfig) {
+  ValidatedGraphConfigCache cache;
+  std::vector<std::unique_ptr<CalculatorGraph>> graphs;
+  std::vector<std::vector<Packet>> outputs(2);
+  for (int i = 0; i < 2; ++i) {
+    auto validated_graph = cache.GetOrCreate(PassThroughChainConfig(3));
+    MEDIAPIPE_ASSERT_OK(validated_graph.status());
+    graphs.push_back(absl::make_unique<CalculatorGraph>());
+    MEDIAPIPE_ASSERT_OK(
+        graphs[i]->Initialize(validated_graph.ValueOrDie(), {}));
+    MEDIAPIPE_ASSERT_OK(graphs[i]->ObserveOutputStream(
+        "in_3", [&outputs, i](const Packet& packet) {
+          outputs[i].push_back(packet);
+          return ::mediapipe::OkStatus();
+        }));
+    MEDIAPIPE_ASSERT_OK(graphs[i]->StartRun({}));
+  }
+  for (int i = 0; i < 2; ++i) {
+    for (int t = 0; t <= i; ++t) {
+      MEDIAPIPE_ASSERT_OK(graphs[i]->AddPacketToInputStream(
+          "in_0", MakePacket<int>(t).At(Timestamp(t))));
+    }
+    MEDIAPIPE_ASSERT_OK(graphs[i]->CloseAllInputStreams());
+  }
+  for (int i = 0; i < 2; ++i) {
+    MEDIAPIPE_ASSERT_OK(graphs[i]->WaitUntilDone());
+    EXPECT_EQ(i + 1, outputs[i].size());
+  }
+  EXPECT_EQ(1, cache.hit_count());
+}
+
+// Initializes a graph with a chain of state.range(0) nodes, with and without
+// ValidatedGraphConfigCache.
+void BM_InitializeGraph(benchmark::State& state) {
+  CalculatorGraphConfig config = PassThroughChainConfig(state.range(0));
+  for (auto _ : state) {
+    CalculatorGraph graph;
+    MEDIAPIPE_CHECK_OK(graph.Initialize(config));
+  }
+}
+
+BENCHMARK(BM_InitializeGraph)->Arg(10)->Arg(100);
+
+void BM_InitializeGraphFromCache(benchmark::State& state) {
+  CalculatorGraphConfig config = PassThroughChainConfig(state.range(0));
+  for (auto _ : state) {
+    CalculatorGraph graph;
+    MEDIAPIPE_CHECK_OK(graph.Initialize(
+        ValidatedGraphConfigCache::Get()->GetOrCreate(config).ValueOrDie(),
+        {}));
+  }
+}
+
+BENCHMARK(BM_InitializeGraphFromCache)->Arg(10)->Arg(100);
+
+}  // namespace
+}  // namespace mediapipe
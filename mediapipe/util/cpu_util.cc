@@ -16,16 +16,25 @@
 
 #include <cmath>
 
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
 #ifdef __ANDROID__
 #include "ndk/sources/android/cpufeatures/cpu-features.h"
 #else
 #include <unistd.h>
 #endif
 #include <fstream>
+#include <string>
+#include <vector>
 
 #include "absl/algorithm/container.h"
+#include "absl/strings/ascii.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/integral_types.h"
@@ -65,6 +74,29 @@ constexpr uint32 kBufferLength = 64;
   }
 }
 
+// Parses a CPU list such as "0-3,8,10-11", the format of the Linux sysfs
+// cpulist files.
+::mediapipe::StatusOr<std::set<int>> ParseCpuList(absl::string_view cpu_list) {
+  std::set<int> cpus;
+  for (absl::string_view range :
+       absl::StrSplit(cpu_list, ',', absl::SkipWhitespace())) {
+    std::vector<absl::string_view> bounds = absl::StrSplit(range, '-');
+    int first;
+    int last;
+    if (bounds.size() > 2 ||
+        !absl::SimpleAtoi(absl::StripAsciiWhitespace(bounds[0]), &first) ||
+        !absl::SimpleAtoi(absl::StripAsciiWhitespace(bounds.back()), &last) ||
+        first > last) {
+      return mediapipe::InvalidArgumentError(
+          absl::StrCat("Invalid CPU list: ", cpu_list));
+    }
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.insert(cpu);
+    }
+  }
+  return cpus;
+}
+
 std::set<int> InferLowerOrHigherCoreIds(bool lower) {
   std::vector<std::pair<int, uint64>> cpu_freq_pairs;
   for (int cpu = 0; cpu < NumCPUCores(); ++cpu) {
@@ -119,4 +151,35 @@ std::set<int> InferHigherCoreIds() {
   return InferLowerOrHigherCoreIds(/* lower= */ false);
 }
 
+::mediapipe::StatusOr<std::set<int>> GetNumaNodeCpuIds(int numa_node) {
+  const std::string path =
+      absl::Substitute("/sys/devices/system/node/node$0/cpulist", numa_node);
+  std::ifstream file(path);
+  std::string cpu_list;
+  if (numa_node < 0 || !file.is_open() || !std::getline(file, cpu_list)) {
+    return mediapipe::NotFoundError(absl::StrCat("Couldn't read ", path));
+  }
+  return ParseCpuList(cpu_list);
+}
+
+std::set<int> GetAffinityCpuIds() {
+  std::set<int> cpu_ids;
+#if defined(__linux__)
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  if (sched_getaffinity(0, sizeof(cpu_set_t), &cpu_set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &cpu_set)) {
+        cpu_ids.insert(cpu);
+      }
+    }
+    return cpu_ids;
+  }
+#endif
+  for (int cpu = 0; cpu < NumCPUCores(); ++cpu) {
+    cpu_ids.insert(cpu);
+  }
+  return cpu_ids;
+}
+
 }  // namespace mediapipe.
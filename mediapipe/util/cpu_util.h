@@ -17,6 +17,8 @@
 
 #include <set>
 
+#include "mediapipe/framework/port/statusor.h"
+
 namespace mediapipe {
 // Returns the number of CPU cores. Compatible with Android.
 int NumCPUCores();
@@ -24,6 +26,12 @@ int NumCPUCores();
 std::set<int> InferLowerCoreIds();
 // Returns a set of inferred CPU ids of higher cores.
 std::set<int> InferHigherCoreIds();
+// Returns the ids of the CPUs of the given NUMA node. Only supported on
+// Linux.
+::mediapipe::StatusOr<std::set<int>> GetNumaNodeCpuIds(int numa_node);
+// Returns the ids of the CPUs the calling thread is allowed to run on. Where
+// the affinity mask is not available, returns all ids below NumCPUCores().
+std::set<int> GetAffinityCpuIds();
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_UTIL_CPU_UTIL_H_